@@ -276,20 +276,9 @@ void QgsFieldCalculator::accept()
     {
       req.setFilterFids( mVectorLayer->selectedFeatureIds() );
     }
-    QgsFeatureIterator fit = mVectorLayer->getFeatures( req );
-    while ( fit.nextFeature( feature ) )
+    auto setValue = [&]( const QgsFeature & feature, QVariant value )
     {
-      expContext.setFeature( feature );
-      expContext.lastScope()->addVariable( QgsExpressionContextScope::StaticVariable( QStringLiteral( "row_number" ), rownum, true ) );
-
-      QVariant value = exp.evaluate( &expContext );
-      if ( exp.hasEvalError() )
-      {
-        calculationSuccess = false;
-        error = exp.evalErrorString();
-        break;
-      }
-      else if ( updatingGeom )
+      if ( updatingGeom )
       {
         if ( value.canConvert< QgsGeometry >() )
         {
@@ -302,9 +291,59 @@ void QgsFieldCalculator::accept()
         field.convertCompatible( value );
         mVectorLayer->changeAttributeValue( feature.id(), mAttributeId, value, newField ? emptyAttribute : feature.attributes().value( mAttributeId ) );
       }
+    };
+
+    // unless the row number is used, the expression is evaluated for blocks of features
+    exp.compile();
+    const QSet<QString> variables = exp.referencedVariables();
+    const bool useBlocks = !variables.contains( QStringLiteral( "row_number" ) ) && !variables.contains( QString() );
+    const int blockSize = 1000;
+    QgsFeatureList block;
+    auto processBlock = [&]
+    {
+      const QVariantList values = exp.evaluate( &expContext, block );
+      if ( exp.hasEvalError() )
+      {
+        calculationSuccess = false;
+        error = exp.evalErrorString();
+        return;
+      }
+      for ( int i = 0; i < block.count(); ++i )
+        setValue( block.at( i ), values.at( i ) );
+      block.clear();
+    };
+
+    QgsFeatureIterator fit = mVectorLayer->getFeatures( req );
+    while ( fit.nextFeature( feature ) )
+    {
+      if ( useBlocks )
+      {
+        block << feature;
+        if ( block.count() == blockSize )
+        {
+          processBlock();
+          if ( !calculationSuccess )
+            break;
+        }
+        continue;
+      }
+
+      expContext.setFeature( feature );
+      expContext.lastScope()->addVariable( QgsExpressionContextScope::StaticVariable( QStringLiteral( "row_number" ), rownum, true ) );
+
+      QVariant value = exp.evaluate( &expContext );
+      if ( exp.hasEvalError() )
+      {
+        calculationSuccess = false;
+        error = exp.evalErrorString();
+        break;
+      }
+      setValue( feature, value );
 
       rownum++;
     }
+    if ( calculationSuccess && !block.isEmpty() )
+      processBlock();
 
     QApplication::restoreOverrideCursor();
 
@@ -17,6 +17,7 @@
 #include "qgsexpressionfunction.h"
 #include "qgsexpressionprivate.h"
 #include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionprogram.h"
 #include "qgsfeaturerequest.h"
 #include "qgscolorramp.h"
 #include "qgslogger.h"
@@ -99,6 +100,7 @@ bool QgsExpression::checkExpression( const QString &text, const QgsExpressionCon
 void QgsExpression::setExpression( const QString &expression )
 {
   detach();
+  d->mProgram.reset();
   d->mRootNode = ::parseExpression( expression, d->mParserErrorString );
   d->mEvalErrorString = QString();
   d->mExp = expression;
@@ -327,6 +329,7 @@ void QgsExpression::setGeomCalculator( const QgsDistanceArea *calc )
 bool QgsExpression::prepare( const QgsExpressionContext *context )
 {
   detach();
+  d->mProgram.reset();
   d->mEvalErrorString = QString();
   if ( !d->mRootNode )
   {
@@ -345,6 +348,34 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
   return d->mRootNode->prepare( this, context );
 }
 
+bool QgsExpression::compile()
+{
+  return compile( nullptr );
+}
+
+bool QgsExpression::compile( QgsExpressionValueCache *sharedValues )
+{
+  // the program is shared with implicitly shared copies, as their expression trees are the same
+  d->mProgram.reset();
+  if ( !d->mRootNode )
+    return false;
+
+  std::unique_ptr< QgsExpressionProgram > program( new QgsExpressionProgram( d->mRootNode, sharedValues ) );
+  if ( program->instructionCount() == 1 && program->fallbackCount() == 1 )
+  {
+    // the whole expression would be evaluated by the tree anyway
+    return false;
+  }
+
+  d->mProgram = std::move( program );
+  return true;
+}
+
+bool QgsExpression::isCompiled() const
+{
+  return static_cast< bool >( d->mProgram );
+}
+
 QVariant QgsExpression::evaluate()
 {
   d->mEvalErrorString = QString();
@@ -354,6 +385,9 @@ QVariant QgsExpression::evaluate()
     return QVariant();
   }
 
+  if ( d->mProgram )
+    return d->mProgram->run( this, nullptr );
+
   return d->mRootNode->eval( this, static_cast<const QgsExpressionContext *>( nullptr ) );
 }
 
@@ -366,9 +400,49 @@ QVariant QgsExpression::evaluate( const QgsExpressionContext *context )
     return QVariant();
   }
 
+  if ( d->mProgram )
+    return d->mProgram->run( this, context );
+
   return d->mRootNode->eval( this, context );
 }
 
+QVariantList QgsExpression::evaluate( QgsExpressionContext *context, const QList< QgsFeature > &features )
+{
+  d->mEvalErrorString = QString();
+  if ( !d->mRootNode )
+  {
+    d->mEvalErrorString = tr( "No root node! Parsing failed?" );
+    return QVariantList();
+  }
+
+  QgsExpressionContext localContext;
+  if ( !context )
+    context = &localContext;
+
+  if ( d->mProgram )
+    return d->mProgram->runBlock( this, context, features );
+
+  // same error handling as the program, failing features get NULL and the first error is kept
+  QVariantList results;
+  results.reserve( features.count() );
+  QString error;
+  for ( const QgsFeature &feature : features )
+  {
+    context->setFeature( feature );
+    QVariant result = d->mRootNode->eval( this, context );
+    if ( hasEvalError() )
+    {
+      if ( error.isNull() )
+        error = d->mEvalErrorString;
+      d->mEvalErrorString = QString();
+      result = QVariant();
+    }
+    results << result;
+  }
+  d->mEvalErrorString = error;
+  return results;
+}
+
 bool QgsExpression::hasEvalError() const
 {
   return !d->mEvalErrorString.isNull();
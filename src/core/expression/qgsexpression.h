@@ -43,6 +43,7 @@ class QgsExpressionContext;
 class QgsExpressionPrivate;
 class QgsExpressionNode;
 class QgsExpressionFunction;
+class QgsExpressionValueCache;
 
 /**
  * \ingroup core
@@ -177,6 +178,42 @@ class CORE_EXPORT QgsExpression
      */
     bool prepare( const QgsExpressionContext *context );
 
+    /**
+     * Compiles the expression to a flat list of instructions, which evaluate() runs instead
+     * of walking the expression tree. Intermediate results are not boxed in QVariants and
+     * attributes are read from the context feature directly, which speeds up expressions
+     * evaluated for many features (e.g. in renderers and feature requests).
+     *
+     * prepare() should be called first, column references which were not resolved by
+     * prepare() and function calls are still evaluated by the expression tree. Results
+     * are always the same as without compiling. Calling prepare() again discards the
+     * compiled program.
+     *
+     * \returns true if the expression was compiled, false if there is nothing to compile
+     * \see isCompiled()
+     * \since QGIS 3.0
+     */
+    bool compile();
+
+    /**
+     * Compiles the expression like compile(), and shares the values of costly subexpressions
+     * with the other expressions compiled with the same \a sharedValues cache, so that they are
+     * evaluated only once per feature. The cache must outlive the compiled expression.
+     *
+     * \returns true if the expression was compiled, false if there is nothing to compile
+     * \note not available in Python bindings
+     * \see QgsExpressionValueCache
+     * \since QGIS 3.0
+     */
+    bool compile( QgsExpressionValueCache *sharedValues ) SIP_SKIP;
+
+    /**
+     * Returns true if the expression has been compiled.
+     * \see compile()
+     * \since QGIS 3.0
+     */
+    bool isCompiled() const;
+
     /**
      * Get list of columns referenced by the expression.
      *
@@ -224,6 +261,25 @@ class CORE_EXPORT QgsExpression
      */
     QVariant evaluate( const QgsExpressionContext *context );
 
+    /**
+     * Evaluates the expression for each feature of a block of \a features and returns the
+     * results in the same order. If the expression was compiled, every instruction of the program
+     * runs over the whole block at once and attributes are read from the features directly,
+     * which is faster than evaluating the features one by one. Blocks of a few hundred to a few
+     * thousand features work best.
+     *
+     * The feature of the \a context is changed to the feature being evaluated when needed, other
+     * variables of the context are the same for all features. Features for which the evaluation
+     * fails get a NULL result, and hasEvalError() and evalErrorString() report the first error.
+     *
+     * \param context context for evaluating expression
+     * \param features features to evaluate the expression for
+     * \note prepare() should be called before calling this method.
+     * \see compile()
+     * \since QGIS 3.0
+     */
+    QVariantList evaluate( QgsExpressionContext *context, const QList< QgsFeature > &features );
+
     //! Returns true if an error occurred when evaluating last input
     bool hasEvalError() const;
     //! Returns evaluation error
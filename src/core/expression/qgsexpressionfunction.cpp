@@ -39,6 +39,8 @@
 #include "qgsmessagelog.h"
 #include "qgsrasterlayer.h"
 #include "qgsvectorlayer.h"
+#include "qgsaggregatecache.h"
+#include "qgsapplication.h"
 #include "qgsrasterbandstats.h"
 #include "qgscolorramp.h"
 #include "qgsfieldformatterregistry.h"
@@ -526,6 +528,19 @@ static QVariant fcnAggregate( const QVariantList &values, const QgsExpressionCon
     if ( context && context->hasCachedValue( cacheKey ) )
       return context->cachedValue( cacheKey );
 
+    // aggregates which do not depend on the context are shared by all expressions
+    QgsAggregateCache *aggregateCache = QgsApplication::aggregateCache();
+    const bool shareResult = aggregateCache && QgsAggregateCache::isCacheable( subExp, context )
+                             && QgsAggregateCache::isCacheable( filterExp, context );
+    const QString sharedKey = QStringLiteral( "aggregate:%1:%2:%3:%4:%5" ).arg( QString::number( aggregate ), subExpression, parameters.filter,
+                              parameters.delimiter, vl->subsetString() );
+    if ( shareResult && aggregateCache->cachedValue( vl, sharedKey, result ) )
+    {
+      context->setCachedValue( cacheKey, result );
+      return result;
+    }
+    const quint64 generation = shareResult ? aggregateCache->layerGeneration( vl ) : 0;
+
     QgsExpressionContext subContext( *context );
     QgsExpressionContextScope *subScope = new QgsExpressionContextScope();
     subScope->setVariable( QStringLiteral( "parent" ), context->feature() );
@@ -533,6 +548,8 @@ static QVariant fcnAggregate( const QVariantList &values, const QgsExpressionCon
     result = vl->aggregate( aggregate, subExpression, parameters, &subContext, &ok );
 
     context->setCachedValue( cacheKey, result );
+    if ( ok && shareResult )
+      aggregateCache->setCachedValue( vl, sharedKey, result, generation );
   }
   else
   {
@@ -547,6 +564,30 @@ static QVariant fcnAggregate( const QVariantList &values, const QgsExpressionCon
   return result;
 }
 
+//! Returns true if values of a referencing and a referenced field are equal in a relation filter exactly when they get the same group key
+static bool groupKeysMatchEquality( QVariant::Type referencingType, QVariant::Type referencedType )
+{
+  auto isNumber = []( QVariant::Type type )
+  {
+    return type == QVariant::Int || type == QVariant::UInt || type == QVariant::LongLong
+           || type == QVariant::ULongLong || type == QVariant::Double;
+  };
+  return ( referencingType == QVariant::String && referencedType == QVariant::String )
+         || ( isNumber( referencingType ) && isNumber( referencedType ) );
+}
+
+//! Converts \a value to the type of \a field, returning false if the conversion fails or changes the value (e.g. by rounding)
+static bool convertGroupValue( const QgsField &field, QVariant &value )
+{
+  const QVariant original = value;
+  if ( !field.convertCompatible( value ) )
+    return false;
+
+  if ( original.isNull() )
+    return value.isNull();
+  return !value.isNull() && value.toString() == original.toString();
+}
+
 static QVariant fcnAggregateRelation( const QVariantList &values, const QgsExpressionContext *context, QgsExpression *parent, const QgsExpressionNodeFunction * )
 {
   if ( !context )
@@ -632,6 +673,57 @@ static QVariant fcnAggregateRelation( const QVariantList &values, const QgsExpre
   QVariant result;
   ok = false;
 
+  // if the aggregate does not depend on the context, calculate it for all parent features in a
+  // single pass over the child layer and share the results with all expressions
+  QgsAggregateCache *aggregateCache = QgsApplication::aggregateCache();
+  QList< int > groupBy;
+  QVariantList groupValues;
+  QStringList referencingFields;
+  bool grouped = aggregateCache && QgsAggregateCache::isCacheable( QgsExpression( subExpression ), context );
+  const QList< QgsRelation::FieldPair > fieldPairs = relation.fieldPairs();
+  for ( const QgsRelation::FieldPair &fieldPair : fieldPairs )
+  {
+    const int referencingIndex = childLayer->fields().lookupField( fieldPair.referencingField() );
+    const int referencedIndex = vl->fields().lookupField( fieldPair.referencedField() );
+    // child features are grouped by their values, which have the type of the referencing field
+    QVariant value = f.attribute( fieldPair.referencedField() );
+    grouped = grouped && referencingIndex >= 0 && referencedIndex >= 0
+              && groupKeysMatchEquality( childLayer->fields().at( referencingIndex ).type(), vl->fields().at( referencedIndex ).type() )
+              && convertGroupValue( childLayer->fields().at( referencingIndex ), value );
+    if ( !grouped )
+      break;
+
+    groupBy << referencingIndex;
+    groupValues << value;
+    referencingFields << fieldPair.referencingField();
+  }
+
+  if ( grouped )
+  {
+    const QString groupsKey = QStringLiteral( "relation_aggregate:%1:%2:%3:%4:%5" ).arg( referencingFields.join( QStringLiteral( "," ) ),
+                              QString::number( aggregate ), subExpression, parameters.delimiter, childLayer->subsetString() );
+    const QString groupKey = QgsAggregateCalculator::groupKey( groupValues );
+    if ( aggregateCache->cachedGroupValue( childLayer, groupsKey, groupKey, result ) )
+    {
+      context->setCachedValue( cacheKey, result );
+      return result;
+    }
+
+    const quint64 generation = aggregateCache->layerGeneration( childLayer );
+    QgsExpressionContext subContext( *context );
+    QgsAggregateCalculator calculator( childLayer );
+    calculator.setDelimiter( parameters.delimiter );
+    QVariant emptyGroupResult;
+    const QVariantMap groupResults = calculator.calculateGroups( aggregate, subExpression, groupBy, &subContext, &ok, &emptyGroupResult );
+    if ( ok )
+    {
+      aggregateCache->setCachedGroupValues( childLayer, groupsKey, groupResults, emptyGroupResult, generation );
+      result = groupResults.value( groupKey, emptyGroupResult );
+      context->setCachedValue( cacheKey, result );
+      return result;
+    }
+    // otherwise calculate the aggregate for this parent feature only, reporting errors as usual
+  }
 
   QgsExpressionContext subContext( *context );
   result = childLayer->aggregate( aggregate, subExpression, parameters, &subContext, &ok );
@@ -168,6 +168,11 @@ QVariant QgsExpressionNodeBinaryOperator::evalNode( QgsExpression *parent, const
   QVariant vR = mOpRight->eval( parent, context );
   ENSURE_NO_EVAL_ERROR;
 
+  return evalOperator( vL, vR, parent, context );
+}
+
+QVariant QgsExpressionNodeBinaryOperator::evalOperator( const QVariant &vL, const QVariant &vR, QgsExpression *parent, const QgsExpressionContext *context )
+{
   switch ( mOp )
   {
     case boPlus:
@@ -155,6 +155,13 @@ class CORE_EXPORT QgsExpressionNodeBinaryOperator : public QgsExpressionNode
     QString text() const;
 
   private:
+
+    /**
+     * Applies the operator to the already evaluated operand values \a vL and \a vR.
+     * Errors are reported to the parent.
+     */
+    QVariant evalOperator( const QVariant &vL, const QVariant &vR, QgsExpression *parent, const QgsExpressionContext *context );
+
     bool compare( double diff );
     qlonglong computeInt( qlonglong x, qlonglong y );
     double computeDouble( double x, double y );
@@ -171,6 +178,8 @@ class CORE_EXPORT QgsExpressionNodeBinaryOperator : public QgsExpressionNode
     QgsExpressionNode *mOpRight = nullptr;
 
     static const char *BINARY_OPERATOR_TEXT[];
+
+    friend class QgsExpressionProgram;
 };
 
 /**
@@ -305,6 +314,8 @@ class CORE_EXPORT QgsExpressionNodeColumnRef : public QgsExpressionNode
   private:
     QString mName;
     int mIndex;
+
+    friend class QgsExpressionProgram;
 };
 
 /**
@@ -333,6 +344,18 @@ class CORE_EXPORT QgsExpressionNodeCondition : public QgsExpressionNode
          */
         QgsExpressionNodeCondition::WhenThen *clone() const SIP_FACTORY;
 
+        /**
+         * The expression that makes the WHEN part of the condition.
+         * \since QGIS 3.0
+         */
+        QgsExpressionNode *whenExp() const { return mWhenExp; }
+
+        /**
+         * The expression node that makes the THEN result part of the condition.
+         * \since QGIS 3.0
+         */
+        QgsExpressionNode *thenExp() const { return mThenExp; }
+
       private:
 #ifdef SIP_RUN
         WhenThen( const QgsExpressionNodeCondition::WhenThen &rh );
@@ -370,6 +393,18 @@ class CORE_EXPORT QgsExpressionNodeCondition : public QgsExpressionNode
     virtual QgsExpressionNode *clone() const override SIP_FACTORY;
     virtual bool isStatic( QgsExpression *parent, const QgsExpressionContext *context ) const override;
 
+    /**
+     * The list of WHEN THEN expression parts of the expression.
+     * \since QGIS 3.0
+     */
+    WhenThenList conditions() const { return mConditions; }
+
+    /**
+     * The ELSE expression used for the condition, or nullptr if there is none.
+     * \since QGIS 3.0
+     */
+    QgsExpressionNode *elseExp() const { return mElseExp; }
+
   private:
     WhenThenList mConditions;
     QgsExpressionNode *mElseExp = nullptr;
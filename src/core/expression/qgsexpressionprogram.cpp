@@ -0,0 +1,1085 @@
+/***************************************************************************
+                               qgsexpressionprogram.cpp
+                             -------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionprogram.h"
+#include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionfunction.h"
+#include "qgsexpressionutils.h"
+#include "qgsexpressioncontext.h"
+#include "qgsexpression.h"
+#include "qgsfeature.h"
+
+#include <cmath>
+#include <numeric>
+
+typedef QgsExpressionNodeBinaryOperator BinaryNode;
+
+void QgsExpressionProgram::Value::setVariant( const QVariant &value )
+{
+  if ( value.isNull() )
+  {
+    type = Null;
+    variant = value;
+    return;
+  }
+
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+      type = Int;
+      intValue = value.toInt();
+      break;
+    case QVariant::LongLong:
+      type = LongLong;
+      intValue = value.toLongLong();
+      break;
+    case QVariant::Double:
+      type = Double;
+      doubleValue = value.toDouble();
+      break;
+    case QVariant::String:
+      type = String;
+      stringValue = value.toString();
+      break;
+    default:
+      type = Variant;
+      variant = value;
+      break;
+  }
+}
+
+QVariant QgsExpressionProgram::Value::toVariant() const
+{
+  switch ( type )
+  {
+    case Int:
+      return QVariant( static_cast< int >( intValue ) );
+    case LongLong:
+      return QVariant( intValue );
+    case Double:
+      return QVariant( doubleValue );
+    case String:
+      return QVariant( stringValue );
+    case Null:
+    case Variant:
+      break;
+  }
+  return variant;
+}
+
+bool QgsExpressionProgram::Value::isFiniteNumber() const
+{
+  return type == Int || type == LongLong || ( type == Double && std::isfinite( doubleValue ) );
+}
+
+int QgsExpressionValueCache::slot( const QString &key )
+{
+  const auto it = mSlotIndexes.constFind( key );
+  if ( it != mSlotIndexes.constEnd() )
+    return it.value();
+
+  mSlots << Slot();
+  mSlotIndexes.insert( key, mSlots.count() - 1 );
+  return mSlots.count() - 1;
+}
+
+static QList< QgsExpressionNode * > childNodes( QgsExpressionNode *node )
+{
+  QList< QgsExpressionNode * > children;
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntUnaryOperator:
+      children << static_cast< QgsExpressionNodeUnaryOperator * >( node )->operand();
+      break;
+    case QgsExpressionNode::ntBinaryOperator:
+      children << static_cast< BinaryNode * >( node )->opLeft() << static_cast< BinaryNode * >( node )->opRight();
+      break;
+    case QgsExpressionNode::ntInOperator:
+      children << static_cast< QgsExpressionNodeInOperator * >( node )->node() << static_cast< QgsExpressionNodeInOperator * >( node )->list()->list();
+      break;
+    case QgsExpressionNode::ntFunction:
+      if ( static_cast< QgsExpressionNodeFunction * >( node )->args() )
+        children << static_cast< QgsExpressionNodeFunction * >( node )->args()->list();
+      break;
+    case QgsExpressionNode::ntCondition:
+    {
+      QgsExpressionNodeCondition *condition = static_cast< QgsExpressionNodeCondition * >( node );
+      const QgsExpressionNodeCondition::WhenThenList conditions = condition->conditions();
+      for ( QgsExpressionNodeCondition::WhenThen *whenThen : conditions )
+        children << whenThen->whenExp() << whenThen->thenExp();
+      if ( condition->elseExp() )
+        children << condition->elseExp();
+      break;
+    }
+    case QgsExpressionNode::ntLiteral:
+    case QgsExpressionNode::ntColumnRef:
+      break;
+  }
+  return children;
+}
+
+//! Returns true if evaluating \a node twice for the same feature gives the same value
+static bool isDeterministic( QgsExpressionNode *node )
+{
+  if ( node->nodeType() == QgsExpressionNode::ntFunction )
+  {
+    static const QSet< QString > sVolatileFunctions
+    {
+      QStringLiteral( "rand" ),
+      QStringLiteral( "randf" ),
+      QStringLiteral( "uuid" ),
+      QStringLiteral( "now" ),
+    };
+    if ( sVolatileFunctions.contains( QgsExpression::Functions()[ static_cast< QgsExpressionNodeFunction * >( node )->fnIndex() ]->name() ) )
+      return false;
+  }
+
+  const QList< QgsExpressionNode * > children = childNodes( node );
+  for ( QgsExpressionNode *child : children )
+  {
+    if ( !child->hasCachedStaticValue() && !isDeterministic( child ) )
+      return false;
+  }
+  return true;
+}
+
+//! Returns true if evaluating \a node costs more than looking up a shared value
+static bool isCostly( QgsExpressionNode *node )
+{
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntFunction:
+    case QgsExpressionNode::ntCondition:
+      return true;
+
+    case QgsExpressionNode::ntBinaryOperator:
+      switch ( static_cast< BinaryNode * >( node )->op() )
+      {
+        case BinaryNode::boRegexp:
+        case BinaryNode::boLike:
+        case BinaryNode::boNotLike:
+        case BinaryNode::boILike:
+        case BinaryNode::boNotILike:
+          return true;
+        default:
+          break;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  const QList< QgsExpressionNode * > children = childNodes( node );
+  for ( QgsExpressionNode *child : children )
+  {
+    if ( !child->hasCachedStaticValue() && isCostly( child ) )
+      return true;
+  }
+  return false;
+}
+
+QgsExpressionProgram::QgsExpressionProgram( QgsExpressionNode *rootNode, QgsExpressionValueCache *sharedValues )
+  : mSharedValues( sharedValues )
+{
+  mSubexpressions << QHash< QString, int >();
+  mResultRegister = compileNode( rootNode );
+  mSubexpressions.clear();
+
+  // the registers are not resized after compiling
+  mRegisterColumns.reserve( mRegisters.count() );
+  for ( int i = 0; i < mRegisters.count(); ++i )
+    mRegisterColumns << &mRegisters[ i ];
+}
+
+int QgsExpressionProgram::fallbackCount() const
+{
+  int count = 0;
+  for ( const Instruction &instruction : mInstructions )
+  {
+    if ( instruction.opCode == EvalNode )
+      count++;
+  }
+  return count;
+}
+
+int QgsExpressionProgram::addConstant( const QVariant &value )
+{
+  Value constant;
+  constant.setVariant( value );
+  mRegisters << constant;
+  return mRegisters.count() - 1;
+}
+
+int QgsExpressionProgram::addInstruction( OpCode opCode, int a, int b, QgsExpressionNode *node )
+{
+  mRegisters << Value();
+  Instruction instruction = { opCode, mRegisters.count() - 1, a, b, node };
+  mInstructions << instruction;
+  return instruction.result;
+}
+
+int QgsExpressionProgram::addJump( OpCode opCode, int a, int b )
+{
+  Instruction instruction = { opCode, -1, a, b, nullptr };
+  mInstructions << instruction;
+  return mInstructions.count() - 1;
+}
+
+void QgsExpressionProgram::addMove( int source, int target )
+{
+  Instruction instruction = { Move, target, source, -1, nullptr };
+  mInstructions << instruction;
+}
+
+int QgsExpressionProgram::compileNode( QgsExpressionNode *node )
+{
+  if ( node->hasCachedStaticValue() )
+    return addConstant( node->cachedStaticValue() );
+  else if ( node->nodeType() == QgsExpressionNode::ntLiteral )
+    return addConstant( static_cast< QgsExpressionNodeLiteral * >( node )->value() );
+
+  // identical subexpressions are only evaluated once
+  const QString key = isDeterministic( node ) ? node->dump() : QString();
+  if ( !key.isNull() )
+  {
+    for ( const QHash< QString, int > &subexpressions : qgsAsConst( mSubexpressions ) )
+    {
+      const auto it = subexpressions.constFind( key );
+      if ( it != subexpressions.constEnd() )
+        return it.value();
+    }
+  }
+
+  int result;
+  if ( mSharedValues && !key.isNull() && isCostly( node ) )
+  {
+    // skip the evaluation if another program already stored the value for this feature
+    mRegisters << Value();
+    result = mRegisters.count() - 1;
+    Instruction lookup = { JumpIfShared, result, mSharedValues->slot( key ), -1, node };
+    mInstructions << lookup;
+    const int jump = mInstructions.count() - 1;
+
+    mSubexpressions << QHash< QString, int >();
+    addMove( compileOperation( node ), result );
+    mSubexpressions.removeLast();
+
+    Instruction store = { StoreShared, -1, result, lookup.a, node };
+    mInstructions << store;
+    mInstructions[ jump ].b = mInstructions.count();
+  }
+  else
+  {
+    result = compileOperation( node );
+  }
+
+  if ( !key.isNull() )
+    mSubexpressions.last().insert( key, result );
+  return result;
+}
+
+int QgsExpressionProgram::compileOperation( QgsExpressionNode *node )
+{
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntLiteral:
+      return addConstant( static_cast< QgsExpressionNodeLiteral * >( node )->value() );
+
+    case QgsExpressionNode::ntColumnRef:
+    {
+      // unresolved columns are looked up by name by the tree
+      QgsExpressionNodeColumnRef *column = static_cast< QgsExpressionNodeColumnRef * >( node );
+      if ( column->mIndex >= 0 )
+        return addInstruction( LoadColumn, column->mIndex, -1, node );
+      break;
+    }
+
+    case QgsExpressionNode::ntUnaryOperator:
+    {
+      QgsExpressionNodeUnaryOperator *unary = static_cast< QgsExpressionNodeUnaryOperator * >( node );
+      const int operand = compileNode( unary->operand() );
+      return addInstruction( unary->op() == QgsExpressionNodeUnaryOperator::uoNot ? Not : Negate, operand, -1, node );
+    }
+
+    case QgsExpressionNode::ntBinaryOperator:
+    {
+      BinaryNode *binary = static_cast< BinaryNode * >( node );
+      const int left = compileNode( binary->opLeft() );
+      const int right = compileNode( binary->opRight() );
+      return addInstruction( Binary, left, right, node );
+    }
+
+    case QgsExpressionNode::ntInOperator:
+    {
+      const int result = compileIn( node );
+      if ( result >= 0 )
+        return result;
+      break;
+    }
+
+    case QgsExpressionNode::ntCondition:
+      return compileCondition( node );
+
+    case QgsExpressionNode::ntFunction:
+    {
+      const int result = compileFunction( node );
+      if ( result >= 0 )
+        return result;
+      break;
+    }
+  }
+
+  return addInstruction( EvalNode, -1, -1, node );
+}
+
+int QgsExpressionProgram::compileIn( QgsExpressionNode *node )
+{
+  QgsExpressionNodeInOperator *in = static_cast< QgsExpressionNodeInOperator * >( node );
+
+  const QList< QgsExpressionNode * > nodeList = in->list()->list();
+  if ( nodeList.isEmpty() )
+    return addConstant( in->isNotIn() ? TVL_True : TVL_False );
+
+  // only lists of static values are compiled, their conversions are done once here
+  QVector< InValue > values;
+  for ( QgsExpressionNode *n : nodeList )
+  {
+    QVariant v;
+    if ( n->hasCachedStaticValue() )
+      v = n->cachedStaticValue();
+    else if ( n->nodeType() == QgsExpressionNode::ntLiteral )
+      v = static_cast< QgsExpressionNodeLiteral * >( n )->value();
+    else
+      return -1;
+
+    InValue value;
+    value.isNull = QgsExpressionUtils::isNull( v );
+    if ( !value.isNull )
+    {
+      value.isDoubleSafe = QgsExpressionUtils::isDoubleSafe( v );
+      if ( value.isDoubleSafe )
+      {
+        bool ok;
+        value.doubleValue = v.toDouble( &ok );
+        // comparing it would raise a conversion error, leave that to the tree
+        if ( !ok || !std::isfinite( value.doubleValue ) )
+          return -1;
+      }
+      value.stringValue = v.toString();
+    }
+    values << value;
+  }
+
+  const int needle = compileNode( in->node() );
+  mInLists << values;
+  return addInstruction( In, needle, mInLists.count() - 1, node );
+}
+
+int QgsExpressionProgram::compileCondition( QgsExpressionNode *node )
+{
+  QgsExpressionNodeCondition *condition = static_cast< QgsExpressionNodeCondition * >( node );
+
+  mRegisters << Value();
+  const int result = mRegisters.count() - 1;
+
+  // the first condition is always evaluated, the following ones and the THEN expressions may be skipped
+  bool hasCondition = false;
+  bool isTrue = false;
+  QList< int > jumpsToEnd;
+  const QgsExpressionNodeCondition::WhenThenList conditions = condition->conditions();
+  for ( QgsExpressionNodeCondition::WhenThen *whenThen : conditions )
+  {
+    QgsExpressionNode *whenExp = whenThen->whenExp();
+    if ( whenExp->hasCachedStaticValue() )
+    {
+      // static conditions are resolved here, unless converting them would raise an error
+      Value value;
+      value.setVariant( whenExp->cachedStaticValue() );
+      if ( value.type == Value::Null || value.isInteger() || value.type == Value::Double )
+      {
+        if ( tvl( value, nullptr ) != QgsExpressionUtils::True )
+          continue;
+
+        addMove( compileNode( whenThen->thenExp() ), result );
+        isTrue = true;
+        break;
+      }
+    }
+
+    const int when = compileNode( whenExp );
+    const int jumpToNext = addJump( JumpIfNotTrue, when, -1 );
+    mSubexpressions << QHash< QString, int >();
+    addMove( compileNode( whenThen->thenExp() ), result );
+    mSubexpressions.removeLast();
+    jumpsToEnd << addJump( Jump, -1, -1 );
+    mInstructions[ jumpToNext ].b = mInstructions.count();
+
+    if ( !hasCondition )
+    {
+      mSubexpressions << QHash< QString, int >();
+      hasCondition = true;
+    }
+  }
+
+  if ( !isTrue )
+    addMove( condition->elseExp() ? compileNode( condition->elseExp() ) : addConstant( QVariant() ), result );
+
+  if ( hasCondition )
+    mSubexpressions.removeLast();
+
+  for ( int jump : qgsAsConst( jumpsToEnd ) )
+    mInstructions[ jump ].a = mInstructions.count();
+
+  return result;
+}
+
+int QgsExpressionProgram::compileFunction( QgsExpressionNode *node )
+{
+  static const QMap< QString, NativeFunction > sNativeFunctions
+  {
+    { QStringLiteral( "abs" ), Abs },
+    { QStringLiteral( "sqrt" ), Sqrt },
+    { QStringLiteral( "floor" ), Floor },
+    { QStringLiteral( "ceil" ), Ceil },
+    { QStringLiteral( "to_real" ), ToReal },
+    { QStringLiteral( "lower" ), Lower },
+    { QStringLiteral( "upper" ), Upper },
+    { QStringLiteral( "trim" ), Trim },
+    { QStringLiteral( "coalesce" ), Coalesce },
+  };
+
+  QgsExpressionNodeFunction *function = static_cast< QgsExpressionNodeFunction * >( node );
+  const QString name = QgsExpression::Functions()[ function->fnIndex() ]->name();
+  const QList< QgsExpressionNode * > argList = function->args() ? function->args()->list() : QList< QgsExpressionNode * >();
+  const auto it = sNativeFunctions.constFind( name );
+  if ( it == sNativeFunctions.constEnd() || ( it.value() != Coalesce && argList.count() != 1 ) )
+    return -1;
+
+  // arguments are evaluated in order, as QgsExpressionFunction::run() does
+  FunctionCall call;
+  call.function = it.value();
+  call.name = name;
+  for ( QgsExpressionNode *arg : argList )
+    call.args << compileNode( arg );
+
+  mFunctionCalls << call;
+  return addInstruction( Function, mFunctionCalls.count() - 1, -1, node );
+}
+
+int QgsExpressionProgram::tvl( const Value &value, QgsExpression *parent )
+{
+  switch ( value.type )
+  {
+    case Value::Null:
+      return QgsExpressionUtils::Unknown;
+    case Value::Int:
+    case Value::LongLong:
+      return value.intValue != 0 ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+    case Value::Double:
+      return !qgsDoubleNear( value.doubleValue, 0.0 ) ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+    case Value::String:
+    case Value::Variant:
+      break;
+  }
+  return QgsExpressionUtils::getTVLValue( value.toVariant(), parent );
+}
+
+void QgsExpressionProgram::setTvl( Value &value, int tvl )
+{
+  switch ( tvl )
+  {
+    case QgsExpressionUtils::False:
+      value.type = Value::Int;
+      value.intValue = 0;
+      break;
+    case QgsExpressionUtils::True:
+      value.type = Value::Int;
+      value.intValue = 1;
+      break;
+    default:
+      value.setNull();
+      break;
+  }
+}
+
+static bool compareDiff( BinaryNode::BinaryOperator op, double diff )
+{
+  switch ( op )
+  {
+    case BinaryNode::boEQ:
+      return qgsDoubleNear( diff, 0.0 );
+    case BinaryNode::boNE:
+      return !qgsDoubleNear( diff, 0.0 );
+    case BinaryNode::boLT:
+      return diff < 0;
+    case BinaryNode::boGT:
+      return diff > 0;
+    case BinaryNode::boLE:
+      return diff <= 0;
+    case BinaryNode::boGE:
+      return diff >= 0;
+    default:
+      Q_ASSERT( false );
+      return false;
+  }
+}
+
+void QgsExpressionProgram::evalBinary( BinaryNode *node, const Value &left, const Value &right, Value &result, QgsExpression *parent, const QgsExpressionContext *context )
+{
+  const BinaryNode::BinaryOperator op = node->op();
+
+  // fast paths for numbers and strings, these must match QgsExpressionNodeBinaryOperator::evalOperator()
+  switch ( op )
+  {
+    case BinaryNode::boPlus:
+      if ( left.type == Value::String && right.type == Value::String )
+      {
+        result.setString( left.stringValue + right.stringValue );
+        return;
+      }
+      FALLTHROUGH;
+    case BinaryNode::boMinus:
+    case BinaryNode::boMul:
+    case BinaryNode::boDiv:
+    case BinaryNode::boMod:
+    {
+      if ( !left.isFiniteNumber() || !right.isFiniteNumber() )
+        break;
+
+      if ( op != BinaryNode::boDiv && left.isInteger() && right.isInteger() )
+      {
+        if ( op == BinaryNode::boMod && right.intValue == 0 )
+          result.setNull();
+        else
+          result.setLongLong( node->computeInt( left.intValue, right.intValue ) );
+        return;
+      }
+
+      const double fR = right.toDouble();
+      if ( ( op == BinaryNode::boDiv || op == BinaryNode::boMod ) && fR == 0. )
+        result.setNull();
+      else
+        result.setDouble( node->computeDouble( left.toDouble(), fR ) );
+      return;
+    }
+
+    case BinaryNode::boIntDiv:
+    {
+      if ( !left.isFiniteNumber() || !right.isFiniteNumber() )
+        break;
+
+      const double fR = right.toDouble();
+      if ( fR == 0. )
+        result.setNull();
+      else
+        result.setLongLong( qlonglong( std::floor( left.toDouble() / fR ) ) );
+      return;
+    }
+
+    case BinaryNode::boPow:
+      if ( !left.isFiniteNumber() || !right.isFiniteNumber() )
+        break;
+
+      result.setDouble( std::pow( left.toDouble(), right.toDouble() ) );
+      return;
+
+    case BinaryNode::boAnd:
+    case BinaryNode::boOr:
+    {
+      const int tvlL = tvl( left, parent );
+      const int tvlR = tvl( right, parent );
+      if ( op == BinaryNode::boAnd )
+        setTvl( result, QgsExpressionUtils::AND[tvlL][tvlR] );
+      else
+        setTvl( result, QgsExpressionUtils::OR[tvlL][tvlR] );
+      return;
+    }
+
+    case BinaryNode::boEQ:
+    case BinaryNode::boNE:
+    case BinaryNode::boLT:
+    case BinaryNode::boGT:
+    case BinaryNode::boLE:
+    case BinaryNode::boGE:
+      if ( left.type == Value::Null || right.type == Value::Null )
+      {
+        result.setNull();
+        return;
+      }
+      else if ( left.isFiniteNumber() && right.isFiniteNumber() )
+      {
+        setTvl( result, compareDiff( op, left.toDouble() - right.toDouble() ) ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+        return;
+      }
+      else if ( left.type == Value::String && right.type == Value::String )
+      {
+        setTvl( result, compareDiff( op, QString::compare( left.stringValue, right.stringValue ) ) ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+        return;
+      }
+      break;
+
+    case BinaryNode::boIs:
+    case BinaryNode::boIsNot:
+    {
+      bool equal;
+      if ( left.type == Value::Null || right.type == Value::Null )
+        equal = left.type == right.type;
+      else if ( left.isFiniteNumber() && right.isFiniteNumber() )
+        equal = qgsDoubleNear( left.toDouble(), right.toDouble() );
+      else if ( left.type == Value::String && right.type == Value::String )
+        equal = left.stringValue == right.stringValue;
+      else
+        break;
+
+      setTvl( result, equal == ( op == BinaryNode::boIs ) ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+      return;
+    }
+
+    case BinaryNode::boConcat:
+      if ( left.type == Value::Null || right.type == Value::Null )
+      {
+        result.setNull();
+        return;
+      }
+      else if ( left.type == Value::String && right.type == Value::String )
+      {
+        result.setString( left.stringValue + right.stringValue );
+        return;
+      }
+      break;
+
+    case BinaryNode::boRegexp:
+    case BinaryNode::boLike:
+    case BinaryNode::boNotLike:
+    case BinaryNode::boILike:
+    case BinaryNode::boNotILike:
+      break;
+  }
+
+  result.setVariant( node->evalOperator( left.toVariant(), right.toVariant(), parent, context ) );
+}
+
+void QgsExpressionProgram::evalNegate( const Value &operand, Value &result, QgsExpression *parent )
+{
+  if ( operand.isInteger() )
+  {
+    result.setLongLong( -operand.intValue );
+    return;
+  }
+  else if ( operand.type == Value::Double && std::isfinite( operand.doubleValue ) )
+  {
+    result.setDouble( -operand.doubleValue );
+    return;
+  }
+
+  // same as QgsExpressionNodeUnaryOperator::evalNode()
+  const QVariant val = operand.toVariant();
+  if ( QgsExpressionUtils::isIntSafe( val ) )
+    result.setLongLong( - QgsExpressionUtils::getIntValue( val, parent ) );
+  else if ( QgsExpressionUtils::isDoubleSafe( val ) )
+    result.setDouble( - QgsExpressionUtils::getDoubleValue( val, parent ) );
+  else
+    parent->setEvalErrorString( QCoreApplication::translate( "QgsExpressionNode", "Unary minus only for numeric values." ) );
+}
+
+void QgsExpressionProgram::evalIn( const Instruction &instruction, const Value &needle, Value &result, QgsExpression *parent )
+{
+  const bool notIn = static_cast< QgsExpressionNodeInOperator * >( instruction.node )->isNotIn();
+  if ( needle.type == Value::Null )
+  {
+    result.setNull();
+    return;
+  }
+
+  // same comparisons as QgsExpressionNodeInOperator::evalNode(), the needle is only converted when needed
+  const bool needleIsDoubleSafe = needle.isInteger() || needle.type == Value::Double || ( ( needle.type == Value::String || needle.type == Value::Variant ) && QgsExpressionUtils::isDoubleSafe( needle.toVariant() ) );
+  bool hasDouble = false;
+  double needleDouble = 0;
+  bool hasString = false;
+  QString needleString;
+  bool listHasNull = false;
+
+  const QVector< InValue > &values = mInLists.at( instruction.b );
+  for ( const InValue &value : values )
+  {
+    if ( value.isNull )
+    {
+      listHasNull = true;
+      continue;
+    }
+
+    bool equal = false;
+    if ( needleIsDoubleSafe && value.isDoubleSafe )
+    {
+      if ( !hasDouble )
+      {
+        needleDouble = needle.isFiniteNumber() ? needle.toDouble() : QgsExpressionUtils::getDoubleValue( needle.toVariant(), parent );
+        if ( parent->hasEvalError() )
+          return;
+        hasDouble = true;
+      }
+      equal = qgsDoubleNear( needleDouble, value.doubleValue );
+    }
+    else
+    {
+      if ( !hasString )
+      {
+        needleString = needle.type == Value::String ? needle.stringValue : needle.toVariant().toString();
+        hasString = true;
+      }
+      equal = needleString == value.stringValue;
+    }
+
+    if ( equal )
+    {
+      setTvl( result, notIn ? QgsExpressionUtils::False : QgsExpressionUtils::True );
+      return;
+    }
+  }
+
+  if ( listHasNull )
+    result.setNull();
+  else
+    setTvl( result, notIn ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+}
+
+void QgsExpressionProgram::evalFunction( const FunctionCall &call, QgsExpressionNodeFunction *node, Value *const *columns, int row, Value &result, QgsExpression *parent, const QgsExpressionContext *context )
+{
+  // coalesce handles NULL arguments itself
+  if ( call.function == Coalesce )
+  {
+    for ( int arg : call.args )
+    {
+      const Value &value = columns[ arg ][ row ];
+      if ( value.type != Value::Null )
+      {
+        result = value;
+        return;
+      }
+    }
+    result.setNull();
+    return;
+  }
+
+  // other functions return NULL for a NULL argument, see QgsExpressionFunction::run()
+  const Value &value = columns[ call.args.at( 0 ) ][ row ];
+  if ( value.type == Value::Null )
+  {
+    result.setNull();
+    return;
+  }
+
+  switch ( call.function )
+  {
+    case Abs:
+    case Sqrt:
+    case Floor:
+    case Ceil:
+    case ToReal:
+    {
+      if ( !value.isFiniteNumber() )
+        break;
+
+      const double x = value.toDouble();
+      if ( call.function == Abs )
+        result.setDouble( std::fabs( x ) );
+      else if ( call.function == Sqrt )
+        result.setDouble( std::sqrt( x ) );
+      else if ( call.function == Floor )
+        result.setDouble( std::floor( x ) );
+      else if ( call.function == Ceil )
+        result.setDouble( std::ceil( x ) );
+      else
+        result.setDouble( x );
+      return;
+    }
+
+    case Lower:
+    case Upper:
+    case Trim:
+      if ( value.type != Value::String )
+        break;
+
+      if ( call.function == Lower )
+        result.setString( value.stringValue.toLower() );
+      else if ( call.function == Upper )
+        result.setString( value.stringValue.toUpper() );
+      else
+        result.setString( value.stringValue.trimmed() );
+      return;
+
+    case Coalesce:
+      break;
+  }
+
+  // let the function convert other values and report errors
+  QgsExpressionFunction *function = QgsExpression::Functions()[ node->fnIndex() ];
+  result.setVariant( function->func( QVariantList() << value.toVariant(), context, parent, node ) );
+}
+
+bool QgsExpressionProgram::isOverridden( const Instruction &instruction, const QgsExpressionContext *context ) const
+{
+  return instruction.opCode == Function && context && context->hasFunction( mFunctionCalls.at( instruction.a ).name );
+}
+
+void QgsExpressionProgram::execute( const Instruction &instruction, Value *const *columns, int row, QgsExpression *parent, const QgsExpressionContext *context )
+{
+  switch ( instruction.opCode )
+  {
+    case Not:
+      setTvl( columns[ instruction.result ][ row ], QgsExpressionUtils::NOT[ tvl( columns[ instruction.a ][ row ], parent ) ] );
+      break;
+
+    case Negate:
+      evalNegate( columns[ instruction.a ][ row ], columns[ instruction.result ][ row ], parent );
+      break;
+
+    case Binary:
+      evalBinary( static_cast< BinaryNode * >( instruction.node ), columns[ instruction.a ][ row ], columns[ instruction.b ][ row ], columns[ instruction.result ][ row ], parent, context );
+      break;
+
+    case In:
+      evalIn( instruction, columns[ instruction.a ][ row ], columns[ instruction.result ][ row ], parent );
+      break;
+
+    case Function:
+      evalFunction( mFunctionCalls.at( instruction.a ), static_cast< QgsExpressionNodeFunction * >( instruction.node ), columns, row, columns[ instruction.result ][ row ], parent, context );
+      break;
+
+    case Move:
+      columns[ instruction.result ][ row ] = columns[ instruction.a ][ row ];
+      break;
+
+    case LoadColumn:
+    case EvalNode:
+    case Jump:
+    case JumpIfNotTrue:
+    case JumpIfShared:
+    case StoreShared:
+      // these depend on the context feature or the flow of execution, see run() and runBlock()
+      Q_ASSERT( false );
+      break;
+  }
+}
+
+QVariant QgsExpressionProgram::run( QgsExpression *parent, const QgsExpressionContext *context )
+{
+  // the context feature is only looked up once
+  bool featureLoaded = false;
+  bool hasFeature = false;
+  QgsFeature feature;
+
+  Value *registers = mRegisters.data();
+  Value *const *columns = mRegisterColumns.constData();
+  const int count = mInstructions.count();
+  int pc = 0;
+  while ( pc < count )
+  {
+    const Instruction &instruction = mInstructions.at( pc++ );
+    switch ( instruction.opCode )
+    {
+      case LoadColumn:
+        if ( !featureLoaded )
+        {
+          hasFeature = context && context->hasFeature();
+          if ( hasFeature )
+            feature = context->feature();
+          featureLoaded = true;
+        }
+        if ( hasFeature )
+          registers[ instruction.result ].setVariant( feature.attribute( instruction.a ) );
+        else
+          registers[ instruction.result ].setVariant( instruction.node->eval( parent, context ) );
+        continue;
+
+      case EvalNode:
+        registers[ instruction.result ].setVariant( instruction.node->eval( parent, context ) );
+        break;
+
+      case Move:
+        registers[ instruction.result ] = registers[ instruction.a ];
+        continue;
+
+      case Jump:
+        pc = instruction.a;
+        continue;
+
+      case JumpIfNotTrue:
+        if ( tvl( registers[ instruction.a ], parent ) != QgsExpressionUtils::True )
+          pc = instruction.b;
+        break;
+
+      case JumpIfShared:
+        if ( mSharedValues->isActive() )
+        {
+          const QgsExpressionValueCache::Slot &slot = mSharedValues->mSlots.at( instruction.a );
+          if ( slot.generation == mSharedValues->mGeneration )
+          {
+            registers[ instruction.result ].setVariant( slot.value );
+            pc = instruction.b;
+          }
+        }
+        continue;
+
+      case StoreShared:
+        if ( mSharedValues->isActive() )
+        {
+          QgsExpressionValueCache::Slot &slot = mSharedValues->mSlots[ instruction.b ];
+          slot.value = registers[ instruction.a ].toVariant();
+          slot.generation = mSharedValues->mGeneration;
+        }
+        continue;
+
+      case Function:
+        // the arguments were already evaluated, but a function provided by the context may differ
+        if ( isOverridden( instruction, context ) )
+        {
+          registers[ instruction.result ].setVariant( instruction.node->eval( parent, context ) );
+          break;
+        }
+        FALLTHROUGH;
+      case Not:
+      case Negate:
+      case Binary:
+      case In:
+        execute( instruction, columns, 0, parent, context );
+        break;
+    }
+
+    if ( parent->hasEvalError() )
+      return QVariant();
+  }
+
+  return registers[ mResultRegister ].toVariant();
+}
+
+void QgsExpressionProgram::allocateBlock( int rowCount )
+{
+  if ( rowCount <= mBlockSize )
+    return;
+
+  mColumns.resize( mRegisters.count() );
+  mBlockColumns.resize( mRegisters.count() );
+  for ( int i = 0; i < mRegisters.count(); ++i )
+  {
+    mColumns[ i ].fill( mRegisters.at( i ), rowCount );
+    mBlockColumns[ i ] = mColumns[ i ].data();
+  }
+  mBlockSize = rowCount;
+}
+
+QVariantList QgsExpressionProgram::runBlock( QgsExpression *parent, QgsExpressionContext *context, const QgsFeatureList &features )
+{
+  QVariantList results;
+  const int rowCount = features.count();
+  if ( rowCount == 0 )
+    return results;
+
+  allocateBlock( rowCount );
+  Value *const *columns = mBlockColumns.constData();
+  const int count = mInstructions.count();
+
+  // rows the current instruction applies to, rows skipped by a jump wait for its target instruction
+  QVector< int > active( rowCount );
+  std::iota( active.begin(), active.end(), 0 );
+  QVector< QVector< int > > waiting( count + 1 );
+
+  // rows with an error are not evaluated further, the first error is reported
+  QVector< bool > failed( rowCount, false );
+  QString error;
+
+  for ( int pc = 0; pc <= count; ++pc )
+  {
+    if ( !waiting.at( pc ).isEmpty() )
+    {
+      active += waiting.at( pc );
+      waiting[ pc ].clear();
+    }
+    if ( pc == count || active.isEmpty() )
+      continue;
+
+    const Instruction &instruction = mInstructions.at( pc );
+    switch ( instruction.opCode )
+    {
+      case LoadColumn:
+      {
+        Value *column = columns[ instruction.result ];
+        for ( int row : qgsAsConst( active ) )
+          column[ row ].setVariant( features.at( row ).attribute( instruction.a ) );
+        continue;
+      }
+
+      case Jump:
+        waiting[ instruction.a ] += active;
+        active.clear();
+        continue;
+
+      case JumpIfShared:
+      case StoreShared:
+        // the rows of a block are different features, their values can't be shared
+        continue;
+
+      default:
+        break;
+    }
+
+    const bool evalByTree = instruction.opCode == EvalNode || isOverridden( instruction, context );
+    int kept = 0;
+    for ( int i = 0; i < active.count(); ++i )
+    {
+      const int row = active.at( i );
+      bool jump = false;
+      if ( evalByTree )
+      {
+        context->setFeature( features.at( row ) );
+        columns[ instruction.result ][ row ].setVariant( instruction.node->eval( parent, context ) );
+      }
+      else if ( instruction.opCode == JumpIfNotTrue )
+      {
+        jump = tvl( columns[ instruction.a ][ row ], parent ) != QgsExpressionUtils::True;
+      }
+      else
+      {
+        execute( instruction, columns, row, parent, context );
+      }
+
+      if ( parent->hasEvalError() )
+      {
+        if ( error.isNull() )
+          error = parent->evalErrorString();
+        parent->setEvalErrorString( QString() );
+        failed[ row ] = true;
+      }
+      else if ( jump )
+      {
+        waiting[ instruction.b ] << row;
+      }
+      else
+      {
+        active[ kept++ ] = row;
+      }
+    }
+    active.resize( kept );
+  }
+
+  results.reserve( rowCount );
+  const Value *resultColumn = columns[ mResultRegister ];
+  for ( int row = 0; row < rowCount; ++row )
+    results << ( failed.at( row ) ? QVariant() : resultColumn[ row ].toVariant() );
+
+  if ( !error.isNull() )
+    parent->setEvalErrorString( error );
+  return results;
+}
@@ -0,0 +1,305 @@
+/***************************************************************************
+                               qgsexpressionprogram.h
+                             -------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef QGSEXPRESSIONPROGRAM_H
+#define QGSEXPRESSIONPROGRAM_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeature.h"
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+class QgsExpression;
+class QgsExpressionContext;
+class QgsExpressionNode;
+class QgsExpressionNodeBinaryOperator;
+class QgsExpressionNodeFunction;
+
+/**
+ * \ingroup core
+ * \class QgsExpressionValueCache
+ * \brief Values of subexpressions shared by several compiled expressions evaluated for the same feature.
+ *
+ * Expressions compiled with the same cache (see QgsExpression::compile()) look up the values of
+ * their costly subexpressions (function calls, CASE expressions and pattern matching) in the
+ * cache before evaluating them, so that a subexpression used by several expressions is only
+ * evaluated once per feature, e.g. for the filters of all rules of a rule-based renderer.
+ *
+ * The cache is only used between startFeature() and endFeature(), which must be called whenever
+ * the feature or the expression context changes. All expressions using the same cache must be
+ * prepared with the same context.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsExpressionValueCache
+{
+  public:
+
+    //! Discards the values of the previous feature and enables the cache
+    void startFeature() { ++mGeneration; mActive = true; }
+
+    //! Disables the cache, compiled expressions then evaluate all their subexpressions
+    void endFeature() { mActive = false; }
+
+    //! Returns true between startFeature() and endFeature()
+    bool isActive() const { return mActive; }
+
+    //! Returns the number of distinct subexpressions registered by compiled expressions
+    int count() const { return mSlots.count(); }
+
+  private:
+
+    struct Slot
+    {
+      //! Value is valid if it matches the generation of the cache
+      quint64 generation = 0;
+      QVariant value;
+    };
+
+    QHash< QString, int > mSlotIndexes;
+    QVector< Slot > mSlots;
+    quint64 mGeneration = 0;
+    bool mActive = false;
+
+    //! Returns the index of the slot of the subexpression with the text \a key
+    int slot( const QString &key );
+
+    friend class QgsExpressionProgram;
+};
+
+/**
+ * \ingroup core
+ * \class QgsExpressionProgram
+ * \brief An expression tree compiled to a flat list of instructions.
+ *
+ * Evaluating an expression tree recursively calls the virtual eval() method of its nodes
+ * and boxes every intermediate result in a QVariant. A program instead runs a flat list
+ * of instructions over a set of registers holding unboxed integer, double and string
+ * values. The feature of the expression context is only looked up once per evaluation,
+ * and attributes are read using the field indexes found when the expression was prepared.
+ *
+ * Operators, conditions, IN lists of static values, column references, common math and
+ * string functions and the static values found when the expression was prepared are
+ * compiled to instructions. Other functions and column references which could not be
+ * resolved are evaluated by the expression tree.
+ * Operators on values which are not numbers or strings (e.g. dates, intervals or arrays)
+ * pass their operands as QVariants to the same code the expression tree uses, so running a
+ * program always gives the same result as evaluating the tree.
+ *
+ * A program can also be run over a block of features at once with runBlock(). Each
+ * register then holds a column of values, one per feature, and every instruction
+ * is applied to all features of the block before the next instruction runs.
+ *
+ * Identical subexpressions are only evaluated once, and CASE conditions which are static are
+ * resolved when compiling. Subexpressions can also be shared with other programs using a
+ * QgsExpressionValueCache.
+ *
+ * Programs are created by QgsExpression::compile().
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsExpressionProgram
+{
+  public:
+
+    /**
+     * Compiles the expression tree starting at \a rootNode. The tree must outlive
+     * the program, as parts of it may be evaluated by the tree interpreter.
+     * If \a sharedValues is set, the values of costly subexpressions are shared
+     * with the other programs using the same cache, which must outlive the program.
+     */
+    explicit QgsExpressionProgram( QgsExpressionNode *rootNode, QgsExpressionValueCache *sharedValues = nullptr );
+
+    /**
+     * Runs the program with the specified \a context and returns the result.
+     * Errors are reported to \a parent in the same way as when evaluating the expression tree.
+     *
+     * \note running the same program from multiple threads at the same time is not supported
+     */
+    QVariant run( QgsExpression *parent, const QgsExpressionContext *context );
+
+    /**
+     * Runs the program for each of the \a features and returns the results in the same order.
+     * Attributes are read from the features directly. The \a context is only used for the parts of
+     * the expression evaluated by the expression tree, its feature is changed to the feature
+     * being evaluated when needed.
+     *
+     * Features for which an error occurs get a NULL result, the first error is reported to \a parent.
+     *
+     * \note running the same program from multiple threads at the same time is not supported
+     */
+    QVariantList runBlock( QgsExpression *parent, QgsExpressionContext *context, const QgsFeatureList &features );
+
+    //! Returns the number of instructions of the program
+    int instructionCount() const { return mInstructions.count(); }
+
+    //! Returns the number of instructions which evaluate part of the expression tree
+    int fallbackCount() const;
+
+  private:
+
+    //! Register value
+    struct Value
+    {
+      enum Type
+      {
+        Null, //!< NULL value, a typed NULL is kept in variant
+        Int, //!< Integer stored as QVariant::Int
+        LongLong, //!< Integer stored as QVariant::LongLong
+        Double,
+        String,
+        Variant, //!< Any other value, kept in variant
+      };
+
+      Type type = Null;
+      qlonglong intValue = 0;
+      double doubleValue = 0;
+      QString stringValue;
+      QVariant variant;
+
+      void setNull() { type = Null; variant = QVariant(); }
+      void setLongLong( qlonglong value ) { type = LongLong; intValue = value; }
+      void setDouble( double value ) { type = Double; doubleValue = value; }
+      void setString( const QString &value ) { type = String; stringValue = value; }
+      void setVariant( const QVariant &value );
+      QVariant toVariant() const;
+
+      bool isInteger() const { return type == Int || type == LongLong; }
+      //! Returns true for integers and finite doubles
+      bool isFiniteNumber() const;
+      double toDouble() const { return type == Double ? doubleValue : static_cast< double >( intValue ); }
+    };
+
+    enum OpCode
+    {
+      LoadColumn, //!< Loads attribute a of the context feature
+      EvalNode, //!< Evaluates the node with the expression tree
+      Not, //!< Logical NOT of register a
+      Negate, //!< Negates register a
+      Binary, //!< Applies the binary operator of node to registers a and b
+      In, //!< Looks up register a in IN list b
+      Move, //!< Copies register a
+      Jump, //!< Continues with instruction a
+      JumpIfNotTrue, //!< Continues with instruction b unless register a is true
+      Function, //!< Calls the native implementation of function call a
+      JumpIfShared, //!< Loads the value of shared slot a and continues with instruction b if it is cached
+      StoreShared, //!< Stores register a in shared slot b
+    };
+
+    //! Functions with a native implementation
+    enum NativeFunction
+    {
+      Abs,
+      Sqrt,
+      Floor,
+      Ceil,
+      ToReal,
+      Lower,
+      Upper,
+      Trim,
+      Coalesce,
+    };
+
+    struct FunctionCall
+    {
+      NativeFunction function;
+      //! Function name, used to check whether the context overrides the function
+      QString name;
+      //! Registers holding the evaluated arguments
+      QVector< int > args;
+    };
+
+    struct Instruction
+    {
+      OpCode opCode;
+      //! Register receiving the result
+      int result;
+      int a;
+      int b;
+      //! Node the instruction was compiled from
+      QgsExpressionNode *node;
+    };
+
+    //! Static value of an IN list
+    struct InValue
+    {
+      bool isNull = false;
+      bool isDoubleSafe = false;
+      double doubleValue = 0;
+      QString stringValue;
+    };
+
+    QVector< Instruction > mInstructions;
+    QVector< Value > mRegisters;
+    QVector< QVector< InValue > > mInLists;
+    QVector< FunctionCall > mFunctionCalls;
+    int mResultRegister = -1;
+    QgsExpressionValueCache *mSharedValues = nullptr;
+
+    //! Registers of the subexpressions compiled so far, by text. A scope is added for code which may be skipped.
+    QList< QHash< QString, int > > mSubexpressions;
+
+    //! Pointers to each register, so that run() can share code with runBlock() using a block of one row
+    QVector< Value * > mRegisterColumns;
+
+    //! Register columns used by runBlock(), constant registers are filled with their value
+    QVector< QVector< Value > > mColumns;
+    QVector< Value * > mBlockColumns;
+    int mBlockSize = 0;
+
+    //! Compiles \a node, or reuses an identical subexpression, and returns the register receiving its value
+    int compileNode( QgsExpressionNode *node );
+    //! Compiles the operation of \a node
+    int compileOperation( QgsExpressionNode *node );
+    //! Compiles an IN operator, returns -1 if it must be evaluated by the tree
+    int compileIn( QgsExpressionNode *node );
+    //! Compiles a CASE condition
+    int compileCondition( QgsExpressionNode *node );
+    //! Compiles a call to a function with a native implementation, returns -1 if there is none
+    int compileFunction( QgsExpressionNode *node );
+    //! Adds a register initialized to \a value and returns its index
+    int addConstant( const QVariant &value );
+    //! Adds an instruction writing to a new register and returns the register
+    int addInstruction( OpCode opCode, int a, int b, QgsExpressionNode *node );
+    //! Adds a jump instruction and returns its index
+    int addJump( OpCode opCode, int a, int b );
+    //! Adds an instruction copying register \a source to register \a target
+    void addMove( int source, int target );
+
+    static int tvl( const Value &value, QgsExpression *parent );
+    static void setTvl( Value &value, int tvl );
+    static void evalBinary( QgsExpressionNodeBinaryOperator *node, const Value &left, const Value &right, Value &result, QgsExpression *parent, const QgsExpressionContext *context );
+    static void evalNegate( const Value &operand, Value &result, QgsExpression *parent );
+    void evalIn( const Instruction &instruction, const Value &needle, Value &result, QgsExpression *parent );
+    static void evalFunction( const FunctionCall &call, QgsExpressionNodeFunction *node, Value *const *columns, int row, Value &result, QgsExpression *parent, const QgsExpressionContext *context );
+
+    //! Returns true if the function called by \a instruction is overridden by the context and must be evaluated by the tree
+    bool isOverridden( const Instruction &instruction, const QgsExpressionContext *context ) const;
+
+    //! Executes an instruction which does not jump or access the context feature for \a row of the register \a columns
+    void execute( const Instruction &instruction, Value *const *columns, int row, QgsExpression *parent, const QgsExpressionContext *context );
+
+    //! Makes sure the register columns can hold \a rowCount rows
+    void allocateBlock( int rowCount );
+};
+
+#endif // QGSEXPRESSIONPROGRAM_H
@@ -244,12 +244,10 @@ void QgsGeometry::fromWkb( unsigned char *wkb, int length )
 {
   detach( false );
 
-  if ( d->geometry )
-  {
-    delete d->geometry;
-  }
+  // if the geometry is not shared, its storage is recycled when the WKB has the same type
   QgsConstWkbPtr ptr( wkb, length );
-  d->geometry = QgsGeometryFactory::geomFromWkb( ptr ).release();
+  std::unique_ptr< QgsAbstractGeometry > previous( d->geometry );
+  d->geometry = QgsGeometryFactory::geomFromWkb( ptr, std::move( previous ) ).release();
   delete [] wkb;
 }
 
@@ -257,12 +255,10 @@ void QgsGeometry::fromWkb( const QByteArray &wkb )
 {
   detach( false );
 
-  if ( d->geometry )
-  {
-    delete d->geometry;
-  }
+  // if the geometry is not shared, its storage is recycled when the WKB has the same type
   QgsConstWkbPtr ptr( wkb );
-  d->geometry = QgsGeometryFactory::geomFromWkb( ptr ).release();
+  std::unique_ptr< QgsAbstractGeometry > previous( d->geometry );
+  d->geometry = QgsGeometryFactory::geomFromWkb( ptr, std::move( previous ) ).release();
 }
 
 GEOSGeometry *QgsGeometry::exportToGeos( double precision ) const
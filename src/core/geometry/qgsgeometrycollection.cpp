@@ -214,13 +214,24 @@ bool QgsGeometryCollection::fromWkb( QgsConstWkbPtr &wkbPtr )
   mGeometries.clear();
   for ( int i = 0; i < nGeometries; ++i )
   {
-    std::unique_ptr< QgsAbstractGeometry > geom( QgsGeometryFactory::geomFromWkb( wkbPtr ) );  // also updates wkbPtr
+    // parts of the same type are recycled, keeping their coordinate storage
+    std::unique_ptr< QgsAbstractGeometry > previous;
+    if ( i < geometryListBackup.size() )
+    {
+      previous.reset( geometryListBackup.at( i ) );
+      geometryListBackup[i] = nullptr;
+    }
+
+    std::unique_ptr< QgsAbstractGeometry > geom( QgsGeometryFactory::geomFromWkb( wkbPtr, std::move( previous ) ) );  // also updates wkbPtr
     if ( geom )
     {
       if ( !addGeometry( geom.release() ) )
       {
+        // recycled parts are lost, restore the remaining ones
         qDeleteAll( mGeometries );
+        geometryListBackup.removeAll( nullptr );
         mGeometries = geometryListBackup;
+        clearCache();
         return false;
       }
     }
@@ -32,6 +32,11 @@
 #include "qgslogger.h"
 
 std::unique_ptr<QgsAbstractGeometry> QgsGeometryFactory::geomFromWkb( QgsConstWkbPtr &wkbPtr )
+{
+  return geomFromWkb( wkbPtr, nullptr );
+}
+
+std::unique_ptr<QgsAbstractGeometry> QgsGeometryFactory::geomFromWkb( QgsConstWkbPtr &wkbPtr, std::unique_ptr<QgsAbstractGeometry> previous )
 {
   if ( !wkbPtr )
     return nullptr;
@@ -50,7 +55,11 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeometryFactory::geomFromWkb( QgsConstWk
   }
   wkbPtr -= 1 + sizeof( int );
 
-  std::unique_ptr< QgsAbstractGeometry > geom = geomFromWkbType( type );
+  std::unique_ptr< QgsAbstractGeometry > geom;
+  if ( previous && previous->wkbType() == type )
+    geom = std::move( previous );
+  else
+    geom = geomFromWkbType( type );
 
   if ( geom )
   {
@@ -59,6 +59,17 @@ class CORE_EXPORT QgsGeometryFactory
      */
     static std::unique_ptr< QgsAbstractGeometry > geomFromWkb( QgsConstWkbPtr &wkb );
 
+    /**
+     * Construct geometry from a WKB string, recycling the \a previous geometry if it
+     * has the same type as the WKB. Recycled geometries keep their parts and coordinate
+     * storage, which avoids most of the memory allocations when decoding many geometries
+     * of the same type in a row (e.g. when iterating over features). If the types differ,
+     * \a previous is deleted and a new geometry is created.
+     * Updates position of the passed WKB pointer.
+     * \since QGIS 3.0
+     */
+    static std::unique_ptr< QgsAbstractGeometry > geomFromWkb( QgsConstWkbPtr &wkb, std::unique_ptr< QgsAbstractGeometry > previous );
+
     /**
      * Construct geometry from a WKT string.
      */
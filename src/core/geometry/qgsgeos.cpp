@@ -99,7 +99,8 @@ class GEOSInit
     GEOSInit &operator=( const GEOSInit &rh ) = delete;
 };
 
-static GEOSInit geosinit;
+// each thread uses its own GEOS context, so that geometry operations can run in parallel
+static thread_local GEOSInit geosinit;
 
 ///@endcond
 
@@ -641,6 +641,21 @@ QgsLineString *QgsLineString::reversed() const
  * See details in QEP #17
  ****************************************************************************/
 
+QPolygonF QgsLineString::asQPolygonF() const
+{
+  // read the coordinate arrays directly instead of going through xAt()/yAt() for every vertex
+  const int nb = mX.size();
+  QPolygonF points( nb );
+  const double *x = mX.constData();
+  const double *y = mY.constData();
+  QPointF *dest = points.data();
+  for ( int i = 0; i < nb; ++i )
+  {
+    *dest++ = QPointF( *x++, *y++ );
+  }
+  return points;
+}
+
 void QgsLineString::draw( QPainter &p ) const
 {
   p.drawPolyline( asQPolygonF() );
@@ -745,12 +760,34 @@ void QgsLineString::transform( const QgsCoordinateTransform &ct, QgsCoordinateTr
 void QgsLineString::transform( const QTransform &t )
 {
   int nPoints = numPoints();
-  for ( int i = 0; i < nPoints; ++i )
+  double *x = mX.data();
+  double *y = mY.data();
+  if ( t.isAffine() )
+  {
+    // avoid QTransform::map() checking the transform type again for every vertex
+    const double m11 = t.m11();
+    const double m12 = t.m12();
+    const double m21 = t.m21();
+    const double m22 = t.m22();
+    const double dx = t.dx();
+    const double dy = t.dy();
+    for ( int i = 0; i < nPoints; ++i )
+    {
+      const double srcX = x[i];
+      const double srcY = y[i];
+      x[i] = m11 * srcX + m21 * srcY + dx;
+      y[i] = m12 * srcX + m22 * srcY + dy;
+    }
+  }
+  else
   {
-    qreal x, y;
-    t.map( mX.at( i ), mY.at( i ), &x, &y );
-    mX[i] = x;
-    mY[i] = y;
+    for ( int i = 0; i < nPoints; ++i )
+    {
+      qreal tx, ty;
+      t.map( x[i], y[i], &tx, &ty );
+      x[i] = tx;
+      y[i] = ty;
+    }
   }
   clearCache();
 }
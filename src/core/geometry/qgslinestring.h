@@ -83,6 +83,47 @@ class CORE_EXPORT QgsLineString: public QgsCurve
     double xAt( int index ) const override;
     double yAt( int index ) const override;
 
+#ifndef SIP_RUN
+
+    /**
+     * Returns a const pointer to the x vertex data, which can be used for
+     * reading all x-coordinates of the line string in bulk.
+     * The pointer is only valid until the line string is modified.
+     * \note Not available in Python bindings
+     * \see yData()
+     * \since QGIS 3.0
+     */
+    const double *xData() const { return mX.constData(); }
+
+    /**
+     * Returns a const pointer to the y vertex data, which can be used for
+     * reading all y-coordinates of the line string in bulk.
+     * The pointer is only valid until the line string is modified.
+     * \note Not available in Python bindings
+     * \see xData()
+     * \since QGIS 3.0
+     */
+    const double *yData() const { return mY.constData(); }
+
+    /**
+     * Returns a const pointer to the z vertex data, or a nullptr if the line string does
+     * not have z values. The pointer is only valid until the line string is modified.
+     * \note Not available in Python bindings
+     * \see xData()
+     * \since QGIS 3.0
+     */
+    const double *zData() const { return mZ.isEmpty() ? nullptr : mZ.constData(); }
+
+    /**
+     * Returns a const pointer to the m vertex data, or a nullptr if the line string does
+     * not have m values. The pointer is only valid until the line string is modified.
+     * \note Not available in Python bindings
+     * \see xData()
+     * \since QGIS 3.0
+     */
+    const double *mData() const { return mM.isEmpty() ? nullptr : mM.constData(); }
+#endif
+
     /**
      * Returns the z-coordinate of the specified node in the line string.
      * \param index index of node, where the first node in the line is 0
@@ -205,6 +246,8 @@ class CORE_EXPORT QgsLineString: public QgsCurve
     int nCoordinates() const override;
     void points( QgsPointSequence &pt SIP_OUT ) const override;
 
+    QPolygonF asQPolygonF() const override;
+
     void draw( QPainter &p ) const override;
 
     void transform( const QgsCoordinateTransform &ct, QgsCoordinateTransform::TransformDirection d = QgsCoordinateTransform::ForwardTransform,
@@ -22,6 +22,8 @@
 #include "qgsmultilinestring.h"
 #include "qgswkbptr.h"
 
+#include <vector>
+
 QgsPolygonV2::QgsPolygonV2()
 {
   mWkbType = QgsWkbTypes::Polygon;
@@ -45,6 +47,14 @@ void QgsPolygonV2::clear()
 
 bool QgsPolygonV2::fromWkb( QgsConstWkbPtr &wkbPtr )
 {
+  // keep the current rings aside, so that their coordinate storage can be reused
+  std::vector< std::unique_ptr< QgsCurve > > previousRings;
+  if ( mExteriorRing )
+    previousRings.emplace_back( std::move( mExteriorRing ) );
+  for ( QgsCurve *ring : qgsAsConst( mInteriorRings ) )
+    previousRings.emplace_back( ring );
+  mInteriorRings.clear();
+
   clear();
   if ( !wkbPtr )
   {
@@ -82,7 +92,11 @@ bool QgsPolygonV2::fromWkb( QgsConstWkbPtr &wkbPtr )
   wkbPtr >> nRings;
   for ( int i = 0; i < nRings; ++i )
   {
-    std::unique_ptr< QgsLineString > line( new QgsLineString() );
+    std::unique_ptr< QgsLineString > line;
+    if ( i < static_cast< int >( previousRings.size() ) && qgsgeometry_cast< QgsLineString * >( previousRings[i].get() ) )
+      line.reset( static_cast< QgsLineString * >( previousRings[i].release() ) );
+    else
+      line.reset( new QgsLineString() );
     line->fromWkbPoints( ringType, wkbPtr );
     /*if ( !line->isRing() )
     {
@@ -0,0 +1,248 @@
+/***************************************************************************
+                         qgswkbgeometryview.cpp
+                         ----------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswkbgeometryview.h"
+#include "qgsapplication.h"
+#include "qgslogger.h"
+#include "qgswkbptr.h"
+
+#include <cstring>
+#include <limits>
+
+QgsWkbGeometryView::QgsWkbGeometryView( const QByteArray &wkb )
+  : mWkb( wkb )
+{
+  if ( mWkb.isEmpty() )
+    return;
+
+  QgsConstWkbPtr wkbPtr( mWkb );
+  try
+  {
+    mWkbType = wkbPtr.readHeader();
+    wkbPtr -= 1 + sizeof( int );
+    mValid = indexGeometry( wkbPtr, 0, true );
+  }
+  catch ( const QgsWkbException &e )
+  {
+    Q_UNUSED( e );
+    QgsDebugMsg( "WKB exception while indexing geometry: " + e.what() );
+    mValid = false;
+  }
+
+  if ( !mValid )
+  {
+    mSequences.clear();
+    mPartCount = 0;
+    mVertexCount = 0;
+  }
+  else if ( !QgsWkbTypes::isMultiType( mWkbType ) )
+  {
+    mPartCount = 1;
+  }
+}
+
+bool QgsWkbGeometryView::indexGeometry( QgsConstWkbPtr &wkbPtr, int part, bool allowCollections )
+{
+  if ( wkbPtr.remaining() < 1 )
+    return false;
+
+  const bool endianSwap = *static_cast< const unsigned char * >( wkbPtr ) != QgsApplication::endian();
+  const QgsWkbTypes::Type type = wkbPtr.readHeader();
+  const int dimensions = QgsWkbTypes::coordDimensions( type );
+
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+      return addSequence( wkbPtr, part, 0, 1, dimensions, endianSwap, false );
+
+    case QgsWkbTypes::LineString:
+    {
+      int nVertices = 0;
+      wkbPtr >> nVertices;
+      return addSequence( wkbPtr, part, 0, nVertices, dimensions, endianSwap, false );
+    }
+
+    case QgsWkbTypes::Polygon:
+    case QgsWkbTypes::Triangle:
+    {
+      int nRings = 0;
+      wkbPtr >> nRings;
+      for ( int ring = 0; ring < nRings; ++ring )
+      {
+        int nVertices = 0;
+        wkbPtr >> nVertices;
+        if ( !addSequence( wkbPtr, part, ring, nVertices, dimensions, endianSwap, true ) )
+          return false;
+      }
+      return true;
+    }
+
+    case QgsWkbTypes::MultiPoint:
+    case QgsWkbTypes::MultiLineString:
+    case QgsWkbTypes::MultiPolygon:
+    case QgsWkbTypes::GeometryCollection:
+    {
+      if ( !allowCollections )
+        return false;
+
+      int nParts = 0;
+      wkbPtr >> nParts;
+      for ( int i = 0; i < nParts; ++i )
+      {
+        if ( !indexGeometry( wkbPtr, i, false ) )
+          return false;
+      }
+      mPartCount = nParts;
+      return true;
+    }
+
+    default:
+      // curved geometries can't be viewed as point sequences
+      return false;
+  }
+}
+
+bool QgsWkbGeometryView::addSequence( QgsConstWkbPtr &wkbPtr, int part, int ring, int vertexCount, int dimensions, bool endianSwap, bool isRing )
+{
+  const int vertexSize = dimensions * static_cast< int >( sizeof( double ) );
+  if ( vertexCount < 0 || vertexCount > wkbPtr.remaining() / vertexSize )
+    return false;
+
+  Sequence sequence;
+  sequence.part = part;
+  sequence.ring = ring;
+  sequence.vertexCount = vertexCount;
+  sequence.offset = static_cast< int >( static_cast< const unsigned char * >( wkbPtr ) - reinterpret_cast< const unsigned char * >( mWkb.constData() ) );
+  sequence.dimensions = dimensions;
+  sequence.endianSwap = endianSwap;
+  sequence.isRing = isRing;
+  mSequences << sequence;
+  mVertexCount += vertexCount;
+
+  wkbPtr += vertexCount * vertexSize;
+  return true;
+}
+
+double QgsWkbGeometryView::coordinate( int offset, bool endianSwap ) const
+{
+  double value;
+  memcpy( &value, mWkb.constData() + offset, sizeof( double ) );
+  if ( endianSwap )
+    QgsApplication::endian_swap( value );
+  return value;
+}
+
+QgsRectangle QgsWkbGeometryView::boundingBox() const
+{
+  if ( mHasBoundingBox )
+    return mBoundingBox;
+
+  double xmin = std::numeric_limits<double>::max();
+  double ymin = std::numeric_limits<double>::max();
+  double xmax = -std::numeric_limits<double>::max();
+  double ymax = -std::numeric_limits<double>::max();
+
+  for ( const Sequence &sequence : mSequences )
+  {
+    const int vertexSize = sequence.dimensions * static_cast< int >( sizeof( double ) );
+    int offset = sequence.offset;
+    for ( int i = 0; i < sequence.vertexCount; ++i, offset += vertexSize )
+    {
+      const double x = coordinate( offset, sequence.endianSwap );
+      const double y = coordinate( offset + sizeof( double ), sequence.endianSwap );
+      if ( x < xmin )
+        xmin = x;
+      if ( x > xmax )
+        xmax = x;
+      if ( y < ymin )
+        ymin = y;
+      if ( y > ymax )
+        ymax = y;
+    }
+  }
+
+  mBoundingBox = xmin <= xmax && ymin <= ymax ? QgsRectangle( xmin, ymin, xmax, ymax ) : QgsRectangle();
+  mHasBoundingBox = true;
+  return mBoundingBox;
+}
+
+QPointF QgsWkbGeometryView::vertexAt( int index, int vertex ) const
+{
+  const Sequence &sequence = mSequences.at( index );
+  Q_ASSERT( vertex >= 0 && vertex < sequence.vertexCount );
+  const int offset = sequence.offset + vertex * sequence.dimensions * static_cast< int >( sizeof( double ) );
+  return QPointF( coordinate( offset, sequence.endianSwap ), coordinate( offset + sizeof( double ), sequence.endianSwap ) );
+}
+
+QPolygonF QgsWkbGeometryView::points( int index ) const
+{
+  const Sequence &sequence = mSequences.at( index );
+  const int vertexSize = sequence.dimensions * static_cast< int >( sizeof( double ) );
+
+  QPolygonF points( sequence.vertexCount );
+  QPointF *point = points.data();
+  int offset = sequence.offset;
+  for ( int i = 0; i < sequence.vertexCount; ++i, ++point, offset += vertexSize )
+  {
+    point->rx() = coordinate( offset, sequence.endianSwap );
+    point->ry() = coordinate( offset + sizeof( double ), sequence.endianSwap );
+  }
+  return points;
+}
+
+bool QgsWkbGeometryView::contains( double x, double y ) const
+{
+  if ( !boundingBox().contains( QgsPointXY( x, y ) ) )
+    return false;
+
+  // even-odd rule over all rings of a polygon, so that holes are excluded
+  bool inside = false;
+  int currentPart = -1;
+  for ( int index = 0; index < mSequences.count(); ++index )
+  {
+    const Sequence &sequence = mSequences.at( index );
+    if ( !sequence.isRing || sequence.vertexCount < 3 )
+      continue;
+
+    if ( sequence.part != currentPart )
+    {
+      if ( inside )
+        return true;
+      currentPart = sequence.part;
+    }
+
+    QPointF previous = vertexAt( index, sequence.vertexCount - 1 );
+    for ( int i = 0; i < sequence.vertexCount; ++i )
+    {
+      const QPointF current = vertexAt( index, i );
+      if ( ( current.y() > y ) != ( previous.y() > y ) &&
+           x < ( previous.x() - current.x() ) * ( y - current.y() ) / ( previous.y() - current.y() ) + current.x() )
+      {
+        inside = !inside;
+      }
+      previous = current;
+    }
+  }
+  return inside;
+}
+
+QgsGeometry QgsWkbGeometryView::geometry() const
+{
+  QgsGeometry geometry;
+  if ( !mWkb.isEmpty() )
+    geometry.fromWkb( mWkb );
+  return geometry;
+}
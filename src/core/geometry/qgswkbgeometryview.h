@@ -0,0 +1,149 @@
+/***************************************************************************
+                         qgswkbgeometryview.h
+                         --------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSWKBGEOMETRYVIEW_H
+#define QGSWKBGEOMETRYVIEW_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsgeometry.h"
+#include "qgsrectangle.h"
+#include "qgswkbtypes.h"
+
+#include <QByteArray>
+#include <QPolygonF>
+#include <QVector>
+
+class QgsConstWkbPtr;
+
+/**
+ * \ingroup core
+ * \class QgsWkbGeometryView
+ * \brief A lightweight read-only view of a geometry stored as WKB.
+ *
+ * The view does not decode the geometry into QgsAbstractGeometry objects. Instead it
+ * indexes where the point sequences (points, line strings and polygon rings) start in
+ * the WKB, so that the bounding box, the vertices and point-in-polygon tests can be
+ * computed directly from the WKB buffer, which is shared and not copied. This is
+ * sufficient for many read-only paths (e.g. rendering and identifying features), and
+ * the full geometry is only decoded when geometry() is called.
+ *
+ * Only linear geometry types (points, line strings, polygons, triangles and collections of
+ * these) can be viewed. For other types isValid() returns false, but geometry() still works.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsWkbGeometryView
+{
+  public:
+
+    //! A sequence of vertices stored in the WKB (a point, a line string or a polygon ring)
+    struct Sequence
+    {
+      //! Index of the geometry part containing the sequence
+      int part = 0;
+      //! Index of the ring within a polygon (0 for the exterior ring and for points and lines)
+      int ring = 0;
+      //! Number of vertices
+      int vertexCount = 0;
+      //! Byte offset of the first coordinate in the WKB
+      int offset = 0;
+      //! Number of coordinates per vertex (2, 3 or 4)
+      int dimensions = 2;
+      //! Whether the coordinates need their byte order swapped
+      bool endianSwap = false;
+      //! Whether the sequence is a polygon ring
+      bool isRing = false;
+    };
+
+    //! Constructs an invalid view
+    QgsWkbGeometryView() = default;
+
+    /**
+     * Constructs a view of the geometry stored in \a wkb. The WKB data are implicitly shared.
+     */
+    explicit QgsWkbGeometryView( const QByteArray &wkb );
+
+    /**
+     * Returns true if the WKB could be indexed, i.e. it is complete and of a linear type.
+     */
+    bool isValid() const { return mValid; }
+
+    //! Returns the WKB type of the geometry, or QgsWkbTypes::Unknown if the WKB header is invalid
+    QgsWkbTypes::Type wkbType() const { return mWkbType; }
+
+    //! Returns the WKB the view was constructed from
+    QByteArray wkb() const { return mWkb; }
+
+    //! Returns the number of parts (1 for single part geometries)
+    int partCount() const { return mPartCount; }
+
+    //! Returns the number of vertex sequences (points, line strings and polygon rings)
+    int sequenceCount() const { return mSequences.count(); }
+
+    //! Returns the vertex sequence at \a index
+    const Sequence &sequence( int index ) const { return mSequences.at( index ); }
+
+    //! Returns the total number of vertices
+    int vertexCount() const { return mVertexCount; }
+
+    /**
+     * Returns the bounding box of the geometry. It is calculated from the WKB when first requested.
+     */
+    QgsRectangle boundingBox() const;
+
+    //! Returns the x and y coordinates of the \a vertex of the sequence at \a index
+    QPointF vertexAt( int index, int vertex ) const;
+
+    /**
+     * Returns the x and y coordinates of all vertices of the sequence at \a index,
+     * e.g. for passing them to QgsClipper or symbol layers.
+     */
+    QPolygonF points( int index ) const;
+
+    /**
+     * Returns true if the point at \a x, \a y lies within any polygon part of the geometry
+     * (taking holes into account). Always returns false for points and lines.
+     */
+    bool contains( double x, double y ) const;
+
+    /**
+     * Decodes the WKB and returns the full geometry.
+     */
+    QgsGeometry geometry() const;
+
+  private:
+
+    QByteArray mWkb;
+    QgsWkbTypes::Type mWkbType = QgsWkbTypes::Unknown;
+    bool mValid = false;
+    int mPartCount = 0;
+    int mVertexCount = 0;
+    QVector< Sequence > mSequences;
+    mutable QgsRectangle mBoundingBox;
+    mutable bool mHasBoundingBox = false;
+
+    //! Indexes the geometry at wkbPtr as part \a part, nested collections are only accepted if \a allowCollections is true
+    bool indexGeometry( QgsConstWkbPtr &wkbPtr, int part, bool allowCollections );
+    //! Adds a sequence starting at the current position of wkbPtr and moves wkbPtr past it
+    bool addSequence( QgsConstWkbPtr &wkbPtr, int part, int ring, int vertexCount, int dimensions, bool endianSwap, bool isRing );
+    //! Reads the coordinate at the given byte offset
+    double coordinate( int offset, bool endianSwap ) const;
+};
+
+#endif // QGSWKBGEOMETRYVIEW_H
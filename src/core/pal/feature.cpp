@@ -40,6 +40,7 @@
 #include "qgsmessagelog.h"
 #include "costcalculator.h"
 #include "qgsgeometryutils.h"
+#include "qgslabelingengine.h"
 #include <QLinkedList>
 #include <cmath>
 #include <cfloat>
@@ -1514,6 +1515,21 @@ int FeaturePart::createCandidatesForPolygon( QList< LabelPosition *> &lPos, Poin
 int FeaturePart::createCandidates( QList< LabelPosition *> &lPos,
                                    double bboxMin[2], double bboxMax[2],
                                    PointSet *mapShape, RTree<LabelPosition *, double, 2, double> *candidates )
+{
+  generateCandidates( lPos, bboxMin, bboxMax, mapShape );
+
+  Q_FOREACH ( LabelPosition *pos, lPos )
+  {
+    pos->insertIntoIndex( candidates );
+  }
+
+  std::sort( lPos.begin(), lPos.end(), CostCalculator::candidateSortGrow );
+  return lPos.count();
+}
+
+int FeaturePart::generateCandidates( QList< LabelPosition *> &lPos,
+                                     double bboxMin[2], double bboxMax[2],
+                                     PointSet *mapShape )
 {
   double bbox[4];
 
@@ -1528,7 +1544,7 @@ int FeaturePart::createCandidates( QList< LabelPosition *> &lPos,
   {
     lPos << new LabelPosition( 0, mLF->fixedPosition().x(), mLF->fixedPosition().y(), getLabelWidth(), getLabelHeight(), angle, 0.0, this );
   }
-  else
+  else if ( !createCandidateFromPreviousPlacement( lPos ) )
   {
     switch ( type )
     {
@@ -1588,16 +1604,42 @@ int FeaturePart::createCandidates( QList< LabelPosition *> &lPos,
       i.remove();
       delete pos;
     }
-    else   // this one is OK
-    {
-      pos->insertIntoIndex( candidates );
-    }
   }
 
-  std::sort( lPos.begin(), lPos.end(), CostCalculator::candidateSortGrow );
   return lPos.count();
 }
 
+bool FeaturePart::createCandidateFromPreviousPlacement( QList<LabelPosition *> &lPos )
+{
+  const QList< QgsLabelPlacementCache::Placement > placements = mLF->previousPlacements();
+  if ( placements.isEmpty() || mLF->layer()->isCurved() )
+    return false;
+
+  QString providerId = mLF->provider() ? mLF->provider()->providerId() : QString();
+  double labelW = getLabelWidth();
+  double labelH = getLabelHeight();
+  double tolerance = std::max( labelW, labelH ) * 1E-6;
+
+  Q_FOREACH ( const QgsLabelPlacementCache::Placement &placement, placements )
+  {
+    // the feature part or its label have changed since the previous render
+    if ( placement.providerId != providerId
+         || !qgsDoubleNear( placement.width, labelW, tolerance )
+         || !qgsDoubleNear( placement.height, labelH, tolerance )
+         || !qgsDoubleNear( placement.partExtent.xMinimum(), xmin, tolerance )
+         || !qgsDoubleNear( placement.partExtent.yMinimum(), ymin, tolerance )
+         || !qgsDoubleNear( placement.partExtent.xMaximum(), xmax, tolerance )
+         || !qgsDoubleNear( placement.partExtent.yMaximum(), ymax, tolerance ) )
+      continue;
+
+    // obstacle costs are added again when the candidates costs are finalized
+    lPos << new LabelPosition( 0, placement.x, placement.y, labelW, labelH, placement.angle, 0.0, this,
+                               placement.reversed, static_cast< LabelPosition::Quadrant >( placement.quadrant ) );
+    return true;
+  }
+  return false;
+}
+
 void FeaturePart::addSizePenalty( int nbp, QList< LabelPosition * > &lPos, double bbx[4], double bby[4] )
 {
   if ( !mGeos )
@@ -138,6 +138,30 @@ namespace pal
        */
       int createCandidates( QList<LabelPosition *> &lPos, double bboxMin[2], double bboxMax[2], PointSet *mapShape, RTree<LabelPosition *, double, 2, double> *candidates );
 
+      /**
+       * Generates label candidates for the feature, without inserting them into a candidate index
+       * and without sorting them by cost (i.e. lPos is left in the order in which createCandidates()
+       * inserts the candidates into the index).
+       * \param lPos pointer to an array of candidates, will be filled by generated candidates
+       * \param bboxMin min values of the map extent
+       * \param bboxMax max values of the map extent
+       * \param mapShape generate candidates for this spatial entity
+       * \returns the number of candidates generated in lPos
+       * \see createCandidates()
+       * \since QGIS 3.0
+       */
+      int generateCandidates( QList<LabelPosition *> &lPos, double bboxMin[2], double bboxMax[2], PointSet *mapShape );
+
+      /**
+       * Recreates the label position placed for this feature part in a previous render, if the
+       * feature part and its label did not change since then.
+       * \param lPos pointer to an array of candidates, will be filled by the recreated candidate
+       * \returns true if a candidate was created
+       * \see QgsLabelFeature::previousPlacements()
+       * \since QGIS 3.0
+       */
+      bool createCandidateFromPreviousPlacement( QList<LabelPosition *> &lPos );
+
       /**
        * Generate candidates for point feature, located around a specified point.
        * \param x x coordinate of the point
@@ -86,6 +86,9 @@ void Pal::removeLayer( Layer *layer )
   mMutex.lock();
   if ( QgsAbstractLabelProvider *key = mLayers.key( layer, nullptr ) )
   {
+    if ( mPreparedLayers.contains( layer ) )
+      deleteLayerCandidates( mPreparedLayers.take( layer ).second );
+
     mLayers.remove( key );
     delete layer;
   }
@@ -97,6 +100,10 @@ Pal::~Pal()
 
   mMutex.lock();
 
+  for ( QHash< Layer *, QPair< QgsRectangle, LayerCandidates * > >::const_iterator it = mPreparedLayers.constBegin(); it != mPreparedLayers.constEnd(); ++it )
+    deleteLayerCandidates( it.value().second );
+  mPreparedLayers.clear();
+
   qDeleteAll( mLayers );
   mLayers.clear();
   mMutex.unlock();
@@ -122,8 +129,8 @@ typedef struct _featCbackCtx
 {
   Layer *layer = nullptr;
   QLinkedList<Feats *> *fFeats;
-  RTree<FeaturePart *, double, 2, double> *obstacles;
-  RTree<LabelPosition *, double, 2, double> *candidates;
+  QList<LabelPosition *> *indexOrder;
+  QList<FeaturePart *> *obstacles;
   double bbox_min[2];
   double bbox_max[2];
 } FeatCallBackCtx;
@@ -137,14 +144,12 @@ typedef struct _featCbackCtx
  */
 bool extractFeatCallback( FeaturePart *ft_ptr, void *ctx )
 {
-  double amin[2], amax[2];
   FeatCallBackCtx *context = reinterpret_cast< FeatCallBackCtx * >( ctx );
 
   // Holes of the feature are obstacles
   for ( int i = 0; i < ft_ptr->getNumSelfObstacles(); i++ )
   {
-    ft_ptr->getSelfObstacle( i )->getBoundingBox( amin, amax );
-    context->obstacles->Insert( amin, amax, ft_ptr->getSelfObstacle( i ) );
+    context->obstacles->append( ft_ptr->getSelfObstacle( i ) );
 
     if ( !ft_ptr->getSelfObstacle( i )->getHoleOf() )
     {
@@ -154,8 +159,12 @@ bool extractFeatCallback( FeaturePart *ft_ptr, void *ctx )
 
   // generate candidates for the feature part
   QList< LabelPosition * > lPos;
-  if ( ft_ptr->createCandidates( lPos, context->bbox_min, context->bbox_max, ft_ptr, context->candidates ) )
+  if ( ft_ptr->generateCandidates( lPos, context->bbox_min, context->bbox_max, ft_ptr ) )
   {
+    // candidates are indexed in order of generation, but kept sorted by cost
+    context->indexOrder->append( lPos );
+    std::sort( lPos.begin(), lPos.end(), CostCalculator::candidateSortGrow );
+
     // valid features are added to fFeats
     Feats *ft = new Feats();
     ft->feature = ft_ptr;
@@ -173,12 +182,6 @@ bool extractFeatCallback( FeaturePart *ft_ptr, void *ctx )
   return true;
 }
 
-typedef struct _obstaclebackCtx
-{
-  RTree<FeaturePart *, double, 2, double> *obstacles;
-  int obstacleCount;
-} ObstacleCallBackCtx;
-
 /*
  * Callback function
  *
@@ -186,13 +189,8 @@ typedef struct _obstaclebackCtx
  */
 bool extractObstaclesCallback( FeaturePart *ft_ptr, void *ctx )
 {
-  double amin[2], amax[2];
-  ObstacleCallBackCtx *context = reinterpret_cast< ObstacleCallBackCtx * >( ctx );
-
-  // insert into obstacles
-  ft_ptr->getBoundingBox( amin, amax );
-  context->obstacles->Insert( amin, amax, ft_ptr );
-  context->obstacleCount++;
+  QList<FeaturePart *> *obstacles = reinterpret_cast< QList<FeaturePart *> * >( ctx );
+  obstacles->append( ft_ptr );
   return true;
 }
 
@@ -250,26 +248,12 @@ Problem *Pal::extract( double lambda_min, double phi_min, double lambda_max, dou
 
   QLinkedList<Feats *> *fFeats = new QLinkedList<Feats *>;
 
-  FeatCallBackCtx context;
-  context.fFeats = fFeats;
-  context.obstacles = obstacles;
-  context.candidates = prob->candidates;
-  context.bbox_min[0] = amin[0];
-  context.bbox_min[1] = amin[1];
-  context.bbox_max[0] = amax[0];
-  context.bbox_max[1] = amax[1];
-
-  ObstacleCallBackCtx obstacleContext;
-  obstacleContext.obstacles = obstacles;
-  obstacleContext.obstacleCount = 0;
-
   // first step : extract features from layers
 
-  int previousFeatureCount = 0;
-  int previousObstacleCount = 0;
-
   QStringList layersWithFeaturesInBBox;
 
+  const QgsRectangle extent( lambda_min, phi_min, lambda_max, phi_max );
+
   mMutex.lock();
   Q_FOREACH ( Layer *layer, mLayers )
   {
@@ -283,28 +267,39 @@ Problem *Pal::extract( double lambda_min, double phi_min, double lambda_max, dou
     if ( !layer->active() )
       continue;
 
-    // check for connected features with the same label text and join them
-    if ( layer->mergeConnectedLines() )
-      layer->joinConnectedFeatures();
-
-    layer->chopFeaturesAtRepeatDistance();
-
-    layer->mMutex.lock();
-
-    // find features within bounding box and generate candidates list
-    context.layer = layer;
-    layer->mFeatureIndex->Search( amin, amax, extractFeatCallback, static_cast< void * >( &context ) );
-    // find obstacles within bounding box
-    layer->mObstacleIndex->Search( amin, amax, extractObstaclesCallback, static_cast< void * >( &obstacleContext ) );
+    // reuse candidates if they were already generated for this extent
+    LayerCandidates *layerCandidates = nullptr;
+    if ( mPreparedLayers.contains( layer ) )
+    {
+      QPair< QgsRectangle, LayerCandidates * > prepared = mPreparedLayers.take( layer );
+      if ( prepared.first == extent )
+        layerCandidates = prepared.second;
+      else
+        deleteLayerCandidates( prepared.second );
+    }
+    if ( !layerCandidates )
+    {
+      layerCandidates = new LayerCandidates();
+      extractLayer( layer, amin, amax, *layerCandidates );
+    }
 
-    layer->mMutex.unlock();
+    Q_FOREACH ( FeaturePart *obstacle, layerCandidates->obstacles )
+    {
+      double omin[2], omax[2];
+      obstacle->getBoundingBox( omin, omax );
+      obstacles->Insert( omin, omax, obstacle );
+    }
+    Q_FOREACH ( LabelPosition *candidate, layerCandidates->indexOrder )
+    {
+      candidate->insertIntoIndex( prob->candidates );
+    }
 
-    if ( context.fFeats->size() - previousFeatureCount > 0 || obstacleContext.obstacleCount > previousObstacleCount )
+    if ( !layerCandidates->features.isEmpty() || !layerCandidates->obstacles.isEmpty() )
     {
       layersWithFeaturesInBBox << layer->name();
     }
-    previousFeatureCount = context.fFeats->size();
-    previousObstacleCount = obstacleContext.obstacleCount;
+    *fFeats += layerCandidates->features;
+    delete layerCandidates;
   }
   mMutex.unlock();
 
@@ -448,6 +443,59 @@ Problem *Pal::extract( double lambda_min, double phi_min, double lambda_max, dou
   return prob;
 }
 
+void Pal::extractLayer( Layer *layer, double amin[2], double amax[2], LayerCandidates &result )
+{
+  // check for connected features with the same label text and join them
+  if ( layer->mergeConnectedLines() )
+    layer->joinConnectedFeatures();
+
+  layer->chopFeaturesAtRepeatDistance();
+
+  FeatCallBackCtx context;
+  context.layer = layer;
+  context.fFeats = &result.features;
+  context.indexOrder = &result.indexOrder;
+  context.obstacles = &result.obstacles;
+  context.bbox_min[0] = amin[0];
+  context.bbox_min[1] = amin[1];
+  context.bbox_max[0] = amax[0];
+  context.bbox_max[1] = amax[1];
+
+  layer->mMutex.lock();
+
+  // find features within bounding box and generate candidates list
+  layer->mFeatureIndex->Search( amin, amax, extractFeatCallback, static_cast< void * >( &context ) );
+  // find obstacles within bounding box
+  layer->mObstacleIndex->Search( amin, amax, extractObstaclesCallback, static_cast< void * >( &result.obstacles ) );
+
+  layer->mMutex.unlock();
+}
+
+void Pal::prepareLayer( Layer *layer, double bbox[4] )
+{
+  if ( !layer || !layer->active() )
+    return;
+
+  double amin[2] = { bbox[0], bbox[1] };
+  double amax[2] = { bbox[2], bbox[3] };
+
+  LayerCandidates *candidates = new LayerCandidates();
+  extractLayer( layer, amin, amax, *candidates );
+
+  mMutex.lock();
+  if ( mPreparedLayers.contains( layer ) )
+    deleteLayerCandidates( mPreparedLayers.take( layer ).second );
+  mPreparedLayers.insert( layer, qMakePair( QgsRectangle( bbox[0], bbox[1], bbox[2], bbox[3] ), candidates ) );
+  mMutex.unlock();
+}
+
+void Pal::deleteLayerCandidates( LayerCandidates *candidates )
+{
+  qDeleteAll( candidates->indexOrder );
+  qDeleteAll( candidates->features );
+  delete candidates;
+}
+
 /*
  * BIG MACHINE
  */
@@ -523,12 +571,8 @@ QList<LabelPosition *> *Pal::solveProblem( Problem *prob, bool displayAll )
 
   try
   {
-    if ( searchMethod == FALP )
-      prob->init_sol_falp();
-    else if ( searchMethod == CHAIN )
-      prob->chain_search();
-    else
-      prob->popmusic();
+    if ( !mParallelSolver || !prob->solveComponents() )
+      prob->solve();
   }
   catch ( InternalException::Empty )
   {
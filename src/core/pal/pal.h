@@ -37,6 +37,8 @@
 #include "qgsgeometry.h"
 #include "qgspallabeling.h"
 #include <QList>
+#include <QHash>
+#include <QLinkedList>
 #include <iostream>
 #include <ctime>
 #include <QMutex>
@@ -53,6 +55,8 @@ namespace pal
 
   class Layer;
   class LabelPosition;
+  class FeaturePart;
+  class Feats;
   class PalStat;
   class Problem;
   class PointSet;
@@ -150,8 +154,24 @@ namespace pal
       //! Check whether the job has been canceled
       inline bool isCanceled() { return fnIsCanceled ? fnIsCanceled( fnIsCanceledContext ) : false; }
 
+      /**
+       * Extracts the labeling problem for the given bounding box. Candidates of layers
+       * which were prepared for the same bounding box using prepareLayer() are reused.
+       */
       Problem *extractProblem( double bbox[4] );
 
+      /**
+       * Generates the label candidates of a single \a layer for the bounding box \a bbox
+       * ahead of extractProblem(). All features of the layer must already be registered.
+       *
+       * Candidate generation does not depend on other layers, so this may be called
+       * from any thread while features are still being registered to other layers.
+       * extractProblem() then only needs to evaluate the prepared candidates against
+       * the obstacles of all layers.
+       * \since QGIS 3.0
+       */
+      void prepareLayer( Layer *layer, double bbox[4] );
+
       QList<LabelPosition *> *solveProblem( Problem *prob, bool displayAll );
 
       /**
@@ -168,6 +188,21 @@ namespace pal
        */
       bool getShowPartial();
 
+      /**
+       * Sets whether the problem should be split into independent sub-problems
+       * (groups of mutually conflicting features) which are solved in parallel.
+       * Candidates of the same rank are then taken by id, so the placements may differ
+       * slightly from the ones of the default solver.
+       * \since QGIS 3.0
+       */
+      void setParallelSolver( bool parallel ) { mParallelSolver = parallel; }
+
+      /**
+       * Returns whether independent sub-problems are solved in parallel.
+       * \since QGIS 3.0
+       */
+      bool parallelSolver() const { return mParallelSolver; }
+
       /**
        * \brief set # candidates to generate for points features
        * Higher the value is, longer Pal::labeller will spend time
@@ -226,8 +261,22 @@ namespace pal
 
     private:
 
+      //! Label candidates and obstacles of a layer within a bounding box
+      struct LayerCandidates
+      {
+        //! Extracted features with their candidates (sorted by cost)
+        QLinkedList<Feats *> features;
+        //! All candidates, in the order in which they are inserted into the candidate index
+        QList<LabelPosition *> indexOrder;
+        //! Obstacles (including holes of the features), in the order in which they are inserted into the obstacle index
+        QList<FeaturePart *> obstacles;
+      };
+
       QHash< QgsAbstractLabelProvider *, Layer * > mLayers;
 
+      //! Candidates generated by prepareLayer(), with the bounding box they were generated for
+      QHash< Layer *, QPair< QgsRectangle, LayerCandidates * > > mPreparedLayers;
+
       QMutex mMutex;
 
       /**
@@ -264,6 +313,9 @@ namespace pal
        */
       bool showPartial;
 
+      //! Whether independent parts of the problem are solved in parallel
+      bool mParallelSolver = false;
+
       //! Callback that may be called from PAL to check whether the job has not been canceled in meanwhile
       FnIsCanceled fnIsCanceled;
       //! Application-specific context for the cancelation check function
@@ -281,6 +333,15 @@ namespace pal
       Problem *extract( double lambda_min, double phi_min,
                         double lambda_max, double phi_max );
 
+      /**
+       * Extracts the features of \a layer within the bounding box (\a amin, \a amax),
+       * generates their label candidates and collects the obstacles of the layer into \a result.
+       */
+      void extractLayer( Layer *layer, double amin[2], double amax[2], LayerCandidates &result );
+
+      //! Deletes the candidates of a layer which were not used in a problem
+      static void deleteLayerCandidates( LayerCandidates *candidates );
+
 
       /**
        * \brief Choose the size of popmusic subpart's
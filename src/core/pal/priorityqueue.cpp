@@ -45,10 +45,11 @@ bool bigger( double l, double r )
 }
 
 // O (size log size)
-PriorityQueue::PriorityQueue( int n, int maxId, bool min )
+PriorityQueue::PriorityQueue( int n, int maxId, bool min, bool orderEqualByKey )
   : size( 0 )
   , maxsize( n )
   , maxId( maxId )
+  , orderEqualByKey( orderEqualByKey )
 {
   heap = new int[maxsize];
   p = new double[maxsize];
@@ -66,6 +67,13 @@ PriorityQueue::PriorityQueue( int n, int maxId, bool min )
     greater = bigger;
 }
 
+bool PriorityQueue::after( int i, int j ) const
+{
+  if ( !orderEqualByKey || p[i] != p[j] )
+    return greater( p[i], p[j] );
+  return heap[i] > heap[j];
+}
+
 PriorityQueue::~PriorityQueue()
 {
   delete[] heap;
@@ -183,7 +191,7 @@ void PriorityQueue::upheap( int key )
   {
     while ( i > 0 )
     {
-      if ( greater( p[PARENT( i )], p[i] ) )
+      if ( after( PARENT( i ), i ) )
       {
         i2 = PARENT( i );
 
@@ -220,7 +228,7 @@ void PriorityQueue::downheap( int id )
     {
       if ( RIGHT( id ) < size )
       {
-        min_child = greater( p[RIGHT( id )], p[LEFT( id )] ) ? LEFT( id ) : RIGHT( id );
+        min_child = after( RIGHT( id ), LEFT( id ) ) ? LEFT( id ) : RIGHT( id );
       }
       else
         min_child = LEFT( id );
@@ -228,7 +236,7 @@ void PriorityQueue::downheap( int id )
     else // leaf
       break;
 
-    if ( greater( p[id], p[min_child] ) )
+    if ( after( id, min_child ) )
     {
       pos[heap[id]] = min_child;
       pos[heap[min_child]] = id;
@@ -58,8 +58,10 @@ namespace pal
        * \\param n max size of the queuet
        * \\param p external vector representing the priority
        * \\param min best element has the smalest p when min is True ans has the biggest when min is false
+       * \\param orderEqualByKey elements with the same priority are returned by increasing key when true,
+       * otherwise their order depends on the history of the heap
        */
-      PriorityQueue( int n, int maxId, bool min );
+      PriorityQueue( int n, int maxId, bool min, bool orderEqualByKey = false );
       ~PriorityQueue();
 
       //! PriorityQueue cannot be copied.
@@ -97,8 +99,15 @@ namespace pal
       int *heap = nullptr;
       double *p = nullptr;
       int *pos = nullptr;
+      bool orderEqualByKey = false;
 
       bool ( *greater )( double l, double r );
+
+      /**
+       * Returns true if the element at heap position \a i comes after the element at position \a j.
+       * Elements with the same priority are ordered by key if orderEqualByKey is set.
+       */
+      bool after( int i, int j ) const;
   };
 
 } // namespace
@@ -43,6 +43,8 @@
 
 #include "qgslabelingengine.h"
 
+#include <QtConcurrentMap>
+
 using namespace pal;
 
 inline void delete_chain( Chain *chain )
@@ -271,7 +273,9 @@ void Problem::init_sol_falp()
 
   init_sol_empty();
 
-  list = new PriorityQueue( nblp, all_nblp, true );
+  // when solving in parallel, candidates of the same rank are taken by id, so that splitting the problem
+  // into groups of conflicting features does not change the placements
+  list = new PriorityQueue( nblp, all_nblp, true, pal->parallelSolver() );
 
   double amin[2];
   double amax[2];
@@ -2228,6 +2232,210 @@ bool Problem::compareLabelArea( pal::LabelPosition *l1, pal::LabelPosition *l2 )
   return l1->getWidth() * l1->getHeight() > l2->getWidth() * l2->getHeight();
 }
 
+void Problem::solve()
+{
+  if ( pal->searchMethod == FALP )
+    init_sol_falp();
+  else if ( pal->searchMethod == CHAIN )
+    chain_search();
+  else
+    popmusic();
+}
+
+typedef struct
+{
+  LabelPosition *lp = nullptr;
+  QVector<int> *parent = nullptr;
+} ComponentContext;
+
+static int findComponent( QVector<int> &parent, int feat )
+{
+  while ( parent[feat] != feat )
+  {
+    parent[feat] = parent[parent[feat]];
+    feat = parent[feat];
+  }
+  return feat;
+}
+
+static bool joinComponentsCallback( LabelPosition *lp, void *ctx )
+{
+  ComponentContext *context = reinterpret_cast< ComponentContext * >( ctx );
+  LabelPosition *lp2 = context->lp;
+
+  int root1 = findComponent( *context->parent, lp->getProblemFeatureId() );
+  int root2 = findComponent( *context->parent, lp2->getProblemFeatureId() );
+  if ( root1 != root2 && lp2->isInConflict( lp ) )
+  {
+    // always keep the smallest feature id as root, so that the split is deterministic
+    ( *context->parent )[ qMax( root1, root2 )] = qMin( root1, root2 );
+  }
+  return true;
+}
+
+//! A group of conflicting features solved as an independent problem
+struct ProblemComponent
+{
+  QVector<int> features;
+  Problem *problem = nullptr;
+  bool failed = false;
+};
+
+static void solveComponent( ProblemComponent &component )
+{
+  try
+  {
+    component.problem->solve();
+  }
+  catch ( InternalException::Empty )
+  {
+    component.failed = true;
+  }
+}
+
+Problem *Problem::createSubProblem( const QVector<int> &features )
+{
+  Problem *sub = new Problem();
+  sub->pal = pal;
+  sub->displayAll = displayAll;
+  sub->nbft = features.count();
+  for ( int i = 0; i < 4; ++i )
+    sub->bbox[i] = bbox[i];
+
+  sub->featStartId = new int[ sub->nbft ];
+  sub->featNbLp = new int[ sub->nbft ];
+  sub->inactiveCost = new double[ sub->nbft ];
+
+  double amin[2];
+  double amax[2];
+  int id = 0;
+  for ( int i = 0; i < sub->nbft; ++i )
+  {
+    int feat = features.at( i );
+    sub->featStartId[i] = id;
+    sub->featNbLp[i] = featNbLp[feat];
+    sub->inactiveCost[i] = inactiveCost[feat];
+
+    for ( int j = 0; j < featNbLp[feat]; ++j, ++id )
+    {
+      LabelPosition *lp = mLabelPositions.at( featStartId[feat] + j );
+      lp->setProblemIds( i, id );
+      lp->getBoundingBox( amin, amax );
+      sub->candidates->Insert( amin, amax, lp );
+      sub->mLabelPositions.append( lp );
+      sub->nbOverlap += lp->getNumOverlaps();
+    }
+  }
+  sub->nblp = id;
+  sub->all_nblp = id;
+  sub->nbOverlap /= 2;
+  return sub;
+}
+
+bool Problem::solveComponents()
+{
+  if ( nbft < 2 )
+    return false;
+
+  // union features whose active candidates conflict with each other
+  QVector<int> parent( nbft );
+  for ( int i = 0; i < nbft; ++i )
+    parent[i] = i;
+
+  ComponentContext context;
+  context.parent = &parent;
+  double amin[2];
+  double amax[2];
+  for ( int i = 0; i < nbft; ++i )
+  {
+    for ( int j = 0; j < featNbLp[i]; ++j )
+    {
+      context.lp = mLabelPositions.at( featStartId[i] + j );
+      context.lp->getBoundingBox( amin, amax );
+      candidates->Search( amin, amax, joinComponentsCallback, reinterpret_cast< void * >( &context ) );
+    }
+    if ( pal->isCanceled() )
+      return false;
+  }
+
+  // collect components, each with ascending feature ids
+  QList< ProblemComponent > components;
+  QHash< int, int > componentIndex;
+  for ( int i = 0; i < nbft; ++i )
+  {
+    int root = findComponent( parent, i );
+    if ( !componentIndex.contains( root ) )
+    {
+      componentIndex.insert( root, components.count() );
+      components.append( ProblemComponent() );
+    }
+    components[ componentIndex.value( root )].features.append( i );
+  }
+
+  if ( components.count() < 2 )
+    return false;
+
+  init_sol_empty();
+  sol->cost = 0;
+
+  // a feature without any conflict keeps its best candidate
+  QList< ProblemComponent > subProblems;
+  Q_FOREACH ( const ProblemComponent &component, components )
+  {
+    if ( component.features.count() == 1 )
+    {
+      int feat = component.features.at( 0 );
+      if ( featNbLp[feat] > 0 )
+      {
+        sol->s[feat] = featStartId[feat];
+        sol->cost += mLabelPositions.at( featStartId[feat] )->cost();
+      }
+      else
+      {
+        sol->cost += inactiveCost[feat];
+      }
+    }
+    else
+    {
+      ProblemComponent sub = component;
+      sub.problem = createSubProblem( component.features );
+      subProblems.append( sub );
+    }
+  }
+
+  QtConcurrent::blockingMap( subProblems, solveComponent );
+
+  bool failed = false;
+  Q_FOREACH ( const ProblemComponent &component, subProblems )
+  {
+    Problem *sub = component.problem;
+    failed |= component.failed;
+
+    for ( int i = 0; i < component.features.count(); ++i )
+    {
+      int feat = component.features.at( i );
+      int lpId = !component.failed && sub->sol ? sub->sol->s[i] : -1;
+      sol->s[feat] = lpId == -1 ? -1 : featStartId[feat] + lpId - sub->featStartId[i];
+
+      // restore the ids of the candidates within this problem
+      for ( int j = 0; j < featNbLp[feat]; ++j )
+        mLabelPositions.at( featStartId[feat] + j )->setProblemIds( feat, featStartId[feat] + j );
+    }
+
+    if ( sub->sol )
+      sol->cost += sub->sol->cost;
+
+    // candidates are owned by this problem
+    sub->mLabelPositions.clear();
+    delete sub;
+  }
+
+  if ( failed )
+    throw InternalException::Empty();
+
+  return true;
+}
+
 QList<LabelPosition *> *Problem::getSolution( bool returnInactive )
 {
 
@@ -36,6 +36,7 @@
 #include "qgis_core.h"
 #include <list>
 #include <QList>
+#include <QVector>
 #include "rtree.hpp"
 
 namespace pal
@@ -150,6 +151,21 @@ namespace pal
        */
       void chain_search();
 
+      /**
+       * Solves the problem using the search method of the associated Pal.
+       * \since QGIS 3.0
+       */
+      void solve();
+
+      /**
+       * Splits the problem into groups of features whose candidates conflict with each other
+       * (connected components of the conflict graph) and solves these independent
+       * sub-problems in parallel. The solution does not depend on the number of threads used.
+       * Returns false if the problem cannot be split, in which case no solution is computed.
+       * \since QGIS 3.0
+       */
+      bool solveComponents();
+
       QList<LabelPosition *> *getSolution( bool returnInactive );
 
       PalStat *getStats();
@@ -253,6 +269,13 @@ namespace pal
 
       void solution_cost();
       void check_solution();
+
+      /**
+       * Creates a sub-problem containing the active candidates of \a features (ascending
+       * feature ids of this problem). Candidates are renumbered for the sub-problem but
+       * remain owned by this problem.
+       */
+      Problem *createSubProblem( const QVector<int> &features );
   };
 
 } // namespace
@@ -24,6 +24,7 @@
 #include "qgsrasterlayer.h"
 #include "qgsgeometry.h"
 #include "qgsgeometryengine.h"
+#include "qgsstaticspatialindex.h"
 #include "qgswkbtypes.h"
 
 #include <functional>
@@ -873,6 +874,27 @@ QVariantMap QgsExtractByExpressionAlgorithm::processAlgorithm( const QVariantMap
     // saving non-matching features, so we need EVERYTHING
     expressionContext.setFields( source->fields() );
     expression.prepare( &expressionContext );
+    expression.compile();
+
+    // the expression is evaluated for blocks of features
+    const int blockSize = 1000;
+    QgsFeatureList block;
+    auto processBlock = [&]
+    {
+      const QVariantList results = expression.evaluate( &expressionContext, block );
+      for ( int i = 0; i < block.count(); ++i )
+      {
+        if ( results.at( i ).toBool() )
+        {
+          matchingSink->addFeature( block[ i ], QgsFeatureSink::FastInsert );
+        }
+        else
+        {
+          nonMatchingSink->addFeature( block[ i ], QgsFeatureSink::FastInsert );
+        }
+      }
+      block.clear();
+    };
 
     QgsFeatureIterator it = source->getFeatures();
     QgsFeature f;
@@ -883,19 +905,15 @@ QVariantMap QgsExtractByExpressionAlgorithm::processAlgorithm( const QVariantMap
         break;
       }
 
-      expressionContext.setFeature( f );
-      if ( expression.evaluate( &expressionContext ).toBool() )
-      {
-        matchingSink->addFeature( f, QgsFeatureSink::FastInsert );
-      }
-      else
-      {
-        nonMatchingSink->addFeature( f, QgsFeatureSink::FastInsert );
-      }
+      block << f;
+      if ( block.count() == blockSize )
+        processBlock();
 
       feedback->setProgress( current * step );
       current++;
     }
+    if ( !feedback->isCanceled() )
+      processBlock();
   }
 
 
@@ -1070,6 +1088,27 @@ QVariantMap QgsExtractByAttributeAlgorithm::processAlgorithm( const QVariantMap
     // saving non-matching features, so we need EVERYTHING
     expressionContext.setFields( source->fields() );
     expression.prepare( &expressionContext );
+    expression.compile();
+
+    // the expression is evaluated for blocks of features
+    const int blockSize = 1000;
+    QgsFeatureList block;
+    auto processBlock = [&]
+    {
+      const QVariantList results = expression.evaluate( &expressionContext, block );
+      for ( int i = 0; i < block.count(); ++i )
+      {
+        if ( results.at( i ).toBool() )
+        {
+          matchingSink->addFeature( block[ i ], QgsFeatureSink::FastInsert );
+        }
+        else
+        {
+          nonMatchingSink->addFeature( block[ i ], QgsFeatureSink::FastInsert );
+        }
+      }
+      block.clear();
+    };
 
     QgsFeatureIterator it = source->getFeatures();
     QgsFeature f;
@@ -1080,19 +1119,15 @@ QVariantMap QgsExtractByAttributeAlgorithm::processAlgorithm( const QVariantMap
         break;
       }
 
-      expressionContext.setFeature( f );
-      if ( expression.evaluate( &expressionContext ).toBool() )
-      {
-        matchingSink->addFeature( f, QgsFeatureSink::FastInsert );
-      }
-      else
-      {
-        nonMatchingSink->addFeature( f, QgsFeatureSink::FastInsert );
-      }
+      block << f;
+      if ( block.count() == blockSize )
+        processBlock();
 
       feedback->setProgress( current * step );
       current++;
     }
+    if ( !feedback->isCanceled() )
+      processBlock();
   }
 
 
@@ -2042,7 +2077,7 @@ QVariantMap QgsLineIntersectionAlgorithm::processAlgorithm( const QVariantMap &p
   if ( !sourceA )
     return QVariantMap();
 
-  std::unique_ptr< QgsFeatureSource > sourceB( parameterAsSource( parameters, QStringLiteral( "INTERSECT" ), context ) );
+  std::unique_ptr< QgsProcessingFeatureSource > sourceB( parameterAsSource( parameters, QStringLiteral( "INTERSECT" ), context ) );
   if ( !sourceB )
     return QVariantMap();
 
@@ -2104,7 +2139,13 @@ QVariantMap QgsLineIntersectionAlgorithm::processAlgorithm( const QVariantMap &p
   if ( !sink )
     return QVariantMap();
 
-  QgsSpatialIndex spatialIndex( sourceB->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ).setDestinationCrs( sourceA->sourceCrs() ) ), feedback );
+  // the index of sourceB can be reused from previous runs if it does not need to be transformed
+  const QgsStaticSpatialIndex spatialIndex = sourceB->sourceCrs() == sourceA->sourceCrs()
+      ? sourceB->createStaticSpatialIndex( feedback )
+      : QgsStaticSpatialIndex( sourceB->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ).setDestinationCrs( sourceA->sourceCrs() ) ), feedback );
+  if ( !spatialIndex.isValid() )
+    throw QgsProcessingException( QObject::tr( "Could not build a spatial index of the intersect layer, it has too many features." ) );
+
   QgsFeature outFeature;
   QgsFeatureIterator features = sourceA->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( fieldsAIndices ) );
   double step = sourceA->featureCount() > 0 ? 100.0 / sourceA->featureCount() : 1;
@@ -2227,7 +2268,8 @@ QVariantMap QgsSplitWithLinesAlgorithm::processAlgorithm( const QVariantMap &par
   if ( !sink )
     return QVariantMap();
 
-  QgsSpatialIndex spatialIndex;
+  QList< QgsFeatureId > splitIds;
+  QVector< QgsRectangle > splitBounds;
   QMap< QgsFeatureId, QgsGeometry > splitGeoms;
   QgsFeatureRequest request;
   request.setSubsetOfAttributes( QgsAttributeList() );
@@ -2243,8 +2285,15 @@ QVariantMap QgsSplitWithLinesAlgorithm::processAlgorithm( const QVariantMap &par
     }
 
     splitGeoms.insert( aSplitFeature.id(), aSplitFeature.geometry() );
-    spatialIndex.insertFeature( aSplitFeature );
+    if ( aSplitFeature.hasGeometry() )
+    {
+      splitIds << aSplitFeature.id();
+      splitBounds << aSplitFeature.geometry().boundingBox();
+    }
   }
+  const QgsStaticSpatialIndex spatialIndex( splitIds, splitBounds );
+  if ( !spatialIndex.isValid() )
+    throw QgsProcessingException( QObject::tr( "Could not build a spatial index of the split layer, it has too many features." ) );
 
   QgsFeature outFeat;
   QgsFeatureIterator features = source->getFeatures();
@@ -88,6 +88,7 @@ class QgsCentroidAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsCentroidAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
 
   protected:
 
@@ -113,6 +114,7 @@ class QgsTransformAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector general" ); }
     QString shortHelpString() const override;
     QgsTransformAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
 
   protected:
 
@@ -319,6 +321,7 @@ class QgsSubdivideAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsSubdivideAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
 
   protected:
     QString outputName() const override { return QObject::tr( "Subdivided" ); }
@@ -373,6 +376,7 @@ class QgsPromoteToMultipartAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsPromoteToMultipartAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
 
   protected:
     QString outputName() const override { return QObject::tr( "Multiparts" ); }
@@ -421,6 +425,7 @@ class QgsBoundingBoxAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsBoundingBoxAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
 
   protected:
     QString outputName() const override { return QObject::tr( "Bounds" ); }
@@ -445,6 +450,7 @@ class QgsOrientedMinimumBoundingBoxAlgorithm : public QgsProcessingFeatureBasedA
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsOrientedMinimumBoundingBoxAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
 
   protected:
     QString outputName() const override { return QObject::tr( "Bounding boxes" ); }
@@ -470,6 +476,7 @@ class QgsMinimumEnclosingCircleAlgorithm : public QgsProcessingFeatureBasedAlgor
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsMinimumEnclosingCircleAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
 
   protected:
     QString outputName() const override { return QObject::tr( "Minimum enclosing circles" ); }
@@ -498,6 +505,7 @@ class QgsConvexHullAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsConvexHullAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
 
   protected:
     QString outputName() const override { return QObject::tr( "Convex hulls" ); }
@@ -597,6 +605,7 @@ class QgsFixGeometriesAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsFixGeometriesAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
 
   protected:
     QgsProcessingFeatureSource::Flag sourceFlags() const override { return QgsProcessingFeatureSource::FlagSkipGeometryValidityChecks; }
@@ -621,6 +630,7 @@ class QgsMergeLinesAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsMergeLinesAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
 
   protected:
     QString outputName() const override { return QObject::tr( "Merged" ); }
@@ -645,6 +655,7 @@ class QgsSmoothAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsSmoothAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
     void initParameters( const QVariantMap &configuration = QVariantMap() ) override;
 
   protected:
@@ -674,6 +685,7 @@ class QgsSimplifyAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsSimplifyAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatures; }
     void initParameters( const QVariantMap &configuration = QVariantMap() ) override;
 
   protected:
@@ -26,6 +26,13 @@
 #include "qgsexception.h"
 #include "qgsmessagelog.h"
 #include "qgsprocessingfeedback.h"
+#include "qgsvectorfilewriter.h"
+
+#include <QMutex>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#include <algorithm>
 
 QgsProcessingAlgorithm::~QgsProcessingAlgorithm()
 {
@@ -636,10 +643,7 @@ void QgsProcessingFeatureBasedAlgorithm::initAlgorithm( const QVariantMap &confi
 
 QgsCoordinateReferenceSystem QgsProcessingFeatureBasedAlgorithm::sourceCrs() const
 {
-  if ( mSource )
-    return mSource->sourceCrs();
-  else
-    return QgsCoordinateReferenceSystem();
+  return mSourceCrs;
 }
 
 QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
@@ -656,31 +660,175 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   if ( !sink )
     return QVariantMap();
 
+  // writing features in large transactions is much faster for database formats like GeoPackage,
+  // the last transaction is committed by the flushBuffer() call below
+  if ( QgsVectorFileWriter *writer = dynamic_cast< QgsVectorFileWriter * >( sink.get() ) )
+    writer->setTransactionBatchSize( 100000 );
+
+  mSourceCrs = mSource->sourceCrs();
   long count = mSource->featureCount();
 
   QgsFeature f;
   QgsFeatureIterator it = mSource->getFeatures( QgsFeatureRequest(), sourceFlags() );
 
-  double step = count > 0 ? 100.0 / count : 1;
-  int current = 0;
-  while ( it.nextFeature( f ) )
+  if ( !( flags() & FlagSupportsParallelFeatures ) || !processFeaturesInParallel( it, *sink, count, parameters, context, feedback ) )
   {
-    if ( feedback->isCanceled() )
+    double step = count > 0 ? 100.0 / count : 1;
+    int current = 0;
+    while ( it.nextFeature( f ) )
     {
-      break;
-    }
+      if ( feedback->isCanceled() )
+      {
+        break;
+      }
 
-    QgsFeature transformed = processFeature( f, feedback );
-    if ( transformed.isValid() )
-      sink->addFeature( transformed, QgsFeatureSink::FastInsert );
+      QgsFeature transformed = processFeature( f, feedback );
+      if ( transformed.isValid() )
+        sink->addFeature( transformed, QgsFeatureSink::FastInsert );
 
-    feedback->setProgress( current * step );
-    current++;
+      feedback->setProgress( current * step );
+      current++;
+    }
   }
 
   mSource.reset();
+  mSourceCrs = QgsCoordinateReferenceSystem();
+
+  // buffered features which cannot be written must not be lost silently when the sink is destroyed
+  if ( !sink->flushBuffer() )
+    throw QgsProcessingException( QObject::tr( "Could not write features to %1" ).arg( dest ) );
 
   QVariantMap outputs;
   outputs.insert( QStringLiteral( "OUTPUT" ), dest );
   return outputs;
 }
+
+///@cond PRIVATE
+
+/**
+ * Feedback used by the threads of a parallel feature based algorithm. Messages are forwarded
+ * one at a time to the feedback of the algorithm, and cancelation of the algorithm feedback
+ * is propagated.
+ */
+class QgsProcessingParallelFeedback : public QgsProcessingFeedback
+{
+  public:
+
+    explicit QgsProcessingParallelFeedback( QgsProcessingFeedback *feedback )
+      : mFeedback( feedback )
+    {
+      connect( feedback, &QgsFeedback::canceled, this, &QgsFeedback::cancel, Qt::DirectConnection );
+      if ( feedback->isCanceled() )
+        cancel();
+    }
+
+    void setProgressText( const QString &text ) override { QMutexLocker locker( &mMutex ); mFeedback->setProgressText( text ); }
+    void reportError( const QString &error ) override { QMutexLocker locker( &mMutex ); mFeedback->reportError( error ); }
+    void pushInfo( const QString &info ) override { QMutexLocker locker( &mMutex ); mFeedback->pushInfo( info ); }
+    void pushCommandInfo( const QString &info ) override { QMutexLocker locker( &mMutex ); mFeedback->pushCommandInfo( info ); }
+    void pushDebugInfo( const QString &info ) override { QMutexLocker locker( &mMutex ); mFeedback->pushDebugInfo( info ); }
+    void pushConsoleInfo( const QString &info ) override { QMutexLocker locker( &mMutex ); mFeedback->pushConsoleInfo( info ); }
+
+  private:
+
+    QgsProcessingFeedback *mFeedback = nullptr;
+    QMutex mMutex;
+};
+
+///@endcond
+
+//! Number of features read for each thread before processing them
+static const int PARALLEL_FEATURES_PER_THREAD = 64;
+
+bool QgsProcessingFeatureBasedAlgorithm::processFeaturesInParallel( QgsFeatureIterator &iterator, QgsFeatureSink &sink, long count, const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  if ( threadCount < 2 )
+    return false;
+
+  // every thread processes features with its own prepared copy of the algorithm,
+  // this instance being used by the current thread
+  std::vector< std::unique_ptr< QgsProcessingFeatureBasedAlgorithm > > clones;
+  QVector< QgsProcessingFeatureBasedAlgorithm * > workers;
+  workers << this;
+  for ( int i = 1; i < threadCount; ++i )
+  {
+    std::unique_ptr< QgsProcessingFeatureBasedAlgorithm > clone( dynamic_cast< QgsProcessingFeatureBasedAlgorithm * >( create() ) );
+    if ( !clone || !clone->prepareAlgorithm( parameters, context, feedback ) )
+      return false;
+
+    clone->mSourceCrs = mSourceCrs;
+    workers << clone.get();
+    clones.push_back( std::move( clone ) );
+  }
+
+  QgsProcessingParallelFeedback parallelFeedback( feedback );
+  QMutex errorMutex;
+  QString error;
+
+  // the input queue is bounded by the batch size, results are kept in input order
+  const int batchSize = PARALLEL_FEATURES_PER_THREAD * threadCount;
+  std::vector< QgsFeature > input;
+  std::vector< QgsFeature > output;
+  input.reserve( batchSize );
+
+  auto processRange = [&]( QgsProcessingFeatureBasedAlgorithm * worker, int begin, int end )
+  {
+    try
+    {
+      for ( int i = begin; i < end && !feedback->isCanceled(); ++i )
+        output[i] = worker->processFeature( input[i], &parallelFeedback );
+    }
+    catch ( QgsProcessingException &e )
+    {
+      QMutexLocker locker( &errorMutex );
+      if ( error.isEmpty() )
+        error = e.what();
+    }
+  };
+
+  double step = count > 0 ? 100.0 / count : 1;
+  long current = 0;
+  QgsFeature f;
+  bool finished = false;
+  while ( !finished && !feedback->isCanceled() )
+  {
+    input.clear();
+    while ( static_cast< int >( input.size() ) < batchSize && iterator.nextFeature( f ) )
+      input.push_back( f );
+    finished = static_cast< int >( input.size() ) < batchSize;
+    if ( input.empty() )
+      break;
+
+    const int size = static_cast< int >( input.size() );
+    output.assign( size, QgsFeature() );
+
+    const int rangeSize = ( size + threadCount - 1 ) / threadCount;
+    QList< QFuture< void > > futures;
+    for ( int w = 1; w < threadCount && w * rangeSize < size; ++w )
+    {
+      QgsProcessingFeatureBasedAlgorithm *worker = workers.at( w );
+      const int begin = w * rangeSize;
+      const int end = std::min( begin + rangeSize, size );
+      futures << QtConcurrent::run( [&processRange, worker, begin, end] { processRange( worker, begin, end ); } );
+    }
+    // the current thread processes the first range itself, so the batch completes even without free threads in the pool
+    processRange( this, 0, std::min( rangeSize, size ) );
+    for ( QFuture< void > &future : futures )
+      future.waitForFinished();
+
+    if ( !error.isEmpty() )
+      throw QgsProcessingException( error );
+
+    for ( QgsFeature &transformed : output )
+    {
+      if ( transformed.isValid() )
+        sink.addFeature( transformed, QgsFeatureSink::FastInsert );
+    }
+
+    current += size;
+    feedback->setProgress( current * step );
+  }
+
+  return true;
+}
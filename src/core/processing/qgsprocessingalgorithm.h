@@ -72,6 +72,7 @@ class CORE_EXPORT QgsProcessingAlgorithm
       FlagSupportsBatch = 1 << 3,  //!< Algorithm supports batch mode
       FlagCanCancel = 1 << 4, //!< Algorithm can be canceled
       FlagRequiresMatchingCrs = 1 << 5, //!< Algorithm requires that all input layers have matching coordinate reference systems
+      FlagSupportsParallelFeatures = 1 << 6, //!< Feature based algorithm can process features in several threads at once, see QgsProcessingFeatureBasedAlgorithm
       FlagDeprecated = FlagHideFromToolbox | FlagHideFromModeler, //!< Algorithm is deprecated
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -764,8 +765,16 @@ Q_DECLARE_OPERATORS_FOR_FLAGS( QgsProcessingAlgorithm::Flags )
  * Using QgsProcessingFeatureBasedAlgorithm as the base class for feature based algorithms allows
  * shortcutting much of the common algorithm code for handling iterating over sources and pushing
  * features to output sinks. It also allows the algorithm execution to be optimised in future
- * (for instance allowing automatic multi-thread processing of the algorithm, or use of the
- * algorithm in "chains", avoiding the need for temporary outputs in multi-step models).
+ * (for instance allowing use of the algorithm in "chains", avoiding the need for temporary
+ * outputs in multi-step models).
+ *
+ * Algorithms which return the FlagSupportsParallelFeatures flag from flags() have their features
+ * processed by several threads at once. Each thread uses its own copy of the algorithm, created
+ * with create() and prepared by calling prepareAlgorithm() with the same parameters, so these
+ * algorithms must not rely on state shared between processFeature() calls and their
+ * prepareAlgorithm() implementation must be safe to call from the thread running the algorithm.
+ * Features are read and written in batches, and written to the output sink in the same order
+ * as if they were processed sequentially.
  *
  * \since QGIS 3.0
  */
@@ -873,6 +882,15 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
   private:
 
     std::unique_ptr< QgsProcessingFeatureSource > mSource;
+    QgsCoordinateReferenceSystem mSourceCrs;
+
+    /**
+     * Processes the features from \a iterator with several threads, writing the results to \a sink.
+     * Returns false if the algorithm could not be prepared for parallel processing, in which case no
+     * feature was read from the iterator.
+     */
+    bool processFeaturesInParallel( QgsFeatureIterator &iterator, QgsFeatureSink &sink, long count, const QVariantMap &parameters,
+                                    QgsProcessingContext &context, QgsProcessingFeedback *feedback );
 
 };
 
@@ -26,6 +26,7 @@
 #include "qgsprocessingparameters.h"
 #include "qgsprocessingalgorithm.h"
 #include "qgsvectorlayerfeatureiterator.h"
+#include "qgsspatialindexfilecache.h"
 
 QList<QgsRasterLayer *> QgsProcessingUtils::compatibleRasterLayers( QgsProject *project, bool sort )
 {
@@ -643,6 +644,18 @@ QgsFeatureIterator QgsProcessingFeatureSource::getFeatures( const QgsFeatureRequ
   return mSource->getFeatures( req );
 }
 
+QgsStaticSpatialIndex QgsProcessingFeatureSource::createStaticSpatialIndex( QgsFeedback *feedback ) const
+{
+  // the cached index of a layer may contain invalid geometries which this source would skip or abort on
+  if ( mInvalidGeometryCheck == QgsFeatureRequest::GeometryNoCheck )
+  {
+    if ( QgsVectorLayer *layer = dynamic_cast< QgsVectorLayer * >( mSource ) )
+      return QgsSpatialIndexFileCache::staticIndex( layer, feedback );
+  }
+
+  return QgsStaticSpatialIndex( getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) ), feedback );
+}
+
 QgsCoordinateReferenceSystem QgsProcessingFeatureSource::sourceCrs() const
 {
   return mSource->sourceCrs();
@@ -24,11 +24,13 @@
 #include "qgsvectorlayer.h"
 #include "qgsmessagelog.h"
 #include "qgsspatialindex.h"
+#include "qgsstaticspatialindex.h"
 
 class QgsProject;
 class QgsProcessingContext;
 class QgsMapLayerStore;
 class QgsProcessingFeedback;
+class QgsFeedback;
 class QgsProcessingFeatureSource;
 
 #include <QString>
@@ -308,6 +310,17 @@ class CORE_EXPORT QgsProcessingFeatureSource : public QgsFeatureSource
     QgsFeatureIterator getFeatures( const QgsFeatureRequest &request, Flags flags ) const;
 
     QgsFeatureIterator getFeatures( const QgsFeatureRequest &request = QgsFeatureRequest() ) const override;
+
+    /**
+     * Returns a static spatial index of the features of the source, in the source's CRS.
+     * Indexes of whole layers read from local files are loaded from the spatial index file cache
+     * when it is enabled and invalid geometries are not checked, see QgsSpatialIndexFileCache.
+     *
+     * The optional \a feedback object can be used to allow cancelation of feature loading.
+     * The returned index must be checked with QgsStaticSpatialIndex::isValid().
+     */
+    QgsStaticSpatialIndex createStaticSpatialIndex( QgsFeedback *feedback = nullptr ) const;
+
     QgsCoordinateReferenceSystem sourceCrs() const override;
     QgsFields fields() const override;
     QgsWkbTypes::Type wkbType() const override;
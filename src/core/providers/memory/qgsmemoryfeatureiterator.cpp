@@ -67,7 +67,7 @@ QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryFeatureSource *sour
   else if ( mRequest.filterType() == QgsFeatureRequest::FilterFid )
   {
     mUsingFeatureIdList = true;
-    QgsFeatureMap::const_iterator it = mSource->mFeatures.constFind( mRequest.filterFid() );
+    QgsMemoryFeatureMap::const_iterator it = mSource->mFeatures.constFind( mRequest.filterFid() );
     if ( it != mSource->mFeatures.constEnd() )
       mFeatureIdList.append( mRequest.filterFid() );
   }
@@ -108,10 +108,11 @@ bool QgsMemoryFeatureIterator::nextFeatureUsingList( QgsFeature &feature )
   // option 1: we have a list of features to traverse
   while ( mFeatureIdListIterator != mFeatureIdList.constEnd() )
   {
+    const QgsMemoryFeature stored = mSource->mFeatures.value( *mFeatureIdListIterator );
     if ( !mFilterRect.isNull() && mRequest.flags() & QgsFeatureRequest::ExactIntersect )
     {
       // do exact check in case we're doing intersection
-      if ( mSource->mFeatures.value( *mFeatureIdListIterator ).hasGeometry() && mSelectRectEngine->intersects( mSource->mFeatures.value( *mFeatureIdListIterator ).geometry().geometry() ) )
+      if ( !stored.geometry.isNull() && mSelectRectEngine->intersects( stored.geometry.geometry() ) )
         hasFeature = true;
     }
     else
@@ -119,7 +120,7 @@ bool QgsMemoryFeatureIterator::nextFeatureUsingList( QgsFeature &feature )
 
     if ( mSubsetExpression )
     {
-      mSource->mExpressionContext.setFeature( mSource->mFeatures.value( *mFeatureIdListIterator ) );
+      mSource->mExpressionContext.setFeature( stored.toFeature( *mFeatureIdListIterator, mSource->mFields ) );
       if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
         hasFeature = false;
     }
@@ -133,18 +134,12 @@ bool QgsMemoryFeatureIterator::nextFeatureUsingList( QgsFeature &feature )
   // copy feature
   if ( hasFeature )
   {
-    feature = mSource->mFeatures.value( *mFeatureIdListIterator );
+    fetchStoredFeature( *mFeatureIdListIterator, mSource->mFeatures.value( *mFeatureIdListIterator ), feature );
     ++mFeatureIdListIterator;
   }
   else
     close();
 
-  if ( hasFeature )
-  {
-    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-    geometryToDestinationCrs( feature, mTransform );
-  }
-
   return hasFeature;
 }
 
@@ -166,20 +161,20 @@ bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
       if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
       {
         // using exact test when checking for intersection
-        if ( mSelectIterator->hasGeometry() && mSelectRectEngine->intersects( mSelectIterator->geometry().geometry() ) )
+        if ( !mSelectIterator->geometry.isNull() && mSelectRectEngine->intersects( mSelectIterator->geometry.geometry() ) )
           hasFeature = true;
       }
       else
       {
         // check just bounding box against rect when not using intersection
-        if ( mSelectIterator->hasGeometry() && mSelectIterator->geometry().boundingBox().intersects( mFilterRect ) )
+        if ( !mSelectIterator->geometry.isNull() && mSelectIterator->geometry.boundingBox().intersects( mFilterRect ) )
           hasFeature = true;
       }
     }
 
     if ( mSubsetExpression )
     {
-      mSource->mExpressionContext.setFeature( *mSelectIterator );
+      mSource->mExpressionContext.setFeature( mSelectIterator->toFeature( mSelectIterator.key(), mSource->mFields ) );
       if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
         hasFeature = false;
     }
@@ -193,11 +188,8 @@ bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
   // copy feature
   if ( hasFeature )
   {
-    feature = mSelectIterator.value();
+    fetchStoredFeature( mSelectIterator.key(), mSelectIterator.value(), feature );
     ++mSelectIterator;
-    feature.setValid( true );
-    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-    geometryToDestinationCrs( feature, mTransform );
   }
   else
     close();
@@ -205,6 +197,23 @@ bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
   return hasFeature;
 }
 
+void QgsMemoryFeatureIterator::fetchStoredFeature( QgsFeatureId fid, const QgsMemoryFeature &stored, QgsFeature &feature ) const
+{
+  feature.setId( fid );
+  feature.setValid( true );
+  feature.setFields( mSource->mFields ); // allow name-based attribute lookups
+
+  // only unpack the requested attributes
+  if ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes )
+    feature.setAttributes( stored.attributes.toAttributes( mRequest.subsetOfAttributes() ) );
+  else
+    feature.setAttributes( stored.attributes.toAttributes() );
+
+  // geometries are implicitly shared, there is no gain in skipping them
+  feature.setGeometry( stored.geometry );
+  geometryToDestinationCrs( feature, mTransform );
+}
+
 bool QgsMemoryFeatureIterator::rewind()
 {
   if ( mClosed )
@@ -243,6 +252,15 @@ QgsMemoryFeatureSource::QgsMemoryFeatureSource( const QgsMemoryProvider *p )
   mExpressionContext.setFields( mFields );
 }
 
+QgsFeature QgsMemoryFeature::toFeature( QgsFeatureId fid, const QgsFields &fields ) const
+{
+  QgsFeature feature( fields, fid );
+  feature.setGeometry( geometry );
+  feature.setAttributes( attributes.toAttributes() );
+  feature.setValid( true );
+  return feature;
+}
+
 QgsFeatureIterator QgsMemoryFeatureSource::getFeatures( const QgsFeatureRequest &request )
 {
   return QgsFeatureIterator( new QgsMemoryFeatureIterator( this, false, request ) );
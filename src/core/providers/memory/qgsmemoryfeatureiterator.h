@@ -21,12 +21,33 @@
 #include "qgsexpressioncontext.h"
 #include "qgsfields.h"
 #include "qgsgeometry.h"
+#include "qgspackedattributes.h"
 
 ///@cond PRIVATE
 
 class QgsMemoryProvider;
 
-typedef QMap<QgsFeatureId, QgsFeature> QgsFeatureMap;
+/**
+ * A feature as stored by the memory provider. The attributes are kept packed and
+ * only converted to QgsAttributes when the feature is fetched.
+ */
+struct QgsMemoryFeature
+{
+  QgsMemoryFeature() = default;
+
+  explicit QgsMemoryFeature( const QgsFeature &feature )
+    : geometry( feature.geometry() )
+    , attributes( feature.attributes() )
+  {}
+
+  //! Returns the stored feature with all its attributes as a QgsFeature with id \a fid
+  QgsFeature toFeature( QgsFeatureId fid, const QgsFields &fields ) const;
+
+  QgsGeometry geometry;
+  QgsPackedAttributes attributes;
+};
+
+typedef QMap<QgsFeatureId, QgsMemoryFeature> QgsMemoryFeatureMap;
 
 class QgsSpatialIndex;
 
@@ -40,7 +61,7 @@ class QgsMemoryFeatureSource : public QgsAbstractFeatureSource
 
   private:
     QgsFields mFields;
-    QgsFeatureMap mFeatures;
+    QgsMemoryFeatureMap mFeatures;
     std::unique_ptr< QgsSpatialIndex > mSpatialIndex;
     QString mSubsetString;
     QgsExpressionContext mExpressionContext;
@@ -68,10 +89,13 @@ class QgsMemoryFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
     bool nextFeatureUsingList( QgsFeature &feature );
     bool nextFeatureTraverseAll( QgsFeature &feature );
 
+    //! Converts a stored feature to the feature returned by the iterator, only unpacking the requested attributes
+    void fetchStoredFeature( QgsFeatureId fid, const QgsMemoryFeature &stored, QgsFeature &feature ) const;
+
     QgsGeometry mSelectRectGeom;
     std::unique_ptr< QgsGeometryEngine > mSelectRectEngine;
     QgsRectangle mFilterRect;
-    QgsFeatureMap::const_iterator mSelectIterator;
+    QgsMemoryFeatureMap::const_iterator mSelectIterator;
     bool mUsingFeatureIdList = false;
     QList<QgsFeatureId> mFeatureIdList;
     QList<QgsFeatureId>::const_iterator mFeatureIdListIterator;
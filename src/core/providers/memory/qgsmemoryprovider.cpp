@@ -31,6 +31,14 @@
 static const QString TEXT_PROVIDER_KEY = QStringLiteral( "memory" );
 static const QString TEXT_PROVIDER_DESCRIPTION = QStringLiteral( "Memory provider" );
 
+//! Returns a feature holding only the id and geometry of a stored feature, for the spatial index
+static QgsFeature spatialIndexFeature( QgsFeatureId fid, const QgsMemoryFeature &stored )
+{
+  QgsFeature feature( fid );
+  feature.setGeometry( stored.geometry );
+  return feature;
+}
+
 QgsMemoryProvider::QgsMemoryProvider( const QString &uri )
   : QgsVectorDataProvider( uri )
 
@@ -275,10 +283,10 @@ QgsRectangle QgsMemoryProvider::extent() const
   if ( mExtent.isEmpty() && !mFeatures.isEmpty() )
   {
     mExtent.setMinimal();
-    Q_FOREACH ( const QgsFeature &feat, mFeatures )
+    for ( const QgsMemoryFeature &feat : qgsAsConst( mFeatures ) )
     {
-      if ( feat.hasGeometry() )
-        mExtent.combineExtentWith( feat.geometry().boundingBox() );
+      if ( !feat.geometry.isNull() )
+        mExtent.combineExtentWith( feat.geometry.boundingBox() );
     }
   }
 
@@ -334,7 +342,7 @@ bool QgsMemoryProvider::addFeatures( QgsFeatureList &flist, Flags )
     it->setId( mNextFeatureId );
     it->setValid( true );
 
-    mFeatures.insert( mNextFeatureId, *it );
+    mFeatures.insert( mNextFeatureId, QgsMemoryFeature( *it ) );
 
     if ( it->hasGeometry() )
     {
@@ -356,7 +364,7 @@ bool QgsMemoryProvider::deleteFeatures( const QgsFeatureIds &id )
 {
   for ( QgsFeatureIds::const_iterator it = id.begin(); it != id.end(); ++it )
   {
-    QgsFeatureMap::iterator fit = mFeatures.find( *it );
+    QgsMemoryFeatureMap::iterator fit = mFeatures.find( *it );
 
     // check whether such feature exists
     if ( fit == mFeatures.end() )
@@ -364,7 +372,7 @@ bool QgsMemoryProvider::deleteFeatures( const QgsFeatureIds &id )
 
     // update spatial index
     if ( mSpatialIndex )
-      mSpatialIndex->deleteFeature( *fit );
+      mSpatialIndex->deleteFeature( spatialIndexFeature( fit.key(), *fit ) );
 
     mFeatures.erase( fit );
   }
@@ -397,12 +405,11 @@ bool QgsMemoryProvider::addAttributes( const QList<QgsField> &attributes )
     // add new field as a last one
     mFields.append( *it );
 
-    for ( QgsFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
+    for ( QgsMemoryFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
     {
-      QgsFeature &f = fit.value();
-      QgsAttributes attr = f.attributes();
+      QgsAttributes attr = fit->attributes.toAttributes();
       attr.append( QVariant() );
-      f.setAttributes( attr );
+      fit->attributes = QgsPackedAttributes( attr );
     }
   }
   return true;
@@ -443,12 +450,11 @@ bool QgsMemoryProvider::deleteAttributes( const QgsAttributeIds &attributes )
     int idx = *it;
     mFields.remove( idx );
 
-    for ( QgsFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
+    for ( QgsMemoryFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
     {
-      QgsFeature &f = fit.value();
-      QgsAttributes attr = f.attributes();
+      QgsAttributes attr = fit->attributes.toAttributes();
       attr.remove( idx );
-      f.setAttributes( attr );
+      fit->attributes = QgsPackedAttributes( attr );
     }
   }
   return true;
@@ -458,13 +464,19 @@ bool QgsMemoryProvider::changeAttributeValues( const QgsChangedAttributesMap &at
 {
   for ( QgsChangedAttributesMap::const_iterator it = attr_map.begin(); it != attr_map.end(); ++it )
   {
-    QgsFeatureMap::iterator fit = mFeatures.find( it.key() );
+    QgsMemoryFeatureMap::iterator fit = mFeatures.find( it.key() );
     if ( fit == mFeatures.end() )
       continue;
 
+    // the attributes are packed again once all changes of the feature are applied
+    QgsAttributes attributes = fit->attributes.toAttributes();
     const QgsAttributeMap &attrs = it.value();
     for ( QgsAttributeMap::const_iterator it2 = attrs.constBegin(); it2 != attrs.constEnd(); ++it2 )
-      fit->setAttribute( it2.key(), it2.value() );
+    {
+      if ( it2.key() >= 0 && it2.key() < attributes.size() )
+        attributes[it2.key()] = it2.value();
+    }
+    fit->attributes = QgsPackedAttributes( attributes );
   }
   return true;
 }
@@ -473,19 +485,19 @@ bool QgsMemoryProvider::changeGeometryValues( const QgsGeometryMap &geometry_map
 {
   for ( QgsGeometryMap::const_iterator it = geometry_map.begin(); it != geometry_map.end(); ++it )
   {
-    QgsFeatureMap::iterator fit = mFeatures.find( it.key() );
+    QgsMemoryFeatureMap::iterator fit = mFeatures.find( it.key() );
     if ( fit == mFeatures.end() )
       continue;
 
     // update spatial index
     if ( mSpatialIndex )
-      mSpatialIndex->deleteFeature( *fit );
+      mSpatialIndex->deleteFeature( spatialIndexFeature( fit.key(), *fit ) );
 
-    fit->setGeometry( it.value() );
+    fit->geometry = it.value();
 
     // update spatial index
     if ( mSpatialIndex )
-      mSpatialIndex->insertFeature( *fit );
+      mSpatialIndex->insertFeature( spatialIndexFeature( fit.key(), *fit ) );
   }
 
   updateExtents();
@@ -523,9 +535,10 @@ bool QgsMemoryProvider::createSpatialIndex()
     mSpatialIndex = new QgsSpatialIndex();
 
     // add existing features to index
-    for ( QgsFeatureMap::const_iterator it = mFeatures.constBegin(); it != mFeatures.constEnd(); ++it )
+    for ( QgsMemoryFeatureMap::const_iterator it = mFeatures.constBegin(); it != mFeatures.constEnd(); ++it )
     {
-      mSpatialIndex->insertFeature( *it );
+      if ( !it->geometry.isNull() )
+        mSpatialIndex->insertFeature( it.key(), it->geometry.boundingBox() );
     }
   }
   return true;
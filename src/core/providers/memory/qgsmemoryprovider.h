@@ -18,9 +18,9 @@
 #include "qgsvectordataprovider.h"
 #include "qgscoordinatereferencesystem.h"
 #include "qgsfields.h"
+#include "qgsmemoryfeatureiterator.h"
 
 ///@cond PRIVATE
-typedef QMap<QgsFeatureId, QgsFeature> QgsFeatureMap;
 
 class QgsSpatialIndex;
 
@@ -84,7 +84,7 @@ class QgsMemoryProvider : public QgsVectorDataProvider
     mutable QgsRectangle mExtent;
 
     // features
-    QgsFeatureMap mFeatures;
+    QgsMemoryFeatureMap mFeatures;
     QgsFeatureId mNextFeatureId;
 
     // indexing
@@ -0,0 +1,271 @@
+/***************************************************************************
+  qgsaggregatecache.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsaggregatecache.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
+#include "qgsexpressionfunction.h"
+#include "qgsexpressionnodeimpl.h"
+#include "qgsvectorlayer.h"
+
+QgsAggregateCache::QgsAggregateCache()
+{
+}
+
+void QgsAggregateCache::clear()
+{
+  QMutexLocker lock( &mMutex );
+  const QStringList layerIds = mLayers.keys();
+  for ( const QString &layerId : layerIds )
+  {
+    invalidate( layerId );
+  }
+}
+
+void QgsAggregateCache::invalidateLayer( const QString &layerId )
+{
+  QMutexLocker lock( &mMutex );
+  invalidate( layerId );
+}
+
+void QgsAggregateCache::invalidate( const QString &layerId )
+{
+  mLayers.remove( layerId );
+  mGenerations.insert( layerId, ++mLastGeneration );
+}
+
+quint64 QgsAggregateCache::layerGeneration( QgsVectorLayer *layer )
+{
+  if ( !layer )
+    return 0;
+
+  QMutexLocker lock( &mMutex );
+  connectLayer( layer );
+  return mGenerations.value( layer->id() );
+}
+
+void QgsAggregateCache::connectLayer( QgsVectorLayer *layer )
+{
+  const QString layerId = layer->id();
+  if ( mConnectedLayers.value( layerId ).data() == layer )
+    return;
+
+  // the layer's data may be changed from another thread than the one calculating aggregates,
+  // so the cache is invalidated directly from the thread emitting the signals
+  auto invalidateLayerAggregates = [this, layerId] { invalidateLayer( layerId ); };
+  connect( layer, &QgsMapLayer::dataChanged, this, invalidateLayerAggregates, Qt::DirectConnection );
+  connect( layer, &QgsVectorLayer::layerModified, this, invalidateLayerAggregates, Qt::DirectConnection );
+  connect( layer, &QgsVectorLayer::featureAdded, this, invalidateLayerAggregates, Qt::DirectConnection );
+  connect( layer, &QgsVectorLayer::featureDeleted, this, invalidateLayerAggregates, Qt::DirectConnection );
+  connect( layer, &QgsVectorLayer::attributeValueChanged, this, invalidateLayerAggregates, Qt::DirectConnection );
+  connect( layer, &QgsVectorLayer::geometryChanged, this, invalidateLayerAggregates, Qt::DirectConnection );
+  connect( layer, &QgsVectorLayer::updatedFields, this, invalidateLayerAggregates, Qt::DirectConnection );
+  connect( layer, &QgsVectorLayer::editingStopped, this, invalidateLayerAggregates, Qt::DirectConnection );
+  connect( layer, &QgsMapLayer::willBeDeleted, this, [this, layerId]
+  {
+    QMutexLocker lock( &mMutex );
+    invalidate( layerId );
+    mConnectedLayers.remove( layerId );
+  }, Qt::DirectConnection );
+
+  mConnectedLayers.insert( layerId, layer );
+}
+
+const QgsAggregateCache::LayerAggregates *QgsAggregateCache::layerAggregates( const QgsVectorLayer *layer ) const
+{
+  if ( !layer )
+    return nullptr;
+
+  // layers of different projects may share the same ID
+  const QString layerId = layer->id();
+  if ( mConnectedLayers.value( layerId ).data() != layer )
+    return nullptr;
+
+  QHash< QString, LayerAggregates >::const_iterator layerIt = mLayers.constFind( layerId );
+  if ( layerIt == mLayers.constEnd() )
+    return nullptr;
+
+  return &layerIt.value();
+}
+
+bool QgsAggregateCache::cachedValue( const QgsVectorLayer *layer, const QString &key, QVariant &value ) const
+{
+  QMutexLocker lock( &mMutex );
+  const LayerAggregates *aggregates = layerAggregates( layer );
+  if ( !aggregates )
+    return false;
+
+  QHash< QString, QVariant >::const_iterator valueIt = aggregates->values.constFind( key );
+  if ( valueIt == aggregates->values.constEnd() )
+    return false;
+
+  value = valueIt.value();
+  return true;
+}
+
+void QgsAggregateCache::setCachedValue( QgsVectorLayer *layer, const QString &key, const QVariant &value, quint64 generation )
+{
+  if ( !layer )
+    return;
+
+  QMutexLocker lock( &mMutex );
+  if ( mConnectedLayers.value( layer->id() ).data() != layer || mGenerations.value( layer->id() ) != generation )
+    return;
+
+  mLayers[ layer->id() ].values.insert( key, value );
+}
+
+bool QgsAggregateCache::cachedGroupValue( const QgsVectorLayer *layer, const QString &key, const QString &groupKey, QVariant &value ) const
+{
+  QMutexLocker lock( &mMutex );
+  const LayerAggregates *aggregates = layerAggregates( layer );
+  if ( !aggregates )
+    return false;
+
+  QHash< QString, GroupedValues >::const_iterator groupsIt = aggregates->groupedValues.constFind( key );
+  if ( groupsIt == aggregates->groupedValues.constEnd() )
+    return false;
+
+  value = groupsIt->values.value( groupKey, groupsIt->emptyGroupValue );
+  return true;
+}
+
+void QgsAggregateCache::setCachedGroupValues( QgsVectorLayer *layer, const QString &key, const QVariantMap &values, const QVariant &emptyGroupValue, quint64 generation )
+{
+  if ( !layer )
+    return;
+
+  QMutexLocker lock( &mMutex );
+  if ( mConnectedLayers.value( layer->id() ).data() != layer || mGenerations.value( layer->id() ) != generation )
+    return;
+
+  GroupedValues groupedValues;
+  groupedValues.values = values;
+  groupedValues.emptyGroupValue = emptyGroupValue;
+  mLayers[ layer->id() ].groupedValues.insert( key, groupedValues );
+}
+
+int QgsAggregateCache::count() const
+{
+  QMutexLocker lock( &mMutex );
+  int count = 0;
+  for ( const LayerAggregates &aggregates : mLayers )
+  {
+    count += aggregates.values.count() + aggregates.groupedValues.count();
+  }
+  return count;
+}
+
+//! Returns true if the result of \a node only depends on the evaluated feature
+static bool nodeIsCacheable( const QgsExpressionNode *node, const QgsExpressionContext *context )
+{
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntUnaryOperator:
+      return nodeIsCacheable( static_cast< const QgsExpressionNodeUnaryOperator * >( node )->operand(), context );
+
+    case QgsExpressionNode::ntBinaryOperator:
+    {
+      const QgsExpressionNodeBinaryOperator *binary = static_cast< const QgsExpressionNodeBinaryOperator * >( node );
+      return nodeIsCacheable( binary->opLeft(), context ) && nodeIsCacheable( binary->opRight(), context );
+    }
+
+    case QgsExpressionNode::ntInOperator:
+    {
+      const QgsExpressionNodeInOperator *in = static_cast< const QgsExpressionNodeInOperator * >( node );
+      if ( !nodeIsCacheable( in->node(), context ) )
+        return false;
+      const QList< QgsExpressionNode * > list = in->list()->list();
+      for ( const QgsExpressionNode *item : list )
+      {
+        if ( !nodeIsCacheable( item, context ) )
+          return false;
+      }
+      return true;
+    }
+
+    case QgsExpressionNode::ntFunction:
+    {
+      static const QSet< QString > sUncacheableFunctions
+      {
+        QStringLiteral( "rand" ),
+        QStringLiteral( "randf" ),
+        QStringLiteral( "uuid" ),
+        QStringLiteral( "now" ),
+        QStringLiteral( "get_feature" ),
+        QStringLiteral( "get_feature_by_id" ),
+        QStringLiteral( "is_selected" ),
+        QStringLiteral( "num_selected" ),
+        QStringLiteral( "represent_value" ),
+        QStringLiteral( "layer_property" ),
+        QStringLiteral( "raster_statistic" ),
+        QStringLiteral( "raster_value" ),
+        QStringLiteral( "var" ),
+        QStringLiteral( "eval" ),
+        QStringLiteral( "env" ),
+      };
+
+      const QgsExpressionNodeFunction *function = static_cast< const QgsExpressionNodeFunction * >( node );
+      const QgsExpressionFunction *fd = QgsExpression::Functions()[ function->fnIndex()];
+      if ( fd->isContextual() || fd->groups().contains( QStringLiteral( "Aggregates" ) )
+           || sUncacheableFunctions.contains( fd->name() )
+           || ( context && context->hasFunction( fd->name() ) ) )
+        return false;
+
+      if ( function->args() )
+      {
+        const QList< QgsExpressionNode * > args = function->args()->list();
+        for ( const QgsExpressionNode *arg : args )
+        {
+          if ( !nodeIsCacheable( arg, context ) )
+            return false;
+        }
+      }
+      return true;
+    }
+
+    case QgsExpressionNode::ntCondition:
+    {
+      const QgsExpressionNodeCondition *condition = static_cast< const QgsExpressionNodeCondition * >( node );
+      const QgsExpressionNodeCondition::WhenThenList conditions = condition->conditions();
+      for ( const QgsExpressionNodeCondition::WhenThen *whenThen : conditions )
+      {
+        if ( !nodeIsCacheable( whenThen->whenExp(), context ) || !nodeIsCacheable( whenThen->thenExp(), context ) )
+          return false;
+      }
+      return !condition->elseExp() || nodeIsCacheable( condition->elseExp(), context );
+    }
+
+    case QgsExpressionNode::ntLiteral:
+    case QgsExpressionNode::ntColumnRef:
+      return true;
+  }
+  return false;
+}
+
+bool QgsAggregateCache::isCacheable( const QgsExpression &expression, const QgsExpressionContext *context )
+{
+  // empty filter
+  if ( expression.expression().trimmed().isEmpty() )
+    return true;
+
+  if ( expression.hasParserError() || !expression.rootNode() )
+    return false;
+
+  // variables are resolved from the expression context
+  if ( !expression.referencedVariables().isEmpty() )
+    return false;
+
+  return nodeIsCacheable( expression.rootNode(), context );
+}
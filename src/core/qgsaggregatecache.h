@@ -0,0 +1,152 @@
+/***************************************************************************
+  qgsaggregatecache.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSAGGREGATECACHE_H
+#define QGSAGGREGATECACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsmaplayer.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QVariant>
+
+class QgsExpression;
+class QgsExpressionContext;
+class QgsVectorLayer;
+
+/**
+ * \ingroup core
+ * This class keeps the results of aggregates calculated over the features of vector layers
+ * by the aggregate() and relation_aggregate() expression functions, so that they can be reused
+ * by all expressions (e.g. in different map renders, labeling, the attribute table and
+ * processing algorithms) instead of only within a single expression context.
+ *
+ * Results are stored per layer and are dropped as soon as the layer's data change, e.g.
+ * when features are edited, the layer's edits are rolled back or the layer reports a
+ * change of its data source. Only aggregates which do not depend on the expression context
+ * should be stored (see isCacheable()).
+ *
+ * Besides single values, the cache stores aggregates calculated for groups of features
+ * (see QgsAggregateCalculator::calculateGroups()), which are used for relation aggregates
+ * of all parent features.
+ *
+ * As aggregates may be calculated in a different thread than the one editing the layer,
+ * a result must be stored together with the layerGeneration() read before it was calculated.
+ * Results calculated while the layer's data changed are then discarded.
+ *
+ * The class is thread-safe (multiple classes can access the same instance safely).
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsAggregateCache : public QObject
+{
+    Q_OBJECT
+  public:
+
+    QgsAggregateCache();
+
+    //! Removes all cached aggregates
+    void clear();
+
+    //! Removes the cached aggregates of the layer with the specified \a layerId
+    void invalidateLayer( const QString &layerId );
+
+    /**
+     * Returns the current generation of the data of \a layer. It changes whenever the
+     * layer's cached aggregates are invalidated. The cache starts listening to the
+     * layer's changes when this method is first called for the layer.
+     */
+    quint64 layerGeneration( QgsVectorLayer *layer );
+
+    /**
+     * Looks up the aggregate with the given \a key for \a layer.
+     * Returns true and sets \a value if the aggregate is cached. Aggregates stored for another
+     * layer object with the same ID (e.g. of another project) are never returned.
+     */
+    bool cachedValue( const QgsVectorLayer *layer, const QString &key, QVariant &value ) const;
+
+    /**
+     * Stores the aggregate \a value with the given \a key for \a layer. The value is discarded
+     * if the layer's data changed since \a generation was returned by layerGeneration().
+     */
+    void setCachedValue( QgsVectorLayer *layer, const QString &key, const QVariant &value, quint64 generation );
+
+    /**
+     * Looks up the aggregate of the group with \a groupKey in the grouped aggregates stored with
+     * the given \a key for \a layer. Returns true and sets \a value if the grouped
+     * aggregates are cached. Groups without features get the value stored for empty groups.
+     */
+    bool cachedGroupValue( const QgsVectorLayer *layer, const QString &key, const QString &groupKey, QVariant &value ) const;
+
+    /**
+     * Stores the aggregates of all groups of features of \a layer with the given \a key.
+     * \param layer layer the aggregates were calculated for
+     * \param key key of the aggregates
+     * \param values aggregate values, by group key
+     * \param emptyGroupValue aggregate value of groups without features
+     * \param generation layer generation returned by layerGeneration() before the aggregates were calculated
+     */
+    void setCachedGroupValues( QgsVectorLayer *layer, const QString &key, const QVariantMap &values,
+                               const QVariant &emptyGroupValue, quint64 generation );
+
+    //! Returns the number of cached aggregates (grouped aggregates count once)
+    int count() const;
+
+    /**
+     * Returns true if aggregates using the \a expression (used as the aggregated expression or as
+     * a filter) only depend on the features of the layer, and not on the expression \a context.
+     * This excludes expressions referencing variables, functions which may be overridden by the
+     * \a context and functions reading other layers, the selection or random values.
+     */
+    static bool isCacheable( const QgsExpression &expression, const QgsExpressionContext *context = nullptr );
+
+  private:
+
+    struct GroupedValues
+    {
+      QVariantMap values;
+      QVariant emptyGroupValue;
+    };
+
+    struct LayerAggregates
+    {
+      QHash< QString, QVariant > values;
+      QHash< QString, GroupedValues > groupedValues;
+    };
+
+    mutable QMutex mMutex;
+
+    //! Cached aggregates by layer ID
+    QHash< QString, LayerAggregates > mLayers;
+    //! Data generation by layer ID
+    QHash< QString, quint64 > mGenerations;
+    //! Last generation assigned to a layer
+    quint64 mLastGeneration = 0;
+    //! Layers this cache is connected to, by layer ID
+    QHash< QString, QgsWeakMapLayerPointer > mConnectedLayers;
+
+    //! Connects to the signals of \a layer reporting changes of its data (without locking)
+    void connectLayer( QgsVectorLayer *layer );
+    //! Returns the cached aggregates of \a layer, or nullptr if there are none (without locking)
+    const LayerAggregates *layerAggregates( const QgsVectorLayer *layer ) const;
+    //! Drops the aggregates of the layer and changes its generation (without locking)
+    void invalidate( const QString &layerId );
+};
+
+#endif // QGSAGGREGATECACHE_H
@@ -22,7 +22,48 @@
 #include "qgsgeometry.h"
 #include "qgsvectorlayer.h"
 
+///@cond PRIVATE
 
+//! Iterates over features which were already fetched from the layer
+class QgsAggregateFeatureListIterator : public QgsAbstractFeatureIterator
+{
+  public:
+
+    explicit QgsAggregateFeatureListIterator( const QgsFeatureList &features )
+      : QgsAbstractFeatureIterator( QgsFeatureRequest() )
+      , mFeatures( features )
+    {}
+
+    virtual bool rewind() override
+    {
+      mIndex = 0;
+      return true;
+    }
+
+    virtual bool close() override
+    {
+      mClosed = true;
+      return true;
+    }
+
+  protected:
+
+    virtual bool fetchFeature( QgsFeature &feature ) override
+    {
+      if ( mClosed || mIndex >= mFeatures.count() )
+        return false;
+
+      feature = mFeatures.at( mIndex++ );
+      return true;
+    }
+
+  private:
+
+    QgsFeatureList mFeatures;
+    int mIndex = 0;
+};
+
+///@endcond
 
 QgsAggregateCalculator::QgsAggregateCalculator( const QgsVectorLayer *layer )
   : mLayer( layer )
@@ -118,6 +159,150 @@ QVariant QgsAggregateCalculator::calculate( QgsAggregateCalculator::Aggregate ag
   return calculate( aggregate, fit, resultType, attrNum, expression.get(), mDelimiter, context, ok );
 }
 
+QVariantMap QgsAggregateCalculator::calculateGroups( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldOrExpression,
+    const QList< int > &groupBy, QgsExpressionContext *context, bool *ok, QVariant *emptyGroupValue ) const
+{
+  if ( ok )
+    *ok = false;
+
+  if ( !mLayer )
+    return QVariantMap();
+
+  const QgsFields fields = mLayer->fields();
+  for ( int field : groupBy )
+  {
+    if ( field < 0 || field >= fields.count() )
+      return QVariantMap();
+  }
+
+  QgsExpressionContext defaultContext = mLayer->createExpressionContext();
+  context = context ? context : &defaultContext;
+
+  std::unique_ptr<QgsExpression> expression;
+
+  int attrNum = fields.lookupField( fieldOrExpression );
+
+  if ( attrNum == -1 )
+  {
+    context->setFields( fields );
+    expression.reset( new QgsExpression( fieldOrExpression ) );
+
+    if ( expression->hasParserError() || !expression->prepare( context ) )
+    {
+      return QVariantMap();
+    }
+  }
+
+  QSet<QString> lst;
+  if ( !expression )
+    lst.insert( fieldOrExpression );
+  else
+    lst = expression->referencedColumns();
+  for ( int field : groupBy )
+    lst.insert( fields.at( field ).name() );
+
+  QgsFeatureRequest request = QgsFeatureRequest()
+                              .setFlags( ( expression && expression->needsGeometry() ) ?
+                                         QgsFeatureRequest::NoFlags :
+                                         QgsFeatureRequest::NoGeometry )
+                              .setSubsetOfAttributes( lst, fields );
+  if ( !mFilterExpression.isEmpty() )
+    request.setFilterExpression( mFilterExpression );
+  request.setExpressionContext( *context );
+
+  // single pass over the layer, keeping the features of each group in the order of iteration
+  QHash< QString, QgsFeatureList > groups;
+  QgsFeatureIterator fit = mLayer->getFeatures( request );
+  QgsFeature f;
+  QVariantList groupValues;
+  while ( fit.nextFeature( f ) )
+  {
+    groupValues.clear();
+    for ( int field : groupBy )
+      groupValues << f.attribute( field );
+
+    groups[ groupKey( groupValues )].append( f );
+  }
+
+  QVariantMap results;
+  for ( QHash< QString, QgsFeatureList >::const_iterator group = groups.constBegin(); group != groups.constEnd(); ++group )
+  {
+    // same result type as calculate() determines when filtering the features of the group
+    QVariant::Type resultType = QVariant::Double;
+    if ( attrNum == -1 )
+    {
+      context->setFeature( group.value().first() );
+      resultType = expression->evaluate( context ).type();
+    }
+    else
+    {
+      resultType = fields.at( attrNum ).type();
+    }
+
+    QgsFeatureIterator groupIt( new QgsAggregateFeatureListIterator( group.value() ) );
+    bool groupOk = false;
+    QVariant value = calculate( aggregate, groupIt, resultType, attrNum, expression.get(), mDelimiter, context, &groupOk );
+    if ( !groupOk )
+      return QVariantMap();
+
+    results.insert( group.key(), value );
+  }
+
+  if ( emptyGroupValue )
+  {
+    if ( attrNum == -1 )
+    {
+      *emptyGroupValue = defaultValue( aggregate );
+    }
+    else
+    {
+      QgsFeatureIterator emptyIt( new QgsAggregateFeatureListIterator( QgsFeatureList() ) );
+      *emptyGroupValue = calculate( aggregate, emptyIt, fields.at( attrNum ).type(), attrNum, nullptr, mDelimiter, context );
+    }
+  }
+
+  if ( ok )
+    *ok = true;
+  return results;
+}
+
+QString QgsAggregateCalculator::groupKey( const QVariantList &values )
+{
+  // values are tagged and strings are length prefixed, so that keys of different values never collide
+  QString key;
+  for ( const QVariant &value : values )
+  {
+    if ( value.isNull() )
+    {
+      key += QStringLiteral( "n;" );
+      continue;
+    }
+
+    switch ( value.type() )
+    {
+      case QVariant::Int:
+      case QVariant::UInt:
+      case QVariant::LongLong:
+      case QVariant::ULongLong:
+        key += QStringLiteral( "d%1;" ).arg( value.toLongLong() );
+        break;
+
+      case QVariant::Double:
+        // integral doubles get the same key as integers
+        key += QStringLiteral( "d%1;" ).arg( value.toDouble(), 0, 'g', 17 );
+        break;
+
+      default:
+      {
+        const QString string = value.toString();
+        key += QStringLiteral( "s%1:" ).arg( string.length() ) + string;
+        break;
+      }
+    }
+  }
+  return key;
+}
+
 QgsAggregateCalculator::Aggregate QgsAggregateCalculator::stringToAggregate( const QString &string, bool *ok )
 {
   QString normalized = string.trimmed().toLower();
@@ -19,6 +19,7 @@
 #define QGSAGGREGATECALCULATOR_H
 
 #include "qgis_core.h"
+#include "qgis_sip.h"
 #include "qgsstatisticalsummary.h"
 #include "qgsdatetimestatisticalsummary.h"
 #include "qgsstringstatisticalsummary.h"
@@ -155,6 +156,33 @@ class CORE_EXPORT QgsAggregateCalculator
      */
     static Aggregate stringToAggregate( const QString &string, bool *ok = nullptr );
 
+    /**
+     * Calculates the value of an aggregate separately for each group of features sharing the same
+     * values for the \a groupBy fields. Unlike calling calculate() with a filter for each group, the
+     * features of the layer are only iterated once.
+     * \param aggregate aggregate to calculate
+     * \param fieldOrExpression source field or expression to use as basis for aggregated values.
+     * \param groupBy indexes of the fields to group the features by
+     * \param context expression context for evaluating expressions
+     * \param ok if specified, will be set to true if aggregate calculation was successful
+     * \param emptyGroupValue if specified, will be set to the aggregate value of groups without features,
+     * i.e. the value calculate() returns when no features match the filter
+     * \returns calculated aggregate values, indexed by the groupKey() of the values of the \a groupBy fields.
+     * Groups without features are not included.
+     * \since QGIS 3.0
+     */
+    QVariantMap calculateGroups( Aggregate aggregate, const QString &fieldOrExpression, const QList< int > &groupBy,
+                                 QgsExpressionContext *context = nullptr, bool *ok = nullptr, QVariant *emptyGroupValue SIP_OUT = nullptr ) const;
+
+    /**
+     * Returns the key of the group of features with the specified values for the group by fields
+     * in the results of calculateGroups().
+     * Values which compare equal in an expression get the same key, provided that the values of
+     * each field have the same type (strings or numbers).
+     * \since QGIS 3.0
+     */
+    static QString groupKey( const QVariantList &values );
+
   private:
 
     //! Source layer
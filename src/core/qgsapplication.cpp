@@ -29,6 +29,7 @@
 #include "qgstaskmanager.h"
 #include "qgsfieldformatterregistry.h"
 #include "qgssvgcache.h"
+#include "qgsaggregatecache.h"
 #include "qgscolorschemeregistry.h"
 #include "qgspainteffectregistry.h"
 #include "qgsrasterrendererregistry.h"
@@ -1535,6 +1536,11 @@ QgsSvgCache *QgsApplication::svgCache()
   return members()->mSvgCache;
 }
 
+QgsAggregateCache *QgsApplication::aggregateCache()
+{
+  return members()->mAggregateCache;
+}
+
 QgsSymbolLayerRegistry *QgsApplication::symbolLayerRegistry()
 {
   return members()->mSymbolLayerRegistry;
@@ -1595,6 +1601,7 @@ QgsApplication::ApplicationMembers::ApplicationMembers()
   mActionScopeRegistry = new QgsActionScopeRegistry();
   mFieldFormatterRegistry = new QgsFieldFormatterRegistry();
   mSvgCache = new QgsSvgCache();
+  mAggregateCache = new QgsAggregateCache();
   mColorSchemeRegistry = new QgsColorSchemeRegistry();
   mColorSchemeRegistry->addDefaultSchemes();
   mPaintEffectRegistry = new QgsPaintEffectRegistry();
@@ -1630,6 +1637,7 @@ QgsApplication::ApplicationMembers::~ApplicationMembers()
   delete mRasterRendererRegistry;
   delete mRendererRegistry;
   delete mSvgCache;
+  delete mAggregateCache;
   delete mSymbolLayerRegistry;
   delete mTaskManager;
 }
@@ -32,6 +32,7 @@ class QgsColorSchemeRegistry;
 class QgsPaintEffectRegistry;
 class QgsRendererRegistry;
 class QgsSvgCache;
+class QgsAggregateCache;
 class QgsSymbolLayerRegistry;
 class QgsRasterRendererRegistry;
 class QgsGPSConnectionRegistry;
@@ -549,6 +550,14 @@ class CORE_EXPORT QgsApplication : public QApplication
      */
     static QgsSvgCache *svgCache();
 
+    /**
+     * Returns the application's aggregate cache, used for sharing the results of aggregates
+     * calculated by expressions over the features of vector layers.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    static QgsAggregateCache *aggregateCache() SIP_SKIP;
+
     /**
      * Returns the application's symbol layer registry, used for managing symbol layers.
      * \since QGIS 3.0
@@ -755,6 +764,7 @@ class CORE_EXPORT QgsApplication : public QApplication
       QgsRendererRegistry *mRendererRegistry = nullptr;
       QgsRuntimeProfiler *mProfiler = nullptr;
       QgsSvgCache *mSvgCache = nullptr;
+      QgsAggregateCache *mAggregateCache = nullptr;
       QgsSymbolLayerRegistry *mSymbolLayerRegistry = nullptr;
       QgsTaskManager *mTaskManager = nullptr;
       QgsLayoutItemRegistry *mLayoutItemRegistry = nullptr;
@@ -77,7 +77,7 @@ bool QgsCachedFeatureIterator::fetchFeature( QgsFeature &f )
       continue;
     }
 
-    f = QgsFeature( *mVectorLayerCache->mCache[*mFeatureIdIterator]->feature() );
+    f = mVectorLayerCache->featureFromCache( mVectorLayerCache->mCache[*mFeatureIdIterator] );
     ++mFeatureIdIterator;
     if ( mRequest.acceptFeature( f ) )
     {
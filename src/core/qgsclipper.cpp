@@ -19,7 +19,9 @@
 #include "qgsclipper.h"
 #include "qgsgeometry.h"
 #include "qgscurve.h"
+#include "qgslinestring.h"
 #include "qgslogger.h"
+#include "qgssimd_p.h"
 
 // Where has all the code gone?
 
@@ -38,10 +40,140 @@ const double QgsClipper::MIN_Y = -16000;
 
 const double QgsClipper::SMALL_NUM = 1e-12;
 
-QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent )
+// Trim the polygon using Sutherland and Hodgman's polygon-clipping algorithm
+void QgsClipper::trimPolygon( QPolygonF &pts, const QgsRectangle &clipRect )
+{
+  QVector<unsigned char> flags;
+  const int insideAll = insideFlags( pts, clipRect, flags );
+  if ( insideAll == InsideAll )
+    return; // nothing to trim
+
+  // clipping to one boundary never moves points out of another boundary which all points were inside of
+  // (the polygon is convex in that direction), so these boundaries can be skipped in all passes
+  QPolygonF tmpPts;
+  tmpPts.reserve( pts.size() );
+  bool first = true;
+  const Boundary boundaries[] = { XMax, YMax, XMin, YMin };
+  const InsideFlag boundaryFlags[] = { InsideXMax, InsideYMax, InsideXMin, InsideYMin };
+  for ( int i = 0; i < 4; ++i )
+  {
+    if ( insideAll & boundaryFlags[i] )
+      continue;
+
+    if ( !first )
+      insideFlags( pts, clipRect, flags );
+    first = false;
+
+    tmpPts.resize( 0 );
+    trimPolygonToBoundary( pts, flags, tmpPts, clipRect, boundaries[i] );
+    pts.swap( tmpPts );
+    if ( pts.isEmpty() )
+      return;
+  }
+}
+
+int QgsClipper::insideFlags( const QPolygonF &pts, const QgsRectangle &rect, QVector<unsigned char> &flags )
+{
+  const int count = pts.size();
+  flags.resize( count );
+  unsigned char *flag = flags.data();
+  const QPointF *pt = pts.constData();
+  const double xMin = rect.xMinimum();
+  const double xMax = rect.xMaximum();
+  const double yMin = rect.yMinimum();
+  const double yMax = rect.yMaximum();
+  int insideAll = InsideAll;
+  int i = 0;
+
+// the SSE2 code works on doubles, while Qt may be built with qreal as float
+#if defined( QGIS_SSE2 ) && !defined( QT_COORD_TYPE )
+  // two points per iteration: the comparisons yield one sign bit per point
+  const double *data = reinterpret_cast< const double * >( pt );
+  const __m128d vxMin = _mm_set1_pd( xMin );
+  const __m128d vxMax = _mm_set1_pd( xMax );
+  const __m128d vyMin = _mm_set1_pd( yMin );
+  const __m128d vyMax = _mm_set1_pd( yMax );
+  for ( ; i + 1 < count; i += 2, data += 4 )
+  {
+    const __m128d p0 = _mm_loadu_pd( data );
+    const __m128d p1 = _mm_loadu_pd( data + 2 );
+    const __m128d x = _mm_unpacklo_pd( p0, p1 );
+    const __m128d y = _mm_unpackhi_pd( p0, p1 );
+    const int xMaxMask = _mm_movemask_pd( _mm_cmplt_pd( x, vxMax ) );
+    const int xMinMask = _mm_movemask_pd( _mm_cmpgt_pd( x, vxMin ) );
+    const int yMaxMask = _mm_movemask_pd( _mm_cmplt_pd( y, vyMax ) );
+    const int yMinMask = _mm_movemask_pd( _mm_cmpgt_pd( y, vyMin ) );
+    const int f0 = ( xMaxMask & 1 ) | ( xMinMask & 1 ) << 1 | ( yMaxMask & 1 ) << 2 | ( yMinMask & 1 ) << 3;
+    const int f1 = ( xMaxMask >> 1 ) | ( xMinMask >> 1 ) << 1 | ( yMaxMask >> 1 ) << 2 | ( yMinMask >> 1 ) << 3;
+    flag[i] = static_cast< unsigned char >( f0 );
+    flag[i + 1] = static_cast< unsigned char >( f1 );
+    insideAll &= f0 & f1;
+  }
+  pt += i;
+#endif
+
+  for ( ; i < count; ++i, ++pt )
+  {
+    const int f = ( pt->x() < xMax ? InsideXMax : 0 )
+                  | ( pt->x() > xMin ? InsideXMin : 0 )
+                  | ( pt->y() < yMax ? InsideYMax : 0 )
+                  | ( pt->y() > yMin ? InsideYMin : 0 );
+    flag[i] = static_cast< unsigned char >( f );
+    insideAll &= f;
+  }
+  return insideAll;
+}
+
+void QgsClipper::trimPolygonToBoundary( const QPolygonF &inPts, const QVector<unsigned char> &flags, QPolygonF &outPts, const QgsRectangle &rect, Boundary b )
 {
-  const int nPoints = curve.numPoints();
+  int flag = 0;
+  switch ( b )
+  {
+    case XMax:
+      flag = InsideXMax;
+      break;
+    case XMin:
+      flag = InsideXMin;
+      break;
+    case YMax:
+      flag = InsideYMax;
+      break;
+    case YMin:
+      flag = InsideYMin;
+      break;
+  }
+
+  const int count = inPts.size();
+  const QPointF *pts = inPts.constData();
+  const unsigned char *inside = flags.constData();
+
+  int i1 = count - 1; // start with last point
 
+  // and compare to the first point initially.
+  for ( int i2 = 0; i2 < count; ++i2 )
+  {
+    // look at each edge of the polygon in turn
+    if ( inside[i2] & flag ) // end point of edge is inside boundary
+    {
+      if ( !( inside[i1] & flag ) )
+      {
+        // edge crosses into the boundary, so trim back to the boundary
+        outPts.append( intersectRect( pts[i1], pts[i2], b, rect ) );
+      }
+      outPts.append( pts[i2] );
+    }
+    else if ( inside[i1] & flag )
+    {
+      // end point of edge is outside boundary but start point is in boundary, so need to trim back
+      outPts.append( intersectRect( pts[i1], pts[i2], b, rect ) );
+    }
+    i1 = i2;
+  }
+}
+
+template< typename PointAt >
+QPolygonF QgsClipper::clippedLine( int nPoints, PointAt pointAt, const QgsRectangle &clipExtent )
+{
   double p0x, p0y, p1x = 0.0, p1y = 0.0; //original coordinates
   double p1x_c, p1y_c; //clipped end coordinates
   double lastClipX = 0.0, lastClipY = 0.0; //last successfully clipped coords
@@ -53,8 +185,7 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
   {
     if ( i == 0 )
     {
-      p1x = curve.xAt( i );
-      p1y = curve.yAt( i );
+      pointAt( i, p1x, p1y );
       continue;
     }
     else
@@ -62,8 +193,7 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
       p0x = p1x;
       p0y = p1y;
 
-      p1x = curve.xAt( i );
-      p1y = curve.yAt( i );
+      pointAt( i, p1x, p1y );
 
       p1x_c = p1x;
       p1y_c = p1y;
@@ -92,6 +222,37 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
   return line;
 }
 
+QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent )
+{
+  // line strings give direct access to their coordinates, avoiding a virtual call per vertex
+  if ( const QgsLineString *lineString = qgsgeometry_cast< const QgsLineString * >( &curve ) )
+  {
+    const double *xData = lineString->xData();
+    const double *yData = lineString->yData();
+    return clippedLine( lineString->numPoints(), [xData, yData]( int i, double & x, double & y )
+    {
+      x = xData[i];
+      y = yData[i];
+    }, clipExtent );
+  }
+
+  return clippedLine( curve.numPoints(), [&curve]( int i, double & x, double & y )
+  {
+    x = curve.xAt( i );
+    y = curve.yAt( i );
+  }, clipExtent );
+}
+
+QPolygonF QgsClipper::clippedLine( const QPolygonF &points, const QgsRectangle &clipExtent )
+{
+  const QPointF *data = points.constData();
+  return clippedLine( points.size(), [data]( int i, double & x, double & y )
+  {
+    x = data[i].x();
+    y = data[i].y();
+  }, clipExtent );
+}
+
 void QgsClipper::connectSeparatedLines( double x0, double y0, double x1, double y1,
                                         const QgsRectangle &clipRect, QPolygonF &pts )
 {
@@ -98,6 +98,13 @@ class CORE_EXPORT QgsClipper
 
     SIP_END
 
+    /**
+     * Trims the given polygon to the rectangular \a clipRect, in place.
+     *
+     * The inside/outside tests are done for all vertices at once before each clipping pass,
+     * and boundaries which all vertices are inside of are skipped, so polygons lying
+     * completely within the clip rectangle are returned untouched.
+     */
     static void trimPolygon( QPolygonF &pts, const QgsRectangle &clipRect );
 
     /**
@@ -108,11 +115,26 @@ class CORE_EXPORT QgsClipper
      */
     static QPolygonF clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent );
 
+    /**
+     * Takes a line given by its \a points and clips it to clipExtent,
+     * e.g. for clipping the point sequences of a QgsWkbGeometryView.
+     * \param points the vertices of the line
+     * \param clipExtent clipping bounds
+     * \returns clipped line coordinates
+     * \since QGIS 3.0
+     */
+    static QPolygonF clippedLine( const QPolygonF &points, const QgsRectangle &clipExtent );
+
   private:
 
     // Used when testing for equivalance to 0.0
     static const double SMALL_NUM;
 
+#ifndef SIP_RUN
+    // Clips the line with nPoints vertices, reading vertex i through pointAt( i, x, y )
+    template< typename PointAt > static QPolygonF clippedLine( int nPoints, PointAt pointAt, const QgsRectangle &clipExtent );
+#endif
+
     // Trims the given feature to the given boundary. Returns the
     // trimmed feature in the outX and outY vectors.
     static void trimFeatureToBoundary( const QVector<double> &inX,
@@ -122,13 +144,27 @@ class CORE_EXPORT QgsClipper
                                        Boundary b,
                                        bool shapeOpen );
 
-    static void trimPolygonToBoundary( const QPolygonF &inPts, QPolygonF &outPts, const QgsRectangle &rect, Boundary b, double boundaryValue );
+    // Flags set by insideFlags() for the boundaries a point is inside of
+    enum InsideFlag
+    {
+      InsideXMax = 1,
+      InsideXMin = 1 << 1,
+      InsideYMax = 1 << 2,
+      InsideYMin = 1 << 3,
+      InsideAll = InsideXMax | InsideXMin | InsideYMax | InsideYMin
+    };
+
+    // Tests all points against the four boundaries of rect in one pass, storing
+    // a combination of InsideFlag values for each point in flags. Returns the
+    // flags which are set for all of the points.
+    static int insideFlags( const QPolygonF &pts, const QgsRectangle &rect, QVector<unsigned char> &flags );
+
+    // Trims the polygon to the given boundary, using the flags computed by insideFlags()
+    static void trimPolygonToBoundary( const QPolygonF &inPts, const QVector<unsigned char> &flags, QPolygonF &outPts, const QgsRectangle &rect, Boundary b );
 
     // Determines if a point is inside or outside the given boundary
     static bool inside( const double x, const double y, Boundary b );
 
-    static bool inside( QPointF pt, Boundary b, double val );
-
     // Calculates the intersection point between a line defined by a
     // (x1, y1), and (x2, y2) and the given boundary
     static QgsPointXY intersect( const double x1, const double y1,
@@ -199,20 +235,6 @@ inline void QgsClipper::trimFeature( QVector<double> &x,
   trimFeatureToBoundary( tmpX, tmpY, x, y, YMin, shapeOpen );
 }
 
-inline void QgsClipper::trimPolygon( QPolygonF &pts, const QgsRectangle &clipRect )
-{
-  QPolygonF tmpPts;
-  tmpPts.reserve( pts.size() );
-
-  trimPolygonToBoundary( pts, tmpPts, clipRect, XMax, clipRect.xMaximum() );
-  pts.resize( 0 );
-  trimPolygonToBoundary( tmpPts, pts, clipRect, YMax, clipRect.yMaximum() );
-  tmpPts.resize( 0 );
-  trimPolygonToBoundary( pts, tmpPts, clipRect, XMin, clipRect.xMinimum() );
-  pts.resize( 0 );
-  trimPolygonToBoundary( tmpPts, pts, clipRect, YMin, clipRect.yMinimum() );
-}
-
 // An auxiliary function that is part of the polygon trimming
 // code. Will trim the given polygon to the given boundary and return
 // the trimmed polygon in the out pointer. Uses Sutherland and
@@ -284,40 +306,6 @@ inline void QgsClipper::trimFeatureToBoundary(
   }
 }
 
-inline void QgsClipper::trimPolygonToBoundary( const QPolygonF &inPts, QPolygonF &outPts, const QgsRectangle &rect, Boundary b, double boundaryValue )
-{
-  int i1 = inPts.size() - 1; // start with last point
-
-  // and compare to the first point initially.
-  for ( int i2 = 0; i2 < inPts.size() ; ++i2 )
-  {
-    // look at each edge of the polygon in turn
-    if ( inside( inPts[i2], b, boundaryValue ) ) // end point of edge is inside boundary
-    {
-      if ( inside( inPts[i1], b, boundaryValue ) )
-      {
-        outPts.append( inPts[i2] );
-      }
-      else
-      {
-        // edge crosses into the boundary, so trim back to the boundary, and
-        // store both ends of the new edge
-        outPts.append( intersectRect( inPts[i1], inPts[i2], b, rect ) );
-        outPts.append( inPts[i2] );
-      }
-    }
-    else // end point of edge is outside boundary
-    {
-      // start point is in boundary, so need to trim back
-      if ( inside( inPts[i1], b, boundaryValue ) )
-      {
-        outPts.append( intersectRect( inPts[i1], inPts[i2], b, rect ) );
-      }
-    }
-    i1 = i2;
-  }
-}
-
 // An auxiliary function to trimPolygonToBoundarY() that returns
 // whether a point is inside or outside the given boundary.
 
@@ -345,23 +333,6 @@ inline bool QgsClipper::inside( const double x, const double y, Boundary b )
   return false;
 }
 
-inline bool QgsClipper::inside( QPointF pt, Boundary b, double val )
-{
-  switch ( b )
-  {
-    case XMax: // x < MAX_X is inside
-      return ( pt.x() < val );
-    case XMin: // x > MIN_X is inside
-      return ( pt.x() > val );
-    case YMax: // y < MAX_Y is inside
-      return ( pt.y() < val );
-    case YMin: // y > MIN_Y is inside
-      return ( pt.y() > val );
-  }
-  return false;
-}
-
-
 // An auxiliary function to trimPolygonToBoundarY() that calculates and
 // returns the intersection of the line defined by the given points
 // and the given boundary.
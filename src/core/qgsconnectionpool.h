@@ -19,6 +19,7 @@
 #define SIP_NO_FILE
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QMap>
 #include <QMutex>
 #include <QSemaphore>
@@ -27,9 +28,37 @@
 #include <QTimer>
 #include <QThread>
 
+#include <algorithm>
+
 
 #define CONN_POOL_MAX_CONCURRENT_CONNS      4
 #define CONN_POOL_EXPIRATION_TIME           60    // in seconds
+#define CONN_POOL_MAX_SHARED_USERS          8
+
+
+/**
+ * \ingroup core
+ * Statistics about the connections acquired from a QgsConnectionPoolGroup.
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+struct QgsConnectionPoolStatistics
+{
+  //! Number of acquired connections
+  int acquired = 0;
+
+  //! Number of acquisitions which got a connection shared with other users
+  int shared = 0;
+
+  //! Number of acquisitions which had to wait for a connection to be released
+  int waited = 0;
+
+  //! Total time spent waiting for connections, in milliseconds
+  qint64 totalWaitTime = 0;
+
+  //! Longest time spent waiting for a connection, in milliseconds
+  qint64 maxWaitTime = 0;
+};
 
 
 /**
@@ -50,6 +79,12 @@
  * - having handleConnectionExpired() slot that calls onConnectionExpired()
  * - having startExpirationTimer(), stopExpirationTimer() slots to start/stop the expiration timer
  *
+ * Connections can also be acquired as shareable. When all connections of the group are in use,
+ * a shareable acquisition does not block but gets one of the connections which are already
+ * acquired as shareable, the one with the fewest users. Up to CONN_POOL_MAX_SHARED_USERS users
+ * can share a connection, the place which uses a shared connection is responsible for
+ * serializing the access to it.
+ *
  * For an example on how to use the template class, have a look at the implementation in Postgres/SpatiaLite providers.
  * \note not available in Python bindings
  */
@@ -66,6 +101,13 @@ class QgsConnectionPoolGroup
       QTime lastUsedTime;
     };
 
+    //! A connection acquired as shareable, with its number of users
+    struct SharedItem
+    {
+      T c;
+      int users;
+    };
+
     QgsConnectionPoolGroup( const QString &ci )
       : connInfo( ci )
       , sem( CONN_POOL_MAX_CONCURRENT_CONNS )
@@ -85,10 +127,51 @@ class QgsConnectionPoolGroup
     //! QgsConnectionPoolGroup cannot be copied
     QgsConnectionPoolGroup &operator=( const QgsConnectionPoolGroup &other ) = delete;
 
-    T acquire()
+    /**
+     * Acquires a connection. If \a shareable is true, the connection may be shared with other
+     * shareable users when all the connections of the group are in use.
+     */
+    T acquire( bool shareable = false )
     {
-      // we are going to acquire a resource - if no resource is available, we will block here
-      sem.acquire();
+      QElapsedTimer waitTimer;
+      waitTimer.start();
+
+      if ( shareable && !sem.tryAcquire() )
+      {
+        // all connections are in use - share the least used shareable connection
+        QMutexLocker locker( &connMutex );
+
+        int best = -1;
+        for ( int i = 0; i < sharedConns.count(); ++i )
+        {
+          if ( sharedConns.at( i ).users < CONN_POOL_MAX_SHARED_USERS && ( best < 0 || sharedConns.at( i ).users < sharedConns.at( best ).users ) )
+            best = i;
+        }
+
+        if ( best >= 0 )
+        {
+          // move the connection to the end, so that connections with the same number of users are picked in turn
+          SharedItem item = sharedConns.takeAt( best );
+          item.users++;
+          sharedConns.append( item );
+
+          stats.acquired++;
+          stats.shared++;
+          return item.c;
+        }
+
+        locker.unlock();
+
+        // we are going to acquire a resource - if no resource is available, we will block here
+        sem.acquire();
+      }
+      else if ( !shareable )
+      {
+        // we are going to acquire a resource - if no resource is available, we will block here
+        sem.acquire();
+      }
+
+      const qint64 waitTime = waitTimer.elapsed();
 
       // quick (preferred) way - use cached connection
       {
@@ -110,7 +193,7 @@ class QgsConnectionPoolGroup
             QMetaObject::invokeMethod( expirationTimer->parent(), "stopExpirationTimer" );
           }
 
-          acquiredConns.append( i.c );
+          recordAcquired( i.c, shareable, waitTime );
 
           return i.c;
         }
@@ -126,7 +209,7 @@ class QgsConnectionPoolGroup
       }
 
       connMutex.lock();
-      acquiredConns.append( c );
+      recordAcquired( c, shareable, waitTime );
       connMutex.unlock();
       return c;
     }
@@ -134,6 +217,23 @@ class QgsConnectionPoolGroup
     void release( T conn )
     {
       connMutex.lock();
+
+      for ( int i = 0; i < sharedConns.count(); ++i )
+      {
+        if ( sharedConns.at( i ).c != conn )
+          continue;
+
+        // the connection goes back to the pool once its last user has released it
+        if ( --sharedConns[i].users > 0 )
+        {
+          connMutex.unlock();
+          return;
+        }
+
+        sharedConns.removeAt( i );
+        break;
+      }
+
       acquiredConns.removeAll( conn );
       if ( !qgsConnectionPool_ConnectionIsValid( conn ) )
       {
@@ -158,6 +258,13 @@ class QgsConnectionPoolGroup
       sem.release(); // this can unlock a thread waiting in acquire()
     }
 
+    //! Returns statistics about the connections acquired from the group
+    QgsConnectionPoolStatistics statistics()
+    {
+      QMutexLocker locker( &connMutex );
+      return stats;
+    }
+
     void invalidateConnections()
     {
       connMutex.lock();
@@ -212,14 +319,38 @@ class QgsConnectionPoolGroup
       connMutex.unlock();
     }
 
+    //! Records a connection acquired from the pool or newly created, connMutex must be locked
+    void recordAcquired( T c, bool shareable, qint64 waitTime )
+    {
+      acquiredConns.append( c );
+      if ( shareable )
+      {
+        SharedItem item;
+        item.c = c;
+        item.users = 1;
+        sharedConns.append( item );
+      }
+
+      stats.acquired++;
+      // a connection which is available right away is acquired in no measurable time
+      if ( waitTime > 0 )
+      {
+        stats.waited++;
+        stats.totalWaitTime += waitTime;
+        stats.maxWaitTime = std::max( stats.maxWaitTime, waitTime );
+      }
+    }
+
   protected:
 
     QString connInfo;
     QStack<Item> conns;
     QList<T> acquiredConns;
+    QList<SharedItem> sharedConns;
     QMutex connMutex;
     QSemaphore sem;
     QTimer *expirationTimer = nullptr;
+    QgsConnectionPoolStatistics stats;
 
 };
 
@@ -260,9 +391,11 @@ class QgsConnectionPool
 
     /**
      * Try to acquire a connection: if no connections are available, the thread will get blocked.
+     * If \a shareable is true, the thread only gets blocked if all connections are already shared by
+     * the maximum number of users, see QgsConnectionPoolGroup.
      * \returns initialized connection or null on error
      */
-    T acquireConnection( const QString &connInfo )
+    T acquireConnection( const QString &connInfo, bool shareable = false )
     {
       mMutex.lock();
       typename T_Groups::iterator it = mGroups.find( connInfo );
@@ -273,7 +406,7 @@ class QgsConnectionPool
       T_Group *group = *it;
       mMutex.unlock();
 
-      return group->acquire();
+      return group->acquire( shareable );
     }
 
     //! Release an existing connection so it will get back into the pool and can be reused
@@ -304,6 +437,18 @@ class QgsConnectionPool
     }
 
 
+    /**
+     * Returns statistics about the connections acquired for the specified resource,
+     * e.g. how long the threads had to wait for a connection.
+     * \since QGIS 3.0
+     */
+    QgsConnectionPoolStatistics statistics( const QString &connInfo )
+    {
+      QMutexLocker locker( &mMutex );
+      typename T_Groups::const_iterator it = mGroups.constFind( connInfo );
+      return it != mGroups.constEnd() ? ( *it )->statistics() : QgsConnectionPoolStatistics();
+    }
+
   protected:
     T_Groups mGroups;
     QMutex mMutex;
@@ -24,6 +24,7 @@
 #include "qgsdistancearea.h"
 #include "qgsunittypes.h"
 #include "qgsexpressionnode.h"
+#include "qgsexpressionprogram.h"
 
 ///@cond
 
@@ -64,6 +65,9 @@ class QgsExpressionPrivate
 
     QString mExp;
 
+    //! Compiled program, not copied as it refers to the nodes of this expression tree
+    std::unique_ptr<QgsExpressionProgram> mProgram;
+
     std::shared_ptr<QgsDistanceArea> mCalc;
     QgsUnitTypes::DistanceUnit mDistanceUnit = QgsUnitTypes::DistanceUnknownUnit;
     QgsUnitTypes::AreaUnit mAreaUnit = QgsUnitTypes::AreaUnknownUnit;
@@ -7,6 +7,7 @@
 #include "qgspallabeling.h"
 #include "geos_c.h"
 #include "qgsmargins.h"
+#include "qgslabelplacementcache.h"
 
 namespace pal
 {
@@ -342,6 +343,21 @@ class CORE_EXPORT QgsLabelFeature
     //! Return provider of this instance
     QgsAbstractLabelProvider *provider() const;
 
+    /**
+     * Returns the label positions placed for this feature in a previous render.
+     * If one of them still matches the feature, it is used as the only candidate.
+     * \see setPreviousPlacements()
+     * \since QGIS 3.0
+     */
+    QList< QgsLabelPlacementCache::Placement > previousPlacements() const { return mPreviousPlacements; }
+
+    /**
+     * Sets the label positions placed for this feature in a previous render.
+     * \see previousPlacements()
+     * \since QGIS 3.0
+     */
+    void setPreviousPlacements( const QList< QgsLabelPlacementCache::Placement > &placements ) { mPreviousPlacements = placements; }
+
   protected:
     //! Pointer to PAL layer (assigned when registered to PAL)
     pal::Layer *mLayer = nullptr;
@@ -396,6 +412,8 @@ class CORE_EXPORT QgsLabelFeature
     QString mLabelText;
     //! extra information for curved labels (may be null)
     pal::LabelInfo *mInfo = nullptr;
+    //! label positions placed in a previous render
+    QList< QgsLabelPlacementCache::Placement > mPreviousPlacements;
 
   private:
 
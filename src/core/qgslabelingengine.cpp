@@ -25,6 +25,7 @@
 #include "problem.h"
 #include "qgsrendercontext.h"
 #include "qgsmaplayer.h"
+#include "qgsruntimeprofiler.h"
 
 
 // helper function for checking for job cancelation within PAL
@@ -77,6 +78,8 @@ QgsLabelingEngine::QgsLabelingEngine()
 
 QgsLabelingEngine::~QgsLabelingEngine()
 {
+  // PAL layers refer to the label features owned by the providers
+  mPal.reset();
   qDeleteAll( mProviders );
   qDeleteAll( mSubProviders );
 }
@@ -112,7 +115,7 @@ void QgsLabelingEngine::removeProvider( QgsAbstractLabelProvider *provider )
   }
 }
 
-void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p )
+void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p, QList< pal::Layer * > *palLayers )
 {
   QgsAbstractLabelProvider::Flags flags = provider->flags();
 
@@ -125,6 +128,9 @@ void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, Qgs
                               flags.testFlag( QgsAbstractLabelProvider::DrawLabels ),
                               flags.testFlag( QgsAbstractLabelProvider::DrawAllLabels ) );
 
+  if ( palLayers )
+    palLayers->append( l );
+
   // extra flags for placement of labels for linestrings
   l->setArrangementFlags( static_cast< pal::LineArrangementFlags >( provider->linePlacementFlags() ) );
 
@@ -162,8 +168,17 @@ void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, Qgs
 
   QList<QgsLabelFeature *> features = provider->labelFeatures( context );
 
+  // labels placed by a previous render at the same scale
+  QgsLabelPlacementCache::LayerPlacements previousPlacements;
+  if ( usePlacementCache() )
+    previousPlacements = mPlacementCache->layerPlacements( provider->layerId(), mMapSettings.scale() );
+
   Q_FOREACH ( QgsLabelFeature *feature, features )
   {
+    QgsLabelPlacementCache::LayerPlacements::const_iterator previousIt = previousPlacements.constFind( feature->id() );
+    if ( previousIt != previousPlacements.constEnd() )
+      feature->setPreviousPlacements( previousIt.value() );
+
     try
     {
       l->registerFeature( feature );
@@ -179,17 +194,18 @@ void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, Qgs
   // any sub-providers?
   Q_FOREACH ( QgsAbstractLabelProvider *subProvider, provider->subProviders() )
   {
+    mMutex.lock();
     mSubProviders << subProvider;
-    processProvider( subProvider, context, p );
+    mMutex.unlock();
+    processProvider( subProvider, context, p, palLayers );
   }
 }
 
-
-void QgsLabelingEngine::run( QgsRenderContext &context )
+pal::Pal *QgsLabelingEngine::createPal() const
 {
   const QgsLabelingEngineSettings &settings = mMapSettings.labelingEngineSettings();
 
-  pal::Pal p;
+  pal::Pal *p = new pal::Pal();
   pal::SearchMethod s;
   switch ( settings.searchMethod() )
   {
@@ -210,21 +226,144 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
       s = pal::FALP;
       break;
   }
-  p.setSearch( s );
+  p->setSearch( s );
 
   // set number of candidates generated per feature
   int candPoint, candLine, candPolygon;
   settings.numCandidatePositions( candPoint, candLine, candPolygon );
-  p.setPointP( candPoint );
-  p.setLineP( candLine );
-  p.setPolyP( candPolygon );
+  p->setPointP( candPoint );
+  p->setLineP( candLine );
+  p->setPolyP( candPolygon );
+
+  p->setShowPartial( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
+  p->setParallelSolver( settings.testFlag( QgsLabelingEngineSettings::ParallelSolver ) );
+
+  return p;
+}
+
+QgsRectangle QgsLabelingEngine::labelingExtent() const
+{
+  QgsGeometry extentGeom = QgsGeometry::fromRect( mMapSettings.visibleExtent() );
+  if ( !qgsDoubleNear( mMapSettings.rotation(), 0.0 ) )
+  {
+    //PAL features are prerotated, so extent also needs to be unrotated
+    extentGeom.rotate( -mMapSettings.rotation(), mMapSettings.visibleExtent().center() );
+  }
+
+  return extentGeom.boundingBox();
+}
+
+bool QgsLabelingEngine::usePlacementCache() const
+{
+  // PAL features are prerotated around the center of the map, so positions
+  // do not survive panning of a rotated map
+  return mPlacementCache && qgsDoubleNear( mMapSettings.rotation(), 0.0 );
+}
 
-  p.setShowPartial( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
+void QgsLabelingEngine::updatePlacementCache( const QList< pal::LabelPosition * > &labels )
+{
+  QHash< QString, QgsLabelPlacementCache::LayerPlacements > placements;
+  Q_FOREACH ( pal::LabelPosition *lp, labels )
+  {
+    QgsLabelFeature *lf = lp->getFeaturePart()->feature();
+    // curved labels are always placed again
+    if ( !lf || !lf->provider() || lp->getNextPart() )
+      continue;
 
+    QgsLabelPlacementCache::Placement placement;
+    placement.providerId = lf->provider()->providerId();
+    double amin[2];
+    double amax[2];
+    lp->getFeaturePart()->getBoundingBox( amin, amax );
+    placement.partExtent = QgsRectangle( amin[0], amin[1], amax[0], amax[1] );
+    placement.width = lp->getWidth();
+    placement.height = lp->getHeight();
+    placement.reversed = lp->getReversed();
+    placement.quadrant = lp->getQuadrant();
+    if ( lp->getUpsideDown() )
+    {
+      // store the position as it was created, before it got turned upright
+      placement.x = lp->getX( 2 );
+      placement.y = lp->getY( 2 );
+      placement.angle = lp->getAlpha() + M_PI;
+    }
+    else
+    {
+      placement.x = lp->getX();
+      placement.y = lp->getY();
+      placement.angle = lp->getAlpha();
+    }
+    placements[ lf->provider()->layerId()][ lf->id()].append( placement );
+  }
+
+  // layers without any placed label are updated too
+  Q_FOREACH ( QgsMapLayer *layer, participatingLayers() )
+  {
+    mPlacementCache->setLayerPlacements( layer, mMapSettings.scale(), placements.value( layer->id() ) );
+  }
+}
+
+void QgsLabelingEngine::prepareLayer( const QString &layerId, QgsRenderContext &context )
+{
+  if ( layerId.isEmpty() )
+    return;
+
+  QList< QgsAbstractLabelProvider * > providers;
+  pal::Pal *p = nullptr;
+  {
+    QMutexLocker locker( &mMutex );
+    Q_FOREACH ( QgsAbstractLabelProvider *provider, mProviders )
+    {
+      if ( provider->layerId() == layerId && !mPreparedProviders.contains( provider ) )
+      {
+        providers << provider;
+        mPreparedProviders << provider;
+      }
+    }
+    if ( providers.isEmpty() )
+      return;
+
+    if ( !mPal )
+      mPal.reset( createPal() );
+    p = mPal.get();
+  }
+
+  QgsRectangle extent = labelingExtent();
+  double bbox[] = { extent.xMinimum(), extent.yMinimum(), extent.xMaximum(), extent.yMaximum() };
+
+  Q_FOREACH ( QgsAbstractLabelProvider *provider, providers )
+  {
+    QList< pal::Layer * > palLayers;
+    processProvider( provider, context, *p, &palLayers );
+
+    Q_FOREACH ( pal::Layer *layer, palLayers )
+    {
+      p->prepareLayer( layer, bbox );
+    }
+  }
+}
+
+
+void QgsLabelingEngine::run( QgsRenderContext &context )
+{
+  const QgsLabelingEngineSettings &settings = mMapSettings.labelingEngineSettings();
+
+  // reuse the PAL instance with layers registered by prepareLayer(), if any
+  std::unique_ptr< pal::Pal > palInstance;
+  {
+    QMutexLocker locker( &mMutex );
+    palInstance.reset( mPal ? mPal.release() : createPal() );
+  }
+  pal::Pal &p = *palInstance;
 
   // for each provider: get labels and register them in PAL
   Q_FOREACH ( QgsAbstractLabelProvider *provider, mProviders )
   {
+    if ( mPreparedProviders.contains( provider ) )
+      continue;
+
+    QgsScopedRuntimeProfile profile( context.profiler(), QStringLiteral( "register" ) );
+
     bool appendedLayerScope = false;
     if ( QgsMapLayer *ml = provider->layer() )
     {
@@ -235,20 +374,14 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
     if ( appendedLayerScope )
       delete context.expressionContext().popScope();
   }
+  mPreparedProviders.clear();
 
 
   // NOW DO THE LAYOUT (from QgsPalLabeling::drawLabeling)
 
   QPainter *painter = context.painter();
 
-  QgsGeometry extentGeom = QgsGeometry::fromRect( mMapSettings.visibleExtent() );
-  if ( !qgsDoubleNear( mMapSettings.rotation(), 0.0 ) )
-  {
-    //PAL features are prerotated, so extent also needs to be unrotated
-    extentGeom.rotate( -mMapSettings.rotation(), mMapSettings.visibleExtent().center() );
-  }
-
-  QgsRectangle extent = extentGeom.boundingBox();
+  QgsRectangle extent = labelingExtent();
 
   p.registerCancelationCallback( &_palIsCanceled, reinterpret_cast< void * >( &context ) );
 
@@ -262,6 +395,7 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
   pal::Problem *problem = nullptr;
   try
   {
+    QgsScopedRuntimeProfile profile( context.profiler(), QStringLiteral( "problem" ) );
     problem = p.extractProblem( bbox );
   }
   catch ( std::exception &e )
@@ -308,7 +442,10 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
   }
 
   // find the solution
-  labels = p.solveProblem( problem, settings.testFlag( QgsLabelingEngineSettings::UseAllLabels ) );
+  {
+    QgsScopedRuntimeProfile profile( context.profiler(), QStringLiteral( "solve" ) );
+    labels = p.solveProblem( problem, settings.testFlag( QgsLabelingEngineSettings::UseAllLabels ) );
+  }
 
   QgsDebugMsgLevel( QString( "LABELING work:  %1 ms ... labels# %2" ).arg( t.elapsed() ).arg( labels->size() ), 4 );
   t.restart();
@@ -319,12 +456,16 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
     delete labels;
     return;
   }
+
+  if ( usePlacementCache() )
+    updatePlacementCache( *labels );
   painter->setRenderHint( QPainter::Antialiasing );
 
   // sort labels
   std::sort( labels->begin(), labels->end(), QgsLabelSorter( mMapSettings ) );
 
   // draw the labels
+  QgsScopedRuntimeProfile drawProfile( context.profiler(), QStringLiteral( "draw" ) );
   QList<pal::LabelPosition *>::iterator it = labels->begin();
   for ( ; it != labels->end(); ++it )
   {
@@ -23,6 +23,10 @@
 
 #include "qgspallabeling.h"
 #include "qgslabelingenginesettings.h"
+#include "qgslabelplacementcache.h"
+
+#include <QMutex>
+#include <QSet>
 
 
 class QgsLabelingEngine;
@@ -188,6 +192,23 @@ class CORE_EXPORT QgsLabelingEngine
     //! Get associated labeling engine settings
     const QgsLabelingEngineSettings &engineSettings() const { return mMapSettings.labelingEngineSettings(); }
 
+    /**
+     * Assigns a cache of label placements from previous renders. Features whose labels
+     * were placed at the same scale keep their previous position, and the placements
+     * computed by run() are stored in the cache. Does not take ownership of the object.
+     * The cache is not used for rotated maps.
+     * \see placementCache()
+     * \since QGIS 3.0
+     */
+    void setPlacementCache( QgsLabelPlacementCache *cache ) { mPlacementCache = cache; }
+
+    /**
+     * Returns the cache of label placements from previous renders, if set.
+     * \see setPlacementCache()
+     * \since QGIS 3.0
+     */
+    QgsLabelPlacementCache *placementCache() const { return mPlacementCache; }
+
     /**
      * Returns a list of layers with providers in the engine.
      * \since QGIS 3.0
@@ -200,6 +221,18 @@ class CORE_EXPORT QgsLabelingEngine
     //! Remove provider if the provider's initialization failed. Provider instance is deleted.
     void removeProvider( QgsAbstractLabelProvider *provider );
 
+    /**
+     * Registers the label features of all providers associated with the layer with
+     * the specified \a layerId and generates their candidate label positions.
+     *
+     * This may be called (from any thread) as soon as the layer has finished registering
+     * its features, while other layers are still being rendered. A subsequent run() then
+     * only needs to process the remaining providers and solve the labeling problem.
+     * The \a context should be the render context of the layer.
+     * \since QGIS 3.0
+     */
+    void prepareLayer( const QString &layerId, QgsRenderContext &context );
+
     //! compute the labeling with given map settings and providers
     void run( QgsRenderContext &context );
 
@@ -210,7 +243,12 @@ class CORE_EXPORT QgsLabelingEngine
     QgsLabelingResults *results() const { return mResults.get(); }
 
   protected:
-    void processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p );
+
+    /**
+     * Registers the label features of \a provider (and its sub-providers) with \a p.
+     * The created PAL layers are appended to \a palLayers if it is not null.
+     */
+    void processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p, QList< pal::Layer * > *palLayers = nullptr );
 
   protected:
     //! Associated map settings instance
@@ -223,6 +261,32 @@ class CORE_EXPORT QgsLabelingEngine
     //! Resulting labeling layout
     std::unique_ptr< QgsLabelingResults > mResults;
 
+  private:
+
+    //! Creates a new PAL instance configured from the labeling engine settings
+    pal::Pal *createPal() const;
+
+    //! Returns the labeling extent (in map units, unrotated)
+    QgsRectangle labelingExtent() const;
+
+    //! Returns whether the placement cache should be used for the current map settings
+    bool usePlacementCache() const;
+
+    //! Stores the placed \a labels in the placement cache
+    void updatePlacementCache( const QList< pal::LabelPosition * > &labels );
+
+    //! Cache of label placements from previous renders (not owned)
+    QgsLabelPlacementCache *mPlacementCache = nullptr;
+
+    //! PAL instance holding the layers registered by prepareLayer(), until the engine is run
+    std::unique_ptr< pal::Pal > mPal;
+
+    //! Providers already processed by prepareLayer()
+    QSet< QgsAbstractLabelProvider * > mPreparedProviders;
+
+    //! Protects mPal, mPreparedProviders and mSubProviders while layers are prepared concurrently
+    QMutex mMutex;
+
 };
 
 
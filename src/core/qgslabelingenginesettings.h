@@ -23,6 +23,7 @@ class CORE_EXPORT QgsLabelingEngineSettings
       RenderOutlineLabels   = 1 << 3,  //!< Whether to render labels as text or outlines
       DrawLabelRectOnly     = 1 << 4,  //!< Whether to only draw the label rect and not the actual label text (used for unit tests)
       DrawCandidates        = 1 << 5,  //!< Whether to draw rectangles of generated candidates (good for debugging)
+      ParallelSolver        = 1 << 6,  //!< Whether to split the label placement problem into independent parts which are solved in parallel (since QGIS 3.0)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
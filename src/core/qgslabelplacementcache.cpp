@@ -0,0 +1,105 @@
+/***************************************************************************
+  qgslabelplacementcache.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgslabelplacementcache.h"
+
+#include <cmath>
+
+QgsLabelPlacementCache::QgsLabelPlacementCache()
+{
+}
+
+void QgsLabelPlacementCache::clear()
+{
+  QMutexLocker lock( &mMutex );
+  disconnectLayers();
+  mBands.clear();
+  mBandOrder.clear();
+}
+
+void QgsLabelPlacementCache::disconnectLayers()
+{
+  Q_FOREACH ( const QgsWeakMapLayerPointer &layer, mConnectedLayers )
+  {
+    if ( layer.data() )
+    {
+      disconnect( layer.data(), &QgsMapLayer::repaintRequested, this, &QgsLabelPlacementCache::layerRequestedRepaint );
+      disconnect( layer.data(), &QgsMapLayer::willBeDeleted, this, &QgsLabelPlacementCache::layerRequestedRepaint );
+    }
+  }
+  mConnectedLayers.clear();
+}
+
+void QgsLabelPlacementCache::invalidateLayer( const QString &layerId )
+{
+  QMutexLocker lock( &mMutex );
+  QHash< int, BandPlacements >::iterator it = mBands.begin();
+  for ( ; it != mBands.end(); ++it )
+  {
+    it.value().remove( layerId );
+  }
+}
+
+QgsLabelPlacementCache::LayerPlacements QgsLabelPlacementCache::layerPlacements( const QString &layerId, double scale ) const
+{
+  QMutexLocker lock( &mMutex );
+  return mBands.value( scaleBand( scale ) ).value( layerId );
+}
+
+void QgsLabelPlacementCache::setLayerPlacements( QgsMapLayer *layer, double scale, const LayerPlacements &placements )
+{
+  if ( !layer )
+    return;
+
+  QMutexLocker lock( &mMutex );
+
+  int band = scaleBand( scale );
+  mBandOrder.removeOne( band );
+  mBandOrder.append( band );
+  while ( mBandOrder.count() > MAX_SCALE_BANDS )
+  {
+    mBands.remove( mBandOrder.takeFirst() );
+  }
+
+  if ( placements.isEmpty() )
+    mBands[ band ].remove( layer->id() );
+  else
+    mBands[ band ].insert( layer->id(), placements );
+
+  // connect to the layer to listen to layer's repaintRequested() signals
+  if ( !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
+  {
+    connect( layer, &QgsMapLayer::repaintRequested, this, &QgsLabelPlacementCache::layerRequestedRepaint );
+    connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsLabelPlacementCache::layerRequestedRepaint );
+    mConnectedLayers << layer;
+  }
+}
+
+int QgsLabelPlacementCache::scaleBand( double scale )
+{
+  // label sizes in map units change with the scale, so bands are narrow enough
+  // to only match renders at the same scale (allowing for rounding errors)
+  if ( scale <= 0 )
+    return 0;
+  return static_cast< int >( std::floor( std::log2( scale ) * 4096 + 0.5 ) );
+}
+
+void QgsLabelPlacementCache::layerRequestedRepaint()
+{
+  QgsMapLayer *layer = qobject_cast<QgsMapLayer *>( sender() );
+  if ( !layer )
+    return;
+
+  invalidateLayer( layer->id() );
+}
@@ -0,0 +1,125 @@
+/***************************************************************************
+  qgslabelplacementcache.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSLABELPLACEMENTCACHE_H
+#define QGSLABELPLACEMENTCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeature.h"
+#include "qgsmaplayer.h"
+#include "qgsrectangle.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+
+
+/**
+ * \ingroup core
+ * This class keeps the label positions placed by the labeling engine in previous map renders,
+ * so that the following renders at the same scale can keep them instead of generating
+ * and solving all candidates again. Panning the map then only needs to place labels
+ * of features which entered the map view, and labels do not jump between renders.
+ *
+ * Placements are stored per layer, feature ID and scale band. A few of the most recently
+ * used scale bands are kept, so that zooming back to a previous scale reuses its labels.
+ * All placements of a layer are dropped when the layer requests a repaint (e.g. when its
+ * features or style changed).
+ *
+ * The class is thread-safe (multiple classes can access the same instance safely).
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsLabelPlacementCache : public QObject
+{
+    Q_OBJECT
+  public:
+
+    //! A label position placed in a previous render
+    struct Placement
+    {
+      //! ID of the label provider which created the label
+      QString providerId;
+      //! Bounding box of the labeled feature part (in map units)
+      QgsRectangle partExtent;
+      //! X coordinate of the candidate's origin (in map units)
+      double x = 0;
+      //! Y coordinate of the candidate's origin (in map units)
+      double y = 0;
+      //! Width of the label (in map units)
+      double width = 0;
+      //! Height of the label (in map units)
+      double height = 0;
+      //! Angle of the label (in radians)
+      double angle = 0;
+      //! Whether the candidate was reversed
+      bool reversed = false;
+      //! Quadrant of the candidate (pal::LabelPosition::Quadrant)
+      int quadrant = 0;
+    };
+
+    //! Placements of a layer's labels, by feature ID
+    typedef QHash< QgsFeatureId, QList< Placement > > LayerPlacements;
+
+    //! Maximum number of scale bands kept in the cache
+    static const int MAX_SCALE_BANDS = 4;
+
+    QgsLabelPlacementCache();
+
+    //! Removes all cached placements
+    void clear();
+
+    //! Removes the cached placements of the layer with the specified \a layerId
+    void invalidateLayer( const QString &layerId );
+
+    /**
+     * Returns the placements of the labels of the layer with \a layerId
+     * which were stored for the given map \a scale.
+     */
+    LayerPlacements layerPlacements( const QString &layerId, double scale ) const;
+
+    /**
+     * Replaces the placements of the labels of \a layer stored for the given map \a scale.
+     */
+    void setLayerPlacements( QgsMapLayer *layer, double scale, const LayerPlacements &placements );
+
+    //! Returns the scale band used for storing placements made at the given map \a scale
+    static int scaleBand( double scale );
+
+  private slots:
+    //! Remove layer (that emitted the signal) from the cache
+    void layerRequestedRepaint();
+
+  private:
+
+    //! Placements of all layers made at one scale band
+    typedef QHash< QString, LayerPlacements > BandPlacements;
+
+    mutable QMutex mMutex;
+
+    //! Placements by scale band
+    QHash< int, BandPlacements > mBands;
+    //! Scale bands, most recently used last
+    QList< int > mBandOrder;
+    //! Layers this cache is connected to
+    QSet< QgsWeakMapLayerPointer > mConnectedLayers;
+
+    //! Disconnects from all layers (without locking)
+    void disconnectLayers();
+};
+
+#endif // QGSLABELPLACEMENTCACHE_H
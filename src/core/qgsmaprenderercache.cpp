@@ -17,6 +17,17 @@
 
 #include "qgsmaplayer.h"
 #include "qgsmaplayerlistutils.h"
+#include "qgsmapsettings.h"
+#include "qgslogger.h"
+#include "qgsreadwritecontext.h"
+#include "qgsvectorlayer.h"
+
+#include <algorithm>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDomDocument>
+#include <QRegularExpression>
+#include <QSaveFile>
 
 QgsMapRendererCache::QgsMapRendererCache()
 {
@@ -26,6 +37,8 @@ QgsMapRendererCache::QgsMapRendererCache()
 void QgsMapRendererCache::clear()
 {
   QMutexLocker lock( &mMutex );
+  mStoredImages.clear();
+  mStoredImageOrder.clear();
   clearInternal();
 }
 
@@ -34,17 +47,27 @@ void QgsMapRendererCache::clearInternal()
   mExtent.setMinimal();
   mScale = 0;
 
-  // make sure we are disconnected from all layers
-  Q_FOREACH ( const QgsWeakMapLayerPointer &layer, mConnectedLayers )
-  {
-    if ( layer.data() )
-    {
-      disconnect( layer.data(), &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-      disconnect( layer.data(), &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
-    }
-  }
   mCachedImages.clear();
-  mConnectedLayers.clear();
+  // disconnect from all layers, except those with stored images
+  dropUnusedConnections();
+}
+
+void QgsMapRendererCache::connectLayer( QgsMapLayer *layer )
+{
+  if ( mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
+    return;
+
+  connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
+  connect( layer, &QgsMapLayer::dataChanged, this, &QgsMapRendererCache::layerRequestedRepaint );
+  connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerWillBeDeleted );
+  mConnectedLayers << layer;
+}
+
+void QgsMapRendererCache::disconnectLayer( QgsMapLayer *layer )
+{
+  disconnect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
+  disconnect( layer, &QgsMapLayer::dataChanged, this, &QgsMapRendererCache::layerRequestedRepaint );
+  disconnect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerWillBeDeleted );
 }
 
 void QgsMapRendererCache::dropUnusedConnections()
@@ -55,8 +78,7 @@ void QgsMapRendererCache::dropUnusedConnections()
   {
     if ( layer.data() )
     {
-      disconnect( layer.data(), &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-      disconnect( layer.data(), &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
+      disconnectLayer( layer.data() );
     }
   }
 
@@ -75,6 +97,17 @@ QSet<QgsWeakMapLayerPointer > QgsMapRendererCache::dependentLayers() const
         result << l;
     }
   }
+  QHash<QString, StoredImage>::const_iterator storedIt = mStoredImages.constBegin();
+  for ( ; storedIt != mStoredImages.constEnd(); ++storedIt )
+  {
+    if ( storedIt.value().layer.data() )
+      result << storedIt.value().layer;
+  }
+  Q_FOREACH ( const QgsWeakMapLayerPointer &l, mStorageLayers )
+  {
+    if ( l.data() )
+      result << l;
+  }
   return result;
 }
 
@@ -96,12 +129,13 @@ bool QgsMapRendererCache::init( const QgsRectangle &extent, double scale )
   return false;
 }
 
-void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &image, const QList<QgsMapLayer *> &dependentLayers )
+void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &image, const QList<QgsMapLayer *> &dependentLayers, const QString &storageKey )
 {
   QMutexLocker lock( &mMutex );
 
   CacheParameters params;
   params.cachedImage = image;
+  params.storageKey = storageKey;
 
   // connect to the layer to listen to layer's repaintRequested() signals
   Q_FOREACH ( QgsMapLayer *layer, dependentLayers )
@@ -109,12 +143,7 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
     if ( layer )
     {
       params.dependentLayers << layer;
-      if ( !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
-      {
-        connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-        connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
-        mConnectedLayers << layer;
-      }
+      connectLayer( layer );
     }
   }
 
@@ -141,6 +170,12 @@ QList< QgsMapLayer * > QgsMapRendererCache::dependentLayers( const QString &cach
   return QList< QgsMapLayer * >();
 }
 
+QString QgsMapRendererCache::cacheImageStorageKey( const QString &cacheKey ) const
+{
+  QMutexLocker lock( &mMutex );
+  return mCachedImages.value( cacheKey ).storageKey;
+}
+
 void QgsMapRendererCache::layerRequestedRepaint()
 {
   QgsMapLayer *layer = qobject_cast<QgsMapLayer *>( sender() );
@@ -148,7 +183,22 @@ void QgsMapRendererCache::layerRequestedRepaint()
     return;
 
   QMutexLocker lock( &mMutex );
+  removeLayer( layer, true );
+}
+
+void QgsMapRendererCache::layerWillBeDeleted()
+{
+  QgsMapLayer *layer = qobject_cast<QgsMapLayer *>( sender() );
+  if ( !layer )
+    return;
+
+  // images on disk stay valid, they may be used by a layer with the same ID loaded later
+  QMutexLocker lock( &mMutex );
+  removeLayer( layer, false );
+}
 
+void QgsMapRendererCache::removeLayer( QgsMapLayer *layer, bool removeFiles )
+{
   // check through all cached images to clear any which depend on this layer
   QMap<QString, CacheParameters>::iterator it = mCachedImages.begin();
   for ( ; it != mCachedImages.end(); )
@@ -161,6 +211,9 @@ void QgsMapRendererCache::layerRequestedRepaint()
 
     it = mCachedImages.erase( it );
   }
+
+  removeStoredImages( layer->id(), removeFiles );
+  mStorageLayers.remove( QgsWeakMapLayerPointer( layer ) );
   dropUnusedConnections();
 }
 
@@ -171,3 +224,236 @@ void QgsMapRendererCache::clearCacheImage( const QString &cacheKey )
   mCachedImages.remove( cacheKey );
   dropUnusedConnections();
 }
+
+void QgsMapRendererCache::setMaximumStoredImages( int count )
+{
+  QMutexLocker lock( &mMutex );
+
+  mMaxStoredImages = count;
+  while ( mStoredImageOrder.count() > std::max( mMaxStoredImages, 0 ) )
+  {
+    mStoredImages.remove( mStoredImageOrder.takeFirst() );
+  }
+  dropUnusedConnections();
+}
+
+int QgsMapRendererCache::maximumStoredImages() const
+{
+  QMutexLocker lock( &mMutex );
+  return mMaxStoredImages;
+}
+
+void QgsMapRendererCache::setStorageDirectory( const QString &directory )
+{
+  QMutexLocker lock( &mMutex );
+
+  mStorageDirectory = directory;
+  if ( !mStorageDirectory.isEmpty() && !QDir().mkpath( mStorageDirectory ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Could not create directory %1 for storing rendered images" ).arg( mStorageDirectory ) );
+  }
+  mStorageLayers.clear();
+  dropUnusedConnections();
+}
+
+QString QgsMapRendererCache::storageDirectory() const
+{
+  QMutexLocker lock( &mMutex );
+  return mStorageDirectory;
+}
+
+bool QgsMapRendererCache::hasImageStorage() const
+{
+  QMutexLocker lock( &mMutex );
+  return mMaxStoredImages > 0 || !mStorageDirectory.isEmpty();
+}
+
+QString QgsMapRendererCache::storageKey( QgsMapLayer *layer, const QgsMapSettings &settings )
+{
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+
+  // layer and its style
+  hash.addData( layer->id().toUtf8() );
+  hash.addData( layer->source().toUtf8() );
+  QDomDocument doc;
+  QDomElement styleElem = doc.createElement( QStringLiteral( "style" ) );
+  doc.appendChild( styleElem );
+  QString errorMessage;
+  layer->writeStyle( styleElem, doc, errorMessage, QgsReadWriteContext() );
+  hash.addData( doc.toByteArray() );
+  hash.addData( settings.layerStyleOverrides().value( layer->id() ).toUtf8() );
+
+  if ( QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( layer ) )
+  {
+    hash.addData( vl->subsetString().toUtf8() );
+    hash.addData( QByteArray::number( vl->opacity(), 'g', 17 ) );
+
+    QList< QgsFeatureId > selectedIds = vl->selectedFeatureIds().toList();
+    std::sort( selectedIds.begin(), selectedIds.end() );
+    Q_FOREACH ( QgsFeatureId id, selectedIds )
+    {
+      hash.addData( QByteArray::number( id ) + ',' );
+    }
+    hash.addData( settings.selectionColor().name( QColor::HexArgb ).toUtf8() );
+  }
+
+  // map settings
+  const QgsRectangle extent = settings.extent();
+  QStringList mapParts;
+  mapParts << qgsDoubleToString( extent.xMinimum(), 17 )
+           << qgsDoubleToString( extent.yMinimum(), 17 )
+           << qgsDoubleToString( extent.xMaximum(), 17 )
+           << qgsDoubleToString( extent.yMaximum(), 17 )
+           << qgsDoubleToString( settings.scale(), 17 )
+           << qgsDoubleToString( settings.rotation(), 17 )
+           << qgsDoubleToString( settings.outputDpi(), 17 )
+           << QString::number( settings.outputSize().width() )
+           << QString::number( settings.outputSize().height() )
+           << QString::number( settings.outputImageFormat() )
+           << QString::number( static_cast< int >( settings.flags() ) )
+           << settings.destinationCrs().toWkt();
+  hash.addData( mapParts.join( '|' ).toUtf8() );
+
+  return QString::fromLatin1( hash.result().toHex() );
+}
+
+QString QgsMapRendererCache::storageFilePrefix( const QString &layerId )
+{
+  return QString::fromLatin1( QCryptographicHash::hash( layerId.toUtf8(), QCryptographicHash::Sha1 ).toHex().left( 16 ) ) + '_';
+}
+
+QString QgsMapRendererCache::storageFileName( const QString &layerId, const QString &storageKey ) const
+{
+  return QDir( mStorageDirectory ).filePath( storageFilePrefix( layerId )
+         + QString::fromLatin1( QCryptographicHash::hash( storageKey.toUtf8(), QCryptographicHash::Sha1 ).toHex() )
+         + QStringLiteral( ".png" ) );
+}
+
+void QgsMapRendererCache::storeImageInMemory( QgsMapLayer *layer, const QString &storageKey, const QImage &image )
+{
+  if ( mMaxStoredImages <= 0 )
+    return;
+
+  StoredImage stored;
+  stored.image = image;
+  stored.layerId = layer->id();
+  stored.layer = layer;
+
+  if ( mStoredImages.contains( storageKey ) )
+    mStoredImageOrder.removeOne( storageKey );
+  mStoredImages.insert( storageKey, stored );
+  mStoredImageOrder.append( storageKey );
+  connectLayer( layer );
+
+  // drop the least recently used images
+  while ( mStoredImageOrder.count() > mMaxStoredImages )
+  {
+    mStoredImages.remove( mStoredImageOrder.takeFirst() );
+  }
+}
+
+void QgsMapRendererCache::removeStoredImages( const QString &layerId, bool removeFiles )
+{
+  QHash<QString, StoredImage>::iterator it = mStoredImages.begin();
+  for ( ; it != mStoredImages.end(); )
+  {
+    if ( it.value().layerId != layerId )
+    {
+      ++it;
+      continue;
+    }
+
+    mStoredImageOrder.removeOne( it.key() );
+    it = mStoredImages.erase( it );
+  }
+
+  if ( removeFiles && !mStorageDirectory.isEmpty() )
+  {
+    QDir dir( mStorageDirectory );
+    const QStringList files = dir.entryList( QStringList() << storageFilePrefix( layerId ) + '*', QDir::Files );
+    Q_FOREACH ( const QString &file, files )
+    {
+      dir.remove( file );
+    }
+  }
+}
+
+void QgsMapRendererCache::storeImage( QgsMapLayer *layer, const QString &storageKey, const QImage &image )
+{
+  if ( !layer || image.isNull() )
+    return;
+
+  QMutexLocker lock( &mMutex );
+
+  storeImageInMemory( layer, storageKey, image );
+
+  if ( !mStorageDirectory.isEmpty() )
+  {
+    // write to a temporary file first, other processes may be reading the same image
+    QSaveFile file( storageFileName( layer->id(), storageKey ) );
+    if ( file.open( QIODevice::WriteOnly ) && image.save( &file, "PNG" ) && file.commit() )
+    {
+      mStorageLayers << layer;
+      connectLayer( layer );
+    }
+    else
+    {
+      QgsDebugMsg( QStringLiteral( "Could not store image of layer %1 in %2" ).arg( layer->id(), mStorageDirectory ) );
+    }
+  }
+
+  dropUnusedConnections();
+}
+
+QImage QgsMapRendererCache::storedImage( QgsMapLayer *layer, const QString &storageKey )
+{
+  if ( !layer )
+    return QImage();
+
+  QMutexLocker lock( &mMutex );
+
+  QHash<QString, StoredImage>::const_iterator it = mStoredImages.constFind( storageKey );
+  if ( it != mStoredImages.constEnd() && it.value().layerId == layer->id() )
+  {
+    mStoredImageOrder.removeOne( storageKey );
+    mStoredImageOrder.append( storageKey );
+    return it.value().image;
+  }
+
+  if ( mStorageDirectory.isEmpty() )
+    return QImage();
+
+  QImage image;
+  if ( !image.load( storageFileName( layer->id(), storageKey ), "PNG" ) )
+    return QImage();
+
+  storeImageInMemory( layer, storageKey, image );
+  mStorageLayers << layer;
+  connectLayer( layer );
+  dropUnusedConnections();
+  return image;
+}
+
+void QgsMapRendererCache::clearStorage()
+{
+  QMutexLocker lock( &mMutex );
+
+  mStoredImages.clear();
+  mStoredImageOrder.clear();
+  mStorageLayers.clear();
+
+  if ( !mStorageDirectory.isEmpty() )
+  {
+    // only remove files created by the cache
+    const QRegularExpression fileNameRx( QStringLiteral( "^[0-9a-f]{16}_[0-9a-f]{40}\\.png$" ) );
+    QDir dir( mStorageDirectory );
+    const QStringList files = dir.entryList( QStringList() << QStringLiteral( "*.png" ), QDir::Files );
+    Q_FOREACH ( const QString &file, files )
+    {
+      if ( fileNameRx.match( file ).hasMatch() )
+        dir.remove( file );
+    }
+  }
+
+  dropUnusedConnections();
+}
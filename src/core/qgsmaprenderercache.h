@@ -18,12 +18,14 @@
 
 #include "qgis_core.h"
 #include <QMap>
+#include <QHash>
 #include <QImage>
 #include <QMutex>
 
 #include "qgsrectangle.h"
 #include "qgsmaplayer.h"
 
+class QgsMapSettings;
 
 /**
  * \ingroup core
@@ -35,6 +37,15 @@
  * If triggered, the cache removes the rendered image (and disconnects from the
  * layers).
  *
+ * Optionally, images of previous renders can also be kept in further tiers, so that
+ * they can be reused when the map is rendered again with the same settings (e.g. when
+ * panning back, or for repeated requests to QGIS Server): a number of the most recently
+ * used images can be kept in memory (see setMaximumStoredImages()) and images can be
+ * stored on disk (see setStorageDirectory()), where they are shared with other processes
+ * using the same directory and survive restarts. Stored images are looked up by a key
+ * which depends on the layer and all map settings affecting its rendering (see storageKey()).
+ * They are removed when their layer requests a repaint or its data change.
+ *
  * The class is thread-safe (multiple classes can access the same instance safely).
  *
  * \since QGIS 2.4
@@ -47,8 +58,10 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     QgsMapRendererCache();
 
     /**
-     * Invalidates the cache contents, clearing all cached images.
+     * Invalidates the cache contents, clearing all cached images and the images
+     * stored in memory. Images stored on disk are kept.
      * \see clearCacheImage()
+     * \see clearStorage()
      */
     void clear();
 
@@ -65,9 +78,12 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      * A list of \a dependentLayers should be passed containing all layer
      * on which this cache image is dependent. If any of these layers triggers a
      * repaint then the cache image will be cleared.
+     * The optional \a storageKey identifies the settings the image was rendered with
+     * (see storageKey()), so that the image is only reused for the same settings.
      * \see cacheImage()
+     * \see cacheImageStorageKey()
      */
-    void setCacheImage( const QString &cacheKey, const QImage &image, const QList< QgsMapLayer * > &dependentLayers = QList< QgsMapLayer * >() );
+    void setCacheImage( const QString &cacheKey, const QImage &image, const QList< QgsMapLayer * > &dependentLayers = QList< QgsMapLayer * >(), const QString &storageKey = QString() );
 
     /**
      * Returns true if the cache contains an image with the specified \a cacheKey.
@@ -91,15 +107,101 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      */
     QList< QgsMapLayer * > dependentLayers( const QString &cacheKey ) const;
 
+    /**
+     * Returns the storage key of the settings the image with the specified \a cacheKey
+     * was rendered with, or an empty string if the image has no storage key.
+     * \see setCacheImage()
+     * \since QGIS 3.0
+     */
+    QString cacheImageStorageKey( const QString &cacheKey ) const;
+
     /**
      * Removes an image from the cache with matching \a cacheKey.
      * \see clear()
      */
     void clearCacheImage( const QString &cacheKey );
 
+    /**
+     * Sets the maximum \a count of layer images from previous renders which are kept
+     * in memory, in addition to the images of the current render. The least recently used
+     * images are dropped first. The default value of 0 disables the memory storage.
+     * \see maximumStoredImages()
+     * \since QGIS 3.0
+     */
+    void setMaximumStoredImages( int count );
+
+    /**
+     * Returns the maximum count of layer images from previous renders which are kept in memory.
+     * \see setMaximumStoredImages()
+     * \since QGIS 3.0
+     */
+    int maximumStoredImages() const;
+
+    /**
+     * Sets the \a directory where layer images are stored on disk. An empty
+     * directory (the default) disables the disk storage.
+     *
+     * Stored images are only removed when their layer requests a repaint in this process,
+     * they are not invalidated when the data of a layer are modified by other applications.
+     * \see storageDirectory()
+     * \see clearStorage()
+     * \since QGIS 3.0
+     */
+    void setStorageDirectory( const QString &directory );
+
+    /**
+     * Returns the directory where layer images are stored on disk, or an empty string
+     * if the disk storage is disabled.
+     * \see setStorageDirectory()
+     * \since QGIS 3.0
+     */
+    QString storageDirectory() const;
+
+    /**
+     * Returns true if images of previous renders are stored in memory or on disk.
+     * \see setMaximumStoredImages()
+     * \see setStorageDirectory()
+     * \since QGIS 3.0
+     */
+    bool hasImageStorage() const;
+
+    /**
+     * Returns the key under which the image of \a layer rendered with the map \a settings
+     * is stored. The key depends on the layer's ID, style, subset string and selection, and on
+     * the extent, scale, output size, DPI, rotation and destination CRS of the map.
+     * \see storeImage()
+     * \see storedImage()
+     * \since QGIS 3.0
+     */
+    static QString storageKey( QgsMapLayer *layer, const QgsMapSettings &settings );
+
+    /**
+     * Stores the \a image of a \a layer under the specified \a storageKey, in memory
+     * and/or on disk depending on the cache's configuration.
+     * \see storedImage()
+     * \since QGIS 3.0
+     */
+    void storeImage( QgsMapLayer *layer, const QString &storageKey, const QImage &image );
+
+    /**
+     * Returns the image of a \a layer stored under the specified \a storageKey. Images
+     * found on disk are also kept in memory. Returns a null image if no image is stored.
+     * \see storeImage()
+     * \since QGIS 3.0
+     */
+    QImage storedImage( QgsMapLayer *layer, const QString &storageKey );
+
+    /**
+     * Removes all images stored in memory and on disk.
+     * \since QGIS 3.0
+     */
+    void clearStorage();
+
   private slots:
     //! Remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
+    //! Remove layer (that emitted the signal) from the cache, keeping its images on disk
+    void layerWillBeDeleted();
 
   private:
 
@@ -107,6 +209,14 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     {
       QImage cachedImage;
       QgsWeakMapLayerPointerList dependentLayers;
+      QString storageKey;
+    };
+
+    struct StoredImage
+    {
+      QImage image;
+      QString layerId;
+      QgsWeakMapLayerPointer layer;
     };
 
     //! Invalidate cache contents (without locking)
@@ -117,6 +227,22 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
 
     QSet< QgsWeakMapLayerPointer > dependentLayers() const;
 
+    //! Connects to the signals of a layer we depend on
+    void connectLayer( QgsMapLayer *layer );
+    //! Disconnects from the signals of a layer
+    void disconnectLayer( QgsMapLayer *layer );
+
+    //! Removes the images depending on a layer, optionally also from disk (without locking)
+    void removeLayer( QgsMapLayer *layer, bool removeFiles );
+    //! Adds an image to the stored images kept in memory (without locking)
+    void storeImageInMemory( QgsMapLayer *layer, const QString &storageKey, const QImage &image );
+    //! Removes the stored images of a layer from memory and optionally from disk (without locking)
+    void removeStoredImages( const QString &layerId, bool removeFiles );
+    //! Returns the name of the file storing the image with the given key on disk
+    QString storageFileName( const QString &layerId, const QString &storageKey ) const;
+    //! Returns the prefix of the names of all files storing images of a layer
+    static QString storageFilePrefix( const QString &layerId );
+
     mutable QMutex mMutex;
     QgsRectangle mExtent;
     double mScale = 0;
@@ -125,6 +251,15 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     QMap<QString, CacheParameters> mCachedImages;
     //! List of all layers on which this cache is currently connected
     QSet< QgsWeakMapLayerPointer > mConnectedLayers;
+
+    //! Images of previous renders kept in memory, by storage key
+    QHash< QString, StoredImage > mStoredImages;
+    //! Storage keys of the images kept in memory, most recently used last
+    QList< QString > mStoredImageOrder;
+    int mMaxStoredImages = 0;
+    QString mStorageDirectory;
+    //! Layers which have images stored on disk by this cache
+    QSet< QgsWeakMapLayerPointer > mStorageLayers;
 };
 
 
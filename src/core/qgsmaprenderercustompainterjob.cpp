@@ -76,6 +76,7 @@ void QgsMapRendererCustomPainterJob::start()
   {
     mLabelingEngineV2.reset( new QgsLabelingEngine() );
     mLabelingEngineV2->setMapSettings( mSettings );
+    mLabelingEngineV2->setPlacementCache( mLabelPlacementCache );
   }
 
   bool canUseLabelCache = prepareLabelCache();
@@ -15,10 +15,12 @@
 
 #include "qgsmaprendererjob.h"
 
+#include <QCryptographicHash>
 #include <QPainter>
 #include <QTime>
 #include <QTimer>
 #include <QtConcurrentMap>
+#include <QThreadPool>
 
 #include "qgslogger.h"
 #include "qgsrendercontext.h"
@@ -36,6 +38,10 @@
 #include "qgsmaplayerlistutils.h"
 #include "qgsvectorlayerlabeling.h"
 #include "qgssettings.h"
+#include "qgsrenderer.h"
+#include "qgspainteffect.h"
+#include "qgssymbol.h"
+#include "qgssymbollayer.h"
 
 ///@cond PRIVATE
 
@@ -64,6 +70,11 @@ void QgsMapRendererJob::setCache( QgsMapRendererCache *cache )
   mCache = cache;
 }
 
+void QgsMapRendererJob::setLabelPlacementCache( QgsLabelPlacementCache *cache )
+{
+  mLabelPlacementCache = cache;
+}
+
 const QgsMapSettings &QgsMapRendererJob::mapSettings() const
 {
   return mSettings;
@@ -93,6 +104,11 @@ bool QgsMapRendererJob::prepareLabelCache() const
 
     // can we reuse the cached label solution?
     bool canUseCache = canCache && mCache->dependentLayers( LABEL_CACHE_ID ).toSet() == labeledLayers;
+    if ( canUseCache && useImageStorage() )
+    {
+      // the cached labels may have been rendered with other settings, e.g. by another server request
+      canUseCache = mCache->cacheImageStorageKey( LABEL_CACHE_ID ) == labelStorageKey();
+    }
     if ( !canUseCache )
     {
       // no - participating layers have changed
@@ -103,6 +119,26 @@ bool QgsMapRendererJob::prepareLabelCache() const
 }
 
 
+bool QgsMapRendererJob::useImageStorage() const
+{
+  // images of layers rendered in previous jobs can only be reused if all features
+  // are rendered, they may contain features hidden by the filter provider otherwise
+  return mCache && mCache->hasImageStorage() && !mFeatureFilterProvider;
+}
+
+QString QgsMapRendererJob::labelStorageKey() const
+{
+  // labels depend on the settings of all labeled layers
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  Q_FOREACH ( QgsMapLayer *ml, mSettings.layers() )
+  {
+    QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
+    if ( vl && QgsPalLabeling::staticWillUseLayer( vl ) )
+      hash.addData( QgsMapRendererCache::storageKey( vl, mSettings ).toUtf8() );
+  }
+  return QString::fromLatin1( hash.result().toHex() );
+}
+
 bool QgsMapRendererJob::reprojectToLayerExtent( const QgsMapLayer *ml, const QgsCoordinateTransform &ct, QgsRectangle &extent, QgsRectangle &r2 )
 {
   bool split = false;
@@ -207,10 +243,13 @@ bool QgsMapRendererJob::reprojectToLayerExtent( const QgsMapLayer *ml, const Qgs
 
 
 
-LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEngine *labelingEngine2 )
+LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEngine *labelingEngine2, bool allowLayerTiles )
 {
   LayerRenderJobs layerJobs;
 
+  if ( mProfilingEnabled )
+    mProfile.clear();
+
   // render all layers in the stack, starting at the base
   QListIterator<QgsMapLayer *> li( mSettings.layers() );
   li.toBack();
@@ -224,6 +263,8 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
 
   bool requiresLabelRedraw = !( mCache && mCache->hasCacheImage( LABEL_CACHE_ID ) );
 
+  const bool useStorage = useImageStorage();
+
   while ( li.hasPrevious() )
   {
     QgsMapLayer *ml = li.previous();
@@ -259,14 +300,39 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
 
     // Force render of layers that are being edited
     // or if there's a labeling engine that needs the layer to register features
+    bool forceRender = false;
+    bool isEditable = false;
     if ( mCache && ml->type() == QgsMapLayer::VectorLayer )
     {
       QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
       bool requiresLabeling = false;
       requiresLabeling = ( labelingEngine2 && QgsPalLabeling::staticWillUseLayer( vl ) ) && requiresLabelRedraw;
-      if ( vl->isEditable() || requiresLabeling )
+      isEditable = vl->isEditable();
+      if ( isEditable || requiresLabeling )
       {
         mCache->clearCacheImage( ml->id() );
+        forceRender = true;
+      }
+    }
+
+    // the layer may have been rendered with the same settings by a previous job
+    QString storageKey;
+    if ( useStorage && !isEditable )
+    {
+      storageKey = QgsMapRendererCache::storageKey( ml, mSettings );
+
+      // the cached image matches the extent and scale, but may have been rendered
+      // with other settings (e.g. by another server request)
+      if ( mCache->hasCacheImage( ml->id() ) && mCache->cacheImageStorageKey( ml->id() ) != storageKey )
+        mCache->clearCacheImage( ml->id() );
+
+      if ( !forceRender && !mCache->hasCacheImage( ml->id() ) )
+      {
+        QImage storedImage = mCache->storedImage( ml, storageKey );
+        if ( !storedImage.isNull() )
+        {
+          mCache->setCacheImage( ml->id(), storedImage.convertToFormat( mSettings.outputImageFormat() ), QList< QgsMapLayer * >() << ml, storageKey );
+        }
       }
     }
 
@@ -281,7 +347,9 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
       job.opacity = vl->opacity();
     }
     job.layer = ml;
+    job.renderer = nullptr;
     job.renderingTime = -1;
+    job.storageKey = storageKey;
 
     job.context = QgsRenderContext::fromMapSettings( mSettings );
     job.context.expressionContext().appendScope( QgsExpressionContextUtils::layerScope( ml ) );
@@ -293,9 +361,17 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
     if ( mFeatureFilterProvider )
       job.context.setFeatureFilterProvider( mFeatureFilterProvider );
 
+    if ( mProfilingEnabled )
+    {
+      job.profiler = new QgsRuntimeProfiler();
+      job.context.setProfiler( job.profiler );
+    }
+
     // if we can use the cache, let's do it and avoid rendering!
     if ( mCache && mCache->hasCacheImage( ml->id() ) )
     {
+      if ( job.profiler )
+        job.profiler->addCount( QStringLiteral( "cached" ) );
       job.cached = true;
       job.imageInitialized = true;
       job.img = new QImage( mCache->cacheImage( ml->id() ) );
@@ -332,7 +408,13 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
     if ( hasStyleOverride )
       ml->styleManager()->setOverrideStyle( mSettings.layerStyleOverrides().value( ml->id() ) );
 
-    job.renderer = ml->createMapRenderer( job.context );
+    // a layer rendered to its own image may be split into tiles which are rendered in parallel
+    bool renderInTiles = allowLayerTiles && job.img
+                         && mSettings.testFlag( QgsMapSettings::RenderLayerTiles )
+                         && canRenderLayerInTiles( ml, labelingEngine2 )
+                         && prepareLayerTiles( job, ml );
+    if ( !renderInTiles )
+      job.renderer = ml->createMapRenderer( job.context );
 
     if ( hasStyleOverride )
       ml->styleManager()->restoreOverrideStyle();
@@ -342,6 +424,216 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
   return layerJobs;
 }
 
+bool QgsMapRendererJob::canRenderLayerInTiles( QgsMapLayer *ml, QgsLabelingEngine *labelingEngine2 ) const
+{
+  if ( QThreadPool::globalInstance()->maxThreadCount() < 2 )
+    return false;
+
+  // tiles are axis aligned in the output image
+  if ( !qgsDoubleNear( mSettings.rotation(), 0.0 ) )
+    return false;
+
+  QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
+  if ( !vl || !vl->renderer() )
+    return false;
+
+  // labels and diagrams would get registered once for every tile the feature falls into
+  if ( labelingEngine2 && ( QgsPalLabeling::staticWillUseLayer( vl ) || vl->diagramsEnabled() ) )
+    return false;
+
+  // effects (e.g. blur, shadows) spread over tile boundaries
+  if ( vl->renderer()->paintEffect() && vl->renderer()->paintEffect()->enabled() )
+    return false;
+
+  // renderers which consider relations between features (clusters, heatmaps, inverted polygons)
+  // need to see all the features at once
+  static const QStringList TILE_SAFE_RENDERERS = QStringList() << QStringLiteral( "singleSymbol" )
+      << QStringLiteral( "categorizedSymbol" )
+      << QStringLiteral( "graduatedSymbol" )
+      << QStringLiteral( "RuleRenderer" );
+  return TILE_SAFE_RENDERERS.contains( vl->renderer()->type() );
+}
+
+double QgsMapRendererJob::layerSymbolMargin( QgsMapLayer *ml, QgsRenderContext &context )
+{
+  QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
+  if ( !vl || !vl->renderer() )
+    return -1;
+
+  double margin = 0;
+  const QgsSymbolList symbols = vl->renderer()->symbols( context );
+  for ( QgsSymbol *symbol : symbols )
+  {
+    const double m = symbolMargin( symbol, context, vl->fields() );
+    if ( m < 0 )
+      return -1;
+    margin = std::max( margin, m );
+  }
+  return margin;
+}
+
+double QgsMapRendererJob::symbolMargin( QgsSymbol *symbol, QgsRenderContext &context, const QgsFields &fields )
+{
+  double margin = 0;
+  const QgsSymbolLayerList layers = symbol->symbolLayers();
+  for ( QgsSymbolLayer *layer : layers )
+  {
+    // the extent of data defined symbols, generated geometries and arrows is only known when rendering
+    if ( layer->dataDefinedProperties().hasActiveProperties()
+         || layer->layerType() == QLatin1String( "GeometryGenerator" )
+         || layer->layerType() == QLatin1String( "ArrowLine" ) )
+      return -1;
+
+    double layerMargin = layer->estimateMaxBleed( context );
+    if ( QgsSymbol *subSymbol = layer->subSymbol() )
+    {
+      const double subSymbolMargin = symbolMargin( subSymbol, context, fields );
+      if ( subSymbolMargin < 0 )
+        return -1;
+      layerMargin += subSymbolMargin;
+    }
+    margin = std::max( margin, layerMargin );
+  }
+
+  if ( symbol->type() == QgsSymbol::Marker )
+  {
+    // some marker layers only know their bounds once they are prepared for rendering
+    std::unique_ptr< QgsMarkerSymbol > marker( static_cast< QgsMarkerSymbol * >( symbol->clone() ) );
+    marker->startRender( context, fields );
+    const QRectF bounds = marker->bounds( QPointF( 0, 0 ), context );
+    marker->stopRender( context );
+    margin = std::max( margin, std::max( std::max( -bounds.left(), bounds.right() ), std::max( -bounds.top(), bounds.bottom() ) ) );
+  }
+  return margin;
+}
+
+bool QgsMapRendererJob::prepareLayerTiles( LayerRenderJob &job, QgsMapLayer *ml )
+{
+  // features outside of a tile may still have symbols overlapping it - fetch them too. Layers
+  // whose symbols cannot be measured before rendering are not split
+  const double symbolMarginPixels = layerSymbolMargin( ml, job.context );
+  if ( symbolMarginPixels < 0 )
+    return false;
+  // one more pixel for antialiasing
+  const double tileMargin = std::ceil( symbolMarginPixels ) + 1;
+
+  const int tileCount = QThreadPool::globalInstance()->maxThreadCount();
+  const int columns = static_cast< int >( std::ceil( std::sqrt( static_cast< double >( tileCount ) ) ) );
+  const int rows = static_cast< int >( std::ceil( static_cast< double >( tileCount ) / columns ) );
+
+  const QSize size = mSettings.outputSize();
+  const QgsRectangle visibleExtent = mSettings.visibleExtent();
+  const double mupp = mSettings.mapUnitsPerPixel();
+  const QgsCoordinateTransform ct = job.context.coordinateTransform();
+
+  bool ok = true;
+  for ( int row = 0; row < rows && ok; ++row )
+  {
+    for ( int column = 0; column < columns && ok; ++column )
+    {
+      const int x0 = size.width() * column / columns;
+      const int x1 = size.width() * ( column + 1 ) / columns;
+      const int y0 = size.height() * row / rows;
+      const int y1 = size.height() * ( row + 1 ) / rows;
+      if ( x1 <= x0 || y1 <= y0 )
+        continue;
+
+      QgsRectangle tileExtent( visibleExtent.xMinimum() + x0 * mupp, visibleExtent.yMaximum() - y1 * mupp,
+                               visibleExtent.xMinimum() + x1 * mupp, visibleExtent.yMaximum() - y0 * mupp );
+
+      QgsMapSettings tileSettings( mSettings );
+      tileSettings.setOutputSize( QSize( x1 - x0, y1 - y0 ) );
+      tileSettings.setExtent( tileExtent );
+
+      QgsRectangle r1 = tileExtent.buffered( tileMargin * mupp ), r2;
+      if ( ct.isValid() )
+      {
+        reprojectToLayerExtent( ml, ct, r1, r2 );
+      }
+      if ( !r1.isFinite() || !r2.isFinite() )
+      {
+        ok = false;
+        break;
+      }
+
+      QImage *tileImage = new QImage( x1 - x0, y1 - y0, mSettings.outputImageFormat() );
+      if ( tileImage->isNull() )
+      {
+        delete tileImage;
+        ok = false;
+        break;
+      }
+
+      job.tiles.append( LayerRenderTileJob() );
+      LayerRenderTileJob &tile = job.tiles.last();
+      tile.img = tileImage;
+      tile.offset = QPoint( x0, y0 );
+
+      tile.context = QgsRenderContext::fromMapSettings( tileSettings );
+      // avoid rounding differences, the tiles share the scale of the whole map
+      tile.context.setRendererScale( mSettings.scale() );
+      tile.context.expressionContext().appendScope( QgsExpressionContextUtils::layerScope( ml ) );
+      tile.context.setCoordinateTransform( ct );
+      tile.context.setExtent( r1 );
+      if ( mFeatureFilterProvider )
+        tile.context.setFeatureFilterProvider( mFeatureFilterProvider );
+      if ( job.profiler )
+      {
+        tile.profiler = new QgsRuntimeProfiler();
+        tile.context.setProfiler( tile.profiler );
+      }
+
+      QPainter *tilePainter = new QPainter( tile.img );
+      tilePainter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
+      tile.context.setPainter( tilePainter );
+
+      tile.renderer = ml->createMapRenderer( tile.context );
+    }
+  }
+
+  if ( !ok || job.tiles.count() < 2 )
+  {
+    cleanupTileJobs( job.tiles );
+    return false;
+  }
+
+  QgsDebugMsgLevel( QString( "layer %1 split into %2 tiles" ).arg( ml->id() ).arg( job.tiles.count() ), 2 );
+  return true;
+}
+
+void QgsMapRendererJob::cleanupTileJobs( LayerRenderTileJobs &tiles, QStringList *errors )
+{
+  for ( LayerRenderTileJobs::iterator it = tiles.begin(); it != tiles.end(); ++it )
+  {
+    LayerRenderTileJob &tile = *it;
+    delete tile.context.painter();
+    tile.context.setPainter( nullptr );
+
+    delete tile.img;
+    tile.img = nullptr;
+
+    if ( tile.renderer )
+    {
+      if ( errors )
+      {
+        Q_FOREACH ( const QString &message, tile.renderer->errors() )
+        {
+          if ( !errors->contains( message ) )
+            errors->append( message );
+        }
+      }
+
+      delete tile.renderer;
+      tile.renderer = nullptr;
+    }
+
+    delete tile.profiler;
+    tile.profiler = nullptr;
+  }
+
+  tiles.clear();
+}
+
 LabelRenderJob QgsMapRendererJob::prepareLabelingJob( QPainter *painter, QgsLabelingEngine *labelingEngine2, bool canUseLabelCache )
 {
   LabelRenderJob job;
@@ -350,10 +642,18 @@ LabelRenderJob QgsMapRendererJob::prepareLabelingJob( QPainter *painter, QgsLabe
   job.context.setLabelingEngine( labelingEngine2 );
   job.context.setExtent( mSettings.visibleExtent() );
 
+  if ( mProfilingEnabled )
+  {
+    job.profiler = new QgsRuntimeProfiler();
+    job.context.setProfiler( job.profiler );
+  }
+
   // if we can use the cache, let's do it and avoid rendering!
   bool hasCache = canUseLabelCache && mCache && mCache->hasCacheImage( LABEL_CACHE_ID );
   if ( hasCache )
   {
+    if ( job.profiler )
+      job.profiler->addCount( QStringLiteral( "cached" ) );
     job.cached = true;
     job.complete = true;
     job.img = new QImage( mCache->cacheImage( LABEL_CACHE_ID ) );
@@ -361,6 +661,9 @@ LabelRenderJob QgsMapRendererJob::prepareLabelingJob( QPainter *painter, QgsLabe
   }
   else
   {
+    if ( canUseLabelCache && useImageStorage() )
+      job.storageKey = labelStorageKey();
+
     if ( canUseLabelCache && ( mCache || !painter ) )
     {
       // Flattened image for drawing labels
@@ -397,7 +700,9 @@ void QgsMapRendererJob::cleanupJobs( LayerRenderJobs &jobs )
       if ( mCache && !job.cached && !job.context.renderingStopped() && job.layer )
       {
         QgsDebugMsg( "caching image for " + ( job.layer ? job.layer->id() : QString() ) );
-        mCache->setCacheImage( job.layer->id(), *job.img, QList< QgsMapLayer * >() << job.layer );
+        mCache->setCacheImage( job.layer->id(), *job.img, QList< QgsMapLayer * >() << job.layer, job.storageKey );
+        if ( !job.storageKey.isEmpty() )
+          mCache->storeImage( job.layer, job.storageKey, *job.img );
       }
 
       delete job.img;
@@ -412,6 +717,32 @@ void QgsMapRendererJob::cleanupJobs( LayerRenderJobs &jobs )
       delete job.renderer;
       job.renderer = nullptr;
     }
+
+    if ( job.profiler )
+    {
+      // tiles of the layer were profiled separately, as they are rendered in parallel
+      Q_FOREACH ( const LayerRenderTileJob &tile, job.tiles )
+      {
+        if ( tile.profiler )
+          job.profiler->merge( *tile.profiler );
+      }
+      if ( job.renderingTime >= 0 )
+        job.profiler->addTime( QStringLiteral( "total" ), job.renderingTime / 1000.0 );
+
+      mProfile.beginGroup( job.layer ? job.layer->id() : QString() );
+      mProfile.merge( *job.profiler );
+      mProfile.endGroup();
+      delete job.profiler;
+      job.profiler = nullptr;
+    }
+
+    if ( !job.tiles.isEmpty() )
+    {
+      QStringList tileErrors;
+      cleanupTileJobs( job.tiles, &tileErrors );
+      Q_FOREACH ( const QString &message, tileErrors )
+        mErrors.append( Error( job.layer ? job.layer->id() : QString(), message ) );
+    }
   }
 
 
@@ -425,12 +756,24 @@ void QgsMapRendererJob::cleanupLabelJob( LabelRenderJob &job )
     if ( mCache && !job.cached && !job.context.renderingStopped() )
     {
       QgsDebugMsg( "caching label result image" );
-      mCache->setCacheImage( LABEL_CACHE_ID, *job.img, _qgis_listQPointerToRaw( job.participatingLayers ) );
+      mCache->setCacheImage( LABEL_CACHE_ID, *job.img, _qgis_listQPointerToRaw( job.participatingLayers ), job.storageKey );
     }
 
     delete job.img;
     job.img = nullptr;
   }
+
+  if ( job.profiler )
+  {
+    if ( job.renderingTime >= 0 )
+      job.profiler->addTime( QStringLiteral( "total" ), job.renderingTime / 1000.0 );
+
+    mProfile.beginGroup( QStringLiteral( "labeling" ) );
+    mProfile.merge( *job.profiler );
+    mProfile.endGroup();
+    delete job.profiler;
+    job.profiler = nullptr;
+  }
 }
 
 
@@ -28,17 +28,37 @@
 #include "qgsrendercontext.h"
 
 #include "qgsmapsettings.h"
+#include "qgsruntimeprofiler.h"
 
 
 class QgsLabelingEngine;
 class QgsLabelingResults;
+class QgsLabelPlacementCache;
 class QgsMapLayerRenderer;
 class QgsMapRendererCache;
 class QgsFeatureFilterProvider;
+class QgsSymbol;
 
 #ifndef SIP_RUN
 /// @cond PRIVATE
 
+/**
+ * \ingroup core
+ * Structure keeping low-level information about rendering of a single spatial tile of a layer.
+ * \since QGIS 3.0
+ */
+struct LayerRenderTileJob
+{
+  QgsRenderContext context;
+  QImage *img = nullptr; //!< Image of the tile, sized to the tile (not to the whole map)
+  QgsMapLayerRenderer *renderer = nullptr; // must be deleted
+  QPoint offset; //!< Position of the top left corner of the tile within the layer image
+  int renderingTime = -1; //!< Time it took to render the tile in ms (it is -1 if not rendered or still rendering)
+  QgsRuntimeProfiler *profiler = nullptr; //!< Profiler of the tile if profiling is enabled (must be deleted)
+};
+
+typedef QList<LayerRenderTileJob> LayerRenderTileJobs;
+
 /**
  * \ingroup core
  * Structure keeping low-level rendering job information.
@@ -55,6 +75,14 @@ struct LayerRenderJob
   bool cached; // if true, img already contains cached image from previous rendering
   QgsWeakMapLayerPointer layer;
   int renderingTime; //!< Time it took to render the layer in ms (it is -1 if not rendered or still rendering)
+  QString storageKey; //!< Key of the layer image in the cache's image storage (empty if the image is not stored)
+  QgsRuntimeProfiler *profiler = nullptr; //!< Profiler of the layer if profiling is enabled (must be deleted)
+
+  /**
+   * Spatial tiles of the layer which are rendered independently (see QgsMapSettings::RenderLayerTiles).
+   * If not empty, renderer is null and the tile images are composed into img once all tiles are rendered.
+   */
+  LayerRenderTileJobs tiles;
 };
 
 typedef QList<LayerRenderJob> LayerRenderJobs;
@@ -82,6 +110,10 @@ struct LabelRenderJob
   int renderingTime = -1;
   //! List of layers which participated in the labeling solution
   QList< QPointer< QgsMapLayer > > participatingLayers;
+  //! Key of the settings of the labeled layers, see QgsMapRendererCache::storageKey() (empty if images are not stored)
+  QString storageKey;
+  //! Profiler of the labeling if profiling is enabled (must be deleted)
+  QgsRuntimeProfiler *profiler = nullptr;
 };
 
 ///@endcond PRIVATE
@@ -199,9 +231,58 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
      */
     void setCache( QgsMapRendererCache *cache );
 
+    /**
+     * Assign a cache to be used for reusing label placements of previous renders
+     * at the same scale, and storing the label placements of this render.
+     * Does not take ownership of the object.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void setLabelPlacementCache( QgsLabelPlacementCache *cache ) SIP_SKIP;
+
     //! Find out how long it took to finish the job (in milliseconds)
     int renderingTime() const { return mRenderingTime; }
 
+    /**
+     * Sets whether the times spent in the phases of rendering each layer and the labels
+     * are collected, see profile(). Profiling is disabled by default, it must be enabled
+     * before the job is started.
+     * \see isProfilingEnabled()
+     * \since QGIS 3.0
+     */
+    void setProfilingEnabled( bool enabled ) { mProfilingEnabled = enabled; }
+
+    /**
+     * Returns true if the times spent in the phases of rendering are collected.
+     * \see setProfilingEnabled()
+     * \since QGIS 3.0
+     */
+    bool isProfilingEnabled() const { return mProfilingEnabled; }
+
+    /**
+     * Returns the times (in seconds) and counters collected while rendering, if profiling
+     * is enabled. They are available when the job has finished.
+     *
+     * Times and counters of a layer are grouped by layer ID (e.g. "layer_id/fetch"):
+     *
+     * - "total": time of rendering the layer
+     * - "fetch": time of fetching features (including the decoding of their geometries by the provider)
+     * - "simplify": time of simplifying geometries when drawing them
+     * - "clip": time of clipping geometries to the map extent
+     * - "transform": time of transforming geometries to map and screen coordinates
+     * - "draw": time of drawing features with symbols (including simplifying, clipping and transforming)
+     * - "labeling": time of registering features of the layer for labeling and diagrams
+     * - "features" and "vertices": counts of fetched features and their vertices
+     * - "cached": count of layer images taken from the cache (see setCache())
+     *
+     * Labeling is grouped as "labeling" with "total", "register", "problem" (creation of
+     * label candidates), "solve", "draw" and "cached". The time of composing the layer
+     * images into the final image is named "composition".
+     * \see setProfilingEnabled()
+     * \since QGIS 3.0
+     */
+    const QgsRuntimeProfiler &profile() const { return mProfile; }
+
     /**
      * Return map settings with which this job was started.
      * \returns A QgsMapSettings instance with render settings
@@ -237,8 +318,16 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
 
     QgsMapRendererCache *mCache = nullptr;
 
+    QgsLabelPlacementCache *mLabelPlacementCache = nullptr;
+
     int mRenderingTime = 0;
 
+    //! Whether the phases of rendering are profiled
+    bool mProfilingEnabled = false;
+
+    //! Times and counters collected while rendering, see profile()
+    QgsRuntimeProfiler mProfile;
+
     /**
      * Prepares the cache for storing the result of labeling. Returns false if
      * the render cannot use cached labels and should not cache the result.
@@ -246,8 +335,26 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
      */
     bool prepareLabelCache() const SIP_SKIP;
 
-    //! \note not available in Python bindings
-    LayerRenderJobs prepareJobs( QPainter *painter, QgsLabelingEngine *labelingEngine2 ) SIP_SKIP;
+    /**
+     * Returns true if images of previous renders may be reused from the cache's image storage.
+     * \note not available in Python bindings
+     */
+    bool useImageStorage() const SIP_SKIP;
+
+    /**
+     * Returns the key of the settings of all labeled layers, to check that cached labels
+     * were rendered with the same settings.
+     * \note not available in Python bindings
+     */
+    QString labelStorageKey() const SIP_SKIP;
+
+    /**
+     * Prepares the rendering jobs for all layers. If \a allowLayerTiles is true and the
+     * QgsMapSettings::RenderLayerTiles flag is set, eligible layers are split into
+     * spatial tiles (see LayerRenderJob::tiles) which must be rendered by the caller.
+     * \note not available in Python bindings
+     */
+    LayerRenderJobs prepareJobs( QPainter *painter, QgsLabelingEngine *labelingEngine2, bool allowLayerTiles = false ) SIP_SKIP;
 
     /**
      * Prepares a labeling job.
@@ -289,6 +396,37 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
 
     bool needTemporaryImage( QgsMapLayer *ml );
 
+    /**
+     * Returns true if the rendering of the map layer \a ml can be split into
+     * independently rendered spatial tiles without affecting the result.
+     */
+    bool canRenderLayerInTiles( QgsMapLayer *ml, QgsLabelingEngine *labelingEngine2 ) const;
+
+    /**
+     * Splits the rendering of map layer \a ml into spatial tiles, storing them in the
+     * tiles of \a job. Returns false (and leaves \a job untouched) if the tiles could not be created.
+     */
+    bool prepareLayerTiles( LayerRenderJob &job, QgsMapLayer *ml );
+
+    /**
+     * Returns the maximum distance (in pixels) by which the symbols of the map layer \a ml may extend
+     * beyond the geometries of its features, or -1 if it is not known before rendering
+     * (e.g. data defined symbol sizes).
+     */
+    static double layerSymbolMargin( QgsMapLayer *ml, QgsRenderContext &context );
+
+    /**
+     * Returns the maximum distance (in pixels) by which \a symbol may extend beyond the geometry
+     * it is rendered for, or -1 if it is not known before rendering.
+     */
+    static double symbolMargin( QgsSymbol *symbol, QgsRenderContext &context, const QgsFields &fields );
+
+    /**
+     * Deletes the images, painters and renderers of \a tiles. Messages reported by the tile
+     * renderers are appended to \a errors (without duplicates) if it is not null.
+     */
+    static void cleanupTileJobs( LayerRenderTileJobs &tiles, QStringList *errors = nullptr );
+
     const QgsFeatureFilterProvider *mFeatureFilterProvider = nullptr;
 };
 
@@ -55,10 +55,11 @@ void QgsMapRendererParallelJob::start()
   {
     mLabelingEngineV2.reset( new QgsLabelingEngine() );
     mLabelingEngineV2->setMapSettings( mSettings );
+    mLabelingEngineV2->setPlacementCache( mLabelPlacementCache );
   }
 
   bool canUseLabelCache = prepareLabelCache();
-  mLayerJobs = prepareJobs( nullptr, mLabelingEngineV2.get() );
+  mLayerJobs = prepareJobs( nullptr, mLabelingEngineV2.get(), true );
   mLabelJob = prepareLabelingJob( nullptr, mLabelingEngineV2.get(), canUseLabelCache );
 
   QgsDebugMsg( QString( "QThreadPool max thread count is %1" ).arg( QThreadPool::globalInstance()->maxThreadCount() ) );
@@ -84,6 +85,13 @@ void QgsMapRendererParallelJob::cancel()
     it->context.setRenderingStopped( true );
     if ( it->renderer && it->renderer->feedback() )
       it->renderer->feedback()->cancel();
+
+    for ( LayerRenderTileJobs::iterator tileIt = it->tiles.begin(); tileIt != it->tiles.end(); ++tileIt )
+    {
+      tileIt->context.setRenderingStopped( true );
+      if ( tileIt->renderer && tileIt->renderer->feedback() )
+        tileIt->renderer->feedback()->cancel();
+    }
   }
 
   if ( mStatus == RenderingLayers )
@@ -120,6 +128,13 @@ void QgsMapRendererParallelJob::cancelWithoutBlocking()
     it->context.setRenderingStopped( true );
     if ( it->renderer && it->renderer->feedback() )
       it->renderer->feedback()->cancel();
+
+    for ( LayerRenderTileJobs::iterator tileIt = it->tiles.begin(); tileIt != it->tiles.end(); ++tileIt )
+    {
+      tileIt->context.setRenderingStopped( true );
+      if ( tileIt->renderer && tileIt->renderer->feedback() )
+        tileIt->renderer->feedback()->cancel();
+    }
   }
 
   if ( mStatus == RenderingLayers )
@@ -196,7 +211,10 @@ void QgsMapRendererParallelJob::renderLayersFinished()
   Q_ASSERT( mStatus == RenderingLayers );
 
   // compose final image
-  mFinalImage = composeImage( mSettings, mLayerJobs, mLabelJob );
+  {
+    QgsScopedRuntimeProfile profile( mProfilingEnabled ? &mProfile : nullptr, QStringLiteral( "composition" ) );
+    mFinalImage = composeImage( mSettings, mLayerJobs, mLabelJob );
+  }
 
   QgsDebugMsg( "PARALLEL layers finished" );
 
@@ -251,9 +269,71 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
   QTime t;
   t.start();
   QgsDebugMsgLevel( QString( "job %1 start (layer %2)" ).arg( reinterpret_cast< quint64 >( &job ), 0, 16 ).arg( job.layer ? job.layer->id() : QString() ), 2 );
+  if ( !job.tiles.isEmpty() )
+  {
+    // the calling thread takes part in rendering of the tiles, so this does not starve the thread pool
+    QtConcurrent::blockingMap( job.tiles, renderLayerTileStatic );
+
+    if ( !job.context.renderingStopped() )
+    {
+      QPainter *painter = job.context.painter();
+      for ( LayerRenderTileJobs::const_iterator it = job.tiles.constBegin(); it != job.tiles.constEnd(); ++it )
+      {
+        painter->drawImage( it->offset, *it->img );
+      }
+    }
+  }
+  else
+  {
+    try
+    {
+      job.renderer->render();
+    }
+    catch ( QgsException &e )
+    {
+      Q_UNUSED( e );
+      QgsDebugMsg( "Caught unhandled QgsException: " + e.what() );
+    }
+    catch ( std::exception &e )
+    {
+      Q_UNUSED( e );
+      QgsDebugMsg( "Caught unhandled std::exception: " + QString::fromLatin1( e.what() ) );
+    }
+    catch ( ... )
+    {
+      QgsDebugMsg( "Caught unhandled unknown exception" );
+    }
+  }
+  job.renderingTime = t.elapsed();
+  QgsDebugMsgLevel( QString( "job %1 end [%2 ms] (layer %3)" ).arg( reinterpret_cast< quint64 >( &job ), 0, 16 ).arg( job.renderingTime ).arg( job.layer ? job.layer->id() : QString() ), 2 );
+
+  // all features of the layer are registered now - prepare its labels while other layers are still rendering
+  if ( job.context.labelingEngine() && job.layer && !job.context.renderingStopped() )
+  {
+    try
+    {
+      job.context.labelingEngine()->prepareLayer( job.layer->id(), job.context );
+    }
+    catch ( std::exception &e )
+    {
+      Q_UNUSED( e );
+      QgsDebugMsg( "Caught unhandled std::exception: " + QString::fromLatin1( e.what() ) );
+    }
+  }
+}
+
+void QgsMapRendererParallelJob::renderLayerTileStatic( LayerRenderTileJob &tile )
+{
+  if ( tile.context.renderingStopped() )
+    return;
+
+  tile.img->fill( 0 );
+
+  QTime t;
+  t.start();
   try
   {
-    job.renderer->render();
+    tile.renderer->render();
   }
   catch ( QgsException &e )
   {
@@ -269,11 +349,12 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
   {
     QgsDebugMsg( "Caught unhandled unknown exception" );
   }
-  job.renderingTime = t.elapsed();
-  QgsDebugMsgLevel( QString( "job %1 end [%2 ms] (layer %3)" ).arg( reinterpret_cast< quint64 >( &job ), 0, 16 ).arg( job.renderingTime ).arg( job.layer ? job.layer->id() : QString() ), 2 );
+  // finish painting so that the tile image can be composed into the layer image
+  tile.context.painter()->end();
+  tile.renderingTime = t.elapsed();
+  QgsDebugMsgLevel( QString( "tile %1 end [%2 ms]" ).arg( reinterpret_cast< quint64 >( &tile ), 0, 16 ).arg( tile.renderingTime ), 3 );
 }
 
-
 void QgsMapRendererParallelJob::renderLabelsStatic( QgsMapRendererParallelJob *self )
 {
   LabelRenderJob &job = self->mLabelJob;
@@ -321,6 +402,7 @@ void QgsMapRendererParallelJob::renderLabelsStatic( QgsMapRendererParallelJob *s
     job.participatingLayers = _qgis_listRawToQPointer( self->mLabelingEngineV2->participatingLayers() );
     if ( job.img )
     {
+      QgsScopedRuntimeProfile profile( job.profiler, QStringLiteral( "composition" ) );
       self->mFinalImage = composeImage( self->mSettings, self->mLayerJobs, self->mLabelJob );
     }
   }
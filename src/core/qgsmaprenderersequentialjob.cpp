@@ -64,6 +64,8 @@ void QgsMapRendererSequentialJob::start()
 
   mInternalJob = new QgsMapRendererCustomPainterJob( mSettings, mPainter );
   mInternalJob->setCache( mCache );
+  mInternalJob->setProfilingEnabled( mProfilingEnabled );
+  mInternalJob->setLabelPlacementCache( mLabelPlacementCache );
 
   connect( mInternalJob, &QgsMapRendererJob::finished, this, &QgsMapRendererSequentialJob::internalFinished );
 
@@ -137,6 +139,7 @@ void QgsMapRendererSequentialJob::internalFinished()
   mUsedCachedLabels = mInternalJob->usedCachedLabels();
 
   mErrors = mInternalJob->errors();
+  mProfile = mInternalJob->profile();
 
   // now we are in a slot called from mInternalJob - do not delete it immediately
   // so the class is still valid when the execution returns to the class
@@ -214,6 +214,7 @@ class CORE_EXPORT QgsMapSettings
       DrawSymbolBounds         = 0x80,  //!< Draw bounds of symbols (for debugging/testing)
       RenderMapTile            = 0x100, //!< Draw map such that there are no problems between adjacent tiles
       RenderPartialOutput      = 0x200, //!< Whether to make extra effort to update map image with partially rendered layers (better for interactive map canvas). Added in QGIS 3.0
+      RenderLayerTiles         = 0x400, //!< Allow splitting the rendering of a single vector layer into spatial tiles rendered in parallel (only used by QgsMapRendererParallelJob). Added in QGIS 3.0
       // TODO: ignore scale-based visibility (overview)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -23,6 +23,7 @@
 
 #include "qgslogger.h"
 #include "qgspointxy.h"
+#include "qgssimd_p.h"
 
 
 QgsMapToPixel::QgsMapToPixel( double mapUnitsPerPixel,
@@ -250,6 +251,55 @@ void QgsMapToPixel::transformInPlace( float &x, float &y ) const
   y = my;
 }
 
+void QgsMapToPixel::transformInPlace( QPolygonF &poly ) const
+{
+  const int count = poly.size();
+  if ( count == 0 )
+    return;
+
+  // the map to pixel matrix is always affine
+  const double m11 = mMatrix.m11();
+  const double m12 = mMatrix.m12();
+  const double m21 = mMatrix.m21();
+  const double m22 = mMatrix.m22();
+  const double dx = mMatrix.dx();
+  const double dy = mMatrix.dy();
+
+  QPointF *pt = poly.data();
+  int i = 0;
+
+// the SSE2 code works on doubles, while Qt may be built with qreal as float
+#if defined( QGIS_SSE2 ) && !defined( QT_COORD_TYPE )
+  Q_STATIC_ASSERT( sizeof( QPointF ) == 2 * sizeof( double ) );
+  double *data = reinterpret_cast< double * >( pt );
+
+  // each point (x, y) fills one register: ( x * m11 + y * m21 + dx, x * m12 + y * m22 + dy )
+  const __m128d colX = _mm_set_pd( m12, m11 );
+  const __m128d colY = _mm_set_pd( m22, m21 );
+  const __m128d translate = _mm_set_pd( dy, dx );
+  for ( ; i + 1 < count; i += 2, data += 4 )
+  {
+    const __m128d p0 = _mm_loadu_pd( data );
+    const __m128d p1 = _mm_loadu_pd( data + 2 );
+    const __m128d x0 = _mm_unpacklo_pd( p0, p0 );
+    const __m128d y0 = _mm_unpackhi_pd( p0, p0 );
+    const __m128d x1 = _mm_unpacklo_pd( p1, p1 );
+    const __m128d y1 = _mm_unpackhi_pd( p1, p1 );
+    _mm_storeu_pd( data, _mm_add_pd( _mm_add_pd( _mm_mul_pd( x0, colX ), _mm_mul_pd( y0, colY ) ), translate ) );
+    _mm_storeu_pd( data + 2, _mm_add_pd( _mm_add_pd( _mm_mul_pd( x1, colX ), _mm_mul_pd( y1, colY ) ), translate ) );
+  }
+  pt += i;
+#endif
+
+  for ( ; i < count; ++i, ++pt )
+  {
+    const double x = pt->x();
+    const double y = pt->y();
+    pt->rx() = x * m11 + y * m21 + dx;
+    pt->ry() = x * m12 + y * m22 + dy;
+  }
+}
+
 QTransform QgsMapToPixel::transform() const
 {
   // NOTE: operations are done in the reverse order in which
@@ -20,6 +20,7 @@
 #include "qgis_core.h"
 #include "qgis_sip.h"
 #include <QTransform>
+#include <QPolygonF>
 #include <vector>
 #include "qgsunittypes.h"
 #include <cassert>
@@ -115,6 +116,16 @@ class CORE_EXPORT QgsMapToPixel
       for ( int i = 0; i < x.size(); ++i )
         transformInPlace( x[i], y[i] );
     }
+
+    /**
+     * Transforms all points of \a poly from map (world) coordinates to device
+     * coordinates in place. The points are transformed in bulk (using SIMD
+     * instructions where available), which is much faster than transforming
+     * them one by one.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void transformInPlace( QPolygonF &poly ) const SIP_SKIP;
 #endif
 
     QgsPointXY toMapCoordinates( int x, int y ) const;
@@ -22,6 +22,7 @@
 #include "qgslogger.h"
 #include "qgsrectangle.h"
 #include "qgswkbptr.h"
+#include "qgswkbgeometryview.h"
 #include "qgsgeometry.h"
 #include "qgslinestring.h"
 #include "qgspolygon.h"
@@ -68,9 +69,10 @@ bool QgsMapToPixelSimplifier::equalSnapToGrid( double x1, double y1, double x2,
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 //! Generalize the WKB-geometry using the BBOX of the original geometry
+//! Returns a null geometry if the original geometry is already minimal
 static QgsGeometry generalizeWkbGeometryByBoundingBox(
   QgsWkbTypes::Type wkbType,
-  const QgsAbstractGeometry &geometry,
+  int nCoordinates,
   const QgsRectangle &envelope )
 {
   unsigned int geometryType = QgsWkbTypes::singleType( QgsWkbTypes::flatType( wkbType ) );
@@ -78,9 +80,9 @@ static QgsGeometry generalizeWkbGeometryByBoundingBox(
   // If the geometry is already minimal skip the generalization
   int minimumSize = geometryType == QgsWkbTypes::LineString ? 2 : 5;
 
-  if ( geometry.nCoordinates() <= minimumSize )
+  if ( nCoordinates <= minimumSize )
   {
-    return QgsGeometry( geometry.clone() );
+    return QgsGeometry();
   }
 
   const double x1 = envelope.xMinimum();
@@ -126,7 +128,8 @@ QgsGeometry QgsMapToPixelSimplifier::simplifyGeometry(
   if ( ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) &&
        isGeneralizableByMapBoundingBox( envelope, map2pixelTol ) )
   {
-    return generalizeWkbGeometryByBoundingBox( wkbType, geometry, envelope );
+    QgsGeometry generalized = generalizeWkbGeometryByBoundingBox( wkbType, geometry.nCoordinates(), envelope );
+    return generalized.isNull() ? QgsGeometry( geometry.clone() ) : generalized;
   }
 
   if ( !( simplifyFlags & QgsMapToPixelSimplifier::SimplifyGeometry ) )
@@ -337,3 +340,25 @@ QgsGeometry QgsMapToPixelSimplifier::simplify( const QgsGeometry &geometry ) con
 
   return simplifyGeometry( mSimplifyFlags, mSimplifyAlgorithm, geometry.wkbType(), *geometry.geometry(), envelope, mTolerance, false );
 }
+
+QgsGeometry QgsMapToPixelSimplifier::simplify( const QgsWkbGeometryView &geometry ) const
+{
+  // geometries which collapse to their bounding box are simplified without decoding the WKB
+  if ( geometry.isValid() && ( mSimplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) )
+  {
+    const QgsWkbTypes::Type flatType = QgsWkbTypes::flatType( QgsWkbTypes::singleType( geometry.wkbType() ) );
+    const bool isaLinearRing = flatType == QgsWkbTypes::Polygon;
+    if ( flatType != QgsWkbTypes::Point && geometry.vertexCount() > ( isaLinearRing ? 6 : 3 ) )
+    {
+      const QgsRectangle envelope = geometry.boundingBox();
+      if ( isGeneralizableByMapBoundingBox( envelope, mTolerance ) )
+      {
+        QgsGeometry generalized = generalizeWkbGeometryByBoundingBox( geometry.wkbType(), geometry.vertexCount(), envelope );
+        if ( !generalized.isNull() )
+          return generalized;
+      }
+    }
+  }
+
+  return simplify( geometry.geometry() );
+}
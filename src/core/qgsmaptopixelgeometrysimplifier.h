@@ -25,6 +25,7 @@
 class QgsAbstractGeometry;
 class QgsWkbPtr;
 class QgsConstWkbPtr;
+class QgsWkbGeometryView;
 
 
 /**
@@ -90,6 +91,14 @@ class CORE_EXPORT QgsMapToPixelSimplifier : public QgsAbstractGeometrySimplifier
     //! Returns a simplified version the specified geometry
     virtual QgsGeometry simplify( const QgsGeometry &geometry ) const override;
 
+    /**
+     * Returns a simplified version of the geometry viewed by \a geometry. Geometries
+     * which can be replaced by their bounding box are simplified without decoding the WKB.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QgsGeometry simplify( const QgsWkbGeometryView &geometry ) const SIP_SKIP;
+
     //! Sets the tolerance of the vector layer managed
     void setTolerance( double value ) { mTolerance = value; }
 
@@ -206,15 +206,31 @@ bool QgsOgrUtils::readOgrFeatureGeometry( OGRFeatureH ogrFet, QgsFeature &featur
   if ( !geom )
     feature.clearGeometry();
   else
-    feature.setGeometry( ogrGeometryToQgsGeometry( geom ) );
+  {
+    // take the geometry out of the feature, so that its storage can be recycled
+    QgsGeometry g = feature.geometry();
+    feature.clearGeometry();
+    readOgrGeometry( geom, g );
+    feature.setGeometry( g );
+  }
 
   return true;
 }
 
 QgsGeometry QgsOgrUtils::ogrGeometryToQgsGeometry( OGRGeometryH geom )
+{
+  QgsGeometry g;
+  readOgrGeometry( geom, g );
+  return g;
+}
+
+void QgsOgrUtils::readOgrGeometry( OGRGeometryH geom, QgsGeometry &geometry )
 {
   if ( !geom )
-    return QgsGeometry();
+  {
+    geometry = QgsGeometry();
+    return;
+  }
 
   // get the wkb representation
   int memorySize = OGR_G_WkbSize( geom );
@@ -279,9 +295,7 @@ QgsGeometry QgsOgrUtils::ogrGeometryToQgsGeometry( OGRGeometryH geom )
     memcpy( wkb + 1, &newType, sizeof( uint32_t ) );
   }
 
-  QgsGeometry g;
-  g.fromWkb( wkb, memorySize );
-  return g;
+  geometry.fromWkb( wkb, memorySize );
 }
 
 QgsFeatureList QgsOgrUtils::stringToFeatureList( const QString &string, const QgsFields &fields, QTextCodec *encoding )
@@ -97,6 +97,18 @@ class CORE_EXPORT QgsOgrUtils
      */
     static QgsGeometry ogrGeometryToQgsGeometry( OGRGeometryH geom );
 
+    /**
+     * Converts an OGR geometry representation into an existing \a geometry.
+     * If \a geometry is not shared with other QgsGeometry objects and is of the same type,
+     * its storage is recycled instead of allocating a new geometry.
+     * \param geom OGR geometry handle
+     * \param geometry destination geometry. If conversion was not successful it
+     * will be empty.
+     * \see ogrGeometryToQgsGeometry()
+     * \since QGIS 3.0
+     */
+    static void readOgrGeometry( OGRGeometryH geom, QgsGeometry &geometry );
+
     /**
      * Attempts to parse a string representing a collection of features using OGR. For example, this method can be
      * used to convert a GeoJSON encoded collection to a list of QgsFeatures.
@@ -0,0 +1,273 @@
+/***************************************************************************
+  qgspackedattributes.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgspackedattributes.h"
+
+#include <cstring>
+
+//! Size of the slot of each attribute
+static const int SLOT_SIZE = 8;
+
+//! Maximum length of strings stored in their slot, the last byte of the slot holds the length
+static const int MAX_INLINE_STRING_LENGTH = SLOT_SIZE - 1;
+
+static int nullBitmapOffset()
+{
+  return static_cast< int >( sizeof( qint32 ) );
+}
+
+static int kindsOffset( int count )
+{
+  return nullBitmapOffset() + ( count + 7 ) / 8;
+}
+
+static int slotsOffset( int count )
+{
+  // slots are aligned to their size
+  const int headerSize = kindsOffset( count ) + count;
+  return ( headerSize + SLOT_SIZE - 1 ) / SLOT_SIZE * SLOT_SIZE;
+}
+
+static bool fitsInline( const QString &string )
+{
+  if ( string.size() > MAX_INLINE_STRING_LENGTH )
+    return false;
+
+  for ( const QChar &c : string )
+  {
+    if ( c.unicode() > 0xff )
+      return false;
+  }
+  return true;
+}
+
+template <typename T>
+static void writeSlot( char *slot, T value )
+{
+  static_assert( sizeof( T ) <= SLOT_SIZE, "value does not fit in a slot" );
+  std::memcpy( slot, &value, sizeof( T ) );
+}
+
+template <typename T>
+static T readSlot( const char *slot )
+{
+  T value;
+  std::memcpy( &value, slot, sizeof( T ) );
+  return value;
+}
+
+QgsPackedAttributes::QgsPackedAttributes( const QgsAttributes &attributes )
+{
+  const int count = attributes.size();
+  if ( count == 0 )
+    return;
+
+  // strings which do not fit in their slot are appended after the slots
+  int size = slotsOffset( count ) + count * SLOT_SIZE;
+  for ( const QVariant &v : attributes )
+  {
+    if ( v.type() == QVariant::String && !v.isNull() )
+    {
+      const QString string = v.toString();
+      if ( !fitsInline( string ) )
+        size += string.size() * static_cast< int >( sizeof( QChar ) );
+    }
+  }
+
+  mData = QByteArray( size, '\0' );
+  char *data = mData.data();
+  writeSlot<qint32>( data, count );
+  char *nulls = data + nullBitmapOffset();
+  char *kinds = data + kindsOffset( count );
+  char *slots = data + slotsOffset( count );
+  int stringOffset = slotsOffset( count ) + count * SLOT_SIZE;
+
+  for ( int i = 0; i < count; ++i )
+  {
+    const QVariant &v = attributes.at( i );
+    char *slot = slots + i * SLOT_SIZE;
+
+    Kind kind = Variant;
+    switch ( v.type() )
+    {
+      case QVariant::Invalid:
+        kind = Invalid;
+        break;
+      case QVariant::Int:
+        kind = Int;
+        break;
+      case QVariant::LongLong:
+        kind = LongLong;
+        break;
+      case QVariant::Double:
+        kind = Double;
+        break;
+      case QVariant::Bool:
+        kind = Bool;
+        break;
+      case QVariant::String:
+        kind = String;
+        break;
+      default:
+        break;
+    }
+
+    if ( v.isNull() )
+    {
+      nulls[i / 8] |= static_cast< char >( 1 << ( i % 8 ) );
+      if ( kind == Variant )
+      {
+        // keeps the type of the null value
+        writeSlot<qint32>( slot, mVariants.size() );
+        mVariants << v;
+      }
+      kinds[i] = static_cast< char >( kind );
+      continue;
+    }
+
+    switch ( kind )
+    {
+      case Invalid:
+        break;
+      case Int:
+        writeSlot<qint32>( slot, v.toInt() );
+        break;
+      case LongLong:
+        writeSlot<qint64>( slot, v.toLongLong() );
+        break;
+      case Double:
+        writeSlot<double>( slot, v.toDouble() );
+        break;
+      case Bool:
+        writeSlot<quint8>( slot, v.toBool() ? 1 : 0 );
+        break;
+      case InlineString:
+      case String:
+      {
+        const QString string = v.toString();
+        if ( fitsInline( string ) )
+        {
+          kind = InlineString;
+          for ( int c = 0; c < string.size(); ++c )
+            slot[c] = static_cast< char >( string.at( c ).unicode() );
+          slot[MAX_INLINE_STRING_LENGTH] = static_cast< char >( string.size() );
+        }
+        else
+        {
+          const int bytes = string.size() * static_cast< int >( sizeof( QChar ) );
+          std::memcpy( data + stringOffset, string.constData(), bytes );
+          writeSlot<quint32>( slot, static_cast< quint32 >( stringOffset ) );
+          writeSlot<quint32>( slot + sizeof( quint32 ), static_cast< quint32 >( string.size() ) );
+          stringOffset += bytes;
+        }
+        break;
+      }
+      case Variant:
+        writeSlot<qint32>( slot, mVariants.size() );
+        mVariants << v;
+        break;
+    }
+    kinds[i] = static_cast< char >( kind );
+  }
+}
+
+int QgsPackedAttributes::size() const
+{
+  return mData.isEmpty() ? 0 : readSlot<qint32>( mData.constData() );
+}
+
+QVariant QgsPackedAttributes::at( int index ) const
+{
+  const int count = size();
+  if ( index < 0 || index >= count )
+    return QVariant();
+
+  return value( mData.constData(), count, index );
+}
+
+bool QgsPackedAttributes::isNull( int index ) const
+{
+  const int count = size();
+  if ( index < 0 || index >= count )
+    return true;
+
+  const char *nulls = mData.constData() + nullBitmapOffset();
+  return nulls[index / 8] & ( 1 << ( index % 8 ) );
+}
+
+QgsAttributes QgsPackedAttributes::toAttributes() const
+{
+  const int count = size();
+  QgsAttributes attributes( count );
+  const char *data = mData.constData();
+  for ( int i = 0; i < count; ++i )
+    attributes[i] = value( data, count, i );
+  return attributes;
+}
+
+QgsAttributes QgsPackedAttributes::toAttributes( const QgsAttributeList &attributes ) const
+{
+  const int count = size();
+  QgsAttributes result( count );
+  const char *data = mData.constData();
+  for ( int i : attributes )
+  {
+    if ( i >= 0 && i < count )
+      result[i] = value( data, count, i );
+  }
+  return result;
+}
+
+bool QgsPackedAttributes::operator==( const QgsPackedAttributes &other ) const
+{
+  if ( mVariants.isEmpty() && other.mVariants.isEmpty() )
+    return mData == other.mData;
+
+  return toAttributes() == other.toAttributes();
+}
+
+QVariant QgsPackedAttributes::value( const char *data, int count, int index ) const
+{
+  const Kind kind = static_cast< Kind >( data[ kindsOffset( count ) + index ] );
+  const char *slot = data + slotsOffset( count ) + index * SLOT_SIZE;
+  const bool null = data[ nullBitmapOffset() + index / 8 ] & ( 1 << ( index % 8 ) );
+
+  switch ( kind )
+  {
+    case Invalid:
+      return QVariant();
+    case Int:
+      return null ? QVariant( QVariant::Int ) : QVariant( readSlot<qint32>( slot ) );
+    case LongLong:
+      return null ? QVariant( QVariant::LongLong ) : QVariant( readSlot<qint64>( slot ) );
+    case Double:
+      return null ? QVariant( QVariant::Double ) : QVariant( readSlot<double>( slot ) );
+    case Bool:
+      return null ? QVariant( QVariant::Bool ) : QVariant( readSlot<quint8>( slot ) != 0 );
+    case InlineString:
+      return QString::fromLatin1( slot, slot[MAX_INLINE_STRING_LENGTH] );
+    case String:
+    {
+      if ( null )
+        return QVariant( QVariant::String );
+
+      const quint32 offset = readSlot<quint32>( slot );
+      const quint32 length = readSlot<quint32>( slot + sizeof( quint32 ) );
+      return QString( reinterpret_cast< const QChar * >( data + offset ), static_cast< int >( length ) );
+    }
+    case Variant:
+      return mVariants.at( readSlot<qint32>( slot ) );
+  }
+  return QVariant();
+}
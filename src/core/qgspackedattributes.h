@@ -0,0 +1,113 @@
+/***************************************************************************
+  qgspackedattributes.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPACKEDATTRIBUTES_H
+#define QGSPACKEDATTRIBUTES_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsattributes.h"
+
+#include <QByteArray>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * \ingroup core
+ * \class QgsPackedAttributes
+ * \brief Compact storage for the attributes of a feature.
+ *
+ * QgsAttributes holds one QVariant per attribute, plus a separate heap allocation for
+ * each string value. QgsPackedAttributes stores the same values in a single buffer
+ * instead: each attribute has a fixed width slot holding integer, double and boolean
+ * values directly, strings of up to 7 Latin-1 characters are stored inline in their slot
+ * and longer strings are appended to the end of the buffer. Null values are tracked in
+ * a bitmap. Values of other types are kept as QVariant.
+ *
+ * Packed attributes are meant for features kept in memory for a long time, like the
+ * features of the memory provider. They are converted to QgsAttributes when handed out
+ * through the API, and the conversion is lossless: the values, their types and their
+ * null flags are identical to the values which were packed.
+ *
+ * Like QgsAttributes, QgsPackedAttributes is implicitly shared.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsPackedAttributes
+{
+  public:
+
+    //! Constructs empty packed attributes
+    QgsPackedAttributes() = default;
+
+    //! Constructs packed attributes holding the values of \a attributes
+    explicit QgsPackedAttributes( const QgsAttributes &attributes );
+
+    //! Returns the number of attributes
+    int size() const;
+
+    //! Returns true if there are no attributes
+    bool isEmpty() const { return size() == 0; }
+
+    //! Returns the value of the attribute at \a index, or an invalid variant if the index is out of range
+    QVariant at( int index ) const;
+
+    //! Returns true if the attribute at \a index holds a null value
+    bool isNull( int index ) const;
+
+    //! Returns the attributes as QgsAttributes
+    QgsAttributes toAttributes() const;
+
+    /**
+     * Returns the attributes as QgsAttributes, with only the attributes from the list of
+     * \a attributes being decoded. Other attributes are returned as invalid variants.
+     */
+    QgsAttributes toAttributes( const QgsAttributeList &attributes ) const;
+
+    /**
+     * Returns the number of bytes used by the packed values, excluding the values
+     * stored as QVariant.
+     */
+    int byteSize() const { return mData.size(); }
+
+    bool operator==( const QgsPackedAttributes &other ) const;
+    bool operator!=( const QgsPackedAttributes &other ) const { return !( *this == other ); }
+
+  private:
+
+    //! Encoding of the value of a slot
+    enum Kind
+    {
+      Invalid = 0,
+      Int,
+      LongLong,
+      Double,
+      Bool,
+      InlineString,
+      String,
+      Variant,
+    };
+
+    //! Layout: attribute count, null bitmap, kind of each slot, padding, slots, string data
+    QByteArray mData;
+
+    //! Values which can not be packed, referenced by index from their slot
+    QVector<QVariant> mVariants;
+
+    QVariant value( const char *data, int count, int index ) const;
+};
+
+#endif // QGSPACKEDATTRIBUTES_H
@@ -17,7 +17,9 @@
 
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
+#include "qgsgeometryutils.h"
 #include "qgsvectorlayer.h"
+#include "qgsvectorlayerfeatureiterator.h"
 #include "qgswkbptr.h"
 #include "qgis.h"
 #include "qgslogger.h"
@@ -25,6 +27,10 @@
 #include <SpatialIndex.h>
 
 #include <QLinkedListIterator>
+#include <QtConcurrentRun>
+#include <algorithm>
+#include <limits>
+#include <memory>
 
 using namespace SpatialIndex;
 
@@ -51,6 +57,36 @@ static SpatialIndex::Region rect2region( const QgsRectangle &rect )
 // is lower than epsilon it will have a special logic...
 static const double POINT_LOC_EPSILON = 1e-12;
 
+//! Number of features read by the background indexing task before they are inserted into the tree
+static const int INDEXING_BATCH_SIZE = 1000;
+
+//! Creates an empty R-tree in the \a storage, with the same parameters as bulk loaded trees
+static SpatialIndex::ISpatialIndex *createEmptyRTree( SpatialIndex::IStorageManager &storage )
+{
+  SpatialIndex::id_type indexId;
+  return RTree::createNewRTree( storage, 0.7, 10, 10, 2, RTree::RV_RSTAR, indexId );
+}
+
+//! Transforms the \a geometry to the destination CRS of \a transform, returns false if it could not be transformed
+static bool transformGeometry( QgsGeometry &geometry, const QgsCoordinateTransform &transform )
+{
+  if ( !transform.isValid() )
+    return true;
+
+  try
+  {
+    geometry.transform( transform );
+  }
+  catch ( const QgsException &e )
+  {
+    Q_UNUSED( e );
+    // See https://issues.qgis.org/issues/12634
+    QgsDebugMsg( QString( "could not transform geometry to map, skipping the snap for it (%1)" ).arg( e.what() ) );
+    return false;
+  }
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 
 
@@ -82,6 +118,54 @@ class QgsPointLocator_Stream : public IDataStream
 ////////////////////////////////////////////////////////////////////////////
 
 
+/**
+ * \ingroup core
+ * Helper class holding an indexed geometry. Compact geometries only keep the x/y coordinates
+ * of the vertices in flat arrays, other geometries (and all curved geometries) keep a copy
+ * of the whole geometry. Vertex indices are the same as those of QgsGeometry.
+ * \note not available in Python bindings
+*/
+class QgsPointLocator_Geometry
+{
+  public:
+    QgsPointLocator_Geometry( const QgsGeometry &geometry, bool compact );
+
+    //! Returns the bounding box of the geometry
+    QgsRectangle boundingBox() const { return mBoundingBox; }
+
+    //! Returns the vertex closest to \a point. \a sqrDist is set to -1 if the geometry has no vertices.
+    QgsPointXY closestVertex( const QgsPointXY &point, int &vertexIndex, double &sqrDist ) const;
+
+    //! Returns the squared distance to the closest segment, or -1 if the geometry has no segments
+    double closestSegment( const QgsPointXY &point, QgsPointXY &minDistPoint, int &afterVertex ) const;
+
+    //! Returns the vertex at \a index
+    QgsPointXY vertexAt( int index ) const;
+
+    //! Returns true if the \a point is within the geometry or on its boundary
+    bool intersects( const QgsPointXY &point ) const;
+
+    //! Returns the segments of the geometry which intersect \a rect
+    QgsPointLocator::MatchList segmentsInRect( const QgsRectangle &rect, QgsVectorLayer *vl, QgsFeatureId fid ) const;
+
+  private:
+    bool mCompact = false;
+    //! Copy of the geometry if it is not compact
+    QgsGeometry mGeometry;
+    QgsRectangle mBoundingBox;
+    QgsWkbTypes::GeometryType mType = QgsWkbTypes::UnknownGeometry;
+    //! x and y coordinates of all vertices of a compact geometry
+    QVector<double> mXY;
+    //! Index of the vertex past the last vertex of each ring (or of each part of point and line geometries)
+    QVector<int> mRingEnds;
+    //! Index of the ring past the last ring of each part
+    QVector<int> mPartEnds;
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+
+
 /**
  * \ingroup core
  * Helper class used when traversing the index looking for vertices - builds a list of matches.
@@ -103,11 +187,11 @@ class QgsPointLocator_VisitorNearestVertex : public IVisitor
     void visitData( const IData &d ) override
     {
       QgsFeatureId id = d.getIdentifier();
-      QgsGeometry *geom = mLocator->mGeoms.value( id );
-      int vertexIndex, beforeVertex, afterVertex;
+      QgsPointLocator_Geometry *geom = mLocator->mGeoms.value( id );
+      int vertexIndex = 0;
       double sqrDist;
 
-      QgsPointXY pt = geom->closestVertex( mSrcPoint, vertexIndex, beforeVertex, afterVertex, sqrDist );
+      QgsPointXY pt = geom->closestVertex( mSrcPoint, vertexIndex, sqrDist );
       if ( sqrDist < 0 )
         return;  // probably empty geometry
 
@@ -152,10 +236,10 @@ class QgsPointLocator_VisitorNearestEdge : public IVisitor
     void visitData( const IData &d ) override
     {
       QgsFeatureId id = d.getIdentifier();
-      QgsGeometry *geom = mLocator->mGeoms.value( id );
+      QgsPointLocator_Geometry *geom = mLocator->mGeoms.value( id );
       QgsPointXY pt;
       int afterVertex;
-      double sqrDist = geom->closestSegmentWithContext( mSrcPoint, pt, afterVertex, nullptr, POINT_LOC_EPSILON );
+      double sqrDist = geom->closestSegment( mSrcPoint, pt, afterVertex );
       if ( sqrDist < 0 )
         return;
 
@@ -194,7 +278,7 @@ class QgsPointLocator_VisitorArea : public IVisitor
     QgsPointLocator_VisitorArea( QgsPointLocator *pl, const QgsPointXY &origPt, QgsPointLocator::MatchList &list )
       : mLocator( pl )
       , mList( list )
-      , mGeomPt( QgsGeometry::fromPoint( origPt ) )
+      , mPoint( origPt )
     {}
 
     void visitNode( const INode &n ) override { Q_UNUSED( n ); }
@@ -203,14 +287,14 @@ class QgsPointLocator_VisitorArea : public IVisitor
     void visitData( const IData &d ) override
     {
       QgsFeatureId id = d.getIdentifier();
-      QgsGeometry *g = mLocator->mGeoms.value( id );
-      if ( g->intersects( mGeomPt ) )
+      QgsPointLocator_Geometry *g = mLocator->mGeoms.value( id );
+      if ( g->intersects( mPoint ) )
         mList << QgsPointLocator::Match( QgsPointLocator::Area, mLocator->mLayer, id, 0, QgsPointXY() );
     }
   private:
     QgsPointLocator *mLocator = nullptr;
     QgsPointLocator::MatchList &mList;
-    QgsGeometry mGeomPt;
+    QgsPointXY mPoint;
 };
 
 
@@ -325,7 +409,7 @@ struct _CohenSutherland
 };
 
 
-static QgsPointLocator::MatchList _geometrySegmentsInRect( QgsGeometry *geom, const QgsRectangle &rect, QgsVectorLayer *vl, QgsFeatureId fid )
+static QgsPointLocator::MatchList _geometrySegmentsInRect( const QgsGeometry *geom, const QgsRectangle &rect, QgsVectorLayer *vl, QgsFeatureId fid )
 {
   // this code is stupidly based on QgsGeometry::closestSegmentWithContext
   // we need iterator for segments...
@@ -524,6 +608,196 @@ static QgsPointLocator::MatchList _geometrySegmentsInRect( QgsGeometry *geom, co
   return lst;
 }
 
+
+////////////////////////////////////////////////////////////////////////////
+
+
+QgsPointLocator_Geometry::QgsPointLocator_Geometry( const QgsGeometry &geometry, bool compact )
+  : mBoundingBox( geometry.boundingBox() )
+  , mType( geometry.type() )
+{
+  const QgsAbstractGeometry *abstractGeometry = geometry.geometry();
+  mCompact = compact && abstractGeometry && !QgsWkbTypes::isCurvedType( abstractGeometry->wkbType() );
+  if ( !mCompact )
+  {
+    mGeometry = geometry;
+    return;
+  }
+
+  mXY.reserve( 2 * abstractGeometry->nCoordinates() );
+  QgsVertexId id;
+  QgsPoint vertex;
+  int part = -1;
+  int ring = -1;
+  while ( abstractGeometry->nextVertex( id, vertex ) )
+  {
+    if ( !mXY.isEmpty() && ( id.part != part || id.ring != ring ) )
+    {
+      mRingEnds << mXY.count() / 2;
+      if ( id.part != part )
+        mPartEnds << mRingEnds.count();
+    }
+    part = id.part;
+    ring = id.ring;
+    mXY << vertex.x() << vertex.y();
+  }
+  if ( !mXY.isEmpty() )
+  {
+    mRingEnds << mXY.count() / 2;
+    mPartEnds << mRingEnds.count();
+  }
+}
+
+QgsPointXY QgsPointLocator_Geometry::closestVertex( const QgsPointXY &point, int &vertexIndex, double &sqrDist ) const
+{
+  if ( !mCompact )
+  {
+    int beforeVertex, afterVertex;
+    return mGeometry.closestVertex( point, vertexIndex, beforeVertex, afterVertex, sqrDist );
+  }
+
+  const double *xy = mXY.constData();
+  const int count = mXY.count() / 2;
+  double minDist = std::numeric_limits<double>::max();
+  int minDistIndex = -1;
+  for ( int i = 0; i < count; ++i )
+  {
+    const double dx = xy[2 * i] - point.x();
+    const double dy = xy[2 * i + 1] - point.y();
+    const double dist = dx * dx + dy * dy;
+    // <= like QgsGeometryUtils::closestVertex(), so that closing vertices are returned
+    if ( dist <= minDist )
+    {
+      minDist = dist;
+      minDistIndex = i;
+    }
+  }
+
+  if ( minDistIndex < 0 )
+  {
+    sqrDist = -1;
+    return QgsPointXY( 0, 0 );
+  }
+  vertexIndex = minDistIndex;
+  sqrDist = minDist;
+  return QgsPointXY( xy[2 * minDistIndex], xy[2 * minDistIndex + 1] );
+}
+
+double QgsPointLocator_Geometry::closestSegment( const QgsPointXY &point, QgsPointXY &minDistPoint, int &afterVertex ) const
+{
+  if ( !mCompact )
+    return mGeometry.closestSegmentWithContext( point, minDistPoint, afterVertex, nullptr, POINT_LOC_EPSILON );
+
+  const double *xy = mXY.constData();
+  double minDist = std::numeric_limits<double>::max();
+  double segmentX = 0.0, segmentY = 0.0;
+  int ringStart = 0;
+  for ( int ringEnd : mRingEnds )
+  {
+    for ( int i = ringStart + 1; i < ringEnd; ++i )
+    {
+      double x, y;
+      const double dist = QgsGeometryUtils::sqrDistToLine( point.x(), point.y(), xy[2 * i - 2], xy[2 * i - 1], xy[2 * i], xy[2 * i + 1], x, y, POINT_LOC_EPSILON );
+      if ( dist < minDist )
+      {
+        minDist = dist;
+        segmentX = x;
+        segmentY = y;
+        afterVertex = i;
+      }
+    }
+    ringStart = ringEnd;
+  }
+
+  if ( minDist == std::numeric_limits<double>::max() )
+    return -1;
+
+  minDistPoint.set( segmentX, segmentY );
+  return minDist;
+}
+
+QgsPointXY QgsPointLocator_Geometry::vertexAt( int index ) const
+{
+  if ( !mCompact )
+    return QgsPointXY( mGeometry.vertexAt( index ) );
+
+  if ( index < 0 || 2 * index >= mXY.count() )
+    return QgsPointXY();
+  return QgsPointXY( mXY.at( 2 * index ), mXY.at( 2 * index + 1 ) );
+}
+
+bool QgsPointLocator_Geometry::intersects( const QgsPointXY &point ) const
+{
+  if ( !mCompact )
+    return mGeometry.intersects( QgsGeometry::fromPoint( point ) );
+
+  if ( !mBoundingBox.contains( point ) )
+    return false;
+
+  const double *xy = mXY.constData();
+  const double px = point.x();
+  const double py = point.y();
+  int ringStart = 0;
+  int partStart = 0;
+  for ( int partEnd : mPartEnds )
+  {
+    // even-odd rule over all rings of the part, holes are within the exterior ring
+    bool inside = false;
+    for ( int ring = partStart; ring < partEnd; ++ring )
+    {
+      const int ringEnd = mRingEnds.at( ring );
+      for ( int i = ringStart; i < ringEnd; ++i )
+      {
+        // the last vertex is connected to the first one in case the ring is not closed
+        const int j = i + 1 < ringEnd ? i + 1 : ringStart;
+        const double x1 = xy[2 * i], y1 = xy[2 * i + 1];
+        const double x2 = xy[2 * j], y2 = xy[2 * j + 1];
+
+        // points on the boundary intersect the geometry
+        if ( ( px - x1 ) * ( y2 - y1 ) == ( py - y1 ) * ( x2 - x1 ) &&
+             px >= std::min( x1, x2 ) && px <= std::max( x1, x2 ) &&
+             py >= std::min( y1, y2 ) && py <= std::max( y1, y2 ) )
+          return true;
+
+        if ( mType == QgsWkbTypes::PolygonGeometry && ( y1 > py ) != ( y2 > py ) &&
+             px < x1 + ( py - y1 ) * ( x2 - x1 ) / ( y2 - y1 ) )
+          inside = !inside;
+      }
+      ringStart = ringEnd;
+    }
+    if ( inside )
+      return true;
+    partStart = partEnd;
+  }
+  return false;
+}
+
+QgsPointLocator::MatchList QgsPointLocator_Geometry::segmentsInRect( const QgsRectangle &rect, QgsVectorLayer *vl, QgsFeatureId fid ) const
+{
+  if ( !mCompact )
+    return _geometrySegmentsInRect( &mGeometry, rect, vl, fid );
+
+  QgsPointLocator::MatchList lst;
+  _CohenSutherland cs( rect );
+  const double *xy = mXY.constData();
+  int ringStart = 0;
+  for ( int ringEnd : mRingEnds )
+  {
+    for ( int i = ringStart + 1; i < ringEnd; ++i )
+    {
+      if ( cs.isSegmentInRect( xy[2 * i - 2], xy[2 * i - 1], xy[2 * i], xy[2 * i + 1] ) )
+      {
+        QgsPointXY edgePoints[2];
+        edgePoints[0].set( xy[2 * i - 2], xy[2 * i - 1] );
+        edgePoints[1].set( xy[2 * i], xy[2 * i + 1] );
+        lst << QgsPointLocator::Match( QgsPointLocator::Edge, vl, fid, 0, QgsPointXY(), i - 1, edgePoints );
+      }
+    }
+    ringStart = ringEnd;
+  }
+  return lst;
+}
+
 /**
  * \ingroup core
  * Helper class used when traversing the index looking for edges - builds a list of matches.
@@ -545,9 +819,9 @@ class QgsPointLocator_VisitorEdgesInRect : public IVisitor
     void visitData( const IData &d ) override
     {
       QgsFeatureId id = d.getIdentifier();
-      QgsGeometry *geom = mLocator->mGeoms.value( id );
+      QgsPointLocator_Geometry *geom = mLocator->mGeoms.value( id );
 
-      Q_FOREACH ( const QgsPointLocator::Match &m, _geometrySegmentsInRect( geom, mSrcRect, mLocator->mLayer, id ) )
+      Q_FOREACH ( const QgsPointLocator::Match &m, geom->segmentsInRect( mSrcRect, mLocator->mLayer, id ) )
       {
         // in range queries the filter may reject some matches
         if ( mFilter && !mFilter->acceptMatch( m ) )
@@ -633,6 +907,8 @@ QgsPointLocator::QgsPointLocator( QgsVectorLayer *layer, const QgsCoordinateRefe
 
   mStorage = StorageManager::createNewMemoryStorageManager();
 
+  connect( &mIndexingWatcher, &QFutureWatcher<bool>::finished, this, &QgsPointLocator::onIndexingFinished );
+
   connect( mLayer, &QgsVectorLayer::featureAdded, this, &QgsPointLocator::onFeatureAdded );
   connect( mLayer, &QgsVectorLayer::featureDeleted, this, &QgsPointLocator::onFeatureDeleted );
   connect( mLayer, &QgsVectorLayer::geometryChanged, this, &QgsPointLocator::onGeometryChanged );
@@ -662,29 +938,72 @@ void QgsPointLocator::setExtent( const QgsRectangle *extent )
   destroyIndex();
 }
 
+void QgsPointLocator::setCompactGeometries( bool compact )
+{
+  if ( compact == mCompactGeometries )
+    return;
+
+  mCompactGeometries = compact;
+  destroyIndex();
+}
+
 
-bool QgsPointLocator::init( int maxFeaturesToIndex )
+bool QgsPointLocator::init( int maxFeaturesToIndex, bool relaxed )
 {
-  return hasIndex() ? true : rebuildIndex( maxFeaturesToIndex );
+  if ( hasIndex() )
+    return true;
+
+  if ( !relaxed || mLayer->geometryType() == QgsWkbTypes::NullGeometry )
+    return rebuildIndex( maxFeaturesToIndex );
+
+  // a previous task may still be finishing after it exceeded the limit of features
+  cancelIndexing();
+
+  // the features are read from a snapshot of the layer, changes made while indexing are
+  // applied by the layer's signals and recorded so that the task does not overwrite them
+  std::shared_ptr< QgsAbstractFeatureSource > source( new QgsVectorLayerFeatureSource( mLayer ) );
+  const QgsFeatureRequest request = indexRequest();
+  const bool compact = mCompactGeometries;
+  {
+    QMutexLocker locker( &mMutex );
+    clearIndex();
+    mRTree = createEmptyRTree( *mStorage );
+  }
+
+  mCancelIndexing.store( 0 );
+  mIndexingWatcher.setFuture( QtConcurrent::run( [this, source, request, maxFeaturesToIndex, compact]
+  {
+    return buildIndexInBackground( source.get(), request, maxFeaturesToIndex, compact );
+  } ) );
+  return true;
 }
 
 
 bool QgsPointLocator::hasIndex() const
 {
+  QMutexLocker locker( &mMutex );
   return mRTree || mIsEmptyLayer;
 }
 
+bool QgsPointLocator::isIndexing() const
+{
+  return mIndexingWatcher.isRunning();
+}
 
-bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
+void QgsPointLocator::waitForIndexingFinished()
 {
-  destroyIndex();
+  mIndexingWatcher.waitForFinished();
+}
+
+int QgsPointLocator::cachedGeometryCount() const
+{
+  QMutexLocker locker( &mMutex );
+  return mGeoms.count();
+}
 
-  QLinkedList<RTree::Data *> dataList;
-  QgsFeature f;
-  QgsWkbTypes::GeometryType geomType = mLayer->geometryType();
-  if ( geomType == QgsWkbTypes::NullGeometry )
-    return true; // nothing to index
 
+QgsFeatureRequest QgsPointLocator::indexRequest() const
+{
   QgsFeatureRequest request;
   request.setSubsetOfAttributes( QgsAttributeList() );
   if ( mExtent )
@@ -705,42 +1024,46 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
     }
     request.setFilterRect( rect );
   }
-  QgsFeatureIterator fi = mLayer->getFeatures( request );
+  return request;
+}
+
+
+bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
+{
+  destroyIndex();
+
+  QLinkedList<RTree::Data *> dataList;
+  QgsFeature f;
+  QgsWkbTypes::GeometryType geomType = mLayer->geometryType();
+  if ( geomType == QgsWkbTypes::NullGeometry )
+    return true; // nothing to index
+
+  QMutexLocker locker( &mMutex );
+
+  QgsFeatureIterator fi = mLayer->getFeatures( indexRequest() );
   int indexedCount = 0;
   while ( fi.nextFeature( f ) )
   {
     if ( !f.hasGeometry() )
       continue;
 
-    if ( mTransform.isValid() )
-    {
-      try
-      {
-        QgsGeometry transformedGeometry = f.geometry();
-        transformedGeometry.transform( mTransform );
-        f.setGeometry( transformedGeometry );
-      }
-      catch ( const QgsException &e )
-      {
-        Q_UNUSED( e );
-        // See https://issues.qgis.org/issues/12634
-        QgsDebugMsg( QString( "could not transform geometry to map, skipping the snap for it (%1)" ).arg( e.what() ) );
-        continue;
-      }
-    }
+    QgsGeometry geometry = f.geometry();
+    if ( !transformGeometry( geometry, mTransform ) )
+      continue;
 
-    SpatialIndex::Region r( rect2region( f.geometry().boundingBox() ) );
+    QgsPointLocator_Geometry *indexedGeometry = new QgsPointLocator_Geometry( geometry, mCompactGeometries );
+    SpatialIndex::Region r( rect2region( indexedGeometry->boundingBox() ) );
     dataList << new RTree::Data( 0, nullptr, r, f.id() );
 
     if ( mGeoms.contains( f.id() ) )
       delete mGeoms.take( f.id() );
-    mGeoms[f.id()] = new QgsGeometry( f.geometry() );
+    mGeoms[f.id()] = indexedGeometry;
     ++indexedCount;
 
     if ( maxFeaturesToIndex != -1 && indexedCount > maxFeaturesToIndex )
     {
       qDeleteAll( dataList );
-      destroyIndex();
+      clearIndex();
       return false;
     }
   }
@@ -766,7 +1089,93 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
 }
 
 
+bool QgsPointLocator::buildIndexInBackground( QgsAbstractFeatureSource *source, const QgsFeatureRequest &request, int maxFeaturesToIndex, bool compact )
+{
+  // features are inserted in batches, so that queries made meanwhile only wait for a short time
+  QHash<QgsFeatureId, QgsPointLocator_Geometry *> batch;
+  auto insertBatch = [this, &batch]
+  {
+    QMutexLocker locker( &mMutex );
+    for ( auto it = batch.constBegin(); it != batch.constEnd(); ++it )
+    {
+      // features changed meanwhile have already been indexed with their current geometry
+      if ( mUpdatedWhileIndexing.contains( it.key() ) )
+        delete it.value();
+      else
+        insertGeometry( it.key(), it.value() );
+    }
+    batch.clear();
+  };
+
+  QgsFeatureIterator fi = source->getFeatures( request );
+  QgsFeature f;
+  int indexedCount = 0;
+  while ( !mCancelIndexing.load() && fi.nextFeature( f ) )
+  {
+    if ( !f.hasGeometry() )
+      continue;
+
+    QgsGeometry geometry = f.geometry();
+    if ( !transformGeometry( geometry, mTransform ) )
+      continue;
+
+    batch.insert( f.id(), new QgsPointLocator_Geometry( geometry, compact ) );
+    ++indexedCount;
+
+    if ( maxFeaturesToIndex != -1 && indexedCount > maxFeaturesToIndex )
+    {
+      qDeleteAll( batch );
+      QMutexLocker locker( &mMutex );
+      clearIndex();
+      return false;
+    }
+
+    if ( batch.count() >= INDEXING_BATCH_SIZE )
+      insertBatch();
+  }
+
+  if ( mCancelIndexing.load() )
+  {
+    // the index is being destroyed
+    qDeleteAll( batch );
+    return true;
+  }
+
+  insertBatch();
+  return true;
+}
+
+
+void QgsPointLocator::cancelIndexing()
+{
+  mCancelIndexing.store( 1 );
+  mIndexingWatcher.waitForFinished();
+}
+
+
+void QgsPointLocator::onIndexingFinished()
+{
+  // the index has been destroyed meanwhile
+  if ( mCancelIndexing.load() )
+    return;
+
+  {
+    QMutexLocker locker( &mMutex );
+    mUpdatedWhileIndexing.clear();
+  }
+  emit initFinished( mIndexingWatcher.result() );
+}
+
+
 void QgsPointLocator::destroyIndex()
+{
+  cancelIndexing();
+
+  QMutexLocker locker( &mMutex );
+  clearIndex();
+}
+
+void QgsPointLocator::clearIndex()
 {
   delete mRTree;
   mRTree = nullptr;
@@ -776,62 +1185,72 @@ void QgsPointLocator::destroyIndex()
   qDeleteAll( mGeoms );
 
   mGeoms.clear();
+
+  mUpdatedWhileIndexing.clear();
 }
 
-void QgsPointLocator::onFeatureAdded( QgsFeatureId fid )
+void QgsPointLocator::insertGeometry( QgsFeatureId fid, QgsPointLocator_Geometry *geometry )
 {
-  if ( !mRTree )
+  if ( QgsPointLocator_Geometry *oldGeometry = mGeoms.take( fid ) )
   {
-    if ( mIsEmptyLayer )
-      rebuildIndex(); // first feature - let's built the index
-    return; // nothing to do if we are not initialized yet
+    mRTree->deleteData( rect2region( oldGeometry->boundingBox() ), fid );
+    delete oldGeometry;
   }
 
+  mRTree->insertData( 0, nullptr, rect2region( geometry->boundingBox() ), fid );
+  mGeoms.insert( fid, geometry );
+}
+
+void QgsPointLocator::onFeatureAdded( QgsFeatureId fid )
+{
+  if ( !hasIndex() )
+    return; // nothing to do if we are not initialized yet
+
   QgsFeature f;
   if ( mLayer->getFeatures( QgsFeatureRequest( fid ) ).nextFeature( f ) )
   {
     if ( !f.hasGeometry() )
       return;
 
-    if ( mTransform.isValid() )
+    QgsGeometry geometry = f.geometry();
+    if ( !transformGeometry( geometry, mTransform ) )
+      return;
+
+    QgsRectangle bbox = geometry.boundingBox();
+    if ( !bbox.isNull() )
     {
-      try
+      QMutexLocker locker( &mMutex );
+      if ( !mRTree )
       {
-        QgsGeometry transformedGeom = f.geometry();
-        transformedGeom.transform( mTransform );
-        f.setGeometry( transformedGeom );
-      }
-      catch ( const QgsException &e )
-      {
-        Q_UNUSED( e );
-        // See https://issues.qgis.org/issues/12634
-        QgsDebugMsg( QString( "could not transform geometry to map, skipping the snap for it (%1)" ).arg( e.what() ) );
-        return;
+        if ( !mIsEmptyLayer )
+          return; // the index has been destroyed meanwhile
+
+        // first feature - start with an empty tree instead of reading the whole layer again
+        mRTree = createEmptyRTree( *mStorage );
+        mIsEmptyLayer = false;
       }
-    }
 
-    QgsRectangle bbox = f.geometry().boundingBox();
-    if ( !bbox.isNull() )
-    {
-      SpatialIndex::Region r( rect2region( bbox ) );
-      mRTree->insertData( 0, nullptr, r, f.id() );
+      if ( isIndexing() )
+        mUpdatedWhileIndexing << fid;
 
-      if ( mGeoms.contains( f.id() ) )
-        delete mGeoms.take( f.id() );
-      mGeoms[fid] = new QgsGeometry( f.geometry() );
+      insertGeometry( fid, new QgsPointLocator_Geometry( geometry, mCompactGeometries ) );
     }
   }
 }
 
 void QgsPointLocator::onFeatureDeleted( QgsFeatureId fid )
 {
+  QMutexLocker locker( &mMutex );
   if ( !mRTree )
     return; // nothing to do if we are not initialized yet
 
-  if ( mGeoms.contains( fid ) )
+  if ( isIndexing() )
+    mUpdatedWhileIndexing << fid;
+
+  if ( QgsPointLocator_Geometry *geometry = mGeoms.take( fid ) )
   {
-    mRTree->deleteData( rect2region( mGeoms[fid]->boundingBox() ), fid );
-    delete mGeoms.take( fid );
+    mRTree->deleteData( rect2region( geometry->boundingBox() ), fid );
+    delete geometry;
   }
 }
 
@@ -845,12 +1264,12 @@ void QgsPointLocator::onGeometryChanged( QgsFeatureId fid, const QgsGeometry &ge
 
 QgsPointLocator::Match QgsPointLocator::nearestVertex( const QgsPointXY &point, double tolerance, MatchFilter *filter )
 {
-  if ( !mRTree )
-  {
+  if ( !hasIndex() )
     init();
-    if ( !mRTree ) // still invalid?
-      return Match();
-  }
+
+  QMutexLocker locker( &mMutex );
+  if ( !mRTree )
+    return Match();
 
   Match m;
   QgsPointLocator_VisitorNearestVertex visitor( this, m, point, filter );
@@ -863,12 +1282,12 @@ QgsPointLocator::Match QgsPointLocator::nearestVertex( const QgsPointXY &point,
 
 QgsPointLocator::Match QgsPointLocator::nearestEdge( const QgsPointXY &point, double tolerance, MatchFilter *filter )
 {
-  if ( !mRTree )
-  {
+  if ( !hasIndex() )
     init();
-    if ( !mRTree ) // still invalid?
-      return Match();
-  }
+
+  QMutexLocker locker( &mMutex );
+  if ( !mRTree )
+    return Match();
 
   QgsWkbTypes::GeometryType geomType = mLayer->geometryType();
   if ( geomType == QgsWkbTypes::PointGeometry )
@@ -885,12 +1304,12 @@ QgsPointLocator::Match QgsPointLocator::nearestEdge( const QgsPointXY &point, do
 
 QgsPointLocator::MatchList QgsPointLocator::edgesInRect( const QgsRectangle &rect, QgsPointLocator::MatchFilter *filter )
 {
-  if ( !mRTree )
-  {
+  if ( !hasIndex() )
     init();
-    if ( !mRTree ) // still invalid?
-      return MatchList();
-  }
+
+  QMutexLocker locker( &mMutex );
+  if ( !mRTree )
+    return MatchList();
 
   QgsWkbTypes::GeometryType geomType = mLayer->geometryType();
   if ( geomType == QgsWkbTypes::PointGeometry )
@@ -912,12 +1331,12 @@ QgsPointLocator::MatchList QgsPointLocator::edgesInRect( const QgsPointXY &point
 
 QgsPointLocator::MatchList QgsPointLocator::pointInPolygon( const QgsPointXY &point )
 {
-  if ( !mRTree )
-  {
+  if ( !hasIndex() )
     init();
-    if ( !mRTree ) // still invalid?
-      return MatchList();
-  }
+
+  QMutexLocker locker( &mMutex );
+  if ( !mRTree )
+    return MatchList();
 
   QgsWkbTypes::GeometryType geomType = mLayer->geometryType();
   if ( geomType == QgsWkbTypes::PointGeometry || geomType == QgsWkbTypes::LineGeometry )
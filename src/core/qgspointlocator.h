@@ -18,6 +18,8 @@
 
 class QgsPointXY;
 class QgsVectorLayer;
+class QgsAbstractFeatureSource;
+class QgsFeatureRequest;
 
 #include "qgis_core.h"
 #include "qgsfeature.h"
@@ -25,6 +27,11 @@ class QgsVectorLayer;
 #include "qgscoordinatereferencesystem.h"
 #include "qgscoordinatetransform.h"
 
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QSet>
+
+class QgsPointLocator_Geometry;
 class QgsPointLocator_VisitorNearestVertex;
 class QgsPointLocator_VisitorNearestEdge;
 class QgsPointLocator_VisitorArea;
@@ -45,6 +52,11 @@ namespace SpatialIndex SIP_SKIP
  *
  * Works with one layer.
  *
+ * The index is kept up to date with additions, deletions and geometry changes of
+ * the layer's features, so it does not need to be rebuilt while the layer is edited.
+ * It can be built in a background thread (see init()), in which case queries
+ * return the features indexed so far until indexing has finished.
+ *
  * \since QGIS 2.8
  */
 class CORE_EXPORT QgsPointLocator : public QObject
@@ -107,12 +119,47 @@ class CORE_EXPORT QgsPointLocator : public QObject
      * Prepare the index for queries. Does nothing if the index already exists.
      * If the number of features is greater than the value of maxFeaturesToIndex, creation of index is stopped
      * to make sure we do not run out of memory. If maxFeaturesToIndex is -1, no limits are used. Returns
-     * false if the creation of index has been prematurely stopped due to the limit of features, otherwise true */
-    bool init( int maxFeaturesToIndex = -1 );
+     * false if the creation of index has been prematurely stopped due to the limit of features, otherwise true.
+     *
+     * If \a relaxed is true, the index is built in a background thread and the method returns true
+     * immediately. Queries return matches of the features indexed so far until initFinished() is emitted.
+     * \see initFinished()
+     */
+    bool init( int maxFeaturesToIndex = -1, bool relaxed = false );
 
     //! Indicate whether the data have been already indexed
     bool hasIndex() const;
 
+    /**
+     * Returns true if the index is being built in a background thread.
+     * \see init()
+     * \since QGIS 3.0
+     */
+    bool isIndexing() const;
+
+    /**
+     * Blocks until the index being built in a background thread is complete.
+     * \see init()
+     * \since QGIS 3.0
+     */
+    void waitForIndexingFinished();
+
+    /**
+     * Sets whether only the vertices of indexed geometries are kept instead of copies of the whole geometries.
+     * Compact geometries need considerably less memory, as Z and M values and the structure of the geometries
+     * are dropped. Curved geometries are always kept whole. Changing the option destroys the index.
+     * \see compactGeometries()
+     * \since QGIS 3.0
+     */
+    void setCompactGeometries( bool compact );
+
+    /**
+     * Returns whether only the vertices of indexed geometries are kept. Defaults to false.
+     * \see setCompactGeometries()
+     * \since QGIS 3.0
+     */
+    bool compactGeometries() const { return mCompactGeometries; }
+
     struct Match
     {
         //! construct invalid match
@@ -246,7 +293,17 @@ class CORE_EXPORT QgsPointLocator : public QObject
      * Return how many geometries are cached in the index
      * \since QGIS 2.14
      */
-    int cachedGeometryCount() const { return mGeoms.count(); }
+    int cachedGeometryCount() const;
+
+  signals:
+
+    /**
+     * Emitted when the index built in a background thread is complete. \a ok is false
+     * if indexing has been stopped due to the limit of features passed to init().
+     * \see init()
+     * \since QGIS 3.0
+     */
+    void initFinished( bool ok );
 
   protected:
     bool rebuildIndex( int maxFeaturesToIndex = -1 );
@@ -256,22 +313,49 @@ class CORE_EXPORT QgsPointLocator : public QObject
     void onFeatureAdded( QgsFeatureId fid );
     void onFeatureDeleted( QgsFeatureId fid );
     void onGeometryChanged( QgsFeatureId fid, const QgsGeometry &geom );
+    void onIndexingFinished();
 
   private:
     //! Storage manager
     SpatialIndex::IStorageManager *mStorage = nullptr;
 
-    QHash<QgsFeatureId, QgsGeometry *> mGeoms;
+    QHash<QgsFeatureId, QgsPointLocator_Geometry *> mGeoms;
     SpatialIndex::ISpatialIndex *mRTree = nullptr;
 
     //! flag whether the layer is currently empty (i.e. mRTree is null but it is not necessary to rebuild it)
     bool mIsEmptyLayer;
 
+    //! whether only vertices of the geometries are kept
+    bool mCompactGeometries = false;
+
+    //! guards the tree and the geometries, which are filled by the background indexing task
+    mutable QMutex mMutex;
+
+    //! watches the background indexing task, its result is false if the limit of features was exceeded
+    QFutureWatcher<bool> mIndexingWatcher;
+
+    //! set to stop the background indexing task
+    QAtomicInt mCancelIndexing;
+
+    //! features updated by layer signals while indexing in background, their indexed version must not be replaced
+    QSet<QgsFeatureId> mUpdatedWhileIndexing;
+
     //! R-tree containing spatial index
     QgsCoordinateTransform mTransform;
     QgsVectorLayer *mLayer = nullptr;
     QgsRectangle *mExtent = nullptr;
 
+    //! Returns the request for the features to index
+    QgsFeatureRequest indexRequest() const;
+    //! Builds the index from features of \a source, inserting them into the tree in batches
+    bool buildIndexInBackground( QgsAbstractFeatureSource *source, const QgsFeatureRequest &request, int maxFeaturesToIndex, bool compact );
+    //! Stops the background indexing task and waits until it is finished
+    void cancelIndexing();
+    //! Deletes the tree and the geometries, must be called with the mutex locked
+    void clearIndex();
+    //! Inserts a geometry into the tree, replacing an existing geometry of the feature. Must be called with the mutex locked
+    void insertGeometry( QgsFeatureId fid, QgsPointLocator_Geometry *geometry );
+
     friend class QgsPointLocator_VisitorNearestVertex;
     friend class QgsPointLocator_VisitorNearestEdge;
     friend class QgsPointLocator_VisitorArea;
@@ -373,6 +373,7 @@ bool QgsProperty::prepare( const QgsExpressionContext &context ) const
         return false;
       }
 
+      d->expression.compile();
       d->expressionPrepared = true;
       d->expressionReferencedCols = d->expression.referencedColumns();
       return true;
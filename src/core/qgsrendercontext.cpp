@@ -53,6 +53,7 @@ QgsRenderContext::QgsRenderContext( const QgsRenderContext &rh )
   , mExpressionContext( rh.mExpressionContext )
   , mGeometry( rh.mGeometry )
   , mFeatureFilterProvider( rh.mFeatureFilterProvider ? rh.mFeatureFilterProvider->clone() : nullptr )
+  , mProfiler( rh.mProfiler )
   , mSegmentationTolerance( rh.mSegmentationTolerance )
   , mSegmentationToleranceType( rh.mSegmentationToleranceType )
 {
@@ -74,6 +75,7 @@ QgsRenderContext &QgsRenderContext::operator=( const QgsRenderContext &rh )
   mExpressionContext = rh.mExpressionContext;
   mGeometry = rh.mGeometry;
   mFeatureFilterProvider.reset( rh.mFeatureFilterProvider ? rh.mFeatureFilterProvider->clone() : nullptr );
+  mProfiler = rh.mProfiler;
   mSegmentationTolerance = rh.mSegmentationTolerance;
   mSegmentationToleranceType = rh.mSegmentationToleranceType;
   mDistanceArea = rh.mDistanceArea;
@@ -37,6 +37,7 @@ class QPainter;
 class QgsAbstractGeometry;
 class QgsLabelingEngine;
 class QgsMapSettings;
+class QgsRuntimeProfiler;
 
 
 /**
@@ -298,6 +299,26 @@ class CORE_EXPORT QgsRenderContext
      */
     const QgsFeatureFilterProvider *featureFilterProvider() const;
 
+    /**
+     * Sets the \a profiler which collects the times spent in the phases of rendering
+     * (e.g. fetching, transforming and drawing features). The profiler is not owned by the
+     * context and must exist as long as the context is used for rendering. Set it to nullptr
+     * (the default) to disable profiling.
+     * \see profiler()
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void setProfiler( QgsRuntimeProfiler *profiler ) { mProfiler = profiler; } SIP_SKIP
+
+    /**
+     * Returns the profiler which collects the times spent in the phases of rendering,
+     * or nullptr if rendering is not profiled.
+     * \see setProfiler()
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QgsRuntimeProfiler *profiler() const { return mProfiler; } SIP_SKIP
+
     /**
      * Sets the segmentation tolerance applied when rendering curved geometries
     \param tolerance the segmentation tolerance*/
@@ -393,6 +414,9 @@ class CORE_EXPORT QgsRenderContext
     //! The feature filter provider
     std::unique_ptr< QgsFeatureFilterProvider > mFeatureFilterProvider;
 
+    //! Profiler for the phases of rendering (not owned, can be nullptr)
+    QgsRuntimeProfiler *mProfiler = nullptr;
+
     double mSegmentationTolerance = M_PI_2 / 90;
 
     QgsAbstractGeometry::SegmentationToleranceType mSegmentationToleranceType = QgsAbstractGeometry::MaximumAngle;
@@ -303,6 +303,7 @@ void QgsRuleBasedLabeling::Rule::prepare( const QgsRenderContext &context, QSet<
   {
     attributeNames.unite( mFilter->referencedColumns() );
     mFilter->prepare( &context.expressionContext() );
+    mFilter->compile();
   }
 
   // call recursively
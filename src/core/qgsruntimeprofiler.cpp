@@ -1,6 +1,9 @@
 #include "qgsruntimeprofiler.h"
 #include "qgslogger.h"
 
+#include <QJsonDocument>
+#include <QJsonObject>
+
 void QgsRuntimeProfiler::beginGroup( const QString &name )
 {
   mGroupStack.push( name );
@@ -40,9 +43,88 @@ void QgsRuntimeProfiler::end()
   QgsDebugMsg( QStringLiteral( "PROFILE: %1 - %2" ).arg( name ).arg( timing ) );
 }
 
+void QgsRuntimeProfiler::addTime( const QString &name, double time )
+{
+  const QString fullName = mGroupPrefix.isEmpty() ? name : mGroupPrefix + name;
+  QHash<QString, int>::const_iterator it = mAccumulatedTimes.constFind( fullName );
+  if ( it != mAccumulatedTimes.constEnd() )
+  {
+    mProfileTimes[ it.value() ].second += time;
+  }
+  else
+  {
+    mAccumulatedTimes.insert( fullName, mProfileTimes.count() );
+    mProfileTimes.append( QPair<QString, double>( fullName, time ) );
+  }
+}
+
+void QgsRuntimeProfiler::addCount( const QString &name, qint64 value )
+{
+  mCounts[ mGroupPrefix.isEmpty() ? name : mGroupPrefix + name ] += value;
+}
+
+double QgsRuntimeProfiler::profileTime( const QString &name ) const
+{
+  double total = 0;
+  QList<QPair<QString, double> >::const_iterator it = mProfileTimes.constBegin();
+  for ( ; it != mProfileTimes.constEnd(); ++it )
+  {
+    if ( ( *it ).first == name )
+      total += ( *it ).second;
+  }
+  return total;
+}
+
+qint64 QgsRuntimeProfiler::count( const QString &name ) const
+{
+  return mCounts.value( name );
+}
+
+void QgsRuntimeProfiler::merge( const QgsRuntimeProfiler &other )
+{
+  QList<QPair<QString, double> >::const_iterator it = other.mProfileTimes.constBegin();
+  for ( ; it != other.mProfileTimes.constEnd(); ++it )
+  {
+    if ( other.mAccumulatedTimes.contains( ( *it ).first ) )
+      addTime( ( *it ).first, ( *it ).second );
+    else
+      mProfileTimes.append( QPair<QString, double>( mGroupPrefix + ( *it ).first, ( *it ).second ) );
+  }
+
+  QMap<QString, qint64>::const_iterator countIt = other.mCounts.constBegin();
+  for ( ; countIt != other.mCounts.constEnd(); ++countIt )
+  {
+    addCount( countIt.key(), countIt.value() );
+  }
+}
+
+QString QgsRuntimeProfiler::toJson() const
+{
+  QJsonObject times;
+  QList<QPair<QString, double> >::const_iterator it = mProfileTimes.constBegin();
+  for ( ; it != mProfileTimes.constEnd(); ++it )
+  {
+    times.insert( ( *it ).first, times.value( ( *it ).first ).toDouble() + ( *it ).second );
+  }
+
+  QJsonObject counts;
+  QMap<QString, qint64>::const_iterator countIt = mCounts.constBegin();
+  for ( ; countIt != mCounts.constEnd(); ++countIt )
+  {
+    counts.insert( countIt.key(), static_cast< double >( countIt.value() ) );
+  }
+
+  QJsonObject profile;
+  profile.insert( QStringLiteral( "times" ), times );
+  profile.insert( QStringLiteral( "counts" ), counts );
+  return QString::fromUtf8( QJsonDocument( profile ).toJson( QJsonDocument::Compact ) );
+}
+
 void QgsRuntimeProfiler::clear()
 {
   mProfileTimes.clear();
+  mAccumulatedTimes.clear();
+  mCounts.clear();
 }
 
 double QgsRuntimeProfiler::totalTime()
@@ -2,7 +2,10 @@
 #define QGSRUNTIMEPROFILER_H
 
 #include <QTime>
+#include <QElapsedTimer>
 #include "qgis_sip.h"
+#include <QHash>
+#include <QMap>
 #include <QPair>
 #include <QStack>
 
@@ -11,6 +14,14 @@
 /**
  * \ingroup core
  * \class QgsRuntimeProfiler
+ *
+ * Collects the times (in seconds) of named profile events and counters. Names are
+ * prefixed by the active groups, e.g. "Group/Name".
+ *
+ * Besides events timed with start() and end(), time can be accumulated with addTime(),
+ * e.g. for phases which are repeated for each rendered feature, and values can be counted
+ * with addCount(). The class is not thread-safe: threads should collect into their own
+ * profilers, which can be combined later with merge().
  */
 class CORE_EXPORT QgsRuntimeProfiler
 {
@@ -52,6 +63,59 @@ class CORE_EXPORT QgsRuntimeProfiler
      */
     const QList<QPair<QString, double > > profileTimes() const { return mProfileTimes; } SIP_SKIP
 
+    /**
+     * \brief Adds \a time (in seconds) to the profile event with the given \a name.
+     * Unlike events timed with start() and end(), repeated calls with the same name
+     * are summed up into a single profile event.
+     * \param name The name of the profile event. Will have the name of the active group prepended.
+     * \param time The time to add, in seconds.
+     * \since QGIS 3.0
+     */
+    void addTime( const QString &name, double time );
+
+    /**
+     * \brief Adds \a value to the counter with the given \a name.
+     * \param name The name of the counter. Will have the name of the active group prepended.
+     * \param value The value to add.
+     * \since QGIS 3.0
+     */
+    void addCount( const QString &name, qint64 value = 1 );
+
+    /**
+     * \brief Returns the total time (in seconds) of the profile events with the given full \a name
+     * (including groups), or 0 if there is no such event.
+     * \since QGIS 3.0
+     */
+    double profileTime( const QString &name ) const;
+
+    /**
+     * \brief Returns the value of the counter with the given full \a name (including groups),
+     * or 0 if there is no such counter.
+     * \since QGIS 3.0
+     */
+    qint64 count( const QString &name ) const;
+
+    /**
+     * \brief Returns all counters, by full name.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QMap<QString, qint64> counts() const { return mCounts; } SIP_SKIP
+
+    /**
+     * \brief Adds all profile times and counters of \a other to this profiler, within the
+     * active group. Accumulated times with equal names are summed up.
+     * \since QGIS 3.0
+     */
+    void merge( const QgsRuntimeProfiler &other );
+
+    /**
+     * \brief Returns the profile times (in seconds) and the counters as JSON, in the form
+     * {"times": {"name": time, ...}, "counts": {"name": value, ...}}.
+     * \since QGIS 3.0
+     */
+    QString toJson() const;
+
     /**
      * \brief clear Clear all profile data.
      */
@@ -69,6 +133,53 @@ class CORE_EXPORT QgsRuntimeProfiler
     QTime mProfileTime;
     QString mCurrentName;
     QList<QPair<QString, double > > mProfileTimes;
+    //! Indexes of the accumulated events in mProfileTimes, by full name
+    QHash<QString, int> mAccumulatedTimes;
+    QMap<QString, qint64> mCounts;
 };
 
+#ifndef SIP_RUN
+
+/**
+ * \ingroup core
+ * \class QgsScopedRuntimeProfile
+ * Adds the time elapsed during its lifetime to the profile event with the given name
+ * of a QgsRuntimeProfiler (see QgsRuntimeProfiler::addTime()). Does nothing if the
+ * profiler is nullptr, so that it can be used in code which is only profiled on demand.
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsScopedRuntimeProfile
+{
+  public:
+
+    /**
+     * Starts timing the profile event with the given \a name of the \a profiler.
+     */
+    QgsScopedRuntimeProfile( QgsRuntimeProfiler *profiler, const QString &name )
+      : mProfiler( profiler )
+    {
+      if ( mProfiler )
+      {
+        mName = name;
+        mTimer.start();
+      }
+    }
+
+    ~QgsScopedRuntimeProfile()
+    {
+      if ( mProfiler )
+        mProfiler->addTime( mName, mTimer.nsecsElapsed() / 1.0e9 );
+    }
+
+  private:
+    QgsRuntimeProfiler *mProfiler = nullptr;
+    QString mName;
+    QElapsedTimer mTimer;
+
+    Q_DISABLE_COPY( QgsScopedRuntimeProfile )
+};
+
+#endif
+
 #endif // QGSRUNTIMEPROFILER_H
@@ -40,6 +40,13 @@ QgsPointLocator *QgsSnappingUtils::locatorForLayer( QgsVectorLayer *vl )
   if ( !mLocators.contains( vl ) )
   {
     QgsPointLocator *vlpl = new QgsPointLocator( vl, destinationCrs() );
+    const QString layerId = vl->id();
+    connect( vlpl, &QgsPointLocator::initFinished, this, [this, layerId]( bool ok )
+    {
+      // the limit of features was exceeded by indexing in background, see prepareIndex()
+      if ( !ok && mHybridMaxAreaPerLayer.value( layerId, -1 ) > 0 )
+        mHybridMaxAreaPerLayer[layerId] /= 4;
+    } );
     mLocators.insert( vl, vlpl );
   }
   return mLocators.value( vl );
@@ -346,7 +353,9 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
     QTime t;
     t.start();
     int i = 0;
-    prepareIndexStarting( layersToIndex.count() );
+    // indexing in background does not block, there is no progress to report
+    if ( !mIndexingInBackground )
+      prepareIndexStarting( layersToIndex.count() );
     Q_FOREACH ( const LayerAndAreaOfInterest &entry, layersToIndex )
     {
       QgsVectorLayer *vl = entry.first;
@@ -357,7 +366,7 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
       {
         QgsRectangle rect( mMapSettings.extent() );
         loc->setExtent( &rect );
-        loc->init();
+        loc->init( -1, mIndexingInBackground );
       }
       else if ( mStrategy == IndexHybrid )
       {
@@ -384,7 +393,7 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
         if ( indexReasonableArea == -1 )
         {
           // we can safely index the whole layer
-          loc->init();
+          loc->init( -1, mIndexingInBackground );
         }
         else
         {
@@ -396,7 +405,8 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
           loc->setExtent( &rect );
 
           // see if it's possible build index for this area
-          if ( !loc->init( mHybridPerLayerFeatureLimit ) )
+          // (in background the result is only known when the locator has finished indexing)
+          if ( !loc->init( mHybridPerLayerFeatureLimit, mIndexingInBackground ) )
           {
             // hmm that didn't work out - too many features!
             // let's make the allowed area smaller for the next time
@@ -406,10 +416,11 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
 
       }
       else  // full index strategy
-        loc->init();
+        loc->init( -1, mIndexingInBackground );
 
       QgsDebugMsg( QString( "Index init: %1 ms (%2)" ).arg( tt.elapsed() ).arg( vl->id() ) );
-      prepareIndexProgress( ++i );
+      if ( !mIndexingInBackground )
+        prepareIndexProgress( ++i );
     }
     QgsDebugMsg( QString( "Prepare index total: %1 ms" ).arg( t.elapsed() ) );
   }
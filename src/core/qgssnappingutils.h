@@ -92,6 +92,21 @@ class CORE_EXPORT QgsSnappingUtils : public QObject
     //! Find out which strategy is used for indexing - by default hybrid indexing is used
     IndexingStrategy indexingStrategy() const { return mStrategy; }
 
+    /**
+     * Sets whether the indexes of layers are built in background threads. Snapping then uses the
+     * features indexed so far instead of blocking until whole layers are indexed.
+     * \see indexingInBackground()
+     * \since QGIS 3.0
+     */
+    void setIndexingInBackground( bool enabled ) { mIndexingInBackground = enabled; }
+
+    /**
+     * Returns whether the indexes of layers are built in background threads. Defaults to false.
+     * \see setIndexingInBackground()
+     * \since QGIS 3.0
+     */
+    bool indexingInBackground() const { return mIndexingInBackground; }
+
     /**
      * Configures how a certain layer should be handled in a snapping operation
      */
@@ -238,6 +253,9 @@ class CORE_EXPORT QgsSnappingUtils : public QObject
 
     //! internal flag that an indexing process is going on. Prevents starting two processes in parallel.
     bool mIsIndexing = false;
+
+    //! whether indexes are built in background threads
+    bool mIndexingInBackground = false;
 };
 
 
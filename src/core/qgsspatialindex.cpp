@@ -22,6 +22,7 @@
 #include "qgslogger.h"
 #include "qgsfeaturesource.h"
 #include "qgsfeedback.h"
+#include "qgsstaticspatialindex.h"
 
 #include "SpatialIndex.h"
 
@@ -152,6 +153,54 @@ class QgsFeatureIteratorDataStream : public IDataStream
 };
 
 
+/**
+ * \ingroup core
+ * \class QgsStaticSpatialIndexDataStream
+ * \brief Utility class for bulk loading of R-trees from the items of a static index. Not a part of public API.
+ * \note not available in Python bindings
+*/
+class QgsStaticSpatialIndexDataStream : public IDataStream
+{
+  public:
+    explicit QgsStaticSpatialIndexDataStream( const QgsStaticSpatialIndex &index )
+    {
+      mIds.reserve( index.count() );
+      mBounds.reserve( index.count() );
+      index.visitItems( [this]( QgsFeatureId id, const QgsRectangle & bounds )
+      {
+        mIds << id;
+        mBounds << bounds;
+        return true;
+      } );
+    }
+
+    //! returns a pointer to the next entry in the stream or 0 at the end of the stream.
+    IData *getNext() override
+    {
+      if ( mNext >= mIds.count() )
+        return nullptr;
+
+      RTree::Data *data = new RTree::Data( 0, nullptr, QgsSpatialIndex::rectToRegion( mBounds.at( mNext ) ), mIds.at( mNext ) );
+      ++mNext;
+      return data;
+    }
+
+    //! returns true if there are more items in the stream.
+    bool hasNext() override { return mNext < mIds.count(); }
+
+    //! returns the total number of entries available in the stream.
+    uint32_t size() override { return static_cast< uint32_t >( mIds.count() ); }
+
+    //! sets the stream pointer to the first entry, if possible.
+    void rewind() override { mNext = 0; }
+
+  private:
+    QVector< QgsFeatureId > mIds;
+    QVector< QgsRectangle > mBounds;
+    int mNext = 0;
+};
+
+
 /**
  * \ingroup core
  *  \class QgsSpatialIndexData
@@ -180,6 +229,19 @@ class QgsSpatialIndexData : public QSharedData
       initTree( &fids );
     }
 
+    //! Constructor for QgsSpatialIndexData which bulk loads the items of a static \a index
+    explicit QgsSpatialIndexData( const QgsStaticSpatialIndex &index )
+    {
+      if ( index.isEmpty() )
+      {
+        initTree();
+        return;
+      }
+
+      QgsStaticSpatialIndexDataStream stream( index );
+      initTree( &stream );
+    }
+
     QgsSpatialIndexData( const QgsSpatialIndexData &other )
       : QSharedData( other )
     {
@@ -250,6 +312,11 @@ QgsSpatialIndex::QgsSpatialIndex( const QgsFeatureSource &source, QgsFeedback *f
   d = new QgsSpatialIndexData( source.getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) ), feedback );
 }
 
+QgsSpatialIndex::QgsSpatialIndex( const QgsStaticSpatialIndex &index )
+{
+  d = new QgsSpatialIndexData( index );
+}
+
 QgsSpatialIndex::QgsSpatialIndex( const QgsSpatialIndex &other ) //NOLINT
   : d( other.d )
 {
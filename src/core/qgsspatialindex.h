@@ -48,6 +48,7 @@ class QgsPointXY;
 class QgsSpatialIndexData;
 class QgsFeatureIterator;
 class QgsFeatureSource;
+class QgsStaticSpatialIndex;
 
 /**
  * \ingroup core
@@ -88,6 +89,15 @@ class CORE_EXPORT QgsSpatialIndex
      */
     explicit QgsSpatialIndex( const QgsFeatureSource &source, QgsFeedback *feedback = nullptr );
 
+    /**
+     * Constructor - creates R-tree and bulk loads it with the items of a static \a index, without reading
+     * any features. Together with QgsSpatialIndexFileCache, this allows creating an index of a layer
+     * from an index file written by a previous session.
+     *
+     * \since QGIS 3.0
+     */
+    explicit QgsSpatialIndex( const QgsStaticSpatialIndex &index );
+
     //! Copy constructor
     QgsSpatialIndex( const QgsSpatialIndex &other );
 
@@ -152,6 +162,7 @@ class CORE_EXPORT QgsSpatialIndex
     static bool featureInfo( const QgsFeature &f, QgsRectangle &rect, QgsFeatureId &id );
 
     friend class QgsFeatureIteratorDataStream; // for access to featureInfo()
+    friend class QgsStaticSpatialIndexDataStream; // for access to rectToRegion()
 
   private:
 
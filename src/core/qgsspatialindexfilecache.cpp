@@ -0,0 +1,183 @@
+/***************************************************************************
+  qgsspatialindexfilecache.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsspatialindexfilecache.h"
+#include "qgsapplication.h"
+#include "qgsdatasourceuri.h"
+#include "qgsfeedback.h"
+#include "qgslogger.h"
+#include "qgssettings.h"
+#include "qgsvectorlayer.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QUrl>
+
+///@cond PRIVATE
+
+//! Returns the path of the local file a layer is read from, or an empty string
+static QString layerFilePath( const QgsVectorLayer *layer )
+{
+  const QString source = layer->source();
+  QString path;
+  if ( source.startsWith( QLatin1String( "file:" ) ) )
+    path = QUrl( source ).toLocalFile();
+  else if ( layer->providerType() == QLatin1String( "spatialite" ) )
+    path = QgsDataSourceUri( source ).database();
+  else
+    path = source.section( '|', 0, 0 );
+
+  return QFileInfo( path ).isFile() ? path : QString();
+}
+
+/**
+ * Returns the paths of the files besides \a filePath which are read with it, e.g. the attributes
+ * of a shapefile. Filters of the layer may depend on their content.
+ */
+static QStringList sidecarFilePaths( const QString &filePath )
+{
+  QStringList paths;
+  const QFileInfo fileInfo( filePath );
+  if ( fileInfo.suffix().compare( QLatin1String( "shp" ), Qt::CaseInsensitive ) != 0 )
+    return paths;
+
+  const QString basePath = fileInfo.dir().filePath( fileInfo.completeBaseName() );
+  for ( const QString &suffix : QStringList() << QStringLiteral( "shx" ) << QStringLiteral( "dbf" ) << QStringLiteral( "cpg" ) )
+  {
+    paths << basePath + '.' + suffix << basePath + '.' + suffix.toUpper();
+  }
+  return paths;
+}
+
+//! Returns true if SQLite may read changes of \a filePath from a write-ahead log or a hot journal
+static bool hasPendingChanges( const QString &filePath )
+{
+  return QFileInfo( filePath + QStringLiteral( "-wal" ) ).size() > 0
+         || QFileInfo( filePath + QStringLiteral( "-journal" ) ).size() > 0;
+}
+
+static const QString INDEX_FILE_SUFFIX = QStringLiteral( ".rtree" );
+
+///@endcond
+
+bool QgsSpatialIndexFileCache::isEnabled()
+{
+  return QgsSettings().value( QStringLiteral( "cache/spatialIndexEnabled" ), false ).toBool();
+}
+
+void QgsSpatialIndexFileCache::setEnabled( bool enabled )
+{
+  QgsSettings().setValue( QStringLiteral( "cache/spatialIndexEnabled" ), enabled );
+}
+
+QString QgsSpatialIndexFileCache::cacheDirectory()
+{
+  const QString directory = QgsSettings().value( QStringLiteral( "cache/spatialIndexDirectory" ) ).toString();
+  if ( directory.isEmpty() )
+    return QgsApplication::qgisSettingsDirPath() + QStringLiteral( "spatialindex" );
+  return directory;
+}
+
+void QgsSpatialIndexFileCache::setCacheDirectory( const QString &directory )
+{
+  QgsSettings().setValue( QStringLiteral( "cache/spatialIndexDirectory" ), directory );
+}
+
+QString QgsSpatialIndexFileCache::indexFilePath( const QgsVectorLayer *layer )
+{
+  if ( !layer || !layer->isValid() || layer->isModified() )
+    return QString();
+
+  const QString filePath = layerFilePath( layer );
+  if ( filePath.isEmpty() )
+    return QString();
+
+  // the content of the main file does not reflect changes which are not checkpointed yet
+  if ( hasPendingChanges( filePath ) )
+    return QString();
+
+  // the source is hashed into the file name, the state of the files is appended so that stale
+  // indexes of the same source can be found and removed
+  const QString sourceKey = layer->providerType() + '\n' + layer->source() + '\n' + layer->subsetString();
+  const QString sourceHash = QString::fromLatin1( QCryptographicHash::hash( sourceKey.toUtf8(), QCryptographicHash::Sha1 ).toHex() );
+  QString stateKey;
+  for ( const QString &path : QStringList() << filePath << sidecarFilePaths( filePath ) )
+  {
+    const QFileInfo fileInfo( path );
+    if ( fileInfo.exists() )
+      stateKey += QStringLiteral( "%1:%2:%3\n" ).arg( fileInfo.fileName() ).arg( fileInfo.size() ).arg( fileInfo.lastModified().toMSecsSinceEpoch() );
+  }
+  const QString stateHash = QString::fromLatin1( QCryptographicHash::hash( stateKey.toUtf8(), QCryptographicHash::Sha1 ).toHex() );
+  const QString fileName = QStringLiteral( "%1_%2%3" ).arg( sourceHash, stateHash, INDEX_FILE_SUFFIX );
+  return QDir( cacheDirectory() ).filePath( fileName );
+}
+
+QgsStaticSpatialIndex QgsSpatialIndexFileCache::staticIndex( QgsVectorLayer *layer, QgsFeedback *feedback )
+{
+  if ( !layer )
+    return QgsStaticSpatialIndex();
+
+  const QString path = isEnabled() ? indexFilePath( layer ) : QString();
+  if ( !path.isEmpty() )
+  {
+    QgsStaticSpatialIndex index;
+    if ( index.readFromFile( path ) )
+      return index;
+  }
+
+  QgsStaticSpatialIndex index( *layer, feedback );
+  if ( path.isEmpty() || !index.isValid() || ( feedback && feedback->isCanceled() ) )
+    return index;
+
+  const QFileInfo indexInfo( path );
+  QDir directory = indexInfo.dir();
+  if ( !directory.mkpath( QStringLiteral( "." ) ) )
+    return index;
+
+  // remove indexes of previous states of the same source
+  const QString sourceHash = indexInfo.fileName().section( '_', 0, 0 );
+  const QStringList staleFiles = directory.entryList( QStringList() << sourceHash + QStringLiteral( "_*" ) + INDEX_FILE_SUFFIX, QDir::Files );
+  for ( const QString &staleFile : staleFiles )
+  {
+    directory.remove( staleFile );
+  }
+
+  if ( !index.writeToFile( path ) )
+    QgsDebugMsg( QString( "Could not write spatial index file %1" ).arg( path ) );
+
+  return index;
+}
+
+QgsSpatialIndex QgsSpatialIndexFileCache::spatialIndex( QgsVectorLayer *layer, QgsFeedback *feedback )
+{
+  const QgsStaticSpatialIndex index = staticIndex( layer, feedback );
+  if ( !index.isValid() )
+  {
+    // too many features for a static index, read them again into a dynamic one
+    return layer ? QgsSpatialIndex( *layer, feedback ) : QgsSpatialIndex();
+  }
+  return QgsSpatialIndex( index );
+}
+
+void QgsSpatialIndexFileCache::clear()
+{
+  QDir directory( cacheDirectory() );
+  const QStringList files = directory.entryList( QStringList() << QStringLiteral( "*" ) + INDEX_FILE_SUFFIX, QDir::Files );
+  for ( const QString &file : files )
+  {
+    directory.remove( file );
+  }
+}
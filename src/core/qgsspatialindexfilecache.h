@@ -0,0 +1,109 @@
+/***************************************************************************
+  qgsspatialindexfilecache.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSPATIALINDEXFILECACHE_H
+#define QGSSPATIALINDEXFILECACHE_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgsspatialindex.h"
+#include "qgsstaticspatialindex.h"
+
+#include <QString>
+
+class QgsFeedback;
+class QgsVectorLayer;
+
+/**
+ * \ingroup core
+ * \class QgsSpatialIndexFileCache
+ * \brief Persists the spatial indexes of layers read from local files, so that they do not need
+ * to be rebuilt by scanning all features of the layer each time an index is needed.
+ *
+ * Index files are stored in cacheDirectory() as static indexes (see QgsStaticSpatialIndex), which
+ * are memory mapped when they are loaded. A file is keyed by the provider, the data source URI
+ * and the subset string of the layer, together with the size and the modification time of
+ * the layer's file. Changing the file therefore invalidates its index, and the stale index file
+ * is replaced when a new one is written.
+ *
+ * Layers which are not read from a local file (e.g. database layers) and layers with
+ * uncommitted edits are always indexed by reading their features.
+ *
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsSpatialIndexFileCache
+{
+  public:
+
+    /**
+     * Returns true if spatial indexes are persisted. Defaults to false, as the cache directory
+     * is not limited in size and index files are only removed when a new index of the same
+     * source is written or clear() is called.
+     * \see setEnabled()
+     */
+    static bool isEnabled();
+
+    /**
+     * Sets whether spatial indexes are persisted.
+     * \see isEnabled()
+     */
+    static void setEnabled( bool enabled );
+
+    /**
+     * Returns the directory the index files are stored in.
+     * \see setCacheDirectory()
+     */
+    static QString cacheDirectory();
+
+    /**
+     * Sets the \a directory the index files are stored in. An empty directory restores
+     * the default location in the user's profile.
+     * \see cacheDirectory()
+     */
+    static void setCacheDirectory( const QString &directory );
+
+    /**
+     * Returns the path of the index file for the current state of \a layer, or an empty string if the
+     * index of the layer cannot be persisted. The file may not exist yet.
+     * The path depends on the size and modification time of the layer's file and the files read
+     * with it (e.g. the attributes of a shapefile). Indexes of SQLite databases with changes in a
+     * write-ahead log or a journal are not persisted.
+     */
+    static QString indexFilePath( const QgsVectorLayer *layer );
+
+    /**
+     * Returns a static spatial index of the features of \a layer. The index is loaded from its index file
+     * if there is one for the current state of the layer, otherwise it is built from the layer's features
+     * and written to the cache.
+     *
+     * The optional \a feedback object can be used to allow cancelation of feature loading. Ownership
+     * of \a feedback is not transferred. Indexes of canceled loads are not written to the cache.
+     *
+     * The returned index must be checked with QgsStaticSpatialIndex::isValid(), as layers with too many
+     * features cannot be indexed.
+     */
+    static QgsStaticSpatialIndex staticIndex( QgsVectorLayer *layer, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Returns a spatial index of the features of \a layer, which can be modified afterwards. It is bulk
+     * loaded from the static index returned by staticIndex(), or from the layer's features if the layer
+     * has too many features for a static index.
+     */
+    static QgsSpatialIndex spatialIndex( QgsVectorLayer *layer, QgsFeedback *feedback = nullptr );
+
+    //! Removes all index files from the cache directory
+    static void clear();
+};
+
+#endif // QGSSPATIALINDEXFILECACHE_H
@@ -0,0 +1,710 @@
+/***************************************************************************
+  qgsstaticspatialindex.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsstaticspatialindex.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeaturesource.h"
+#include "qgsfeedback.h"
+#include "qgsgeometry.h"
+#include "qgsmessagelog.h"
+#include "qgspointxy.h"
+#include "qgssimd_p.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+
+///@cond PRIVATE
+
+namespace
+{
+  const char INDEX_MAGIC[8] = { 'Q', 'G', 'S', 'R', 'T', 'R', 'E', 'E' };
+  const quint32 INDEX_VERSION = 1;
+  //! Written in native byte order, indexes from machines with another byte order are rejected
+  const quint32 BYTE_ORDER_MARK = 0x01020304;
+
+  //! Number of children of each node of indexes built from features
+  const int DEFAULT_NODE_SIZE = 16;
+
+  //! Number of items above which the Hilbert values are computed and sorted in parallel
+  const int PARALLEL_BUILD_THRESHOLD = 100000;
+
+  /**
+   * Layout of the start of the index buffer. It is followed by the end of each level (numLevels
+   * quint64 values), the boxes of all nodes (4 doubles per node: xmin, ymin, xmax, ymax) and
+   * the index of each node (a qint64 per node). Leaves come first and store a feature ID,
+   * other nodes store the position of their first child. The root is the last node.
+   */
+  struct IndexHeader
+  {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 nodeSize;
+    quint32 numLevels;
+    quint64 numItems;
+    quint64 numNodes;
+    double extent[4];
+  };
+
+  static_assert( sizeof( IndexHeader ) == 72, "Index header must not contain padding" );
+
+  //! Read-only view on the arrays of an index buffer
+  struct IndexView
+  {
+    explicit IndexView( const QByteArray &data )
+    {
+      if ( data.size() < static_cast< int >( sizeof( IndexHeader ) ) )
+        return;
+
+      header = reinterpret_cast< const IndexHeader * >( data.constData() );
+      levelBounds = reinterpret_cast< const quint64 * >( data.constData() + sizeof( IndexHeader ) );
+      boxes = reinterpret_cast< const double * >( levelBounds + header->numLevels );
+      indices = reinterpret_cast< const qint64 * >( boxes + 4 * header->numNodes );
+    }
+
+    bool isEmpty() const { return !header || header->numItems == 0; }
+
+    //! Returns the end of the level containing the node at \a pos
+    quint64 upperBound( quint64 pos ) const
+    {
+      return *std::upper_bound( levelBounds, levelBounds + header->numLevels, pos );
+    }
+
+    const IndexHeader *header = nullptr;
+    const quint64 *levelBounds = nullptr;
+    const double *boxes = nullptr;
+    const qint64 *indices = nullptr;
+  };
+
+  qint64 indexDataSize( quint64 numLevels, quint64 numNodes )
+  {
+    return sizeof( IndexHeader ) + numLevels * sizeof( quint64 ) + numNodes * ( 4 * sizeof( double ) + sizeof( qint64 ) );
+  }
+
+  /**
+   * Returns the position of ( \a x, \a y ) along a Hilbert curve filling a 65536 x 65536 grid.
+   * Based on "Fast Hilbert curve generation, sorting, and range queries" by Rawrunprotected.
+   */
+  quint32 hilbertValue( quint32 x, quint32 y )
+  {
+    quint32 a = x ^ y;
+    quint32 b = 0xFFFF ^ a;
+    quint32 c = 0xFFFF ^ ( x | y );
+    quint32 d = x & ( y ^ 0xFFFF );
+
+    quint32 A = a | ( b >> 1 );
+    quint32 B = ( a >> 1 ) ^ a;
+    quint32 C = ( ( c >> 1 ) ^ ( b & ( d >> 1 ) ) ) ^ c;
+    quint32 D = ( ( a & ( c >> 1 ) ) ^ ( d >> 1 ) ) ^ d;
+
+    a = A;
+    b = B;
+    c = C;
+    d = D;
+    A = ( ( a & ( a >> 2 ) ) ^ ( b & ( b >> 2 ) ) );
+    B = ( ( a & ( b >> 2 ) ) ^ ( b & ( ( a ^ b ) >> 2 ) ) );
+    C ^= ( ( a & ( c >> 2 ) ) ^ ( b & ( d >> 2 ) ) );
+    D ^= ( ( b & ( c >> 2 ) ) ^ ( ( a ^ b ) & ( d >> 2 ) ) );
+
+    a = A;
+    b = B;
+    c = C;
+    d = D;
+    A = ( ( a & ( a >> 4 ) ) ^ ( b & ( b >> 4 ) ) );
+    B = ( ( a & ( b >> 4 ) ) ^ ( b & ( ( a ^ b ) >> 4 ) ) );
+    C ^= ( ( a & ( c >> 4 ) ) ^ ( b & ( d >> 4 ) ) );
+    D ^= ( ( b & ( c >> 4 ) ) ^ ( ( a ^ b ) & ( d >> 4 ) ) );
+
+    a = A;
+    b = B;
+    c = C;
+    d = D;
+    C ^= ( ( a & ( c >> 8 ) ) ^ ( b & ( d >> 8 ) ) );
+    D ^= ( ( b & ( c >> 8 ) ) ^ ( ( a ^ b ) & ( d >> 8 ) ) );
+
+    a = C ^ ( C >> 1 );
+    b = D ^ ( D >> 1 );
+
+    quint32 i0 = x ^ y;
+    quint32 i1 = b | ( 0xFFFF ^ ( i0 | a ) );
+
+    i0 = ( i0 | ( i0 << 8 ) ) & 0x00FF00FF;
+    i0 = ( i0 | ( i0 << 4 ) ) & 0x0F0F0F0F;
+    i0 = ( i0 | ( i0 << 2 ) ) & 0x33333333;
+    i0 = ( i0 | ( i0 << 1 ) ) & 0x55555555;
+
+    i1 = ( i1 | ( i1 << 8 ) ) & 0x00FF00FF;
+    i1 = ( i1 | ( i1 << 4 ) ) & 0x0F0F0F0F;
+    i1 = ( i1 | ( i1 << 2 ) ) & 0x33333333;
+    i1 = ( i1 | ( i1 << 1 ) ) & 0x55555555;
+
+    return ( i1 << 1 ) | i0;
+  }
+
+  //! Item sorted along the Hilbert curve, the item index keeps the order stable
+  struct HilbertItem
+  {
+    quint32 hilbert;
+    int item;
+
+    bool operator<( const HilbertItem &other ) const
+    {
+      return hilbert < other.hilbert || ( hilbert == other.hilbert && item < other.item );
+    }
+  };
+
+  //! Range of items processed by one thread, merging ranges are sorted from begin to middle and from middle to end
+  struct HilbertBlock
+  {
+    int begin;
+    int middle;
+    int end;
+  };
+
+  //! Computes the Hilbert values of all items and sorts them, using all cores for large inputs
+  QVector< HilbertItem > sortItems( const QVector< QgsRectangle > &bounds, const QgsRectangle &extent )
+  {
+    const int count = bounds.count();
+    QVector< HilbertItem > items( count );
+
+    const double width = extent.width();
+    const double height = extent.height();
+    const double hilbertMax = 0xFFFF;
+    const double xScale = width > 0 ? hilbertMax / width : 0;
+    const double yScale = height > 0 ? hilbertMax / height : 0;
+    const double xMin = extent.xMinimum();
+    const double yMin = extent.yMinimum();
+
+    // the items are written from several threads, so the vector must not detach while doing so
+    HilbertItem *itemData = items.data();
+    auto sortBlock = [itemData, &bounds, xScale, yScale, xMin, yMin, hilbertMax]( const HilbertBlock & block )
+    {
+      for ( int i = block.begin; i < block.end; ++i )
+      {
+        const QgsRectangle &rect = bounds.at( i );
+        const double x = xScale * ( ( rect.xMinimum() + rect.xMaximum() ) / 2 - xMin );
+        const double y = yScale * ( ( rect.yMinimum() + rect.yMaximum() ) / 2 - yMin );
+        itemData[i].hilbert = hilbertValue( static_cast< quint32 >( qBound( 0.0, x, hilbertMax ) ), static_cast< quint32 >( qBound( 0.0, y, hilbertMax ) ) );
+        itemData[i].item = i;
+      }
+      std::sort( itemData + block.begin, itemData + block.end );
+    };
+
+    const int threads = std::max( 1, QThread::idealThreadCount() );
+    if ( count < PARALLEL_BUILD_THRESHOLD || threads == 1 )
+    {
+      sortBlock( HilbertBlock{ 0, 0, count } );
+      return items;
+    }
+
+    QVector< HilbertBlock > blocks;
+    const int blockSize = ( count + threads - 1 ) / threads;
+    for ( int begin = 0; begin < count; begin += blockSize )
+    {
+      blocks << HilbertBlock{ begin, begin, std::min( begin + blockSize, count ) };
+    }
+    QtConcurrent::blockingMap( blocks, sortBlock );
+
+    // merge the sorted blocks pairwise, until a single block is left
+    while ( blocks.count() > 1 )
+    {
+      QVector< HilbertBlock > merged;
+      for ( int i = 0; i + 1 < blocks.count(); i += 2 )
+      {
+        merged << HilbertBlock{ blocks.at( i ).begin, blocks.at( i + 1 ).begin, blocks.at( i + 1 ).end };
+      }
+      QtConcurrent::blockingMap( merged, [itemData]( const HilbertBlock & block )
+      {
+        std::inplace_merge( itemData + block.begin, itemData + block.middle, itemData + block.end );
+      } );
+
+      if ( blocks.count() % 2 )
+        merged << blocks.last();
+      blocks = merged;
+    }
+    return items;
+  }
+
+  //! Returns the squared distance between a point and a box, 0 if the point is inside the box
+  inline double boxDistanceSquared( double x, double y, const double *box )
+  {
+    const double dx = x < box[0] ? box[0] - x : ( x > box[2] ? x - box[2] : 0 );
+    const double dy = y < box[1] ? box[1] - y : ( y > box[3] ? y - box[3] : 0 );
+    return dx * dx + dy * dy;
+  }
+
+  //! Node or item waiting in the nearest neighbor queue
+  struct NeighborCandidate
+  {
+    double distance;
+    qint64 index;
+    bool isItem;
+
+    //! Orders the priority queue by increasing distance, items first so that they are returned as soon as possible
+    bool operator<( const NeighborCandidate &other ) const
+    {
+      return distance > other.distance || ( distance == other.distance && !isItem && other.isItem );
+    }
+  };
+}
+
+///@endcond
+
+QgsStaticSpatialIndex::QgsStaticSpatialIndex()
+{
+}
+
+QgsStaticSpatialIndex::QgsStaticSpatialIndex( const QgsFeatureIterator &fi, QgsFeedback *feedback )
+{
+  load( fi, feedback );
+}
+
+QgsStaticSpatialIndex::QgsStaticSpatialIndex( const QgsFeatureSource &source, QgsFeedback *feedback )
+{
+  load( source.getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) ), feedback );
+}
+
+QgsStaticSpatialIndex::QgsStaticSpatialIndex( const QList<QgsFeatureId> &ids, const QVector<QgsRectangle> &bounds, int nodeSize )
+{
+  build( ids, bounds, nodeSize );
+}
+
+void QgsStaticSpatialIndex::load( const QgsFeatureIterator &fi, QgsFeedback *feedback )
+{
+  QList< QgsFeatureId > ids;
+  QVector< QgsRectangle > bounds;
+
+  QgsFeatureIterator it = fi;
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return;
+
+    if ( !f.hasGeometry() )
+      continue;
+
+    ids << f.id();
+    bounds << f.geometry().boundingBox();
+  }
+
+  build( ids, bounds, DEFAULT_NODE_SIZE );
+}
+
+void QgsStaticSpatialIndex::build( const QList<QgsFeatureId> &ids, const QVector<QgsRectangle> &bounds, int nodeSize )
+{
+  Q_ASSERT( ids.count() == bounds.count() );
+  const quint64 numItems = static_cast< quint64 >( std::min( ids.count(), bounds.count() ) );
+  nodeSize = std::max( 2, nodeSize );
+
+  // number of nodes of each level, up to a single root
+  QVector< quint64 > levelBounds;
+  quint64 numNodes = numItems;
+  if ( numItems > 0 )
+  {
+    quint64 levelNodes = numItems;
+    levelBounds << numNodes;
+    do
+    {
+      levelNodes = ( levelNodes + nodeSize - 1 ) / nodeSize;
+      numNodes += levelNodes;
+      levelBounds << numNodes;
+    }
+    while ( levelNodes != 1 );
+  }
+
+  // the index is stored in a QByteArray, which is limited to 2 GB
+  const qint64 dataSize = indexDataSize( levelBounds.count(), numNodes );
+  if ( dataSize > std::numeric_limits< int >::max() )
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Cannot build a static spatial index of %1 items larger than 2 GB" ).arg( numItems ) );
+    mData.clear();
+    mMappedFile.reset();
+    mValid = false;
+    return;
+  }
+
+  QByteArray data( static_cast< int >( dataSize ), Qt::Uninitialized );
+  IndexHeader *header = reinterpret_cast< IndexHeader * >( data.data() );
+  std::memcpy( header->magic, INDEX_MAGIC, sizeof( INDEX_MAGIC ) );
+  header->version = INDEX_VERSION;
+  header->byteOrder = BYTE_ORDER_MARK;
+  header->nodeSize = static_cast< quint32 >( nodeSize );
+  header->numLevels = static_cast< quint32 >( levelBounds.count() );
+  header->numItems = numItems;
+  header->numNodes = numNodes;
+  std::fill( header->extent, header->extent + 4, 0.0 );
+
+  quint64 *dataLevelBounds = reinterpret_cast< quint64 * >( data.data() + sizeof( IndexHeader ) );
+  std::copy( levelBounds.constBegin(), levelBounds.constEnd(), dataLevelBounds );
+  double *boxes = reinterpret_cast< double * >( dataLevelBounds + levelBounds.count() );
+  qint64 *indices = reinterpret_cast< qint64 * >( boxes + 4 * numNodes );
+
+  if ( numItems == 0 )
+  {
+    mData = data;
+    mMappedFile.reset();
+    mValid = true;
+    return;
+  }
+
+  // not using QgsRectangle::combineExtentWith(), which treats a rectangle at the origin as null
+  double extentMin[2] = { std::numeric_limits< double >::max(), std::numeric_limits< double >::max() };
+  double extentMax[2] = { -std::numeric_limits< double >::max(), -std::numeric_limits< double >::max() };
+  for ( const QgsRectangle &rect : bounds )
+  {
+    extentMin[0] = std::min( extentMin[0], rect.xMinimum() );
+    extentMin[1] = std::min( extentMin[1], rect.yMinimum() );
+    extentMax[0] = std::max( extentMax[0], rect.xMaximum() );
+    extentMax[1] = std::max( extentMax[1], rect.yMaximum() );
+  }
+  const QgsRectangle extent( extentMin[0], extentMin[1], extentMax[0], extentMax[1] );
+
+  // leaves, in the order of their position along the Hilbert curve
+  const QVector< HilbertItem > sorted = sortItems( bounds, extent );
+  for ( quint64 pos = 0; pos < numItems; ++pos )
+  {
+    const int item = sorted.at( pos ).item;
+    const QgsRectangle &rect = bounds.at( item );
+    double *box = boxes + 4 * pos;
+    box[0] = rect.xMinimum();
+    box[1] = rect.yMinimum();
+    box[2] = rect.xMaximum();
+    box[3] = rect.yMaximum();
+    indices[pos] = ids.at( item );
+  }
+
+  // each upper level groups nodeSize consecutive nodes of the level below
+  quint64 pos = 0;
+  quint64 parent = numItems;
+  for ( int level = 0; level < levelBounds.count() - 1; ++level )
+  {
+    const quint64 end = levelBounds.at( level );
+    while ( pos < end )
+    {
+      const quint64 firstChild = pos;
+      double *parentBox = boxes + 4 * parent;
+      parentBox[0] = std::numeric_limits< double >::max();
+      parentBox[1] = std::numeric_limits< double >::max();
+      parentBox[2] = -std::numeric_limits< double >::max();
+      parentBox[3] = -std::numeric_limits< double >::max();
+      for ( int i = 0; i < nodeSize && pos < end; ++i, ++pos )
+      {
+        const double *box = boxes + 4 * pos;
+        parentBox[0] = std::min( parentBox[0], box[0] );
+        parentBox[1] = std::min( parentBox[1], box[1] );
+        parentBox[2] = std::max( parentBox[2], box[2] );
+        parentBox[3] = std::max( parentBox[3], box[3] );
+      }
+      indices[parent] = static_cast< qint64 >( firstChild );
+      ++parent;
+    }
+  }
+
+  std::copy( boxes + 4 * ( numNodes - 1 ), boxes + 4 * numNodes, header->extent );
+
+  mData = data;
+  mMappedFile.reset();
+  mValid = true;
+}
+
+bool QgsStaticSpatialIndex::isValid() const
+{
+  return mValid;
+}
+
+int QgsStaticSpatialIndex::count() const
+{
+  const IndexView index( mData );
+  return index.header ? static_cast< int >( index.header->numItems ) : 0;
+}
+
+int QgsStaticSpatialIndex::nodeSize() const
+{
+  const IndexView index( mData );
+  return index.header ? static_cast< int >( index.header->nodeSize ) : DEFAULT_NODE_SIZE;
+}
+
+QgsRectangle QgsStaticSpatialIndex::extent() const
+{
+  const IndexView index( mData );
+  if ( index.isEmpty() )
+    return QgsRectangle();
+
+  const double *extent = index.header->extent;
+  return QgsRectangle( extent[0], extent[1], extent[2], extent[3] );
+}
+
+QList<QgsFeatureId> QgsStaticSpatialIndex::intersects( const QgsRectangle &rect ) const
+{
+  QList<QgsFeatureId> list;
+  intersects( rect, [&list]( QgsFeatureId id )
+  {
+    list.append( id );
+    return true;
+  } );
+  return list;
+}
+
+void QgsStaticSpatialIndex::intersects( const QgsRectangle &rect, const std::function<bool ( QgsFeatureId )> &visitor ) const
+{
+  const IndexView index( mData );
+  if ( index.isEmpty() )
+    return;
+
+  const double xMin = rect.xMinimum();
+  const double yMin = rect.yMinimum();
+  const double xMax = rect.xMaximum();
+  const double yMax = rect.yMaximum();
+  const quint64 numItems = index.header->numItems;
+  const int nodeSize = static_cast< int >( index.header->nodeSize );
+
+  // the children of a node are tested in a branch free loop first
+  QVector< char > hits( nodeSize );
+#ifdef QGIS_SSE2
+  // each box ( xMin, yMin, xMax, yMax ) is tested with two comparisons of ( x, y ) pairs
+  const __m128d queryMin = _mm_set_pd( yMin, xMin );
+  const __m128d queryMax = _mm_set_pd( yMax, xMax );
+#endif
+  QVector< quint64 > queue;
+  quint64 node = index.header->numNodes - 1;
+  while ( true )
+  {
+    const quint64 end = std::min( node + nodeSize, index.upperBound( node ) );
+    const int children = static_cast< int >( end - node );
+    const double *box = index.boxes + 4 * node;
+    char *hit = hits.data();
+#ifdef QGIS_SSE2
+    for ( int i = 0; i < children; ++i )
+    {
+      const __m128d boxMin = _mm_loadu_pd( box + 4 * i );
+      const __m128d boxMax = _mm_loadu_pd( box + 4 * i + 2 );
+      const __m128d overlaps = _mm_and_pd( _mm_cmple_pd( boxMin, queryMax ), _mm_cmpge_pd( boxMax, queryMin ) );
+      hit[i] = _mm_movemask_pd( overlaps ) == 3;
+    }
+#else
+    for ( int i = 0; i < children; ++i )
+    {
+      hit[i] = ( box[4 * i] <= xMax ) & ( box[4 * i + 1] <= yMax ) & ( box[4 * i + 2] >= xMin ) & ( box[4 * i + 3] >= yMin );
+    }
+#endif
+
+    for ( int i = 0; i < children; ++i )
+    {
+      if ( !hit[i] )
+        continue;
+
+      const qint64 childIndex = index.indices[node + i];
+      if ( node < numItems )
+      {
+        if ( !visitor( childIndex ) )
+          return;
+      }
+      else
+      {
+        queue.append( static_cast< quint64 >( childIndex ) );
+      }
+    }
+
+    if ( queue.isEmpty() )
+      break;
+
+    node = queue.takeLast();
+  }
+}
+
+void QgsStaticSpatialIndex::visitItems( const std::function<bool ( QgsFeatureId, const QgsRectangle & )> &visitor ) const
+{
+  const IndexView index( mData );
+  if ( index.isEmpty() )
+    return;
+
+  for ( quint64 pos = 0; pos < index.header->numItems; ++pos )
+  {
+    const double *box = index.boxes + 4 * pos;
+    if ( !visitor( index.indices[pos], QgsRectangle( box[0], box[1], box[2], box[3] ) ) )
+      return;
+  }
+}
+
+QList<QgsFeatureId> QgsStaticSpatialIndex::nearestNeighbor( const QgsPointXY &point, int neighbors, double maxDistance ) const
+{
+  QList<QgsFeatureId> list;
+  const IndexView index( mData );
+  if ( index.isEmpty() || neighbors <= 0 )
+    return list;
+
+  const double x = point.x();
+  const double y = point.y();
+  const double maxDistanceSquared = maxDistance > 0 ? maxDistance * maxDistance : std::numeric_limits< double >::infinity();
+  const quint64 numItems = index.header->numItems;
+  const quint64 nodeSize = index.header->nodeSize;
+
+  std::priority_queue< NeighborCandidate > queue;
+  quint64 node = index.header->numNodes - 1;
+  while ( true )
+  {
+    const quint64 end = std::min( node + nodeSize, index.upperBound( node ) );
+    for ( quint64 pos = node; pos < end; ++pos )
+    {
+      const double distance = boxDistanceSquared( x, y, index.boxes + 4 * pos );
+      if ( distance > maxDistanceSquared )
+        continue;
+
+      queue.push( NeighborCandidate{ distance, index.indices[pos], node < numItems } );
+    }
+
+    // items closer than any remaining node are the next nearest neighbors
+    while ( !queue.empty() && queue.top().isItem )
+    {
+      list.append( queue.top().index );
+      queue.pop();
+      if ( list.count() == neighbors )
+        return list;
+    }
+
+    if ( queue.empty() )
+      break;
+
+    node = static_cast< quint64 >( queue.top().index );
+    queue.pop();
+  }
+  return list;
+}
+
+bool QgsStaticSpatialIndex::writeToFile( const QString &path ) const
+{
+  if ( !mValid )
+    return false;
+
+  QSaveFile file( path );
+  if ( !file.open( QIODevice::WriteOnly ) )
+    return false;
+
+  const QByteArray data = mData.isEmpty() ? QgsStaticSpatialIndex( QList< QgsFeatureId >(), QVector< QgsRectangle >() ).mData : mData;
+  if ( file.write( data ) != data.size() )
+  {
+    file.cancelWriting();
+    return false;
+  }
+  return file.commit();
+}
+
+bool QgsStaticSpatialIndex::readFromFile( const QString &path )
+{
+  std::shared_ptr< QFile > file = std::make_shared< QFile >( path );
+  if ( !file->open( QIODevice::ReadOnly ) )
+    return false;
+
+  const qint64 size = file->size();
+  if ( size < static_cast< qint64 >( sizeof( IndexHeader ) ) || size > std::numeric_limits< int >::max() )
+    return false;
+
+  if ( uchar *mapped = file->map( 0, size ) )
+  {
+    const QByteArray data = QByteArray::fromRawData( reinterpret_cast< const char * >( mapped ), static_cast< int >( size ) );
+    if ( !isValidData( data ) )
+      return false;
+
+    mData = data;
+    mMappedFile = file;
+    mValid = true;
+    return true;
+  }
+
+  // mapping is not supported by the file system, read the whole file instead
+  const QByteArray data = file->readAll();
+  if ( !isValidData( data ) )
+    return false;
+
+  mData = data;
+  mMappedFile.reset();
+  mValid = true;
+  return true;
+}
+
+QByteArray QgsStaticSpatialIndex::data() const
+{
+  // the mapped file may be closed before the returned buffer is released
+  if ( mMappedFile )
+    return QByteArray( mData.constData(), mData.size() );
+
+  return mData;
+}
+
+QgsStaticSpatialIndex QgsStaticSpatialIndex::fromData( const QByteArray &data, bool *ok )
+{
+  QgsStaticSpatialIndex index;
+  // the arrays are accessed in place, so they must be suitably aligned
+  const QByteArray alignedData = reinterpret_cast< quintptr >( data.constData() ) % alignof( double ) == 0 ? data : QByteArray( data.constData(), data.size() );
+  const bool valid = isValidData( alignedData );
+  if ( valid )
+    index.mData = alignedData;
+
+  if ( ok )
+    *ok = valid;
+  return index;
+}
+
+bool QgsStaticSpatialIndex::isValidData( const QByteArray &data )
+{
+  if ( data.size() < static_cast< int >( sizeof( IndexHeader ) ) || reinterpret_cast< quintptr >( data.constData() ) % alignof( double ) != 0 )
+    return false;
+
+  const IndexHeader *header = reinterpret_cast< const IndexHeader * >( data.constData() );
+  if ( std::memcmp( header->magic, INDEX_MAGIC, sizeof( INDEX_MAGIC ) ) != 0
+       || header->version != INDEX_VERSION
+       || header->byteOrder != BYTE_ORDER_MARK
+       || header->nodeSize < 2
+       || header->numItems > static_cast< quint64 >( std::numeric_limits< int >::max() )
+       || header->numNodes > static_cast< quint64 >( data.size() )
+       || header->numLevels > 64 )
+    return false;
+
+  if ( indexDataSize( header->numLevels, header->numNodes ) != data.size() )
+    return false;
+
+  if ( header->numItems == 0 )
+    return header->numNodes == 0 && header->numLevels == 0;
+
+  // levels must be consecutive, end with a single root and internal nodes must point to the level below
+  const IndexView index( data );
+  if ( header->numLevels < 2 || index.levelBounds[0] != header->numItems || index.levelBounds[header->numLevels - 1] != header->numNodes
+       || index.levelBounds[header->numLevels - 2] != header->numNodes - 1 )
+    return false;
+
+  for ( quint32 level = 1; level < header->numLevels; ++level )
+  {
+    const quint64 childLevelStart = level > 1 ? index.levelBounds[level - 2] : 0;
+    const quint64 childLevelEnd = index.levelBounds[level - 1];
+    if ( childLevelEnd >= index.levelBounds[level] )
+      return false;
+
+    for ( quint64 pos = childLevelEnd; pos < index.levelBounds[level]; ++pos )
+    {
+      const qint64 child = index.indices[pos];
+      if ( child < static_cast< qint64 >( childLevelStart ) || child >= static_cast< qint64 >( childLevelEnd ) )
+        return false;
+    }
+  }
+  return true;
+}
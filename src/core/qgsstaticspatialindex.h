@@ -0,0 +1,178 @@
+/***************************************************************************
+  qgsstaticspatialindex.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSTATICSPATIALINDEX_H
+#define QGSSTATICSPATIALINDEX_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgsfeature.h"
+#include "qgsrectangle.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <functional>
+#include <memory>
+
+class QFile;
+class QgsFeatureIterator;
+class QgsFeatureSource;
+class QgsFeedback;
+class QgsPointXY;
+
+/**
+ * \ingroup core
+ * \class QgsStaticSpatialIndex
+ * \brief A packed R-tree spatial index which cannot be modified once built.
+ *
+ * Unlike QgsSpatialIndex, which allows features to be inserted and deleted, the static index
+ * is bulk loaded once with all features. The features are sorted along a Hilbert curve and
+ * the tree is packed into flat arrays of bounding boxes and feature IDs, without
+ * any per-node allocations. Building the index is much faster and it needs a fraction of
+ * the memory of QgsSpatialIndex, making it the preferred choice for read-only indexes
+ * over large data sets, e.g. the inputs of processing algorithms.
+ *
+ * The whole index is stored in one contiguous buffer, which can be written to a file with
+ * writeToFile() and memory mapped again with readFromFile() without rebuilding the tree.
+ * The buffer is limited to 2 GB (about 50 million features). Larger indexes cannot be
+ * built, in which case isValid() returns false and the index must not be used.
+ *
+ * Copies of an index are cheap, as they share the same buffer. Queries are thread-safe.
+ *
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsStaticSpatialIndex
+{
+  public:
+
+    //! Constructs an empty index
+    QgsStaticSpatialIndex();
+
+    /**
+     * Constructs an index of the features from the iterator \a fi. Features without geometry are skipped.
+     *
+     * The optional \a feedback object can be used to allow cancelation of feature loading. Ownership
+     * of \a feedback is not transferred, and callers must take care that the lifetime of feedback exceeds
+     * that of the spatial index construction. If loading is canceled the index is empty.
+     */
+    explicit QgsStaticSpatialIndex( const QgsFeatureIterator &fi, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Constructs an index of the features from the \a source. Features without geometry are skipped.
+     *
+     * The optional \a feedback object can be used to allow cancelation of feature loading. Ownership
+     * of \a feedback is not transferred, and callers must take care that the lifetime of feedback exceeds
+     * that of the spatial index construction. If loading is canceled the index is empty.
+     */
+    explicit QgsStaticSpatialIndex( const QgsFeatureSource &source, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Constructs an index of items with the specified \a ids and \a bounds, which must have the same size.
+     * Each node of the tree has up to \a nodeSize children.
+     */
+    QgsStaticSpatialIndex( const QList< QgsFeatureId > &ids, const QVector< QgsRectangle > &bounds, int nodeSize = 16 );
+
+    /**
+     * Returns false if the index could not be built because it would exceed the 2 GB
+     * limit of its buffer. An invalid index contains no items, so callers must check this
+     * before running queries against an index of many features.
+     */
+    bool isValid() const;
+
+    //! Returns true if the index contains no items
+    bool isEmpty() const { return count() == 0; }
+
+    //! Returns the number of items in the index
+    int count() const;
+
+    //! Returns the number of children of each node of the tree
+    int nodeSize() const;
+
+    //! Returns the bounding box of all items in the index
+    QgsRectangle extent() const;
+
+    //! Returns the IDs of the items whose bounding box intersects the specified rectangle
+    QList<QgsFeatureId> intersects( const QgsRectangle &rect ) const;
+
+    /**
+     * Calls \a visitor with the ID of each item whose bounding box intersects the specified rectangle.
+     * The query stops as soon as the visitor returns false.
+     * \note not available in Python bindings
+     */
+    void intersects( const QgsRectangle &rect, const std::function< bool( QgsFeatureId ) > &visitor ) const SIP_SKIP;
+
+    /**
+     * Calls \a visitor with the ID and the bounding box of each item of the index, in the order
+     * they are stored in. Stops as soon as the visitor returns false.
+     * \note not available in Python bindings
+     */
+    void visitItems( const std::function< bool( QgsFeatureId, const QgsRectangle & ) > &visitor ) const SIP_SKIP;
+
+    /**
+     * Returns the IDs of the \a neighbors items nearest to the \a point, ordered by increasing distance
+     * of their bounding box. Only items within \a maxDistance of the point are returned if it is set.
+     */
+    QList<QgsFeatureId> nearestNeighbor( const QgsPointXY &point, int neighbors, double maxDistance = 0 ) const;
+
+    /**
+     * Writes the index to the file at \a path. Returns false if the index is not valid or
+     * the file could not be written.
+     * \see readFromFile()
+     */
+    bool writeToFile( const QString &path ) const;
+
+    /**
+     * Replaces the index with the one stored in the file at \a path, which is memory mapped
+     * instead of read into memory whenever possible. Returns false (leaving the index unchanged)
+     * if the file does not exist or is not a valid index written on a machine with
+     * the same byte order.
+     * \see writeToFile()
+     */
+    bool readFromFile( const QString &path );
+
+    /**
+     * Returns the buffer holding the whole index.
+     * \see fromData()
+     */
+    QByteArray data() const;
+
+    /**
+     * Constructs an index from a buffer returned by data(). Returns an empty index and sets \a ok
+     * to false if the buffer is not a valid index.
+     */
+    static QgsStaticSpatialIndex fromData( const QByteArray &data, bool *ok SIP_OUT = nullptr );
+
+  private:
+
+    //! Buffer holding the header, the level bounds, the node boxes and the node indices
+    QByteArray mData;
+
+    //! File the buffer is mapped from, kept open for as long as any copy of the index uses it
+    std::shared_ptr< QFile > mMappedFile;
+
+    //! False if the index was too large to be built
+    bool mValid = true;
+
+    //! Sorts the items along the Hilbert curve and packs the tree into mData
+    void build( const QList< QgsFeatureId > &ids, const QVector< QgsRectangle > &bounds, int nodeSize );
+
+    //! Loads the index from features of an iterator
+    void load( const QgsFeatureIterator &fi, QgsFeedback *feedback );
+
+    //! Returns true if \a data holds a valid index
+    static bool isValidData( const QByteArray &data );
+};
+
+#endif // QGSSTATICSPATIALINDEX_H
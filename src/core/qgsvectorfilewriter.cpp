@@ -41,6 +41,7 @@
 #include <QTextStream>
 #include <QSet>
 #include <QMetaType>
+#include <QtConcurrentRun>
 
 #include <cassert>
 #include <cstdlib> // size_t
@@ -626,6 +627,8 @@ void QgsVectorFileWriter::init( QString vectorFileName,
 
   QgsDebugMsg( "Done creating fields" );
 
+  prepareAttributeConversions();
+
   mWkbType = geometryType;
 
   if ( newFilename )
@@ -1893,22 +1896,130 @@ QString QgsVectorFileWriter::errorMessage()
   return mErrorMessage;
 }
 
+//! Number of features of which the geometries are converted in one go while the previous features are written
+static const int GEOMETRY_CONVERSION_CHUNK_SIZE = 512;
+
 bool QgsVectorFileWriter::addFeature( QgsFeature &feature, QgsFeatureSink::Flags )
 {
-  return addFeatureWithStyle( feature, nullptr, QgsUnitTypes::DistanceMeters );
+  startTransactionBatch();
+  if ( !addFeatureWithStyle( feature, nullptr, QgsUnitTypes::DistanceMeters ) )
+    return false;
+  return endTransactionBatch();
 }
 
 bool QgsVectorFileWriter::addFeatures( QgsFeatureList &features, QgsFeatureSink::Flags )
 {
-  QgsFeatureList::iterator fIt = features.begin();
+  if ( mWkbType == QgsWkbTypes::NoGeometry || features.size() <= GEOMETRY_CONVERSION_CHUNK_SIZE )
+  {
+    QgsFeatureList::iterator fIt = features.begin();
+    for ( ; fIt != features.end(); ++fIt )
+    {
+      startTransactionBatch();
+      if ( !addFeatureWithStyle( *fIt, nullptr, QgsUnitTypes::DistanceMeters ) || !endTransactionBatch() )
+        return false;
+    }
+    return true;
+  }
+
+  // convert the geometries of the next chunk of features on a worker thread, while
+  // the current chunk is written to OGR (which has to happen on this thread)
+  const QgsFeatureList constFeatures = features;
+  const QgsWkbTypes::Type wkbType = mWkbType;
+  auto convertChunk = [constFeatures, wkbType]( int begin ) -> QVector< ConvertedGeometry >
+  {
+    const int end = std::min( begin + GEOMETRY_CONVERSION_CHUNK_SIZE, constFeatures.size() );
+    QVector< ConvertedGeometry > geometries;
+    geometries.reserve( end - begin );
+    for ( int i = begin; i < end; ++i )
+      geometries << convertGeometry( constFeatures.at( i ), wkbType );
+    return geometries;
+  };
+
+  QVector< ConvertedGeometry > geometries = convertChunk( 0 );
   bool result = true;
-  for ( ; fIt != features.end(); ++fIt )
+  for ( int begin = 0; begin < constFeatures.size(); begin += GEOMETRY_CONVERSION_CHUNK_SIZE )
   {
-    result = result && addFeatureWithStyle( *fIt, nullptr, QgsUnitTypes::DistanceMeters );
+    const int next = begin + GEOMETRY_CONVERSION_CHUNK_SIZE;
+    QFuture< QVector< ConvertedGeometry > > nextGeometries;
+    if ( next < constFeatures.size() )
+      nextGeometries = QtConcurrent::run( [convertChunk, next] { return convertChunk( next ); } );
+
+    for ( int i = 0; i < geometries.size(); ++i )
+    {
+      if ( !result )
+      {
+        // an earlier feature could not be written, discard the remaining geometries
+        OGR_G_DestroyGeometry( geometries.at( i ).geometry );
+        continue;
+      }
+
+      QgsFeature feature = constFeatures.at( begin + i );
+      startTransactionBatch();
+      OGRFeatureH poFeature = createFeature( feature, geometries.at( i ) );
+      result = poFeature
+               && writeFeatureWithStyle( poFeature, feature, nullptr, QgsUnitTypes::DistanceMeters )
+               && endTransactionBatch();
+    }
+
+    if ( next < constFeatures.size() )
+      geometries = nextGeometries.result();
   }
   return result;
 }
 
+bool QgsVectorFileWriter::flushBuffer()
+{
+  return commitTransactionBatch();
+}
+
+void QgsVectorFileWriter::setTransactionBatchSize( int size )
+{
+  mTransactionBatchSize = std::max( size, 0 );
+  if ( mTransactionBatchSize == 0 )
+    commitTransactionBatch();
+}
+
+void QgsVectorFileWriter::startTransactionBatch()
+{
+  if ( mTransactionBatchSize <= 0 || mTransactionsUnsupported || mTransactionFeatureCount >= 0 || !mLayer )
+    return;
+
+  if ( OGR_L_StartTransaction( mLayer ) != OGRERR_NONE )
+  {
+    QgsDebugMsg( "Error when trying to enable transactions on OGRLayer." );
+    mTransactionsUnsupported = true;
+    return;
+  }
+  mTransactionFeatureCount = 0;
+}
+
+bool QgsVectorFileWriter::endTransactionBatch()
+{
+  if ( mTransactionFeatureCount < 0 )
+    return true;
+
+  if ( ++mTransactionFeatureCount < mTransactionBatchSize )
+    return true;
+
+  return commitTransactionBatch();
+}
+
+bool QgsVectorFileWriter::commitTransactionBatch()
+{
+  if ( mTransactionFeatureCount < 0 )
+    return true;
+
+  mTransactionFeatureCount = -1;
+  if ( OGR_L_CommitTransaction( mLayer ) != OGRERR_NONE )
+  {
+    mErrorMessage = QObject::tr( "Error while committing transaction (OGR error: %1)" ).arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
+    mError = ErrFeatureWriteFailed;
+    QgsMessageLog::logMessage( mErrorMessage, QObject::tr( "OGR" ) );
+    return false;
+  }
+  return true;
+}
+
 bool QgsVectorFileWriter::addFeatureWithStyle( QgsFeature &feature, QgsFeatureRenderer *renderer, QgsUnitTypes::DistanceUnit outputUnit )
 {
   // create the feature
@@ -1916,6 +2027,11 @@ bool QgsVectorFileWriter::addFeatureWithStyle( QgsFeature &feature, QgsFeatureRe
   if ( !poFeature )
     return false;
 
+  return writeFeatureWithStyle( poFeature, feature, renderer, outputUnit );
+}
+
+bool QgsVectorFileWriter::writeFeatureWithStyle( OGRFeatureH poFeature, QgsFeature &feature, QgsFeatureRenderer *renderer, QgsUnitTypes::DistanceUnit outputUnit )
+{
   //add OGR feature style type
   if ( mSymbologyExport != NoSymbology && renderer )
   {
@@ -1976,11 +2092,108 @@ bool QgsVectorFileWriter::addFeatureWithStyle( QgsFeature &feature, QgsFeatureRe
   return true;
 }
 
+void QgsVectorFileWriter::prepareAttributeConversions()
+{
+  mAttributeConversions.clear();
+  if ( !mLayer )
+    return;
+
+  OGRFeatureDefnH defn = OGR_L_GetLayerDefn( mLayer );
+  mAttributeConversions.reserve( mAttrIdxToOgrIdx.size() );
+  for ( QMap<int, int>::const_iterator it = mAttrIdxToOgrIdx.constBegin(); it != mAttrIdxToOgrIdx.constEnd(); ++it )
+  {
+    OGRFieldDefnH fldDefn = OGR_FD_GetFieldDefn( defn, it.value() );
+    if ( !fldDefn )
+      continue;
+
+    // values of the type matching the OGR field (which is the usual case) use the conversion
+    // prepared here, other values are dispatched on their type when they are written
+    QVariant::Type type = QVariant::Invalid;
+    switch ( OGR_Fld_GetType( fldDefn ) )
+    {
+      case OFTInteger:
+        type = QVariant::Int;
+        break;
+      case OFTInteger64:
+        type = QVariant::LongLong;
+        break;
+      case OFTReal:
+        type = QVariant::Double;
+        break;
+      case OFTString:
+        type = QVariant::String;
+        break;
+      case OFTDate:
+        type = QVariant::Date;
+        break;
+      case OFTTime:
+        type = QVariant::Time;
+        break;
+      case OFTDateTime:
+        type = QVariant::DateTime;
+        break;
+      default:
+        break;
+    }
+
+    AttributeConversion conversion;
+    conversion.attributeIndex = it.key();
+    conversion.ogrIndex = it.value();
+    conversion.type = type;
+    conversion.kind = attributeConversionKind( type );
+    mAttributeConversions << conversion;
+  }
+}
+
+QgsVectorFileWriter::AttributeConversionKind QgsVectorFileWriter::attributeConversionKind( QVariant::Type type ) const
+{
+  switch ( type )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+      return IntegerValue;
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+      return Integer64Value;
+    case QVariant::String:
+      return StringValue;
+    case QVariant::Double:
+      return DoubleValue;
+    case QVariant::Date:
+      return DateValue;
+    case QVariant::DateTime:
+      return mOgrDriverName == QLatin1String( "ESRI Shapefile" ) ? DateTimeAsStringValue : DateTimeValue;
+    case QVariant::Time:
+      return mOgrDriverName == QLatin1String( "ESRI Shapefile" ) ? TimeAsStringValue : TimeValue;
+    case QVariant::Invalid:
+      return SkipValue;
+    default:
+      return UnsupportedValue;
+  }
+}
+
 OGRFeatureH QgsVectorFileWriter::createFeature( const QgsFeature &feature )
+{
+  ConvertedGeometry geometry;
+  if ( mWkbType != QgsWkbTypes::NoGeometry )
+    geometry = convertGeometry( feature, mWkbType );
+
+  return createFeature( feature, geometry );
+}
+
+OGRFeatureH QgsVectorFileWriter::createFeature( const QgsFeature &feature, const ConvertedGeometry &geometry )
 {
   QgsLocaleNumC l; // Make sure the decimal delimiter is a dot
   Q_UNUSED( l );
 
+  if ( mWkbType != QgsWkbTypes::NoGeometry && !geometry.geometry )
+  {
+    mErrorMessage = QObject::tr( "Feature geometry not imported (OGR error: %1)" ).arg( geometry.error );
+    mError = ErrFeatureWriteFailed;
+    QgsMessageLog::logMessage( mErrorMessage, QObject::tr( "OGR" ) );
+    return nullptr;
+  }
+
   OGRFeatureH poFeature = OGR_F_Create( OGR_L_GetLayerDefn( mLayer ) );
 
   qint64 fid = FID_TO_NUMBER( feature.id() );
@@ -1998,12 +2211,13 @@ OGRFeatureH QgsVectorFileWriter::createFeature( const QgsFeature &feature )
   }
 
   // attribute handling
-  for ( QMap<int, int>::const_iterator it = mAttrIdxToOgrIdx.constBegin(); it != mAttrIdxToOgrIdx.constEnd(); ++it )
+  const QgsAttributes attributes = feature.attributes();
+  for ( const AttributeConversion &conversion : qgsAsConst( mAttributeConversions ) )
   {
-    int fldIdx = it.key();
-    int ogrField = it.value();
+    const int fldIdx = conversion.attributeIndex;
+    const int ogrField = conversion.ogrIndex;
 
-    QVariant attrValue = feature.attribute( fldIdx );
+    QVariant attrValue = attributes.value( fldIdx );
 
     if ( !attrValue.isValid() || attrValue.isNull() )
     {
@@ -2025,64 +2239,62 @@ OGRFeatureH QgsVectorFileWriter::createFeature( const QgsFeature &feature )
       attrValue = mFieldValueConverter->convert( fldIdx, attrValue );
     }
 
-    switch ( attrValue.type() )
+    const AttributeConversionKind kind = attrValue.type() == conversion.type ? conversion.kind : attributeConversionKind( attrValue.type() );
+    switch ( kind )
     {
-      case QVariant::Int:
-      case QVariant::UInt:
+      case IntegerValue:
         OGR_F_SetFieldInteger( poFeature, ogrField, attrValue.toInt() );
         break;
-      case QVariant::LongLong:
-      case QVariant::ULongLong:
+      case Integer64Value:
         OGR_F_SetFieldInteger64( poFeature, ogrField, attrValue.toLongLong() );
         break;
-      case QVariant::String:
+      case StringValue:
+      case TimeAsStringValue:
         OGR_F_SetFieldString( poFeature, ogrField, mCodec->fromUnicode( attrValue.toString() ).constData() );
         break;
-      case QVariant::Double:
+      case DoubleValue:
         OGR_F_SetFieldDouble( poFeature, ogrField, attrValue.toDouble() );
         break;
-      case QVariant::Date:
+      case DateValue:
+      {
+        const QDate date = attrValue.toDate();
         OGR_F_SetFieldDateTime( poFeature, ogrField,
-                                attrValue.toDate().year(),
-                                attrValue.toDate().month(),
-                                attrValue.toDate().day(),
+                                date.year(),
+                                date.month(),
+                                date.day(),
                                 0, 0, 0, 0 );
         break;
-      case QVariant::DateTime:
-        if ( mOgrDriverName == QLatin1String( "ESRI Shapefile" ) )
-        {
-          OGR_F_SetFieldString( poFeature, ogrField, mCodec->fromUnicode( attrValue.toDateTime().toString( QStringLiteral( "yyyy/MM/dd hh:mm:ss.zzz" ) ) ).constData() );
-        }
-        else
-        {
-          OGR_F_SetFieldDateTime( poFeature, ogrField,
-                                  attrValue.toDateTime().date().year(),
-                                  attrValue.toDateTime().date().month(),
-                                  attrValue.toDateTime().date().day(),
-                                  attrValue.toDateTime().time().hour(),
-                                  attrValue.toDateTime().time().minute(),
-                                  attrValue.toDateTime().time().second(),
-                                  0 );
-        }
+      }
+      case DateTimeAsStringValue:
+        OGR_F_SetFieldString( poFeature, ogrField, mCodec->fromUnicode( attrValue.toDateTime().toString( QStringLiteral( "yyyy/MM/dd hh:mm:ss.zzz" ) ) ).constData() );
         break;
-      case QVariant::Time:
-        if ( mOgrDriverName == QLatin1String( "ESRI Shapefile" ) )
-        {
-          OGR_F_SetFieldString( poFeature, ogrField, mCodec->fromUnicode( attrValue.toString() ).constData() );
-        }
-        else
-        {
-          OGR_F_SetFieldDateTime( poFeature, ogrField,
-                                  0, 0, 0,
-                                  attrValue.toTime().hour(),
-                                  attrValue.toTime().minute(),
-                                  attrValue.toTime().second(),
-                                  0 );
-        }
+      case DateTimeValue:
+      {
+        const QDateTime dateTime = attrValue.toDateTime();
+        OGR_F_SetFieldDateTime( poFeature, ogrField,
+                                dateTime.date().year(),
+                                dateTime.date().month(),
+                                dateTime.date().day(),
+                                dateTime.time().hour(),
+                                dateTime.time().minute(),
+                                dateTime.time().second(),
+                                0 );
         break;
-      case QVariant::Invalid:
+      }
+      case TimeValue:
+      {
+        const QTime time = attrValue.toTime();
+        OGR_F_SetFieldDateTime( poFeature, ogrField,
+                                0, 0, 0,
+                                time.hour(),
+                                time.minute(),
+                                time.second(),
+                                0 );
         break;
-      default:
+      }
+      case SkipValue:
+        break;
+      case UnsupportedValue:
         mErrorMessage = QObject::tr( "Invalid variant type for field %1[%2]: received %3 with type %4" )
                         .arg( mFields.at( fldIdx ).name() )
                         .arg( ogrField )
@@ -2090,107 +2302,94 @@ OGRFeatureH QgsVectorFileWriter::createFeature( const QgsFeature &feature )
                               attrValue.toString() );
         QgsMessageLog::logMessage( mErrorMessage, QObject::tr( "OGR" ) );
         mError = ErrFeatureWriteFailed;
+        OGR_G_DestroyGeometry( geometry.geometry );
+        OGR_F_Destroy( poFeature );
         return nullptr;
     }
   }
 
-  if ( mWkbType != QgsWkbTypes::NoGeometry )
+  if ( geometry.geometry )
   {
-    if ( feature.hasGeometry() )
-    {
-      // build geometry from WKB
-      QgsGeometry geom = feature.geometry();
-
-      // turn single geometry to multi geometry if needed
-      if ( QgsWkbTypes::flatType( geom.geometry()->wkbType() ) != QgsWkbTypes::flatType( mWkbType ) &&
-           QgsWkbTypes::flatType( geom.geometry()->wkbType() ) == QgsWkbTypes::flatType( QgsWkbTypes::singleType( mWkbType ) ) )
-      {
-        geom.convertToMultiType();
-      }
-
-      if ( geom.geometry()->wkbType() != mWkbType )
-      {
-        OGRGeometryH mGeom2 = nullptr;
-
-        // If requested WKB type is 25D and geometry WKB type is 3D,
-        // we must force the use of 25D.
-        if ( mWkbType >= QgsWkbTypes::Point25D && mWkbType <= QgsWkbTypes::MultiPolygon25D )
-        {
-          //ND: I suspect there's a bug here, in that this is NOT converting the geometry's WKB type,
-          //so the exported WKB has a different type to what the OGRGeometry is expecting.
-          //possibly this is handled already in OGR, but it should be fixed regardless by actually converting
-          //geom to the correct WKB type
-          QgsWkbTypes::Type wkbType = geom.geometry()->wkbType();
-          if ( wkbType >= QgsWkbTypes::PointZ && wkbType <= QgsWkbTypes::MultiPolygonZ )
-          {
-            QgsWkbTypes::Type wkbType25d = static_cast<QgsWkbTypes::Type>( geom.geometry()->wkbType() - QgsWkbTypes::PointZ + QgsWkbTypes::Point25D );
-            mGeom2 = createEmptyGeometry( wkbType25d );
-          }
-        }
+    // set geometry (ownership is passed to OGR)
+    OGR_F_SetGeometryDirectly( poFeature, geometry.geometry );
+  }
+  return poFeature;
+}
 
-        if ( !mGeom2 )
-        {
-          // there's a problem when layer type is set as wkbtype Polygon
-          // although there are also features of type MultiPolygon
-          // (at least in OGR provider)
-          // If the feature's wkbtype is different from the layer's wkbtype,
-          // try to export it too.
-          //
-          // Btw. OGRGeometry must be exactly of the type of the geometry which it will receive
-          // i.e. Polygons can't be imported to OGRMultiPolygon
-          mGeom2 = createEmptyGeometry( geom.geometry()->wkbType() );
-        }
+QgsVectorFileWriter::ConvertedGeometry QgsVectorFileWriter::convertGeometry( const QgsFeature &feature, QgsWkbTypes::Type wkbType )
+{
+  ConvertedGeometry result;
+  if ( !feature.hasGeometry() )
+  {
+    result.geometry = OGR_G_CreateGeometry( ogrTypeFromWkbType( wkbType ) );
+    return result;
+  }
 
-        if ( !mGeom2 )
-        {
-          mErrorMessage = QObject::tr( "Feature geometry not imported (OGR error: %1)" )
-                          .arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
-          mError = ErrFeatureWriteFailed;
-          QgsMessageLog::logMessage( mErrorMessage, QObject::tr( "OGR" ) );
-          OGR_F_Destroy( poFeature );
-          return nullptr;
-        }
+  // build geometry from WKB
+  QgsGeometry geom = feature.geometry();
 
-        QByteArray wkb( geom.exportToWkb() );
-        OGRErr err = OGR_G_ImportFromWkb( mGeom2, reinterpret_cast<unsigned char *>( const_cast<char *>( wkb.constData() ) ), wkb.length() );
-        if ( err != OGRERR_NONE )
-        {
-          mErrorMessage = QObject::tr( "Feature geometry not imported (OGR error: %1)" )
-                          .arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
-          mError = ErrFeatureWriteFailed;
-          QgsMessageLog::logMessage( mErrorMessage, QObject::tr( "OGR" ) );
-          OGR_F_Destroy( poFeature );
-          return nullptr;
-        }
+  // turn single geometry to multi geometry if needed
+  if ( QgsWkbTypes::flatType( geom.geometry()->wkbType() ) != QgsWkbTypes::flatType( wkbType ) &&
+       QgsWkbTypes::flatType( geom.geometry()->wkbType() ) == QgsWkbTypes::flatType( QgsWkbTypes::singleType( wkbType ) ) )
+  {
+    geom.convertToMultiType();
+  }
 
-        // pass ownership to geometry
-        OGR_F_SetGeometryDirectly( poFeature, mGeom2 );
-      }
-      else // wkb type matches
+  OGRGeometryH ogrGeom = nullptr;
+  if ( geom.geometry()->wkbType() != wkbType )
+  {
+    // If requested WKB type is 25D and geometry WKB type is 3D,
+    // we must force the use of 25D.
+    if ( wkbType >= QgsWkbTypes::Point25D && wkbType <= QgsWkbTypes::MultiPolygon25D )
+    {
+      //ND: I suspect there's a bug here, in that this is NOT converting the geometry's WKB type,
+      //so the exported WKB has a different type to what the OGRGeometry is expecting.
+      //possibly this is handled already in OGR, but it should be fixed regardless by actually converting
+      //geom to the correct WKB type
+      QgsWkbTypes::Type geomWkbType = geom.geometry()->wkbType();
+      if ( geomWkbType >= QgsWkbTypes::PointZ && geomWkbType <= QgsWkbTypes::MultiPolygonZ )
       {
-        QByteArray wkb( geom.exportToWkb() );
-        OGRGeometryH ogrGeom = createEmptyGeometry( mWkbType );
-        OGRErr err = OGR_G_ImportFromWkb( ogrGeom, reinterpret_cast<unsigned char *>( const_cast<char *>( wkb.constData() ) ), wkb.length() );
-        if ( err != OGRERR_NONE )
-        {
-          mErrorMessage = QObject::tr( "Feature geometry not imported (OGR error: %1)" )
-                          .arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
-          mError = ErrFeatureWriteFailed;
-          QgsMessageLog::logMessage( mErrorMessage, QObject::tr( "OGR" ) );
-          OGR_F_Destroy( poFeature );
-          return nullptr;
-        }
-
-        // set geometry (ownership is passed to OGR)
-        OGR_F_SetGeometryDirectly( poFeature, ogrGeom );
+        QgsWkbTypes::Type wkbType25d = static_cast<QgsWkbTypes::Type>( geom.geometry()->wkbType() - QgsWkbTypes::PointZ + QgsWkbTypes::Point25D );
+        ogrGeom = OGR_G_CreateGeometry( ogrTypeFromWkbType( wkbType25d ) );
       }
     }
-    else
+
+    if ( !ogrGeom )
     {
-      OGR_F_SetGeometry( poFeature, createEmptyGeometry( mWkbType ) );
+      // there's a problem when layer type is set as wkbtype Polygon
+      // although there are also features of type MultiPolygon
+      // (at least in OGR provider)
+      // If the feature's wkbtype is different from the layer's wkbtype,
+      // try to export it too.
+      //
+      // Btw. OGRGeometry must be exactly of the type of the geometry which it will receive
+      // i.e. Polygons can't be imported to OGRMultiPolygon
+      ogrGeom = OGR_G_CreateGeometry( ogrTypeFromWkbType( geom.geometry()->wkbType() ) );
     }
   }
-  return poFeature;
+  else // wkb type matches
+  {
+    ogrGeom = OGR_G_CreateGeometry( ogrTypeFromWkbType( wkbType ) );
+  }
+
+  if ( !ogrGeom )
+  {
+    // OGR error messages are per thread, so the message is collected here
+    result.error = QString::fromUtf8( CPLGetLastErrorMsg() );
+    return result;
+  }
+
+  QByteArray wkb( geom.exportToWkb() );
+  OGRErr err = OGR_G_ImportFromWkb( ogrGeom, reinterpret_cast<unsigned char *>( const_cast<char *>( wkb.constData() ) ), wkb.length() );
+  if ( err != OGRERR_NONE )
+  {
+    result.error = QString::fromUtf8( CPLGetLastErrorMsg() );
+    OGR_G_DestroyGeometry( ogrGeom );
+    return result;
+  }
+
+  result.geometry = ogrGeom;
+  return result;
 }
 
 void QgsVectorFileWriter::resetMap( const QgsAttributeList &attributes )
@@ -2202,6 +2401,7 @@ void QgsVectorFileWriter::resetMap( const QgsAttributeList &attributes )
     if ( omap.find( i ) != omap.end() )
       mAttrIdxToOgrIdx.insert( attributes[i], omap[i] );
   }
+  prepareAttributeConversions();
 }
 
 bool QgsVectorFileWriter::writeFeature( OGRLayerH layer, OGRFeatureH feature )
@@ -2219,6 +2419,8 @@ bool QgsVectorFileWriter::writeFeature( OGRLayerH layer, OGRFeatureH feature )
 
 QgsVectorFileWriter::~QgsVectorFileWriter()
 {
+  commitTransactionBatch();
+
   if ( mDS )
   {
     OGR_DS_Destroy( mDS );
@@ -540,6 +540,35 @@ class CORE_EXPORT QgsVectorFileWriter : public QgsFeatureSink
     bool addFeature( QgsFeature &feature, QgsFeatureSink::Flags flags = 0 ) override;
     bool addFeatures( QgsFeatureList &features, QgsFeatureSink::Flags flags = 0 ) override;
 
+    /**
+     * Commits the pending transaction batch, if any.
+     * \see setTransactionBatchSize()
+     */
+    bool flushBuffer() override;
+
+    /**
+     * Returns the number of features written in a single transaction by addFeature()
+     * and addFeatures(). A value of 0 means that features are not written in transactions.
+     * \since QGIS 3.0
+     * \see setTransactionBatchSize()
+     */
+    int transactionBatchSize() const { return mTransactionBatchSize; }
+
+    /**
+     * Sets the number of features written in a single transaction by addFeature()
+     * and addFeatures(). Large batches considerably speed up writing to database
+     * formats like GeoPackage or SpatiaLite. Set \a size to 0 (the default) to write
+     * features without transactions.
+     *
+     * The pending transaction is committed when flushBuffer() is called or when the
+     * writer is destroyed.
+     * As errors cannot be reported by the destructor, callers should call flushBuffer()
+     * and check its result once all features are added.
+     * \since QGIS 3.0
+     * \see transactionBatchSize()
+     */
+    void setTransactionBatchSize( int size );
+
     /**
      * Adds a \a feature to the currently opened data source, using the style from a specified \a renderer.
      * \since QGIS 3.0
@@ -676,10 +705,65 @@ class CORE_EXPORT QgsVectorFileWriter : public QgsFeatureSink
 
     QgsRenderContext mRenderContext;
 
+    //! How an attribute value is set on an OGR feature
+    enum AttributeConversionKind
+    {
+      SkipValue,
+      IntegerValue,
+      Integer64Value,
+      StringValue,
+      DoubleValue,
+      DateValue,
+      DateTimeValue,
+      DateTimeAsStringValue,
+      TimeValue,
+      TimeAsStringValue,
+      UnsupportedValue,
+    };
+
+    //! Prepared conversion of an attribute to its OGR field
+    struct AttributeConversion
+    {
+      int attributeIndex;
+      int ogrIndex;
+      //! Value type matching the OGR field type, values of this type use the prepared conversion
+      QVariant::Type type;
+      AttributeConversionKind kind;
+    };
+
+    //! OGR geometry converted from the geometry of a feature
+    struct ConvertedGeometry
+    {
+      OGRGeometryH geometry = nullptr;
+      //! Error message if the conversion failed
+      QString error;
+    };
+
+    //! Conversions of the written attributes, built from mAttrIdxToOgrIdx by prepareAttributeConversions()
+    QVector<AttributeConversion> mAttributeConversions;
+
+    int mTransactionBatchSize = 0;
+    //! Number of features written in the current transaction, or -1 if no transaction is active
+    int mTransactionFeatureCount = -1;
+    bool mTransactionsUnsupported = false;
+
     static QMap<QString, MetaData> initMetaData();
     void createSymbolLayerTable( QgsVectorLayer *vl, const QgsCoordinateTransform &ct, OGRDataSourceH ds );
+    void prepareAttributeConversions();
+    AttributeConversionKind attributeConversionKind( QVariant::Type type ) const;
     OGRFeatureH createFeature( const QgsFeature &feature );
+    //! Creates an OGR feature with the attributes of \a feature and the already converted \a geometry (ownership is transferred)
+    OGRFeatureH createFeature( const QgsFeature &feature, const ConvertedGeometry &geometry );
+    //! Converts the geometry of \a feature to an OGR geometry of type \a wkbType. Safe to call from any thread.
+    static ConvertedGeometry convertGeometry( const QgsFeature &feature, QgsWkbTypes::Type wkbType );
     bool writeFeature( OGRLayerH layer, OGRFeatureH feature );
+    //! Writes \a poFeature using the style from \a renderer, and destroys it
+    bool writeFeatureWithStyle( OGRFeatureH poFeature, QgsFeature &feature, QgsFeatureRenderer *renderer, QgsUnitTypes::DistanceUnit outputUnit );
+    //! Starts a transaction if transaction batches are enabled and no transaction is active
+    void startTransactionBatch();
+    //! Counts a feature written to the current transaction, and commits it once the batch is full
+    bool endTransactionBatch();
+    bool commitTransactionBatch();
 
     //! Writes features considering symbol level order
     QgsVectorFileWriter::WriterError exportFeaturesSymbolLevels( QgsVectorLayer *layer, QgsFeatureIterator &fit, const QgsCoordinateTransform &ct, QString *errorMessage = nullptr );
@@ -3595,6 +3595,7 @@ QList<QVariant> QgsVectorLayer::getValues( const QString &fieldOrExpression, boo
       ok = false;
       return values;
     }
+    expression->compile();
   }
 
   QgsFeature f;
@@ -3620,14 +3621,21 @@ QList<QVariant> QgsVectorLayer::getValues( const QString &fieldOrExpression, boo
     fit = getSelectedFeatures( request );
   }
 
+  // expressions are evaluated for blocks of features
+  const int blockSize = 1000;
+  QgsFeatureList block;
+
   // create list of non-null attribute values
   while ( fit.nextFeature( f ) )
   {
     if ( expression )
     {
-      context.setFeature( f );
-      QVariant v = expression->evaluate( &context );
-      values << v;
+      block << f;
+      if ( block.count() == blockSize )
+      {
+        values += expression->evaluate( &context, block );
+        block.clear();
+      }
     }
     else
     {
@@ -3639,6 +3647,8 @@ QList<QVariant> QgsVectorLayer::getValues( const QString &fieldOrExpression, boo
       return values;
     }
   }
+  if ( !block.isEmpty() )
+    values += expression->evaluate( &context, block );
   ok = true;
   return values;
 }
@@ -16,11 +16,371 @@
  ***************************************************************************/
 
 #include "qgsvectorlayercache.h"
+#include "qgsvectorlayercache_p.h"
 #include "qgscacheindex.h"
 #include "qgscachedfeatureiterator.h"
 #include "qgsvectorlayerjoininfo.h"
 #include "qgsvectorlayerjoinbuffer.h"
 
+#include <algorithm>
+#include <limits>
+
+///@cond PRIVATE
+
+//! Feature id of the rows of the columns which are not used by any feature
+static const QgsFeatureId FREE_ROW = std::numeric_limits<QgsFeatureId>::min();
+
+QgsVectorLayerCacheColumn::QgsVectorLayerCacheColumn( QVariant::Type type )
+  : mType( type )
+{
+  switch ( type )
+  {
+    case QVariant::Int:
+      mStorage = IntStorage;
+      break;
+    case QVariant::LongLong:
+      mStorage = LongLongStorage;
+      break;
+    case QVariant::Double:
+      mStorage = DoubleStorage;
+      break;
+    case QVariant::String:
+      mStorage = StringStorage;
+      break;
+    default:
+      mStorage = VariantStorage;
+      break;
+  }
+}
+
+void QgsVectorLayerCacheColumn::resize( int rowCount )
+{
+  if ( rowCount == mRowCount )
+    return;
+
+  for ( int row = rowCount; row < mRowCount; ++row )
+    releaseString( row );
+
+  switch ( mStorage )
+  {
+    case IntStorage:
+      mInts.resize( rowCount );
+      break;
+    case LongLongStorage:
+      mLongLongs.resize( rowCount );
+      break;
+    case DoubleStorage:
+      mDoubles.resize( rowCount );
+      break;
+    case StringStorage:
+      mStringCodes.resize( rowCount );
+      break;
+    case VariantStorage:
+      mVariants.resize( rowCount );
+      break;
+  }
+
+  mNulls.resize( rowCount );
+  mInvalid.resize( rowCount );
+  if ( rowCount > mRowCount )
+    mInvalid.fill( true, mRowCount, rowCount );
+  mRowCount = rowCount;
+}
+
+void QgsVectorLayerCacheColumn::setValue( int row, const QVariant &value )
+{
+  releaseString( row );
+  mInvalid.setBit( row );
+
+  if ( !value.isValid() )
+  {
+    mNulls.clearBit( row );
+    if ( mStorage == VariantStorage )
+      mVariants[row] = QVariant();
+    return;
+  }
+
+  // a value of another type than the field can only be kept unchanged as a variant
+  if ( mStorage != VariantStorage && value.type() != mType )
+    convertToVariants();
+
+  mInvalid.clearBit( row );
+
+  if ( mStorage == VariantStorage )
+  {
+    mVariants[row] = value;
+    return;
+  }
+
+  if ( value.isNull() )
+  {
+    mNulls.setBit( row );
+    return;
+  }
+
+  mNulls.clearBit( row );
+  switch ( mStorage )
+  {
+    case IntStorage:
+      mInts[row] = value.toInt();
+      break;
+    case LongLongStorage:
+      mLongLongs[row] = value.toLongLong();
+      break;
+    case DoubleStorage:
+      mDoubles[row] = value.toDouble();
+      break;
+    case StringStorage:
+      mStringCodes[row] = encodeString( value.toString() );
+      break;
+    case VariantStorage:
+      break;
+  }
+}
+
+QVariant QgsVectorLayerCacheColumn::value( int row ) const
+{
+  if ( mInvalid.testBit( row ) )
+    return QVariant();
+
+  if ( mStorage == VariantStorage )
+    return mVariants.at( row );
+
+  if ( mNulls.testBit( row ) )
+    return QVariant( mType );
+
+  switch ( mStorage )
+  {
+    case IntStorage:
+      return mInts.at( row );
+    case LongLongStorage:
+      return mLongLongs.at( row );
+    case DoubleStorage:
+      return mDoubles.at( row );
+    case StringStorage:
+      return mDictionary.at( mStringCodes.at( row ) );
+    case VariantStorage:
+      break;
+  }
+  return QVariant();
+}
+
+void QgsVectorLayerCacheColumn::clearValue( int row )
+{
+  releaseString( row );
+  mInvalid.setBit( row );
+  mNulls.clearBit( row );
+  if ( mStorage == VariantStorage )
+    mVariants[row] = QVariant();
+}
+
+void QgsVectorLayerCacheColumn::uniqueValues( QSet<QVariant> &values, int limit ) const
+{
+  if ( limit >= 0 && values.size() >= limit )
+    return;
+
+  switch ( mStorage )
+  {
+    case IntStorage:
+    case LongLongStorage:
+    case DoubleStorage:
+    {
+      // collecting the raw numbers first avoids hashing a variant for each row
+      QSet<qlonglong> longLongs;
+      QSet<double> doubles;
+      for ( int row = 0; row < mRowCount; ++row )
+      {
+        if ( mInvalid.testBit( row ) || mNulls.testBit( row ) )
+          continue;
+
+        if ( mStorage == IntStorage )
+          longLongs.insert( mInts.at( row ) );
+        else if ( mStorage == LongLongStorage )
+          longLongs.insert( mLongLongs.at( row ) );
+        else
+          doubles.insert( mDoubles.at( row ) );
+      }
+
+      for ( qlonglong v : qgsAsConst( longLongs ) )
+      {
+        if ( limit >= 0 && values.size() >= limit )
+          return;
+        values.insert( mStorage == IntStorage ? QVariant( static_cast< int >( v ) ) : QVariant( v ) );
+      }
+      for ( double v : qgsAsConst( doubles ) )
+      {
+        if ( limit >= 0 && values.size() >= limit )
+          return;
+        values.insert( v );
+      }
+      break;
+    }
+
+    case StringStorage:
+    {
+      // the dictionary only holds strings used by a row
+      for ( int code = 0; code < mDictionary.size(); ++code )
+      {
+        if ( limit >= 0 && values.size() >= limit )
+          return;
+        if ( mDictionaryRefs.at( code ) > 0 )
+          values.insert( mDictionary.at( code ) );
+      }
+      break;
+    }
+
+    case VariantStorage:
+    {
+      for ( int row = 0; row < mRowCount; ++row )
+      {
+        if ( limit >= 0 && values.size() >= limit )
+          return;
+        if ( !mInvalid.testBit( row ) )
+          values.insert( mVariants.at( row ) );
+      }
+      return;
+    }
+  }
+
+  if ( ( limit < 0 || values.size() < limit ) && mNulls.count( true ) > 0 )
+    values.insert( QVariant( mType ) );
+}
+
+QVariant QgsVectorLayerCacheColumn::minimumValue() const
+{
+  return minimumOrMaximumValue( true );
+}
+
+QVariant QgsVectorLayerCacheColumn::maximumValue() const
+{
+  return minimumOrMaximumValue( false );
+}
+
+template <typename T>
+static QVariant minimumOrMaximumOfArray( const QVector<T> &values, const QBitArray &skipped, bool minimum )
+{
+  bool found = false;
+  T result = T();
+  for ( int row = 0; row < values.size(); ++row )
+  {
+    if ( skipped.testBit( row ) )
+      continue;
+
+    const T v = values.at( row );
+    if ( !found || ( minimum ? v < result : v > result ) )
+    {
+      result = v;
+      found = true;
+    }
+  }
+  return found ? QVariant( result ) : QVariant();
+}
+
+QVariant QgsVectorLayerCacheColumn::minimumOrMaximumValue( bool minimum ) const
+{
+  const QBitArray skipped = mNulls | mInvalid;
+
+  switch ( mStorage )
+  {
+    case IntStorage:
+      return minimumOrMaximumOfArray( mInts, skipped, minimum );
+    case LongLongStorage:
+      return minimumOrMaximumOfArray( mLongLongs, skipped, minimum );
+    case DoubleStorage:
+      return minimumOrMaximumOfArray( mDoubles, skipped, minimum );
+
+    case StringStorage:
+    {
+      // each distinct string only needs to be compared once
+      QVariant result;
+      for ( int code = 0; code < mDictionary.size(); ++code )
+      {
+        if ( mDictionaryRefs.at( code ) == 0 )
+          continue;
+
+        const QVariant v( mDictionary.at( code ) );
+        if ( !result.isValid() || ( minimum ? qgsVariantLessThan( v, result ) : qgsVariantGreaterThan( v, result ) ) )
+          result = v;
+      }
+      return result;
+    }
+
+    case VariantStorage:
+    {
+      QVariant result;
+      for ( int row = 0; row < mRowCount; ++row )
+      {
+        const QVariant &v = mVariants.at( row );
+        if ( v.isNull() )
+          continue;
+
+        if ( !result.isValid() || ( minimum ? qgsVariantLessThan( v, result ) : qgsVariantGreaterThan( v, result ) ) )
+          result = v;
+      }
+      return result;
+    }
+  }
+  return QVariant();
+}
+
+int QgsVectorLayerCacheColumn::encodeString( const QString &string )
+{
+  int code = mDictionaryCodes.value( string, -1 );
+  if ( code < 0 )
+  {
+    if ( !mFreeCodes.isEmpty() )
+    {
+      code = mFreeCodes.takeLast();
+      mDictionary[code] = string;
+    }
+    else
+    {
+      code = mDictionary.size();
+      mDictionary.append( string );
+      mDictionaryRefs.append( 0 );
+    }
+    mDictionaryCodes.insert( string, code );
+  }
+  mDictionaryRefs[code]++;
+  return code;
+}
+
+void QgsVectorLayerCacheColumn::releaseString( int row )
+{
+  if ( mStorage != StringStorage || mInvalid.testBit( row ) || mNulls.testBit( row ) )
+    return;
+
+  const int code = mStringCodes.at( row );
+  if ( --mDictionaryRefs[code] == 0 )
+  {
+    mDictionaryCodes.remove( mDictionary.at( code ) );
+    mDictionary[code].clear();
+    mFreeCodes.append( code );
+  }
+}
+
+void QgsVectorLayerCacheColumn::convertToVariants()
+{
+  QVector<QVariant> variants( mRowCount );
+  for ( int row = 0; row < mRowCount; ++row )
+    variants[row] = value( row );
+
+  mInts = QVector<int>();
+  mLongLongs = QVector<qlonglong>();
+  mDoubles = QVector<double>();
+  mStringCodes = QVector<int>();
+  mDictionary = QStringList();
+  mDictionaryRefs = QVector<int>();
+  mDictionaryCodes = QHash<QString, int>();
+  mFreeCodes = QVector<int>();
+
+  mVariants = variants;
+  mNulls.fill( false );
+  mStorage = VariantStorage;
+}
+
+///@endcond
+
 QgsVectorLayerCache::QgsVectorLayerCache( QgsVectorLayer *layer, int cacheSize, QObject *parent )
   : QObject( parent )
   , mLayer( layer )
@@ -47,6 +407,10 @@ QgsVectorLayerCache::~QgsVectorLayerCache()
 {
   qDeleteAll( mCacheIndices );
   mCacheIndices.clear();
+
+  // cached features release their rows of the columns when deleted
+  mCache.clear();
+  qDeleteAll( mColumns );
 }
 
 void QgsVectorLayerCache::setCacheSize( int cacheSize )
@@ -81,6 +445,10 @@ void QgsVectorLayerCache::setCacheGeometry( bool cacheGeometry )
 void QgsVectorLayerCache::setCacheSubsetOfAttributes( const QgsAttributeList &attributes )
 {
   mCachedAttributes = attributes;
+
+  // the columns must match the cached attributes
+  if ( mColumnarStorage )
+    invalidate();
 }
 
 void QgsVectorLayerCache::setFullCache( bool fullCache )
@@ -154,7 +522,7 @@ bool QgsVectorLayerCache::featureAtId( QgsFeatureId featureId, QgsFeature &featu
 
   if ( cachedFeature )
   {
-    feature = QgsFeature( *cachedFeature->feature() );
+    feature = featureFromCache( cachedFeature );
     featureFound = true;
   }
   else if ( mLayer->getFeatures( QgsFeatureRequest()
@@ -230,7 +598,15 @@ void QgsVectorLayerCache::onAttributeValueChanged( QgsFeatureId fid, int field,
 
   if ( cachedFeat )
   {
-    cachedFeat->mFeature->setAttribute( field, value );
+    if ( cachedFeat->mRow >= 0 )
+    {
+      if ( QgsVectorLayerCacheColumn *column = mColumns.value( field ) )
+        column->setValue( cachedFeat->mRow, value );
+    }
+    else
+    {
+      cachedFeat->mFeature->setAttribute( field, value );
+    }
   }
 
   emit attributeValueChanged( fid, field, value );
@@ -297,6 +673,10 @@ void QgsVectorLayerCache::attributeDeleted( int field )
     else if ( attr > field )
       mCachedAttributes << attr - 1;
   }
+
+  // the columns are indexed by attribute
+  if ( mColumnarStorage )
+    invalidate();
 }
 
 void QgsVectorLayerCache::geometryChanged( QgsFeatureId fid, const QgsGeometry &geom )
@@ -318,10 +698,205 @@ void QgsVectorLayerCache::layerDeleted()
 void QgsVectorLayerCache::invalidate()
 {
   mCache.clear();
+  resetColumns();
   mFullCache = false;
   emit invalidated();
 }
 
+void QgsVectorLayerCache::setColumnarStorage( bool columnar )
+{
+  if ( columnar == mColumnarStorage )
+    return;
+
+  mColumnarStorage = columnar;
+  invalidate();
+}
+
+QHash<QgsFeatureId, QVariant> QgsVectorLayerCache::cachedAttributeValues( int index ) const
+{
+  QHash<QgsFeatureId, QVariant> values;
+  if ( !mCachedAttributes.contains( index ) )
+    return values;
+
+  values.reserve( mCache.size() );
+  if ( mColumnarStorage )
+  {
+    const QgsVectorLayerCacheColumn *column = mColumns.value( index );
+    if ( !column )
+      return values;
+
+    for ( int row = 0; row < mRowFeatureIds.size(); ++row )
+    {
+      const QgsFeatureId fid = mRowFeatureIds.at( row );
+      if ( fid != FREE_ROW )
+        values.insert( fid, column->value( row ) );
+    }
+  }
+  else
+  {
+    const QList<QgsFeatureId> fids = mCache.keys();
+    for ( QgsFeatureId fid : fids )
+    {
+      values.insert( fid, mCache.object( fid )->mFeature->attribute( index ) );
+    }
+  }
+  return values;
+}
+
+QSet<QVariant> QgsVectorLayerCache::uniqueValues( int index, int limit ) const
+{
+  if ( !mFullCache || !mCachedAttributes.contains( index ) )
+    return mLayer->uniqueValues( index, limit );
+
+  QSet<QVariant> values;
+  if ( mColumnarStorage )
+  {
+    if ( const QgsVectorLayerCacheColumn *column = mColumns.value( index ) )
+      column->uniqueValues( values, limit );
+  }
+  else
+  {
+    const QList<QgsFeatureId> fids = mCache.keys();
+    for ( QgsFeatureId fid : fids )
+    {
+      if ( limit >= 0 && values.size() >= limit )
+        break;
+      values.insert( mCache.object( fid )->mFeature->attribute( index ) );
+    }
+  }
+  return values;
+}
+
+QVariant QgsVectorLayerCache::minimumValue( int index ) const
+{
+  if ( !mFullCache || !mCachedAttributes.contains( index ) )
+    return mLayer->minimumValue( index );
+
+  if ( mColumnarStorage )
+  {
+    const QgsVectorLayerCacheColumn *column = mColumns.value( index );
+    return column ? column->minimumValue() : QVariant();
+  }
+
+  QVariant minimum;
+  const QList<QgsFeatureId> fids = mCache.keys();
+  for ( QgsFeatureId fid : fids )
+  {
+    const QVariant v = mCache.object( fid )->mFeature->attribute( index );
+    if ( !v.isNull() && ( !minimum.isValid() || qgsVariantLessThan( v, minimum ) ) )
+      minimum = v;
+  }
+  return minimum;
+}
+
+QVariant QgsVectorLayerCache::maximumValue( int index ) const
+{
+  if ( !mFullCache || !mCachedAttributes.contains( index ) )
+    return mLayer->maximumValue( index );
+
+  if ( mColumnarStorage )
+  {
+    const QgsVectorLayerCacheColumn *column = mColumns.value( index );
+    return column ? column->maximumValue() : QVariant();
+  }
+
+  QVariant maximum;
+  const QList<QgsFeatureId> fids = mCache.keys();
+  for ( QgsFeatureId fid : fids )
+  {
+    const QVariant v = mCache.object( fid )->mFeature->attribute( index );
+    if ( !v.isNull() && ( !maximum.isValid() || qgsVariantGreaterThan( v, maximum ) ) )
+      maximum = v;
+  }
+  return maximum;
+}
+
+void QgsVectorLayerCache::cacheFeature( QgsFeature &feat )
+{
+  QgsCachedFeature *cachedFeature = new QgsCachedFeature( feat, this );
+
+  if ( mColumnarStorage )
+  {
+    // the attributes are moved to the columns, the cached feature only keeps id and geometry
+    const QgsAttributes attributes = feat.attributes();
+    cachedFeature->mAttributeCount = attributes.size();
+    cachedFeature->mRow = allocateRow( feat.id() );
+    for ( auto it = mColumns.constBegin(); it != mColumns.constEnd(); ++it )
+    {
+      if ( it.key() < attributes.size() )
+        it.value()->setValue( cachedFeature->mRow, attributes.at( it.key() ) );
+    }
+    cachedFeature->mFeature->setAttributes( QgsAttributes() );
+  }
+
+  mCache.insert( feat.id(), cachedFeature );
+}
+
+QgsFeature QgsVectorLayerCache::featureFromCache( const QgsCachedFeature *cachedFeature ) const
+{
+  QgsFeature feature( *cachedFeature->mFeature );
+  if ( cachedFeature->mRow >= 0 )
+  {
+    QgsAttributes attributes( cachedFeature->mAttributeCount );
+    for ( auto it = mColumns.constBegin(); it != mColumns.constEnd(); ++it )
+    {
+      if ( it.key() < attributes.size() )
+        attributes[it.key()] = it.value()->value( cachedFeature->mRow );
+    }
+    feature.setAttributes( attributes );
+  }
+  return feature;
+}
+
+int QgsVectorLayerCache::allocateRow( QgsFeatureId fid )
+{
+  if ( !mFreeRows.isEmpty() )
+  {
+    const int row = mFreeRows.takeLast();
+    mRowFeatureIds[row] = fid;
+    return row;
+  }
+
+  const int row = mRowFeatureIds.size();
+  mRowFeatureIds.append( fid );
+
+  // grow the columns geometrically, unused rows have no value
+  for ( QgsVectorLayerCacheColumn *column : qgsAsConst( mColumns ) )
+  {
+    if ( row >= column->rowCount() )
+      column->resize( std::max( 64, column->rowCount() * 2 ) );
+  }
+  return row;
+}
+
+void QgsVectorLayerCache::releaseRow( int row )
+{
+  for ( QgsVectorLayerCacheColumn *column : qgsAsConst( mColumns ) )
+  {
+    column->clearValue( row );
+  }
+  mRowFeatureIds[row] = FREE_ROW;
+  mFreeRows.append( row );
+}
+
+void QgsVectorLayerCache::resetColumns()
+{
+  qDeleteAll( mColumns );
+  mColumns.clear();
+  mRowFeatureIds.clear();
+  mFreeRows.clear();
+
+  if ( !mColumnarStorage || !mLayer )
+    return;
+
+  const QgsFields fields = mLayer->fields();
+  for ( int attr : qgsAsConst( mCachedAttributes ) )
+  {
+    if ( attr >= 0 && attr < fields.count() )
+      mColumns.insert( attr, new QgsVectorLayerCacheColumn( fields.at( attr ).type() ) );
+  }
+}
+
 bool QgsVectorLayerCache::canUseCacheForRequest( const QgsFeatureRequest &featureRequest, QgsFeatureIterator &it )
 {
   // check first for available indices
@@ -28,6 +28,7 @@
 
 class QgsCachedFeatureIterator;
 class QgsAbstractCacheIndex;
+class QgsVectorLayerCacheColumn;
 
 /**
  * \ingroup core
@@ -37,6 +38,11 @@ class QgsAbstractCacheIndex;
  * The cached features can be indexed by QgsAbstractCacheIndex.
  *
  * Proper indexing for a given use-case may speed up performance substantially.
+ *
+ * With columnar storage (see setColumnarStorage()), the attributes of the cached features are
+ * stored column by column in typed arrays instead of in a copy of each feature. This needs
+ * much less memory for large tables and allows to scan the values of an attribute without
+ * building features, see cachedAttributeValues(), uniqueValues(), minimumValue() and maximumValue().
  */
 
 class CORE_EXPORT QgsVectorLayerCache : public QObject
@@ -71,6 +77,8 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
           // That's the reason we need this wrapper:
           // Inform the cache that this feature has been removed
           mCache->featureRemoved( mFeature->id() );
+          if ( mRow >= 0 )
+            mCache->releaseRow( mRow );
           delete mFeature;
         }
 
@@ -80,6 +88,12 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
         QgsFeature *mFeature = nullptr;
         QgsVectorLayerCache *mCache = nullptr;
 
+        //! Row of the attributes in the columns of the cache when using columnar storage, otherwise -1
+        int mRow = -1;
+
+        //! Number of attributes of the feature when using columnar storage
+        int mAttributeCount = 0;
+
         friend class QgsVectorLayerCache;
         Q_DISABLE_COPY( QgsCachedFeature )
     };
@@ -159,6 +173,60 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
      */
     bool hasFullCache() const { return mFullCache; }
 
+    /**
+     * Sets whether the attributes of cached features are stored column by column.
+     *
+     * Columnar storage keeps the values of each cached attribute in a typed array, with strings
+     * dictionary encoded and null values tracked in bitmaps, instead of keeping a copy of the
+     * attributes of each feature. Changing the storage mode invalidates the cache.
+     *
+     * \see columnarStorage()
+     * \since QGIS 3.0
+     */
+    void setColumnarStorage( bool columnar );
+
+    /**
+     * Returns true if the attributes of cached features are stored column by column. Defaults to false.
+     * \see setColumnarStorage()
+     * \since QGIS 3.0
+     */
+    bool columnarStorage() const { return mColumnarStorage; }
+
+    /**
+     * Returns the values of the attribute at \a index of all cached features, by feature id.
+     * With columnar storage the values are read from the attribute's column without building features.
+     * Returns an empty hash if the attribute is not cached.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QHash<QgsFeatureId, QVariant> cachedAttributeValues( int index ) const SIP_SKIP;
+
+    /**
+     * Returns the unique values of the attribute at \a index, up to \a limit values if it is not -1.
+     * If the cache holds all features and the attribute is cached, the values are read from the cache,
+     * otherwise the layer is queried (see QgsVectorLayer::uniqueValues()).
+     * \since QGIS 3.0
+     */
+    QSet<QVariant> uniqueValues( int index, int limit = -1 ) const;
+
+    /**
+     * Returns the minimum value of the attribute at \a index. If the cache holds all features and
+     * the attribute is cached, the value is computed from the cache, otherwise the layer is queried
+     * (see QgsVectorLayer::minimumValue()).
+     * \see maximumValue()
+     * \since QGIS 3.0
+     */
+    QVariant minimumValue( int index ) const;
+
+    /**
+     * Returns the maximum value of the attribute at \a index. If the cache holds all features and
+     * the attribute is cached, the value is computed from the cache, otherwise the layer is queried
+     * (see QgsVectorLayer::maximumValue()).
+     * \see minimumValue()
+     * \since QGIS 3.0
+     */
+    QVariant maximumValue( int index ) const;
+
     /**
      * \brief
      * Adds a QgsAbstractCacheIndex to this cache. Cache indices know about features present
@@ -380,11 +448,19 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
 
     void connectJoinedLayers() const;
 
-    inline void cacheFeature( QgsFeature &feat )
-    {
-      QgsCachedFeature *cachedFeature = new QgsCachedFeature( feat, this );
-      mCache.insert( feat.id(), cachedFeature );
-    }
+    void cacheFeature( QgsFeature &feat );
+
+    //! Returns a copy of a cached feature, with its attributes read from the columns when using columnar storage
+    QgsFeature featureFromCache( const QgsCachedFeature *cachedFeature ) const;
+
+    //! Returns a free row of the columns for the feature \a fid
+    int allocateRow( QgsFeatureId fid );
+
+    //! Clears the values of \a row in all columns and makes it available to other features
+    void releaseRow( int row );
+
+    //! Recreates empty columns for the cached attributes when using columnar storage, must only be called when the cache is empty
+    void resetColumns();
 
     QgsVectorLayer *mLayer = nullptr;
     QCache< QgsFeatureId, QgsCachedFeature > mCache;
@@ -395,6 +471,17 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
 
     QgsAttributeList mCachedAttributes;
 
+    bool mColumnarStorage = false;
+
+    //! Columns of the cached attributes by attribute index, when using columnar storage
+    QHash<int, QgsVectorLayerCacheColumn *> mColumns;
+
+    //! Feature ids by row of the columns
+    QVector<QgsFeatureId> mRowFeatureIds;
+
+    //! Rows of the columns which are not used by any feature
+    QVector<int> mFreeRows;
+
     friend class QgsCachedFeatureIterator;
     friend class QgsCachedFeatureWriterIterator;
     friend class QgsCachedFeature;
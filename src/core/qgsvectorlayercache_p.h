@@ -0,0 +1,127 @@
+/***************************************************************************
+  qgsvectorlayercache_p.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSVECTORLAYERCACHE_PRIVATE_H
+#define QGSVECTORLAYERCACHE_PRIVATE_H
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#define SIP_NO_FILE
+
+#include <QBitArray>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * Stores the values of one attribute of the features held by a QgsVectorLayerCache in
+ * columnar storage mode. Each cached feature is assigned a row, which is the same in all
+ * columns of the cache.
+ *
+ * Values of integer, double and string fields are kept in typed arrays, with strings being
+ * dictionary encoded. Null values and rows without a value are tracked in bitmaps. A value
+ * which cannot be stored in the typed array without changing it (e.g. a value of a different
+ * type than the field) converts the column to an array of variants, so that values are always
+ * returned exactly as they were set.
+ */
+class QgsVectorLayerCacheColumn
+{
+  public:
+
+    //! Constructs a column for values of the specified field \a type
+    explicit QgsVectorLayerCacheColumn( QVariant::Type type = QVariant::Invalid );
+
+    //! Returns the number of rows of the column
+    int rowCount() const { return mRowCount; }
+
+    //! Resizes the column to \a rowCount rows, new rows have no value
+    void resize( int rowCount );
+
+    //! Sets the value of \a row
+    void setValue( int row, const QVariant &value );
+
+    //! Returns the value of \a row, or an invalid variant if the row has no value
+    QVariant value( int row ) const;
+
+    //! Removes the value of \a row
+    void clearValue( int row );
+
+    //! Adds the distinct values of the column to \a values, until \a values holds \a limit values (if limit is not -1)
+    void uniqueValues( QSet<QVariant> &values, int limit = -1 ) const;
+
+    //! Returns the smallest non null value of the column, or an invalid variant if there is none
+    QVariant minimumValue() const;
+
+    //! Returns the largest non null value of the column, or an invalid variant if there is none
+    QVariant maximumValue() const;
+
+  private:
+
+    enum Storage
+    {
+      IntStorage,
+      LongLongStorage,
+      DoubleStorage,
+      StringStorage,
+      VariantStorage,
+    };
+
+    QVariant::Type mType = QVariant::Invalid;
+    Storage mStorage = VariantStorage;
+    int mRowCount = 0;
+
+    QVector<int> mInts;
+    QVector<qlonglong> mLongLongs;
+    QVector<double> mDoubles;
+    QVector<QVariant> mVariants;
+
+    //! Dictionary codes of the strings of the rows
+    QVector<int> mStringCodes;
+    //! Strings by dictionary code
+    QStringList mDictionary;
+    //! Number of rows using each dictionary code, codes which are not used any more are reused
+    QVector<int> mDictionaryRefs;
+    //! Dictionary codes by string
+    QHash<QString, int> mDictionaryCodes;
+    QVector<int> mFreeCodes;
+
+    //! Rows holding a null value of the column type
+    QBitArray mNulls;
+    //! Rows without a value (an invalid variant)
+    QBitArray mInvalid;
+
+    //! Returns the dictionary code of \a string, adding it to the dictionary if needed
+    int encodeString( const QString &string );
+    //! Releases the string of \a row if the column is dictionary encoded
+    void releaseString( int row );
+    //! Converts the column to an array of variants
+    void convertToVariants();
+    //! Returns the smallest or largest non null value of the column
+    QVariant minimumOrMaximumValue( bool minimum ) const;
+};
+
+/// @endcond
+
+#endif // QGSVECTORLAYERCACHE_PRIVATE_H
@@ -35,6 +35,7 @@
 #include "qgsexception.h"
 #include "qgslogger.h"
 #include "qgssettings.h"
+#include "qgsruntimeprofiler.h"
 
 #include <QPicture>
 
@@ -261,7 +262,7 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
   mContext.expressionContext().appendScope( symbolScope );
 
   QgsFeature fet;
-  while ( fit.nextFeature( fet ) )
+  while ( nextFeature( fit, fet ) )
   {
     try
     {
@@ -280,7 +281,11 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
       bool drawMarker = ( mDrawVertexMarkers && mContext.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
 
       // render feature
-      bool rendered = mRenderer->renderFeature( fet, mContext, -1, sel, drawMarker );
+      bool rendered = false;
+      {
+        QgsScopedRuntimeProfile profile( mContext.profiler(), QStringLiteral( "draw" ) );
+        rendered = mRenderer->renderFeature( fet, mContext, -1, sel, drawMarker );
+      }
 
       // labeling - register feature
       if ( rendered )
@@ -288,6 +293,7 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
         // new labeling engine
         if ( mContext.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
         {
+          QgsScopedRuntimeProfile profile( mContext.profiler(), QStringLiteral( "labeling" ) );
           QgsGeometry obstacleGeometry;
           QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( fet, mContext );
 
@@ -343,7 +349,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
 
   // 1. fetch features
   QgsFeature fet;
-  while ( fit.nextFeature( fet ) )
+  while ( nextFeature( fit, fet ) )
   {
     if ( mContext.renderingStopped() )
     {
@@ -372,6 +378,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
     // new labeling engine
     if ( mContext.labelingEngine() )
     {
+      QgsScopedRuntimeProfile profile( mContext.profiler(), QStringLiteral( "labeling" ) );
       QgsGeometry obstacleGeometry;
       QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( fet, mContext );
 
@@ -447,6 +454,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
 
         try
         {
+          QgsScopedRuntimeProfile profile( mContext.profiler(), QStringLiteral( "draw" ) );
           mRenderer->renderFeature( *fit, mContext, layer, sel, drawMarker );
         }
         catch ( const QgsCsException &cse )
@@ -463,6 +471,24 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
 }
 
 
+bool QgsVectorLayerRenderer::nextFeature( QgsFeatureIterator &fit, QgsFeature &feature )
+{
+  QgsRuntimeProfiler *profiler = mContext.profiler();
+  if ( !profiler )
+    return fit.nextFeature( feature );
+
+  {
+    QgsScopedRuntimeProfile profile( profiler, QStringLiteral( "fetch" ) );
+    if ( !fit.nextFeature( feature ) )
+      return false;
+  }
+
+  profiler->addCount( QStringLiteral( "features" ) );
+  if ( feature.hasGeometry() )
+    profiler->addCount( QStringLiteral( "vertices" ), feature.geometry().geometry()->nCoordinates() );
+  return true;
+}
+
 void QgsVectorLayerRenderer::stopRenderer( QgsSingleSymbolRenderer *selRenderer )
 {
   mRenderer->stopRender( mContext );
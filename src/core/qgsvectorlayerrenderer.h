@@ -98,6 +98,9 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
     //! Stop version 2 renderer and selected renderer (if required)
     void stopRenderer( QgsSingleSymbolRenderer *selRenderer );
 
+    //! Fetches the next feature, recording the time and feature counts in the context's profiler (if any)
+    bool nextFeature( QgsFeatureIterator &fit, QgsFeature &feature );
+
 
   protected:
 
@@ -393,7 +393,10 @@ bool QgsRuleBasedRenderer::Rule::startRender( QgsRenderContext &context, const Q
 
   // init this rule
   if ( mFilter )
+  {
     mFilter->prepare( &context.expressionContext() );
+    mFilter->compile();
+  }
   if ( mSymbol )
     mSymbol->startRender( context, fields );
 
@@ -820,7 +823,10 @@ bool QgsRuleBasedRenderer::renderFeature( QgsFeature &feature,
   mCurrentFeatures.append( FeatureToRender( feature, flags ) );
 
   // check each active rule
-  return mRootRule->renderFeature( mCurrentFeatures.last(), context, mRenderQueue ) == Rule::Rendered;
+  mSharedValues.startFeature();
+  const bool rendered = mRootRule->renderFeature( mCurrentFeatures.last(), context, mRenderQueue ) == Rule::Rendered;
+  mSharedValues.endFeature();
+  return rendered;
 }
 
 
@@ -829,6 +835,14 @@ void QgsRuleBasedRenderer::startRender( QgsRenderContext &context, const QgsFiel
   // prepare active children
   mRootRule->startRender( context, fields, mFilter );
 
+  // the filters of all rules are evaluated for the same feature, let them share identical subexpressions
+  const RuleList rules = mRootRule->descendants();
+  for ( Rule *rule : rules )
+  {
+    if ( rule->filter() && rule->filter()->isCompiled() )
+      rule->filter()->compile( &mSharedValues );
+  }
+
   QSet<int> symbolZLevelsSet = mRootRule->collectZLevels();
   QList<int> symbolZLevels = symbolZLevelsSet.toList();
   std::sort( symbolZLevels.begin(), symbolZLevels.end() );
@@ -1144,22 +1158,34 @@ QString QgsRuleBasedRenderer::dump() const
 
 bool QgsRuleBasedRenderer::willRenderFeature( QgsFeature &feat, QgsRenderContext &context )
 {
-  return mRootRule->willRenderFeature( feat, &context );
+  mSharedValues.startFeature();
+  const bool willRender = mRootRule->willRenderFeature( feat, &context );
+  mSharedValues.endFeature();
+  return willRender;
 }
 
 QgsSymbolList QgsRuleBasedRenderer::symbolsForFeature( QgsFeature &feat, QgsRenderContext &context )
 {
-  return mRootRule->symbolsForFeature( feat, &context );
+  mSharedValues.startFeature();
+  const QgsSymbolList symbols = mRootRule->symbolsForFeature( feat, &context );
+  mSharedValues.endFeature();
+  return symbols;
 }
 
 QgsSymbolList QgsRuleBasedRenderer::originalSymbolsForFeature( QgsFeature &feat, QgsRenderContext &context )
 {
-  return mRootRule->symbolsForFeature( feat, &context );
+  mSharedValues.startFeature();
+  const QgsSymbolList symbols = mRootRule->symbolsForFeature( feat, &context );
+  mSharedValues.endFeature();
+  return symbols;
 }
 
 QSet< QString > QgsRuleBasedRenderer::legendKeysForFeature( QgsFeature &feature, QgsRenderContext &context )
 {
-  return mRootRule->legendKeysForFeature( feature, &context );
+  mSharedValues.startFeature();
+  const QSet< QString > keys = mRootRule->legendKeysForFeature( feature, &context );
+  mSharedValues.endFeature();
+  return keys;
 }
 
 QgsRuleBasedRenderer *QgsRuleBasedRenderer::convertFromRenderer( const QgsFeatureRenderer *renderer )
@@ -21,6 +21,7 @@
 #include "qgsfields.h"
 #include "qgsfeature.h"
 #include "qgis.h"
+#include "qgsexpressionprogram.h"
 
 #include "qgsrenderer.h"
 
@@ -524,6 +525,10 @@ class CORE_EXPORT QgsRuleBasedRenderer : public QgsFeatureRenderer
     QString mFilter;
 
   private:
+
+    //! Values of the subexpressions shared by the filters of the rules, for the feature being rendered
+    QgsExpressionValueCache mSharedValues;
+
 #ifdef SIP_RUN
     QgsRuleBasedRenderer( const QgsRuleBasedRenderer & );
     QgsRuleBasedRenderer &operator=( const QgsRuleBasedRenderer & );
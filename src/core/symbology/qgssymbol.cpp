@@ -39,6 +39,7 @@
 #include "qgspolygon.h"
 #include "qgsclipper.h"
 #include "qgsproperty.h"
+#include "qgsruntimeprofiler.h"
 
 #include <QColor>
 #include <QImage>
@@ -110,11 +111,16 @@ QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &
   //apply clipping for large lines to achieve a better rendering performance
   if ( clipToExtent && nPoints > 1 )
   {
+    QgsScopedRuntimeProfile profile( context.profiler(), QStringLiteral( "clip" ) );
     const QgsRectangle &e = context.extent();
     const double cw = e.width() / 10;
     const double ch = e.height() / 10;
     const QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
-    pts = QgsClipper::clippedLine( curve, clipRect );
+    // lines completely within the clip rectangle can skip the per-segment clipping
+    if ( clipRect.contains( curve.boundingBox() ) )
+      pts = curve.asQPolygonF();
+    else
+      pts = QgsClipper::clippedLine( curve, clipRect );
   }
   else
   {
@@ -122,16 +128,13 @@ QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &
   }
 
   //transform the QPolygonF to screen coordinates
+  QgsScopedRuntimeProfile profile( context.profiler(), QStringLiteral( "transform" ) );
   if ( ct.isValid() )
   {
     ct.transformPolygon( pts );
   }
 
-  QPointF *ptr = pts.data();
-  for ( int i = 0; i < pts.size(); ++i, ++ptr )
-  {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
-  }
+  mtp.transformInPlace( pts );
 
   return pts;
 }
@@ -154,20 +157,18 @@ QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve
   const QRectF ptsRect = poly.boundingRect();
   if ( clipToExtent && !context.extent().contains( ptsRect ) )
   {
+    QgsScopedRuntimeProfile profile( context.profiler(), QStringLiteral( "clip" ) );
     QgsClipper::trimPolygon( poly, clipRect );
   }
 
   //transform the QPolygonF to screen coordinates
+  QgsScopedRuntimeProfile profile( context.profiler(), QStringLiteral( "transform" ) );
   if ( ct.isValid() )
   {
     ct.transformPolygon( poly );
   }
 
-  QPointF *ptr = poly.data();
-  for ( int i = 0; i < poly.size(); ++i, ++ptr )
-  {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
-  }
+  mtp.transformInPlace( poly );
 
   return poly;
 }
@@ -723,6 +724,7 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
   // Simplify the geometry, if needed.
   if ( context.vectorSimplifyMethod().forceLocalOptimization() )
   {
+    QgsScopedRuntimeProfile profile( context.profiler(), QStringLiteral( "simplify" ) );
     const int simplifyHints = context.vectorSimplifyMethod().simplifyHints();
     const QgsMapToPixelSimplifier simplifier( simplifyHints, context.vectorSimplifyMethod().tolerance(),
         static_cast< QgsMapToPixelSimplifier::SimplifyAlgorithm >( context.vectorSimplifyMethod().simplifyAlgorithm() ) );
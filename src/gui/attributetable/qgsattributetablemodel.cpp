@@ -853,6 +853,23 @@ void QgsAttributeTableModel::prefetchSortData( const QString &expressionString )
     widgetCache = mAttributeWidgetCaches.at( mSortFieldIndex );
     widgetConfig = mWidgetConfigs.at( mSortFieldIndex );
     fieldFormatter = mFieldFormatters.at( mSortFieldIndex );
+
+    // sorting by a field of a fully cached layer can read the values straight from the cache
+    if ( mLayerCache->hasFullCache()
+         && mFeatureRequest.filterType() == QgsFeatureRequest::FilterNone
+         && mFeatureRequest.filterRect().isNull() )
+    {
+      const QHash<QgsFeatureId, QVariant> values = mLayerCache->cachedAttributeValues( mSortFieldIndex );
+      if ( !values.isEmpty() )
+      {
+        mSortCache.reserve( values.size() );
+        for ( auto it = values.constBegin(); it != values.constEnd(); ++it )
+        {
+          mSortCache.insert( it.key(), fieldFormatter->sortValue( layer(), mSortFieldIndex, widgetConfig, widgetCache, it.value() ) );
+        }
+        return;
+      }
+    }
   }
 
   QgsFeatureRequest request = QgsFeatureRequest( mFeatureRequest )
@@ -269,6 +269,7 @@ void QgsDualView::initLayerCache( bool cacheGeometry )
   QgsSettings settings;
   int cacheSize = settings.value( QStringLiteral( "qgis/attributeTableRowCache" ), "10000" ).toInt();
   mLayerCache = new QgsVectorLayerCache( mLayer, cacheSize, this );
+  mLayerCache->setColumnarStorage( settings.value( QStringLiteral( "qgis/attributeTableColumnarCache" ), true ).toBool() );
   mLayerCache->setCacheGeometry( cacheGeometry );
   if ( 0 == cacheSize || 0 == ( QgsVectorDataProvider::SelectAtId & mLayer->dataProvider()->capabilities() ) )
   {
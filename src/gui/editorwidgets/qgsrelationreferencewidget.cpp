@@ -471,6 +471,47 @@ void QgsRelationReferenceWidget::init()
 
     QgsVectorLayerCache *layerCache = new QgsVectorLayerCache( mReferencedLayer, 100000, this );
 
+    // Request the filter attributes for caching
+    Q_FOREACH ( const QString &fieldName, mFilterFields )
+    {
+      if ( mReferencedLayer->fields().lookupField( fieldName ) != -1 )
+        requestedAttrs << fieldName;
+    }
+
+    QgsExpression displayExpression( mReferencedLayer->displayExpression() );
+
+    requestedAttrs += displayExpression.referencedColumns();
+    requestedAttrs << mRelation.fieldPairs().at( 0 ).second;
+
+    Q_FOREACH ( const QgsConditionalStyle &style, mReferencedLayer->conditionalStyles()->rowStyles() )
+    {
+      QgsExpression exp( style.rule() );
+      requestedAttrs += exp.referencedColumns();
+    }
+
+    if ( displayExpression.isField() )
+    {
+      Q_FOREACH ( const QgsConditionalStyle &style, mReferencedLayer->conditionalStyles()->fieldStyles( *displayExpression.referencedColumns().constBegin() ) )
+      {
+        QgsExpression exp( style.rule() );
+        requestedAttrs += exp.referencedColumns();
+      }
+    }
+
+    QgsAttributeList attributes;
+    Q_FOREACH ( const QString &attr, requestedAttrs )
+      attributes << mReferencedLayer->fields().lookupField( attr );
+
+    layerCache->setCacheSubsetOfAttributes( attributes );
+    mMasterModel = new QgsAttributeTableModel( layerCache, this );
+    mMasterModel->setRequest( QgsFeatureRequest().setFlags( QgsFeatureRequest::NoGeometry ).setSubsetOfAttributes( requestedAttrs, mReferencedLayer->fields() ) );
+    mFilterModel = new QgsAttributeTableFilterModel( mCanvas, mMasterModel, mMasterModel );
+    mFeatureListModel = new QgsFeatureListModel( mFilterModel, this );
+    mFeatureListModel->setDisplayExpression( mReferencedLayer->displayExpression() );
+
+    mMasterModel->loadLayer();
+
+    // The values of the filters are read from the loaded cache
     if ( !mFilterFields.isEmpty() )
     {
       Q_FOREACH ( const QString &fieldName, mFilterFields )
@@ -484,7 +525,7 @@ void QgsRelationReferenceWidget::init()
         cb->setProperty( "Field", fieldName );
         cb->setProperty( "FieldAlias", mReferencedLayer->attributeDisplayName( idx ) );
         mFilterComboBoxes << cb;
-        QVariantList uniqueValues = mReferencedLayer->uniqueValues( idx ).toList();
+        QVariantList uniqueValues = layerCache->uniqueValues( idx ).toList();
         cb->addItem( mReferencedLayer->attributeDisplayName( idx ) );
         QVariant nullValue = QgsApplication::nullRepresentation();
         cb->addItem( nullValue.toString(), QVariant( mReferencedLayer->fields().at( idx ).type() ) );
@@ -497,9 +538,6 @@ void QgsRelationReferenceWidget::init()
 
         connect( cb, static_cast<void ( QComboBox::* )( int )>( &QComboBox::currentIndexChanged ), this, &QgsRelationReferenceWidget::filterChanged );
 
-        // Request this attribute for caching
-        requestedAttrs << fieldName;
-
         mFilterLayout->addWidget( cb );
       }
 
@@ -508,7 +546,7 @@ void QgsRelationReferenceWidget::init()
         QVariant nullValue = QgsApplication::nullRepresentation();
 
         QgsFeature ft;
-        QgsFeatureIterator fit = layerCache->getFeatures();
+        QgsFeatureIterator fit = layerCache->getFeatures( QgsFeatureRequest().setFlags( QgsFeatureRequest::NoGeometry ).setSubsetOfAttributes( mFilterFields, mReferencedLayer->fields() ) );
         while ( fit.nextFeature( ft ) )
         {
           for ( int i = 0; i < mFilterComboBoxes.count() - 1; ++i )
@@ -534,39 +572,6 @@ void QgsRelationReferenceWidget::init()
       mFilterContainer->hide();
     }
 
-    QgsExpression displayExpression( mReferencedLayer->displayExpression() );
-
-    requestedAttrs += displayExpression.referencedColumns();
-    requestedAttrs << mRelation.fieldPairs().at( 0 ).second;
-
-    Q_FOREACH ( const QgsConditionalStyle &style, mReferencedLayer->conditionalStyles()->rowStyles() )
-    {
-      QgsExpression exp( style.rule() );
-      requestedAttrs += exp.referencedColumns();
-    }
-
-    if ( displayExpression.isField() )
-    {
-      Q_FOREACH ( const QgsConditionalStyle &style, mReferencedLayer->conditionalStyles()->fieldStyles( *displayExpression.referencedColumns().constBegin() ) )
-      {
-        QgsExpression exp( style.rule() );
-        requestedAttrs += exp.referencedColumns();
-      }
-    }
-
-    QgsAttributeList attributes;
-    Q_FOREACH ( const QString &attr, requestedAttrs )
-      attributes << mReferencedLayer->fields().lookupField( attr );
-
-    layerCache->setCacheSubsetOfAttributes( attributes );
-    mMasterModel = new QgsAttributeTableModel( layerCache, this );
-    mMasterModel->setRequest( QgsFeatureRequest().setFlags( QgsFeatureRequest::NoGeometry ).setSubsetOfAttributes( requestedAttrs, mReferencedLayer->fields() ) );
-    mFilterModel = new QgsAttributeTableFilterModel( mCanvas, mMasterModel, mMasterModel );
-    mFeatureListModel = new QgsFeatureListModel( mFilterModel, this );
-    mFeatureListModel->setDisplayExpression( mReferencedLayer->displayExpression() );
-
-    mMasterModel->loadLayer();
-
     mFeatureListModel->setInjectNull( mAllowNull );
     if ( mOrderByValue )
     {
@@ -53,6 +53,7 @@ email                : sherman at mrcc.com
 #include "qgsmaptopixel.h"
 #include "qgsmapoverviewcanvas.h"
 #include "qgsmaprenderercache.h"
+#include "qgslabelplacementcache.h"
 #include "qgsmaprenderercustompainterjob.h"
 #include "qgsmaprendererparalleljob.h"
 #include "qgsmaprenderersequentialjob.h"
@@ -222,6 +223,7 @@ QgsMapCanvas::~QgsMapCanvas()
   // CanvasProperties struct has its own dtor for freeing resources
 
   delete mCache;
+  delete mLabelPlacementCache;
 
   delete mLabelingResults;
 
@@ -411,11 +413,19 @@ void QgsMapCanvas::setCachingEnabled( bool enabled )
   if ( enabled )
   {
     mCache = new QgsMapRendererCache;
+    mLabelPlacementCache = new QgsLabelPlacementCache;
+
+    // optionally keep images of previous renders, e.g. for panning back
+    QgsSettings settings;
+    mCache->setMaximumStoredImages( settings.value( QStringLiteral( "Map/rendererCacheStoredImages" ), 0 ).toInt() );
+    mCache->setStorageDirectory( settings.value( QStringLiteral( "Map/rendererCacheDirectory" ), QString() ).toString() );
   }
   else
   {
     delete mCache;
     mCache = nullptr;
+    delete mLabelPlacementCache;
+    mLabelPlacementCache = nullptr;
   }
 }
 
@@ -428,6 +438,8 @@ void QgsMapCanvas::clearCache()
 {
   if ( mCache )
     mCache->clear();
+  if ( mLabelPlacementCache )
+    mLabelPlacementCache->clear();
 }
 
 void QgsMapCanvas::setParallelRenderingEnabled( bool enabled )
@@ -523,6 +535,11 @@ void QgsMapCanvas::refreshMap()
     mJob = new QgsMapRendererSequentialJob( mSettings );
   connect( mJob, &QgsMapRendererJob::finished, this, &QgsMapCanvas::rendererJobFinished );
   mJob->setCache( mCache );
+  mJob->setLabelPlacementCache( mLabelPlacementCache );
+
+  // the phases of rendering are logged together with the refresh time
+  QgsSettings settings;
+  mJob->setProfilingEnabled( settings.value( QStringLiteral( "Map/logCanvasRefreshEvent" ), false ).toBool() );
 
   mJob->start();
 
@@ -593,6 +610,8 @@ void QgsMapCanvas::rendererJobFinished()
     {
       QString logMsg = tr( "Canvas refresh: %1 ms" ).arg( mJob->renderingTime() );
       QgsMessageLog::logMessage( logMsg, tr( "Rendering" ) );
+      if ( mJob->isProfilingEnabled() )
+        QgsMessageLog::logMessage( mJob->profile().toJson(), tr( "Rendering" ) );
     }
 
     if ( mDrawRenderingStats )
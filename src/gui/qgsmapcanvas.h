@@ -57,6 +57,7 @@ class QgsVectorLayer;
 
 class QgsLabelingResults;
 class QgsMapRendererCache;
+class QgsLabelPlacementCache;
 class QgsMapRendererQImageJob;
 class QgsMapSettings;
 class QgsMapCanvasMap;
@@ -140,7 +141,8 @@ class GUI_EXPORT QgsMapCanvas : public QGraphicsView
     const QgsLabelingResults *labelingResults() const;
 
     /**
-     * Set whether to cache images of rendered layers
+     * Set whether to cache images of rendered layers. When enabled, label
+     * placements are also kept between renders at the same scale.
      * \since QGIS 2.4
      */
     void setCachingEnabled( bool enabled );
@@ -962,6 +964,9 @@ class GUI_EXPORT QgsMapCanvas : public QGraphicsView
     //! Optionally use cache with rendered map layers for the current map settings
     QgsMapRendererCache *mCache = nullptr;
 
+    //! Label placements of previous renders, kept while caching is enabled
+    QgsLabelPlacementCache *mLabelPlacementCache = nullptr;
+
     QTimer *mResizeTimer = nullptr;
     QTimer *mRefreshTimer = nullptr;
 
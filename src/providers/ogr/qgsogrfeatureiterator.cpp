@@ -26,10 +26,17 @@
 #include "qgssettings.h"
 #include "qgsexception.h"
 #include "qgswkbtypes.h"
+#include "qgswkbgeometryview.h"
 
 #include <QTextCodec>
 #include <QFile>
 
+#include <algorithm>
+#include <utility>
+
+//! Maximum number of features read ahead in a batch
+static const int MAX_BATCH_SIZE = 1024;
+
 // using from provider:
 // - setRelevantFields(), mRelevantFieldsForNextFeature
 // - ogrLayer
@@ -176,6 +183,19 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
     OGR_L_SetAttributeFilter( ogrLayer, nullptr );
   }
 
+  // prepare the conversion of the requested attributes
+  const QgsAttributeList fetchAttributes = ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ) ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
+  for ( int idx : fetchAttributes )
+  {
+    if ( idx < 0 || idx >= mSource->mFields.count() )
+      continue;
+
+    AttributeConversion conversion;
+    conversion.attIndex = idx;
+    conversion.ogrIndex = mSource->mFirstFieldIsFid ? idx - 1 : idx;
+    conversion.type = mSource->mFields.at( idx ).type();
+    mAttributeConversions << conversion;
+  }
 
   //start with first feature
   rewind();
@@ -260,27 +280,59 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
     return false;
   }
 
-  OGRFeatureH fet;
+  if ( mBatchIndex >= mBatch.size() && !readBatch() )
+  {
+    close();
+    return false;
+  }
 
-  while ( ( fet = OGR_L_GetNextFeature( ogrLayer ) ) )
+  // the previous feature of the caller takes the place of the returned one, so that the
+  // next batch can recycle its geometry storage
+  std::swap( feature, mBatch[mBatchIndex++] );
+
+  feature.setValid( true );
+  geometryToDestinationCrs( feature, mTransform );
+  return true;
+}
+
+bool QgsOgrFeatureIterator::readBatch()
+{
+  // the features of the previous batch are overwritten, which recycles their geometry storage
+  mBatch.resize( mBatchSize );
+  mBatchIndex = 0;
+
+  QVector<OGRFeatureH> ogrFeatures;
+  ogrFeatures.reserve( mBatchSize );
+
+  OGRFeatureH fet;
+  while ( ogrFeatures.size() < mBatchSize && ( fet = OGR_L_GetNextFeature( ogrLayer ) ) )
   {
-    if ( !readFeature( fet, feature ) )
+    QgsFeature &feature = mBatch[ogrFeatures.size()];
+    bool filterRectTested = false;
+    if ( !readFeatureGeometry( fet, feature, &filterRectTested ) )
       continue;
-    else
-      OGR_F_Destroy( fet );
 
-    if ( !mFilterRect.isNull() && !feature.hasGeometry() )
+    // features without geometry cannot intersect the filter rectangle, unless they passed the
+    // test before their geometry was dropped
+    if ( !mFilterRect.isNull() && !feature.hasGeometry() && !filterRectTested )
+    {
+      OGR_F_Destroy( fet );
       continue;
+    }
 
-    // we have a feature, end this cycle
-    feature.setValid( true );
-    geometryToDestinationCrs( feature, mTransform );
-    return true;
+    ogrFeatures << fet;
+  }
+  mBatch.resize( ogrFeatures.size() );
 
-  } // while
+  readAttributes( ogrFeatures.constData(), mBatch.data(), mBatch.size() );
 
-  close();
-  return false;
+  for ( OGRFeatureH ogrFeature : qgsAsConst( ogrFeatures ) )
+    OGR_F_Destroy( ogrFeature );
+
+  // start with small batches, so that iterations over a few features do not read more than needed
+  mBatchSize = std::min( mBatchSize * 2, MAX_BATCH_SIZE );
+
+  return !mBatch.isEmpty();
 }
 
 
@@ -292,6 +344,9 @@ bool QgsOgrFeatureIterator::rewind()
   OGR_L_ResetReading( ogrLayer );
 
   mFilterFidsIt = mFilterFids.constBegin();
+  mBatch.clear();
+  mBatchIndex = 0;
+  mBatchSize = 1;
 
   return true;
 }
@@ -320,31 +375,41 @@ bool QgsOgrFeatureIterator::close()
 
   mConn = nullptr;
   ogrLayer = nullptr;
+  mBatch.clear();
 
   mClosed = true;
   return true;
 }
 
 
-void QgsOgrFeatureIterator::getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature &f, int attindex ) const
+bool QgsOgrFeatureIterator::geometryIntersectsFilterRect( OGRGeometryH geom ) const
 {
-  if ( mSource->mFirstFieldIsFid && attindex == 0 )
+  QByteArray wkb( OGR_G_WkbSize( geom ), Qt::Uninitialized );
+  OGR_G_ExportToWkb( geom, ( OGRwkbByteOrder ) QgsApplication::endian(), reinterpret_cast< unsigned char * >( wkb.data() ) );
+
+  QgsWkbGeometryView view( wkb );
+  if ( view.isValid() && view.vertexCount() > 0 )
   {
-    f.setAttribute( 0, static_cast<qint64>( OGR_F_GetFID( ogrFet ) ) );
-    return;
-  }
+    const QgsRectangle bbox = view.boundingBox();
+    if ( !bbox.intersects( mFilterRect ) )
+      return false;
+    if ( mFilterRect.contains( bbox ) )
+      return true;
 
-  int attindexWithoutFid = ( mSource->mFirstFieldIsFid ) ? attindex - 1 : attindex;
-  bool ok = false;
-  QVariant value = QgsOgrUtils::getOgrFeatureAttribute( ogrFet, mSource->mFieldsWithoutFid, attindexWithoutFid, mSource->mEncoding, &ok );
-  if ( !ok )
-    return;
+    const QgsPointXY center = mFilterRect.center();
+    if ( view.contains( center.x(), center.y() ) )
+      return true;
+  }
 
-  f.setAttribute( attindex, value );
+  QgsGeometry g = QgsOgrUtils::ogrGeometryToQgsGeometry( geom );
+  return !g.isNull() && g.intersects( mFilterRect );
 }
 
-bool QgsOgrFeatureIterator::readFeature( OGRFeatureH fet, QgsFeature &feature ) const
+bool QgsOgrFeatureIterator::readFeatureGeometry( OGRFeatureH fet, QgsFeature &feature, bool *filterRectTested ) const
 {
+  if ( filterRectTested )
+    *filterRectTested = false;
+
   if ( mOrigFidAdded )
   {
     OGRFeatureDefnH fdef = OGR_L_GetLayerDefn( ogrLayer );
@@ -358,18 +423,34 @@ bool QgsOgrFeatureIterator::readFeature( OGRFeatureH fet, QgsFeature &feature )
   {
     feature.setId( OGR_F_GetFID( fet ) );
   }
-  feature.initAttributes( mSource->mFields.count() );
   feature.setFields( mSource->mFields ); // allow name-based attribute lookups
 
   bool useIntersect = mRequest.flags() & QgsFeatureRequest::ExactIntersect;
   bool geometryTypeFilter = mSource->mOgrGeometryTypeFilter != wkbUnknown;
-  if ( mFetchGeometry || useIntersect || geometryTypeFilter )
+  if ( useIntersect && !geometryTypeFilter && !mFilterRect.isNull() && ( mRequest.flags() & QgsFeatureRequest::NoGeometry ) )
+  {
+    // the geometry is only needed for the intersection test (e.g. when selecting features
+    // by rectangle), which can mostly be decided without decoding it
+    OGRGeometryH geom = OGR_F_GetGeometryRef( fet );
+    if ( !geom || !geometryIntersectsFilterRect( geom ) )
+    {
+      OGR_F_Destroy( fet );
+      return false;
+    }
+    feature.clearGeometry();
+    if ( filterRectTested )
+      *filterRectTested = true;
+  }
+  else if ( mFetchGeometry || useIntersect || geometryTypeFilter )
   {
     OGRGeometryH geom = OGR_F_GetGeometryRef( fet );
 
     if ( geom )
     {
-      QgsGeometry g = QgsOgrUtils::ogrGeometryToQgsGeometry( geom );
+      // take the geometry out of the feature, so that its storage can be recycled
+      QgsGeometry g = feature.geometry();
+      feature.clearGeometry();
+      QgsOgrUtils::readOgrGeometry( geom, g );
 
       // Insure that multipart datasets return multipart geometry
       if ( QgsWkbTypes::isMultiType( mSource->mWkbType ) && !g.isMultipart() )
@@ -400,25 +481,94 @@ bool QgsOgrFeatureIterator::readFeature( OGRFeatureH fet, QgsFeature &feature )
     feature.clearGeometry();
   }
 
-  // fetch attributes
-  if ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes )
+  return true;
+}
+
+bool QgsOgrFeatureIterator::readFeature( OGRFeatureH fet, QgsFeature &feature ) const
+{
+  if ( !readFeatureGeometry( fet, feature ) )
+    return false;
+
+  readAttributes( &fet, &feature, 1 );
+  return true;
+}
+
+void QgsOgrFeatureIterator::readAttributes( const OGRFeatureH *ogrFeatures, QgsFeature *features, int count ) const
+{
+  if ( count == 0 )
+    return;
+
+  QVector<QgsAttributes> attributes( count, QgsAttributes( mSource->mFields.count() ) );
+
+  // each attribute is converted for all features at once, with a single dispatch on its type
+  const QVariant nullValue = QVariant( QString() );
+  for ( const AttributeConversion &conversion : mAttributeConversions )
   {
-    QgsAttributeList attrs = mRequest.subsetOfAttributes();
-    for ( QgsAttributeList::const_iterator it = attrs.constBegin(); it != attrs.constEnd(); ++it )
+    const int idx = conversion.attIndex;
+    const int ogrIdx = conversion.ogrIndex;
+
+    if ( ogrIdx < 0 )
     {
-      getFeatureAttribute( fet, feature, *it );
+      for ( int i = 0; i < count; ++i )
+        attributes[i][idx] = static_cast<qint64>( OGR_F_GetFID( ogrFeatures[i] ) );
+      continue;
     }
-  }
-  else
-  {
-    // all attributes
-    for ( int idx = 0; idx < mSource->mFields.count(); ++idx )
+
+    switch ( conversion.type )
     {
-      getFeatureAttribute( fet, feature, idx );
+      case QVariant::String:
+        for ( int i = 0; i < count; ++i )
+        {
+          if ( !OGR_F_IsFieldSetAndNotNull( ogrFeatures[i], ogrIdx ) )
+            attributes[i][idx] = nullValue;
+          else if ( mSource->mEncoding )
+            attributes[i][idx] = mSource->mEncoding->toUnicode( OGR_F_GetFieldAsString( ogrFeatures[i], ogrIdx ) );
+          else
+            attributes[i][idx] = QString::fromUtf8( OGR_F_GetFieldAsString( ogrFeatures[i], ogrIdx ) );
+        }
+        break;
+
+      case QVariant::Int:
+        for ( int i = 0; i < count; ++i )
+        {
+          attributes[i][idx] = OGR_F_IsFieldSetAndNotNull( ogrFeatures[i], ogrIdx )
+                               ? QVariant( OGR_F_GetFieldAsInteger( ogrFeatures[i], ogrIdx ) ) : nullValue;
+        }
+        break;
+
+      case QVariant::LongLong:
+        for ( int i = 0; i < count; ++i )
+        {
+          attributes[i][idx] = OGR_F_IsFieldSetAndNotNull( ogrFeatures[i], ogrIdx )
+                               ? QVariant( static_cast<qint64>( OGR_F_GetFieldAsInteger64( ogrFeatures[i], ogrIdx ) ) ) : nullValue;
+        }
+        break;
+
+      case QVariant::Double:
+        for ( int i = 0; i < count; ++i )
+        {
+          attributes[i][idx] = OGR_F_IsFieldSetAndNotNull( ogrFeatures[i], ogrIdx )
+                               ? QVariant( OGR_F_GetFieldAsDouble( ogrFeatures[i], ogrIdx ) ) : nullValue;
+        }
+        break;
+
+      default:
+      {
+        // dates and times
+        bool ok = false;
+        for ( int i = 0; i < count; ++i )
+        {
+          QVariant value = QgsOgrUtils::getOgrFeatureAttribute( ogrFeatures[i], mSource->mFieldsWithoutFid, ogrIdx, mSource->mEncoding, &ok );
+          if ( ok )
+            attributes[i][idx] = value;
+        }
+        break;
+      }
     }
   }
 
-  return true;
+  for ( int i = 0; i < count; ++i )
+    features[i].setAttributes( attributes.at( i ) );
 }
 
 
@@ -19,6 +19,8 @@
 #include "qgsogrconnpool.h"
 #include "qgsfields.h"
 
+#include <QVector>
+
 #include <ogr_api.h>
 
 class QgsOgrFeatureIterator;
@@ -66,10 +68,38 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
 
   private:
 
+    //! Conversion of an OGR field to a requested attribute
+    struct AttributeConversion
+    {
+      //! Index of the attribute
+      int attIndex;
+      //! Index of the OGR field, or -1 if the attribute is the feature id
+      int ogrIndex;
+      //! Type of the attribute
+      QVariant::Type type;
+    };
+
     bool readFeature( OGRFeatureH fet, QgsFeature &feature ) const;
 
-    //! Get an attribute associated with a feature
-    void getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature &f, int attindex ) const;
+    /**
+     * Reads the id and the geometry of \a fet into \a feature, and checks whether the feature
+     * passes the geometry filters. If it does not, \a fet is destroyed and false is returned.
+     * \a filterRectTested is set to true if the feature was tested against the filter rectangle
+     * without keeping its geometry.
+     */
+    bool readFeatureGeometry( OGRFeatureH fet, QgsFeature &feature, bool *filterRectTested = nullptr ) const;
+
+    /**
+     * Returns true if \a geom intersects the filter rectangle. The test is done on a view of the
+     * geometry's WKB, and the geometry is only decoded if it crosses the boundary of the rectangle.
+     */
+    bool geometryIntersectsFilterRect( OGRGeometryH geom ) const;
+
+    //! Reads the requested attributes of \a count OGR features into \a features, one attribute after the other
+    void readAttributes( const OGRFeatureH *ogrFeatures, QgsFeature *features, int count ) const;
+
+    //! Reads the next batch of features, returns false if there are no more features
+    bool readBatch();
 
     QgsOgrConn *mConn = nullptr;
     OGRLayerH ogrLayer = nullptr;
@@ -87,6 +117,16 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
     QgsRectangle mFilterRect;
     QgsCoordinateTransform mTransform;
 
+    //! Conversions of the requested attributes, prepared once for all features
+    QVector<AttributeConversion> mAttributeConversions;
+
+    //! Features which have been read ahead, reused by the next batch once they have been returned
+    QVector<QgsFeature> mBatch;
+    //! Index of the next feature of mBatch
+    int mBatchIndex = 0;
+    //! Number of features to read in the next batch, it grows up to a maximum as the iteration goes on
+    int mBatchSize = 1;
+
     bool fetchFeatureWithId( QgsFeatureId id, QgsFeature &feature ) const;
 };
 
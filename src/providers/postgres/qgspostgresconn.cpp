@@ -29,9 +29,11 @@
 #include "qgssettings.h"
 
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QThread>
 
 #include <climits>
+#include <limits>
 
 // for htonl
 #ifdef Q_OS_WIN
@@ -1035,7 +1037,7 @@ PGresult *QgsPostgresConn::PQexec( const QString &query, bool logError )
   if ( res )
   {
     int errorStatus = PQresultStatus( res );
-    if ( errorStatus != PGRES_COMMAND_OK && errorStatus != PGRES_TUPLES_OK )
+    if ( errorStatus != PGRES_COMMAND_OK && errorStatus != PGRES_TUPLES_OK && errorStatus != PGRES_COPY_IN )
     {
       if ( logError )
       {
@@ -1062,7 +1064,7 @@ PGresult *QgsPostgresConn::PQexec( const QString &query, bool logError )
   return res;
 }
 
-bool QgsPostgresConn::openCursor( const QString &cursorName, const QString &sql )
+bool QgsPostgresConn::openCursor( const QString &cursorName, const QString &sql, bool isolated )
 {
   if ( mOpenCursors++ == 0 && !mTransaction )
   {
@@ -1073,13 +1075,24 @@ bool QgsPostgresConn::openCursor( const QString &cursorName, const QString &sql
       PQexecNR( QStringLiteral( "BEGIN" ) );
   }
   QgsDebugMsgLevel( QString( "Binary cursor %1 for %2" ).arg( cursorName, sql ), 3 );
-  return PQexecNR( QStringLiteral( "DECLARE %1 BINARY CURSOR%2 FOR %3" ).
-                   arg( cursorName, !mTransaction ? QLatin1String( "" ) : QStringLiteral( " WITH HOLD" ), sql ) );
+  const QString declare = QStringLiteral( "DECLARE %1 BINARY CURSOR%2 FOR %3" ).
+                          arg( cursorName, !mTransaction ? QLatin1String( "" ) : QStringLiteral( " WITH HOLD" ), sql );
+  if ( !isolated )
+    return PQexecNR( declare );
+
+  if ( PQexecNRIsolated( declare ) )
+    return true;
+
+  // the other cursors are still open
+  if ( --mOpenCursors == 0 && !mTransaction )
+    PQexecNR( QStringLiteral( "COMMIT" ) );
+  return false;
 }
 
-bool QgsPostgresConn::closeCursor( const QString &cursorName )
+bool QgsPostgresConn::closeCursor( const QString &cursorName, bool isolated )
 {
-  if ( !PQexecNR( QStringLiteral( "CLOSE %1" ).arg( cursorName ) ) )
+  const QString close = QStringLiteral( "CLOSE %1" ).arg( cursorName );
+  if ( !( isolated ? PQexecNRIsolated( close ) : PQexecNR( close ) ) )
     return false;
 
   if ( --mOpenCursors == 0 && !mTransaction )
@@ -1091,6 +1104,52 @@ bool QgsPostgresConn::closeCursor( const QString &cursorName )
   return true;
 }
 
+QString QgsPostgresConn::isolatedQuery( const QString &query )
+{
+  return QStringLiteral( "SAVEPOINT qgis_isolated;%1;RELEASE SAVEPOINT qgis_isolated" ).arg( query );
+}
+
+bool QgsPostgresConn::rollbackIsolatedQuery()
+{
+  // falls back to the ROLLBACK of the whole transaction if the savepoint is lost as well
+  return PQexecNR( QStringLiteral( "ROLLBACK TO SAVEPOINT qgis_isolated" ) );
+}
+
+bool QgsPostgresConn::PQexecNRIsolated( const QString &query )
+{
+  QgsPostgresResult res( PQexec( isolatedQuery( query ), false ) );
+  if ( res.PQresultStatus() == PGRES_COMMAND_OK )
+    return true;
+
+  QgsMessageLog::logMessage( tr( "Query: %1 returned %2 [%3]" )
+                             .arg( query )
+                             .arg( res.PQresultStatus() )
+                             .arg( res.PQresultErrorMessage() ),
+                             tr( "PostGIS" ) );
+  rollbackIsolatedQuery();
+  return false;
+}
+
+qint64 QgsPostgresConn::lockShared()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  QMutexLocker locker( &mSharedLock );
+  const quint64 ticket = mNextSharedTicket++;
+  while ( ticket != mServedSharedTicket )
+    mSharedLockReleased.wait( &mSharedLock );
+
+  return timer.elapsed();
+}
+
+void QgsPostgresConn::unlockShared()
+{
+  QMutexLocker locker( &mSharedLock );
+  mServedSharedTicket++;
+  mSharedLockReleased.wakeAll();
+}
+
 QString QgsPostgresConn::uniqueCursorName()
 {
   return QStringLiteral( "qgis_%1" ).arg( ++mNextCursorId );
@@ -1210,6 +1269,18 @@ int QgsPostgresConn::PQsendQuery( const QString &query )
   return ::PQsendQuery( mConn, query.toUtf8() );
 }
 
+int QgsPostgresConn::PQputCopyData( const QByteArray &buffer )
+{
+  Q_ASSERT( mConn );
+  return ::PQputCopyData( mConn, buffer.constData(), buffer.size() );
+}
+
+int QgsPostgresConn::PQputCopyEnd( const QString &errorMessage )
+{
+  Q_ASSERT( mConn );
+  return ::PQputCopyEnd( mConn, errorMessage.isNull() ? nullptr : errorMessage.toUtf8().constData() );
+}
+
 bool QgsPostgresConn::begin()
 {
   if ( mTransaction )
@@ -1331,6 +1402,78 @@ qint64 QgsPostgresConn::getBinaryInt( QgsPostgresResult &queryResult, int row, i
   return oid;
 }
 
+double QgsPostgresConn::getBinaryDouble( QgsPostgresResult &queryResult, int row, int col )
+{
+  const char *p = PQgetvalue( queryResult.result(), row, col );
+  size_t s = PQgetlength( queryResult.result(), row, col );
+
+  if ( s == sizeof( float ) )
+  {
+    quint32 bits;
+    memcpy( &bits, p, sizeof( bits ) );
+    if ( mSwapEndian )
+      bits = ntohl( bits );
+
+    float value;
+    memcpy( &value, &bits, sizeof( value ) );
+    return value;
+  }
+  else if ( s == sizeof( double ) )
+  {
+    quint32 bits0, bits1;
+    memcpy( &bits0, p, sizeof( bits0 ) );
+    memcpy( &bits1, p + sizeof( quint32 ), sizeof( bits1 ) );
+    if ( mSwapEndian )
+    {
+      bits0 = ntohl( bits0 );
+      bits1 = ntohl( bits1 );
+    }
+
+    quint64 bits = ( static_cast< quint64 >( bits0 ) << 32 ) | bits1;
+    double value;
+    memcpy( &value, &bits, sizeof( value ) );
+    return value;
+  }
+
+  QgsDebugMsg( QString( "unexpected size %1" ).arg( s ) );
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+bool QgsPostgresConn::supportsBinaryValue( const QgsField &fld )
+{
+  // oid is left out, as it is unsigned but stored in an integer field
+  const QString &type = fld.typeName();
+  return type == QLatin1String( "int2" ) || type == QLatin1String( "int4" ) || type == QLatin1String( "int8" ) ||
+         type == QLatin1String( "float4" ) || type == QLatin1String( "float8" ) ||
+         type == QLatin1String( "bool" );
+}
+
+QVariant QgsPostgresConn::getBinaryValue( QgsPostgresResult &queryResult, int row, int col, const QgsField &fld )
+{
+  if ( queryResult.PQgetisnull( row, col ) )
+    return QVariant( fld.type() );
+
+  QVariant value;
+  switch ( fld.type() )
+  {
+    case QVariant::Bool:
+      return *::PQgetvalue( queryResult.result(), row, col ) != 0;
+
+    case QVariant::Double:
+      value = getBinaryDouble( queryResult, row, col );
+      break;
+
+    default:
+      value = getBinaryInt( queryResult, row, col );
+      break;
+  }
+
+  if ( !value.convert( fld.type() ) )
+    return QVariant( fld.type() );
+
+  return value;
+}
+
 QString QgsPostgresConn::fieldExpression( const QgsField &fld, QString expr )
 {
   const QString &type = fld.typeName();
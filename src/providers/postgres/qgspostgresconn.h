@@ -22,7 +22,9 @@
 #include <QStringList>
 #include <QVector>
 #include <QMap>
+#include <QAtomicInt>
 #include <QMutex>
+#include <QWaitCondition>
 
 #include "qgis.h"
 #include "qgsdatasourceuri.h"
@@ -229,9 +231,30 @@ class QgsPostgresConn : public QObject
     //! run a query and free result buffer
     bool PQexecNR( const QString &query, bool retry = true );
 
-    //! cursor handling
-    bool openCursor( const QString &cursorName, const QString &declare );
-    bool closeCursor( const QString &cursorName );
+    /**
+     * Runs a \a query within a savepoint (see isolatedQuery()), so that an error
+     * only rolls back the query instead of the whole transaction of the connection.
+     */
+    bool PQexecNRIsolated( const QString &query );
+
+    /**
+     * Returns \a query wrapped in a savepoint, to be sent in one round trip. If the
+     * query fails, rollbackIsolatedQuery() must be called before using the connection again.
+     * The cursors of other users of a shared connection stay open, unlike with the ROLLBACK
+     * of PQexecNR().
+     */
+    static QString isolatedQuery( const QString &query );
+
+    //! Rolls back a failed isolatedQuery(), keeping the cursors opened before it
+    bool rollbackIsolatedQuery();
+
+    /**
+     * cursor handling
+     * If \a isolated is true, the cursor is declared or closed with isolated queries, e.g. on
+     * connections shared by several feature iterators.
+     */
+    bool openCursor( const QString &cursorName, const QString &declare, bool isolated = false );
+    bool closeCursor( const QString &cursorName, bool isolated = false );
 
     QString uniqueCursorName();
 
@@ -252,6 +275,8 @@ class QgsPostgresConn : public QObject
     PGresult *PQgetResult();
     PGresult *PQprepare( const QString &stmtName, const QString &query, int nParams, const Oid *paramTypes );
     PGresult *PQexecPrepared( const QString &stmtName, const QStringList &params );
+    int PQputCopyData( const QByteArray &buffer );
+    int PQputCopyEnd( const QString &errorMessage = QString() );
 
     bool begin();
     bool commit();
@@ -311,6 +336,21 @@ class QgsPostgresConn : public QObject
 
     qint64 getBinaryInt( QgsPostgresResult &queryResult, int row, int col );
 
+    //! Returns the value of a float4 or float8 column fetched from a binary cursor
+    double getBinaryDouble( QgsPostgresResult &queryResult, int row, int col );
+
+    /**
+     * Returns true if the values of field \a fld can be fetched from a binary cursor
+     * as they are, without casting them to text, and decoded with getBinaryValue().
+     */
+    static bool supportsBinaryValue( const QgsField &fld );
+
+    /**
+     * Decodes the value of field \a fld fetched from a binary cursor, the field
+     * must be supported by supportsBinaryValue().
+     */
+    QVariant getBinaryValue( QgsPostgresResult &queryResult, int row, int col, const QgsField &fld );
+
     QString fieldExpression( const QgsField &fld, QString expr = "%1" );
 
     QString connInfo() const { return mConnInfo; }
@@ -344,6 +384,16 @@ class QgsPostgresConn : public QObject
     void lock() { mLock.lock(); }
     void unlock() { mLock.unlock(); }
 
+    /**
+     * Locks a pool connection shared by several feature iterators. Iterators waiting for the
+     * connection get it in the order in which they asked for it, so that none of them is starved.
+     * \returns the time spent waiting for the connection, in milliseconds
+     */
+    qint64 lockShared();
+
+    //! Unlocks a connection locked with lockShared()
+    void unlockShared();
+
   private:
     QgsPostgresConn( const QString &conninfo, bool readOnly, bool shared, bool transaction );
     ~QgsPostgresConn();
@@ -410,13 +460,20 @@ class QgsPostgresConn : public QObject
     bool mSwapEndian;
     void deduceEndian();
 
-    int mNextCursorId;
+    //! Atomic, as pool connections may be shared by iterators of different threads
+    QAtomicInt mNextCursorId;
 
     bool mShared; //! < whether the connection is shared by more providers (must not be if going to be used in worker threads)
 
     bool mTransaction;
 
     QMutex mLock;
+
+    //! Tickets of lockShared(), served in order
+    QMutex mSharedLock;
+    QWaitCondition mSharedLockReleased;
+    quint64 mNextSharedTicket = 0;
+    quint64 mServedSharedTicket = 0;
 };
 
 // clazy:excludeall=qstring-allocations
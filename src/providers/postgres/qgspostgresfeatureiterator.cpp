@@ -38,7 +38,10 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
 {
   if ( !source->mTransactionConnection )
   {
-    mConn = QgsPostgresConnPool::instance()->acquireConnection( mSource->mConnInfo );
+    // a shared connection does not block when the pool is exhausted, but the cursors
+    // of the iterators using it take turns on the connection
+    mIsSharedConnection = QgsSettings().value( QStringLiteral( "PostgreSQL/shareIteratorConnections" ), false ).toBool();
+    mConn = QgsPostgresConnPool::instance()->acquireConnection( mSource->mConnInfo, mIsSharedConnection );
     mIsTransactionConnection = false;
   }
   else
@@ -252,41 +255,10 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
     QElapsedTimer timer;
     timer.start();
 
-    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
-    QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
-
     lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
-    {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-    }
-
-    QgsPostgresResult queryResult;
-    for ( ;; )
-    {
-      queryResult = mConn->PQgetResult();
-      if ( !queryResult.result() )
-        break;
-
-      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
-      {
-        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-        break;
-      }
-
-      int rows = queryResult.PQntuples();
-      if ( rows == 0 )
-        continue;
-
-      mLastFetch = rows < mFeatureQueueSize;
-
-      for ( int row = 0; row < rows; row++ )
-      {
-        mFeatureQueue.enqueue( QgsFeature() );
-        getFeature( queryResult, row, mFeatureQueue.back() );
-      } // for each row in queue
-    }
-    unlock();
+    // the FETCH has usually been sent ahead, while the previous features were consumed
+    if ( mPendingFetchSize > 0 || sendFetch() )
+      receiveFetch();
 
     if ( timer.elapsed() > 500 && mFeatureQueueSize > 1 )
     {
@@ -296,6 +268,13 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
     {
       mFeatureQueueSize *= 2;
     }
+
+    // send the next FETCH right away, so that the server processes it and the data travels
+    // while the features of this batch are consumed. This is not possible on transaction
+    // and shared connections, as other users of the connection must be able to run their queries.
+    if ( !mLastFetch && !mFeatureQueue.empty() && !mIsTransactionConnection && !mIsSharedConnection )
+      sendFetch();
+    unlock();
   }
 
   if ( mFeatureQueue.empty() )
@@ -318,6 +297,74 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
   return true;
 }
 
+bool QgsPostgresFeatureIterator::sendFetch()
+{
+  QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
+  QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
+
+  // a failing FETCH must not abort the cursors of the other iterators sharing the connection
+  if ( mIsSharedConnection )
+    fetch = QgsPostgresConn::isolatedQuery( fetch );
+
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    mPendingFetchSize = 0;
+    return false;
+  }
+
+  mPendingFetchSize = mFeatureQueueSize;
+  return true;
+}
+
+void QgsPostgresFeatureIterator::receiveFetch( bool discard )
+{
+  const int fetchSize = mPendingFetchSize;
+  mPendingFetchSize = 0;
+
+  // all results must be read before the connection can be used again
+  QgsPostgresResult queryResult;
+  bool failed = false;
+  for ( ;; )
+  {
+    queryResult = mConn->PQgetResult();
+    if ( !queryResult.result() )
+      break;
+
+    // results of the savepoint commands of isolated queries
+    const ExecStatusType status = queryResult.PQresultStatus();
+    if ( status == PGRES_COMMAND_OK )
+      continue;
+
+    if ( status != PGRES_TUPLES_OK )
+    {
+      if ( !discard )
+        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+      failed = true;
+      discard = true;
+      continue;
+    }
+
+    if ( discard )
+      continue;
+
+    int rows = queryResult.PQntuples();
+    if ( rows == 0 )
+      continue;
+
+    mLastFetch = rows < fetchSize;
+
+    for ( int row = 0; row < rows; row++ )
+    {
+      mFeatureQueue.enqueue( QgsFeature() );
+      getFeature( queryResult, row, mFeatureQueue.back() );
+    } // for each row in queue
+  }
+
+  if ( failed && mIsSharedConnection )
+    mConn->rollbackIsolatedQuery();
+}
+
 bool QgsPostgresFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   if ( !mExpressionCompiled )
@@ -363,12 +410,16 @@ void QgsPostgresFeatureIterator::lock()
 {
   if ( mIsTransactionConnection )
     mConn->lock();
+  else if ( mIsSharedConnection )
+    mSharedConnectionWaitTime += mConn->lockShared();
 }
 
 void QgsPostgresFeatureIterator::unlock()
 {
   if ( mIsTransactionConnection )
     mConn->unlock();
+  else if ( mIsSharedConnection )
+    mConn->unlockShared();
 }
 
 bool QgsPostgresFeatureIterator::rewind()
@@ -379,7 +430,13 @@ bool QgsPostgresFeatureIterator::rewind()
   // move cursor to first record
 
   lock();
-  mConn->PQexecNR( QStringLiteral( "move absolute 0 in %1" ).arg( mCursorName ) );
+  if ( mPendingFetchSize > 0 )
+    receiveFetch( true );
+  const QString move = QStringLiteral( "move absolute 0 in %1" ).arg( mCursorName );
+  if ( mIsSharedConnection )
+    mConn->PQexecNRIsolated( move );
+  else
+    mConn->PQexecNR( move );
   unlock();
   mFeatureQueue.clear();
   mFetched = 0;
@@ -394,11 +451,16 @@ bool QgsPostgresFeatureIterator::close()
     return false;
 
   lock();
-  mConn->closeCursor( mCursorName );
+  if ( mPendingFetchSize > 0 )
+    receiveFetch( true );
+  mConn->closeCursor( mCursorName, mIsSharedConnection );
   unlock();
 
   if ( !mIsTransactionConnection )
   {
+    if ( mIsSharedConnection )
+      QgsDebugMsgLevel( QString( "Cursor %1 waited %2 ms for the shared connection" ).arg( mCursorName ).arg( mSharedConnectionWaitTime ), 2 );
+
     QgsPostgresConnPool::instance()->releaseConnection( mConn );
   }
   mConn = nullptr;
@@ -634,13 +696,24 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
       return false;
   }
 
+  // numeric and boolean values are decoded from the binary cursor, other values are cast to text
+  mBinaryAttributes.fill( false, mSource->mFields.count() );
   bool subsetOfAttributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes;
   Q_FOREACH ( int idx, subsetOfAttributes ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList() )
   {
     if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
       continue;
 
-    query += delim + mConn->fieldExpression( mSource->mFields.at( idx ) );
+    const QgsField fld = mSource->mFields.at( idx );
+    if ( QgsPostgresConn::supportsBinaryValue( fld ) )
+    {
+      mBinaryAttributes[idx] = true;
+      query += delim + QgsPostgresConn::quotedIdentifier( fld.name() );
+    }
+    else
+    {
+      query += delim + mConn->fieldExpression( fld );
+    }
   }
 
   query += " FROM " + mSource->mQuery;
@@ -655,7 +728,7 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
     query += QStringLiteral( " ORDER BY %1 " ).arg( orderBy );
 
   lock();
-  if ( !mConn->openCursor( mCursorName, query ) )
+  if ( !mConn->openCursor( mCursorName, query, mIsSharedConnection ) )
   {
     unlock();
     // reloading the fields might help next time around
@@ -726,7 +799,9 @@ bool QgsPostgresFeatureIterator::getFeature( QgsPostgresResult &queryResult, int
         }
       }
 
-      QgsGeometry g;
+      // take the geometry out of the feature, so that its storage can be recycled
+      QgsGeometry g = feature.geometry();
+      feature.clearGeometry();
       g.fromWkb( featureGeom, returnedLength + 1 );
       feature.setGeometry( g );
     }
@@ -817,7 +892,9 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
     return;
 
   const QgsField fld = mSource->mFields.at( idx );
-  QVariant v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
+  QVariant v = mBinaryAttributes.at( idx )
+               ? mConn->getBinaryValue( queryResult, row, col, fld )
+               : QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
   feature.setAttribute( idx, v );
 
   col++;
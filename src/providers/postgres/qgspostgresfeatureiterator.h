@@ -18,6 +18,7 @@
 #include "qgsfeatureiterator.h"
 
 #include <QQueue>
+#include <QVector>
 
 #include "qgspostgresprovider.h"
 
@@ -94,6 +95,12 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
     bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
 
+    //! Sends a FETCH of the next mFeatureQueueSize features, without waiting for its result
+    bool sendFetch();
+
+    //! Waits for the result of the pending FETCH and adds the features to the queue, or drops them if \a discard is true
+    void receiveFetch( bool discard = false );
+
     QString mCursorName;
 
     /**
@@ -105,6 +112,15 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     //! Maximal size of the feature queue
     int mFeatureQueueSize;
 
+    /**
+     * Number of features requested by the FETCH which was sent to the server and
+     * whose result has not been received yet, or 0 if there is no pending FETCH
+     */
+    int mPendingFetchSize = 0;
+
+    //! Whether the attributes are fetched in binary format, by attribute index
+    QVector<bool> mBinaryAttributes;
+
     //! Number of retrieved features
     int mFetched;
 
@@ -113,6 +129,12 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
 
     bool mIsTransactionConnection;
 
+    //! Set to true, if the connection is acquired from the pool as shareable with other iterators
+    bool mIsSharedConnection = false;
+
+    //! Time spent waiting for the shared connection, in milliseconds
+    qint64 mSharedConnectionWaitTime = 0;
+
     virtual bool providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const override;
 
     virtual bool prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause> &orderBys ) override;
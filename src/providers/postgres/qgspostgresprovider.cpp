@@ -1970,6 +1970,11 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   if ( mIsQuery )
     return false;
 
+  // features which do not need to be updated with the values generated by the database are streamed
+  QgsAttributeList copyAttributes;
+  if ( ( flags & QgsFeatureSink::FastInsert ) && canCopyFeatures( flist, copyAttributes ) )
+    return copyFeatures( flist, copyAttributes );
+
   QgsPostgresConn *conn = connectionRW();
   if ( !conn )
   {
@@ -2243,6 +2248,221 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   return returnvalue;
 }
 
+bool QgsPostgresProvider::canCopyFeatures( const QgsFeatureList &flist, QgsAttributeList &attributes ) const
+{
+  attributes.clear();
+
+  // geometries are sent as hex EWKB, which cannot be converted to topogeometries
+  if ( !mGeometryColumn.isNull() && mSpatialColType != SctGeometry )
+    return false;
+
+  for ( int idx = 0; idx < mAttributeFields.count(); ++idx )
+  {
+    const QString fieldname = mAttributeFields.at( idx ).name();
+    if ( fieldname.isEmpty() || fieldname == mGeometryColumn )
+      continue;
+
+    const QString defVal = defaultValueClause( idx );
+    bool hasNull = false;
+    bool hasValue = false;
+
+    for ( const QgsFeature &feature : flist )
+    {
+      const QgsAttributes attrs = feature.attributes();
+      const QVariant v = idx < attrs.count() ? attrs.at( idx ) : QVariant();
+
+      if ( v.isNull() )
+      {
+        hasNull = true;
+        continue;
+      }
+
+      // arrays and hstore values are only available as SQL literals (see QgsPostgresConn::quotedList()
+      // and quotedMap()). The COPY text format would need the backslash escaping of COPY on top of the
+      // array and hstore quoting, so these features are inserted with INSERT statements instead.
+      if ( v.type() == QVariant::Map || v.type() == QVariant::List || v.type() == QVariant::StringList )
+        return false;
+
+      // the default value clause must be evaluated
+      if ( !defVal.isNull() && v.toString() == defVal )
+        return false;
+
+      hasValue = true;
+    }
+
+    if ( !defVal.isNull() && hasNull )
+    {
+      // null values are replaced by the default value. The database does that itself for the
+      // columns which are left out of the COPY, but only if no feature has a value for it.
+      if ( hasValue )
+        return false;
+
+      continue;
+    }
+
+    attributes << idx;
+  }
+
+  // views and other relations may not support COPY
+  return relkind() == Relkind::OrdinaryTable;
+}
+
+//! Appends \a value to \a buffer, escaped for the text format of COPY
+static void appendCopyValue( QByteArray &buffer, const QString &value )
+{
+  const QByteArray utf8 = value.toUtf8();
+  for ( const char c : utf8 )
+  {
+    switch ( c )
+    {
+      case '\\':
+        buffer += "\\\\";
+        break;
+      case '\n':
+        buffer += "\\n";
+        break;
+      case '\r':
+        buffer += "\\r";
+        break;
+      case '\t':
+        buffer += "\\t";
+        break;
+      default:
+        buffer += c;
+        break;
+    }
+  }
+}
+
+bool QgsPostgresProvider::copyFeatures( const QgsFeatureList &flist, const QgsAttributeList &attributes )
+{
+  QgsPostgresConn *conn = connectionRW();
+  if ( !conn )
+  {
+    return false;
+  }
+  conn->lock();
+
+  bool returnvalue = true;
+
+  try
+  {
+    conn->begin();
+
+    QString copy = QStringLiteral( "COPY %1(" ).arg( mQuery );
+    QString delim;
+
+    if ( !mGeometryColumn.isNull() )
+    {
+      copy += quotedIdentifier( mGeometryColumn );
+      delim = ',';
+    }
+
+    for ( int idx : attributes )
+    {
+      copy += delim + quotedIdentifier( mAttributeFields.at( idx ).name() );
+      delim = ',';
+    }
+
+    copy += QLatin1String( ") FROM STDIN" );
+
+    QgsDebugMsg( QString( "copy addfeatures: %1" ).arg( copy ) );
+    QgsPostgresResult result( conn->PQexec( copy ) );
+    if ( result.PQresultStatus() != PGRES_COPY_IN )
+      throw PGException( result );
+
+    const bool forceMulti = QgsWkbTypes::isMultiType( wkbType() );
+    const QString srid = mRequestedSrid.isEmpty() ? mDetectedSrid : mRequestedSrid;
+    const QByteArray sridPrefix = srid.isEmpty() ? QByteArray() : QStringLiteral( "SRID=%1;" ).arg( srid ).toLatin1();
+
+    // rows are sent in chunks of about 1 MB
+    const int chunkSize = 1024 * 1024;
+    QByteArray buffer;
+    buffer.reserve( chunkSize + 64 * 1024 );
+    QString copyError;
+
+    for ( const QgsFeature &feature : flist )
+    {
+      if ( !mGeometryColumn.isNull() )
+      {
+        if ( feature.hasGeometry() )
+        {
+          QgsGeometry geom = convertToProviderType( feature.geometry() );
+          if ( geom.isNull() )
+            geom = feature.geometry();
+          if ( forceMulti && !geom.isMultipart() )
+            geom.convertToMultiType();
+
+          buffer += sridPrefix;
+          buffer += geom.exportToWkb().toHex();
+        }
+        else
+        {
+          buffer += "\\N";
+        }
+      }
+
+      const QgsAttributes attrs = feature.attributes();
+      bool first = mGeometryColumn.isNull();
+      for ( int idx : attributes )
+      {
+        if ( !first )
+          buffer += '\t';
+        first = false;
+
+        const QVariant v = idx < attrs.count() ? attrs.at( idx ) : QVariant();
+        if ( v.isNull() )
+          buffer += "\\N";
+        else
+          appendCopyValue( buffer, v.toString() );
+      }
+      buffer += '\n';
+
+      if ( buffer.size() >= chunkSize )
+      {
+        if ( conn->PQputCopyData( buffer ) != 1 )
+        {
+          copyError = conn->PQerrorMessage();
+          break;
+        }
+        buffer.clear();
+      }
+    }
+
+    if ( copyError.isNull() && !buffer.isEmpty() && conn->PQputCopyData( buffer ) != 1 )
+      copyError = conn->PQerrorMessage();
+
+    conn->PQputCopyEnd( copyError );
+
+    // all results must be read before the connection can be used again
+    result = conn->PQgetResult();
+    for ( ;; )
+    {
+      QgsPostgresResult trailingResult( conn->PQgetResult() );
+      if ( !trailingResult.result() )
+        break;
+    }
+
+    if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+      throw PGException( result );
+
+    returnvalue &= conn->commit();
+    if ( mTransaction )
+      mTransaction->dirtyLastSavePoint();
+
+    mShared->addFeaturesCounted( flist.size() );
+  }
+  catch ( PGException &e )
+  {
+    pushError( tr( "PostGIS error while adding features: %1" ).arg( e.errorMessage() ) );
+    conn->rollback();
+    returnvalue = false;
+  }
+
+  conn->unlock();
+  return returnvalue;
+}
+
 bool QgsPostgresProvider::deleteFeatures( const QgsFeatureIds &id )
 {
   bool returnvalue = true;
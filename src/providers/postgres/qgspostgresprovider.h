@@ -426,6 +426,20 @@ class QgsPostgresProvider : public QgsVectorDataProvider
 
     QString paramValue( const QString &fieldvalue, const QString &defaultValue ) const;
 
+    /**
+     * Returns true if the features of \a flist can be added with a COPY statement instead of one
+     * INSERT per feature. This is only possible if the features do not need any default value to be
+     * evaluated, in which case the \a attributes to copy are returned.
+     */
+    bool canCopyFeatures( const QgsFeatureList &flist, QgsAttributeList &attributes ) const;
+
+    /**
+     * Adds the features of \a flist with a COPY ... FROM STDIN statement, which streams the geometries
+     * and the \a attributes of all features in a single statement. Values generated by the database
+     * are not read back into the features.
+     */
+    bool copyFeatures( const QgsFeatureList &flist, const QgsAttributeList &attributes );
+
     QgsPostgresConn *mConnectionRO = nullptr ; //! read-only database connection (initially)
     QgsPostgresConn *mConnectionRW = nullptr ; //! read-write database connection (on update)
 
@@ -591,7 +591,9 @@ void QgsSpatiaLiteFeatureIterator::getFeatureGeometry( sqlite3_stmt *stmt, int i
     QgsSpatiaLiteProvider::convertToGeosWKB( ( const unsigned char * )blob, blob_size, &featureGeom, &geom_size );
     if ( featureGeom )
     {
-      QgsGeometry g;
+      // take the geometry out of the feature, so that its storage can be recycled
+      QgsGeometry g = feature.geometry();
+      feature.clearGeometry();
       g.fromWkb( featureGeom, geom_size );
       feature.setGeometry( g );
     }
@@ -130,6 +130,17 @@ void QgsServerSettings::initSettings()
                                QVariant()
                              };
   mSettings[ sCacheSize.envVar ] = sCacheSize;
+
+  // render cache directory
+  const Setting sRenderCacheDir = { QgsServerSettingsEnv::QGIS_SERVER_RENDER_CACHE_DIRECTORY,
+                                    QgsServerSettingsEnv::DEFAULT_VALUE,
+                                    "Specify the directory where rendered layer images are stored (images are not invalidated when data are modified outside of QGIS Server)",
+                                    "/cache/render_directory",
+                                    QVariant::String,
+                                    QVariant( "" ),
+                                    QVariant()
+                                  };
+  mSettings[ sRenderCacheDir.envVar ] = sRenderCacheDir;
 }
 
 void QgsServerSettings::load()
@@ -305,3 +316,8 @@ QString QgsServerSettings::cacheDirectory() const
 {
   return value( QgsServerSettingsEnv::QGIS_SERVER_CACHE_DIRECTORY ).toString();
 }
+
+QString QgsServerSettings::renderCacheDirectory() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_RENDER_CACHE_DIRECTORY ).toString();
+}
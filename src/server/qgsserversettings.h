@@ -56,7 +56,8 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_PROJECT_FILE,
       MAX_CACHE_LAYERS,
       QGIS_SERVER_CACHE_DIRECTORY,
-      QGIS_SERVER_CACHE_SIZE
+      QGIS_SERVER_CACHE_SIZE,
+      QGIS_SERVER_RENDER_CACHE_DIRECTORY
     };
     Q_ENUM( EnvVar )
 };
@@ -157,6 +158,14 @@ class SERVER_EXPORT QgsServerSettings
       */
     QString cacheDirectory() const;
 
+    /**
+     * Returns the directory where rendered layer images are stored, so that they can be reused
+     * by later GetMap requests with the same parameters.
+      * \returns the directory or an empty string if rendered images are not stored.
+      * \since QGIS 3.0
+      */
+    QString renderCacheDirectory() const;
+
   private:
     void initSettings();
     QVariant value( QgsServerSettingsEnv::EnvVar envVar ) const;
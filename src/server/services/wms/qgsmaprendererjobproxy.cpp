@@ -20,18 +20,25 @@
 #include "qgsmessagelog.h"
 #include "qgsmaprendererparalleljob.h"
 #include "qgsmaprenderercustompainterjob.h"
+#include "qgsmaprenderercache.h"
 
 namespace QgsWms
 {
+  // rendered layer images are shared by all requests handled by the process
+  Q_GLOBAL_STATIC( QgsMapRendererCache, sRenderCache )
 
   QgsMapRendererJobProxy::QgsMapRendererJobProxy(
     bool parallelRendering
     , int maxThreads
     , QgsAccessControl *accessControl
+    , const QString &renderCacheDirectory
+    , bool profilingEnabled
   )
     :
     mParallelRendering( parallelRendering )
     , mAccessControl( accessControl )
+    , mRenderCacheDirectory( renderCacheDirectory )
+    , mProfilingEnabled( profilingEnabled )
   {
 #ifndef HAVE_SERVER_PYTHON_PLUGINS
     Q_UNUSED( mAccessControl );
@@ -53,21 +60,67 @@ namespace QgsWms
     {
       QgsMapRendererParallelJob renderJob( mapSettings );
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
-      renderJob.setFeatureFilterProvider( mAccessControl );
+      renderJob.setFeatureFilterProvider( featureFilterProvider() );
 #endif
+      renderJob.setCache( renderCache() );
+      renderJob.setProfilingEnabled( mProfilingEnabled );
       renderJob.start();
       renderJob.waitForFinished();
       *image = renderJob.renderedImage();
       mPainter.reset( new QPainter( image ) );
+      logProfile( renderJob );
     }
     else
     {
       mPainter.reset( new QPainter( image ) );
       QgsMapRendererCustomPainterJob renderJob( mapSettings, mPainter.get() );
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
-      renderJob.setFeatureFilterProvider( mAccessControl );
+      renderJob.setFeatureFilterProvider( featureFilterProvider() );
 #endif
+      renderJob.setCache( renderCache() );
+      renderJob.setProfilingEnabled( mProfilingEnabled );
       renderJob.renderSynchronously();
+      logProfile( renderJob );
+    }
+  }
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+  QgsFeatureFilterProvider *QgsMapRendererJobProxy::featureFilterProvider() const
+  {
+    if ( !mAccessControl )
+      return nullptr;
+
+    // without registered access control filters, all features are rendered
+    QStringList filterKeys;
+    if ( mAccessControl->fillCacheKey( filterKeys ) && filterKeys.isEmpty() )
+      return nullptr;
+
+    return mAccessControl;
+  }
+#endif
+
+  QgsMapRendererCache *QgsMapRendererJobProxy::renderCache() const
+  {
+    if ( mRenderCacheDirectory.isEmpty() )
+      return nullptr;
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+    // images filtered by access control plugins must never be shared with other requests
+    if ( featureFilterProvider() )
+      return nullptr;
+#endif
+
+    QgsMapRendererCache *cache = sRenderCache();
+    if ( cache->storageDirectory() != mRenderCacheDirectory )
+      cache->setStorageDirectory( mRenderCacheDirectory );
+    return cache;
+  }
+
+  void QgsMapRendererJobProxy::logProfile( const QgsMapRendererJob &job ) const
+  {
+    if ( job.isProfilingEnabled() )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Rendering profile: %1" ).arg( job.profile().toJson() ), QStringLiteral( "server" ), QgsMessageLog::INFO );
     }
   }
 
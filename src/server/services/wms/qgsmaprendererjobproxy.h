@@ -21,6 +21,9 @@
 #include "qgsmapsettings.h"
 #include "qgsaccesscontrol.h"
 
+class QgsMapRendererCache;
+class QgsMapRendererJob;
+
 namespace QgsWms
 {
 
@@ -37,11 +40,16 @@ namespace QgsWms
       /**
        * Constructor.
         * \param accessControl Does not take ownership of QgsAccessControl
+        * \param renderCacheDirectory directory where rendered layer images are stored for
+        * later requests (no images are stored if empty)
+        * \param profilingEnabled whether the times of the rendering phases are logged
         */
       QgsMapRendererJobProxy(
         bool parallelRendering
         , int maxThreads
         , QgsAccessControl *accessControl
+        , const QString &renderCacheDirectory = QString()
+        , bool profilingEnabled = false
       );
 
       /**
@@ -60,7 +68,20 @@ namespace QgsWms
     private:
       bool mParallelRendering;
       QgsAccessControl *mAccessControl = nullptr;
+      QString mRenderCacheDirectory;
+      bool mProfilingEnabled = false;
       std::unique_ptr<QPainter> mPainter;
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+      //! Returns the access control if it has filters registered, nullptr otherwise
+      QgsFeatureFilterProvider *featureFilterProvider() const;
+#endif
+
+      //! Logs the times of the rendering phases of a finished \a job as JSON
+      void logProfile( const QgsMapRendererJob &job ) const;
+
+      //! Returns the process wide cache of rendered layer images, or nullptr if images are not stored
+      QgsMapRendererCache *renderCache() const;
   };
 
 
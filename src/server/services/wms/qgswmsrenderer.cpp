@@ -2646,7 +2646,9 @@ namespace QgsWms
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
       mAccessControl->resolveFilterFeatures( mapSettings.layers() );
 #endif
-      QgsMapRendererJobProxy renderJob( mSettings.parallelRendering(), mSettings.maxThreads(), mAccessControl );
+      // the times of the rendering phases are only logged with the most verbose log level
+      QgsMapRendererJobProxy renderJob( mSettings.parallelRendering(), mSettings.maxThreads(), mAccessControl,
+                                        mSettings.renderCacheDirectory(), mSettings.logLevel() == QgsMessageLog::INFO );
       renderJob.render( mapSettings, &image );
       painter = renderJob.takePainter();
     }
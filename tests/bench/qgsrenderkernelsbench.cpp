@@ -0,0 +1,136 @@
+/***************************************************************************
+  qgsrenderkernelsbench.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsclipper.h"
+#include "qgslinestring.h"
+#include "qgsmaptopixel.h"
+#include "qgsrectangle.h"
+
+#include <cmath>
+
+/**
+ * Micro-benchmarks of the per-vertex kernels used when drawing vector geometries:
+ * map to pixel conversion and clipping of lines and polygons.
+ *
+ * Run with e.g. "qgis_renderkernelsbench -iterations 100" or "-callgrind".
+ */
+class QgsRenderKernelsBench : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+
+    void mapToPixelPerPoint();
+    void mapToPixelBatch();
+    void trimPolygonInside();
+    void trimPolygonCrossing();
+    void clippedLineInside();
+    void clippedLineCrossing();
+
+  private:
+    //! Number of vertices of the benchmarked geometries
+    static const int VERTICES = 100000;
+
+    QgsMapToPixel mMapToPixel;
+    //! A wavy ring around the origin with a radius of 100 map units
+    QPolygonF mRing;
+    QgsLineString mLine;
+};
+
+void QgsRenderKernelsBench::initTestCase()
+{
+  mMapToPixel = QgsMapToPixel( 0.25, 0, 0, 1000, 1000, 15 );
+
+  mRing.reserve( VERTICES );
+  QVector< double > x;
+  QVector< double > y;
+  x.reserve( VERTICES );
+  y.reserve( VERTICES );
+  for ( int i = 0; i < VERTICES; ++i )
+  {
+    const double angle = 2 * M_PI * i / VERTICES;
+    const double radius = 100 + 10 * std::sin( angle * 200 );
+    mRing << QPointF( radius * std::cos( angle ), radius * std::sin( angle ) );
+    x << mRing.last().x();
+    y << mRing.last().y();
+  }
+  mLine.setPoints( x, y );
+}
+
+void QgsRenderKernelsBench::mapToPixelPerPoint()
+{
+  QBENCHMARK
+  {
+    QPolygonF pts = mRing;
+    QPointF *ptr = pts.data();
+    for ( int i = 0; i < pts.size(); ++i, ++ptr )
+    {
+      mMapToPixel.transformInPlace( ptr->rx(), ptr->ry() );
+    }
+  }
+}
+
+void QgsRenderKernelsBench::mapToPixelBatch()
+{
+  QBENCHMARK
+  {
+    QPolygonF pts = mRing;
+    mMapToPixel.transformInPlace( pts );
+  }
+}
+
+void QgsRenderKernelsBench::trimPolygonInside()
+{
+  const QgsRectangle clipRect( -200, -200, 200, 200 );
+  QBENCHMARK
+  {
+    QPolygonF pts = mRing;
+    QgsClipper::trimPolygon( pts, clipRect );
+  }
+}
+
+void QgsRenderKernelsBench::trimPolygonCrossing()
+{
+  const QgsRectangle clipRect( -50, -200, 200, 95 );
+  QBENCHMARK
+  {
+    QPolygonF pts = mRing;
+    QgsClipper::trimPolygon( pts, clipRect );
+  }
+}
+
+void QgsRenderKernelsBench::clippedLineInside()
+{
+  const QgsRectangle clipRect( -200, -200, 200, 200 );
+  QBENCHMARK
+  {
+    QgsClipper::clippedLine( mLine, clipRect );
+  }
+}
+
+void QgsRenderKernelsBench::clippedLineCrossing()
+{
+  const QgsRectangle clipRect( -50, -200, 200, 95 );
+  QBENCHMARK
+  {
+    QgsClipper::clippedLine( mLine, clipRect );
+  }
+}
+
+QGSTEST_MAIN( QgsRenderKernelsBench )
+#include "qgsrenderkernelsbench.moc"
@@ -34,6 +34,8 @@ class TestQgsClipper: public QObject
     void init() {} // will be called before each testfunction is executed.
     void cleanup() {} // will be called after every testfunction.
     void basic();
+    void trimPolygonInside();
+    void trimPolygonOutside();
   private:
     bool checkBoundingBox( const QPolygonF &polygon, const QgsRectangle &clipRect );
 };
@@ -78,6 +80,40 @@ void TestQgsClipper::basic()
   QVERIFY( ! checkBoundingBox( polygon, clipRectInner ) );
 }
 
+void TestQgsClipper::trimPolygonInside()
+{
+  // polygons completely inside the clip rectangle are left untouched
+  QPolygonF polygon;
+  polygon << QPointF( 1, 1 ) << QPointF( 9, 1 ) << QPointF( 9, 9 ) << QPointF( 1, 9 ) << QPointF( 1, 1 );
+  const QPolygonF original = polygon;
+  QgsClipper::trimPolygon( polygon, QgsRectangle( 0, 0, 10, 10 ) );
+  QCOMPARE( polygon, original );
+
+  // only sticking out on one side
+  polygon << QPointF( 5, 15 );
+  QgsClipper::trimPolygon( polygon, QgsRectangle( 0, 0, 10, 10 ) );
+  QVERIFY( checkBoundingBox( polygon, QgsRectangle( 0, 0, 10, 10 ) ) );
+  QCOMPARE( polygon.boundingRect(), QRectF( 1, 1, 8, 9 ) );
+}
+
+void TestQgsClipper::trimPolygonOutside()
+{
+  QPolygonF polygon;
+  polygon << QPointF( 11, 1 ) << QPointF( 19, 1 ) << QPointF( 19, 9 );
+  QgsClipper::trimPolygon( polygon, QgsRectangle( 0, 0, 10, 10 ) );
+  QVERIFY( polygon.isEmpty() );
+
+  // surrounding the clip rectangle
+  polygon.clear();
+  polygon << QPointF( -10, -10 ) << QPointF( 20, -10 ) << QPointF( 20, 20 ) << QPointF( -10, 20 ) << QPointF( -10, -10 );
+  QgsClipper::trimPolygon( polygon, QgsRectangle( 0, 0, 10, 10 ) );
+  QCOMPARE( polygon.boundingRect(), QRectF( 0, 0, 10, 10 ) );
+
+  polygon.clear();
+  QgsClipper::trimPolygon( polygon, QgsRectangle( 0, 0, 10, 10 ) );
+  QVERIFY( polygon.isEmpty() );
+}
+
 bool TestQgsClipper::checkBoundingBox( const QPolygonF &polygon, const QgsRectangle &clipRect )
 {
   QgsRectangle bBox( polygon.boundingRect() );
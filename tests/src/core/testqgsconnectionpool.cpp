@@ -15,6 +15,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgsapplication.h"
+#include "qgsconnectionpool.h"
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
 #include "qgspoint.h"
@@ -26,6 +27,56 @@
 #include <QtConcurrentMap>
 #include "qgstest.h"
 
+//! Dummy connection for testing the pool templates
+struct TestPoolConnection
+{
+  QString name;
+  bool valid = true;
+};
+
+QString qgsConnectionPool_ConnectionToName( TestPoolConnection *c )
+{
+  return c->name;
+}
+
+void qgsConnectionPool_ConnectionCreate( const QString &name, TestPoolConnection *&c )
+{
+  c = new TestPoolConnection;
+  c->name = name;
+}
+
+void qgsConnectionPool_ConnectionDestroy( TestPoolConnection *c )
+{
+  delete c;
+}
+
+void qgsConnectionPool_InvalidateConnection( TestPoolConnection *c )
+{
+  c->valid = false;
+}
+
+bool qgsConnectionPool_ConnectionIsValid( TestPoolConnection *c )
+{
+  return c->valid;
+}
+
+class TestPoolGroup : public QObject, public QgsConnectionPoolGroup<TestPoolConnection *>
+{
+    Q_OBJECT
+
+  public:
+    explicit TestPoolGroup( const QString &name ) : QgsConnectionPoolGroup<TestPoolConnection *>( name ) { initTimer( this ); }
+
+  protected slots:
+    void handleConnectionExpired() { onConnectionExpired(); }
+    void startExpirationTimer() { expirationTimer->start(); }
+    void stopExpirationTimer() { expirationTimer->stop(); }
+};
+
+class TestPool : public QgsConnectionPool<TestPoolConnection *, TestPoolGroup>
+{
+};
+
 class TestQgsConnectionPool: public QObject
 {
     Q_OBJECT
@@ -34,6 +85,7 @@ class TestQgsConnectionPool: public QObject
     void initTestCase();
     void cleanupTestCase();
     void layersFromSameDatasetGPX();
+    void sharedConnections();
 
   private:
     struct ReadJob
@@ -140,5 +192,50 @@ void TestQgsConnectionPool::layersFromSameDatasetGPX()
   QFile( testFile.fileName() ).remove();
 }
 
+void TestQgsConnectionPool::sharedConnections()
+{
+  TestPool pool;
+  const QString name = QStringLiteral( "test" );
+
+  QList<TestPoolConnection *> conns;
+  for ( int i = 0; i < CONN_POOL_MAX_CONCURRENT_CONNS; ++i )
+    conns << pool.acquireConnection( name, true );
+  QCOMPARE( conns.toSet().count(), CONN_POOL_MAX_CONCURRENT_CONNS );
+
+  QgsConnectionPoolStatistics stats = pool.statistics( name );
+  QCOMPARE( stats.acquired, CONN_POOL_MAX_CONCURRENT_CONNS );
+  QCOMPARE( stats.shared, 0 );
+
+  // the pool is exhausted, shareable acquisitions get the least used connections in turn instead of blocking
+  TestPoolConnection *shared1 = pool.acquireConnection( name, true );
+  TestPoolConnection *shared2 = pool.acquireConnection( name, true );
+  QVERIFY( conns.contains( shared1 ) );
+  QVERIFY( conns.contains( shared2 ) );
+  QVERIFY( shared1 != shared2 );
+
+  stats = pool.statistics( name );
+  QCOMPARE( stats.acquired, CONN_POOL_MAX_CONCURRENT_CONNS + 2 );
+  QCOMPARE( stats.shared, 2 );
+
+  // connections go back to the pool once all their users have released them
+  pool.releaseConnection( shared1 );
+  for ( TestPoolConnection *c : qgsAsConst( conns ) )
+    pool.releaseConnection( c );
+
+  // shared2 still has a user, all other connections can be acquired without blocking
+  QList<TestPoolConnection *> exclusive;
+  for ( int i = 0; i < CONN_POOL_MAX_CONCURRENT_CONNS - 1; ++i )
+    exclusive << pool.acquireConnection( name );
+  QVERIFY( !exclusive.contains( shared2 ) );
+  QCOMPARE( exclusive.toSet().count(), CONN_POOL_MAX_CONCURRENT_CONNS - 1 );
+
+  for ( TestPoolConnection *c : qgsAsConst( exclusive ) )
+    pool.releaseConnection( c );
+  pool.releaseConnection( shared2 );
+
+  stats = pool.statistics( QStringLiteral( "unknown" ) );
+  QCOMPARE( stats.acquired, 0 );
+}
+
 QGSTEST_MAIN( TestQgsConnectionPool )
 #include "testqgsconnectionpool.moc"
@@ -33,6 +33,8 @@
 #include "qgsrasterlayer.h"
 #include "qgsproject.h"
 #include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionprogram.h"
+#include "qgsaggregatecache.h"
 
 static void _parseAndEvalExpr( int arg )
 {
@@ -44,6 +46,29 @@ static void _parseAndEvalExpr( int arg )
   }
 }
 
+//! Replaces the upper() function, to check that functions of the context take precedence
+class UpperOverrideFunction : public QgsScopedExpressionFunction
+{
+  public:
+    UpperOverrideFunction()
+      : QgsScopedExpressionFunction( QStringLiteral( "upper" ), 1, QStringLiteral( "test" ) ) {}
+
+    virtual QVariant func( const QVariantList &values, const QgsExpressionContext *, QgsExpression *, const QgsExpressionNodeFunction * ) override
+    {
+      sCalls++;
+      return values.at( 0 ).toString() + '!';
+    }
+
+    QgsScopedExpressionFunction *clone() const override
+    {
+      return new UpperOverrideFunction();
+    }
+
+    static int sCalls;
+};
+
+int UpperOverrideFunction::sCalls = 0;
+
 class TestQgsExpression: public QObject
 {
     Q_OBJECT
@@ -1288,6 +1313,249 @@ class TestQgsExpression: public QObject
       run_evaluation_test( exp3, evalError, result );
       QgsExpression exp4( exp );
       run_evaluation_test( exp4, evalError, result );
+      QgsExpression exp5( string );
+      exp5.compile();
+      run_evaluation_test( exp5, evalError, result );
+    }
+
+    void compile_data()
+    {
+      QTest::addColumn<QString>( "string" );
+
+      QTest::newRow( "int arithmetic" ) << "int_f * 2 + ll_f - 1";
+      QTest::newRow( "division" ) << "int_f / 2";
+      QTest::newRow( "integer division" ) << "int_f // 2";
+      QTest::newRow( "modulo zero" ) << "int_f % 0";
+      QTest::newRow( "double modulo" ) << "dbl_f % 2";
+      QTest::newRow( "power" ) << "int_f ^ 2";
+      QTest::newRow( "overflow" ) << "dbl_f * 1e308 * 10";
+      QTest::newRow( "minus int" ) << "-int_f";
+      QTest::newRow( "minus double" ) << "-dbl_f";
+      QTest::newRow( "minus string" ) << "-str_f";
+      QTest::newRow( "minus numeric string" ) << "-num_str_f";
+      QTest::newRow( "string plus" ) << "str_f + 'd'";
+      QTest::newRow( "numeric string plus" ) << "num_str_f + 1";
+      QTest::newRow( "concat" ) << "str_f || int_f";
+      QTest::newRow( "concat null" ) << "str_f || null_f";
+      QTest::newRow( "null plus" ) << "null_f + 1";
+      QTest::newRow( "and" ) << "int_f = 5 and dbl_f > 2";
+      QTest::newRow( "or" ) << "int_f <> 5 or null_f = 1";
+      QTest::newRow( "not bool" ) << "not bool_f";
+      QTest::newRow( "bool string compare" ) << "bool_f = 'true'";
+      QTest::newRow( "string compare" ) << "str_f > 'abb'";
+      QTest::newRow( "numeric string compare" ) << "num_str_f = 12";
+      QTest::newRow( "string string compare" ) << "num_str_f = '12.0'";
+      QTest::newRow( "is null" ) << "null_f is null";
+      QTest::newRow( "is not" ) << "int_f is not 5.0";
+      QTest::newRow( "string is" ) << "str_f is 'abc'";
+      QTest::newRow( "in" ) << "int_f in (1, 5, 7)";
+      QTest::newRow( "not in" ) << "str_f not in ('a', 'b')";
+      QTest::newRow( "numeric string in" ) << "num_str_f in (12)";
+      QTest::newRow( "null in" ) << "null_f in (1)";
+      QTest::newRow( "in list with null" ) << "int_f in (1, null)";
+      QTest::newRow( "in non static list" ) << "( int_f in (int_f, 2) ) = 1";
+      QTest::newRow( "case" ) << "case when int_f > 3 then 'big' when int_f > 1 then 'small' end";
+      QTest::newRow( "case else" ) << "case when null_f then 1 else dbl_f end";
+      QTest::newRow( "case conversion error" ) << "case when str_f then 1 else 0 end";
+      QTest::newRow( "date plus interval" ) << "date_f + '1 day'";
+      QTest::newRow( "like" ) << "str_f like 'a%'";
+      QTest::newRow( "regexp" ) << "str_f ~ 'b'";
+      QTest::newRow( "function argument" ) << "upper(str_f) = 'ABC'";
+      QTest::newRow( "math functions" ) << "abs(dbl_f) + sqrt(int_f) + floor(dbl_f) * ceil(dbl_f)";
+      QTest::newRow( "sqrt negative" ) << "sqrt(dbl_f)";
+      QTest::newRow( "to_real" ) << "to_real(int_f)";
+      QTest::newRow( "to_real numeric string" ) << "to_real(num_str_f)";
+      QTest::newRow( "to_real error" ) << "to_real(str_f)";
+      QTest::newRow( "string functions" ) << "upper(str_f) || lower('A') || trim(num_str_f)";
+      QTest::newRow( "string function on number" ) << "upper(int_f)";
+      QTest::newRow( "coalesce" ) << "coalesce(null_f, int_f, str_f)";
+      QTest::newRow( "case in function" ) << "abs(case when int_f > 3 then dbl_f else -int_f end)";
+      QTest::newRow( "repeated subexpression" ) << "( int_f + 1 ) * ( int_f + 1 ) - ( int_f + 1 )";
+      QTest::newRow( "repeated in branches" ) << "case when int_f > 3 then upper(str_f) when dbl_f > 0 then upper(str_f) || 'x' else lower(str_f) || upper(str_f) end || upper(str_f)";
+      QTest::newRow( "repeated condition" ) << "case when dbl_f < 0 then 1 when int_f > 3 and dbl_f < 0 then 2 else dbl_f < 0 end";
+      QTest::newRow( "static conditions" ) << "case when 1 = 2 then int_f when 1 = 1 then dbl_f else str_f end";
+      QTest::newRow( "static null condition" ) << "case when null then int_f end";
+      QTest::newRow( "static string condition" ) << "case when 'abc' then int_f else dbl_f end";
+      QTest::newRow( "function operand" ) << "int_f + $id";
+      QTest::newRow( "static subexpression" ) << "int_f + (2 * 3)";
+    }
+
+    void compile()
+    {
+      QFETCH( QString, string );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int_f" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "ll_f" ), QVariant::LongLong ) );
+      fields.append( QgsField( QStringLiteral( "dbl_f" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "str_f" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "num_str_f" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "null_f" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "date_f" ), QVariant::Date ) );
+      fields.append( QgsField( QStringLiteral( "bool_f" ), QVariant::Bool ) );
+
+      QgsFeature f1( fields, 1 );
+      f1.setAttributes( QgsAttributes() << QVariant( 5 ) << QVariant( 3000000000LL ) << QVariant( 2.5 ) << QVariant( "abc" )
+                        << QVariant( "12" ) << QVariant( QVariant::Int ) << QVariant( QDate( 2017, 10, 1 ) ) << QVariant( true ) );
+      QgsFeature f2( fields, 2 );
+      f2.setAttributes( QgsAttributes() << QVariant( QVariant::Int ) << QVariant( 2LL ) << QVariant( -1.5 ) << QVariant( "" )
+                        << QVariant( "x" ) << QVariant( 7 ) << QVariant( QVariant::Date ) << QVariant( false ) );
+
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f1, fields );
+
+      QgsExpression tree( string );
+      QVERIFY( !tree.hasParserError() );
+      tree.prepare( &context );
+
+      QgsExpression compiled( string );
+      compiled.prepare( &context );
+      QVERIFY( compiled.compile() );
+      QVERIFY( compiled.isCompiled() );
+
+      // evaluate with both features twice, to check that values of previous evaluations are not reused
+      const QList< QgsFeature > features = QList< QgsFeature >() << f1 << f2 << f1 << f2;
+      QVariantList blockResults;
+      QString blockError;
+      for ( const QgsFeature &feature : features )
+      {
+        context.setFeature( feature );
+        const QVariant expected = tree.evaluate( &context );
+        const QVariant result = compiled.evaluate( &context );
+        QCOMPARE( compiled.hasEvalError(), tree.hasEvalError() );
+        QCOMPARE( compiled.evalErrorString(), tree.evalErrorString() );
+        QCOMPARE( result.type(), expected.type() );
+        QCOMPARE( result.isNull(), expected.isNull() );
+        QCOMPARE( result, expected );
+
+        // features with an error get NULL when evaluating a block
+        blockResults << ( tree.hasEvalError() ? QVariant() : expected );
+        if ( blockError.isNull() )
+          blockError = tree.evalErrorString();
+      }
+
+      // evaluating the features as a block, with and without compiling
+      QList< QgsExpression * > expressions = QList< QgsExpression * >() << &tree << &compiled;
+      for ( QgsExpression *exp : expressions )
+      {
+        const QVariantList results = exp->evaluate( &context, features );
+        QCOMPARE( results.count(), blockResults.count() );
+        for ( int i = 0; i < results.count(); ++i )
+        {
+          QCOMPARE( results.at( i ).type(), blockResults.at( i ).type() );
+          QCOMPARE( results.at( i ).isNull(), blockResults.at( i ).isNull() );
+          QCOMPARE( results.at( i ), blockResults.at( i ) );
+        }
+        QCOMPARE( exp->evalErrorString(), blockError );
+      }
+
+      // preparing again discards the program
+      compiled.prepare( &context );
+      QVERIFY( !compiled.isCompiled() );
+    }
+
+    void compile_fallback()
+    {
+      QgsExpressionContext context;
+      QgsExpression empty;
+      QVERIFY( !empty.compile() );
+
+      // nothing to gain if the whole expression is evaluated by the tree
+      QgsExpression function( QStringLiteral( "$id" ) );
+      function.prepare( &context );
+      QVERIFY( !function.compile() );
+      QVERIFY( !function.isCompiled() );
+
+      // static expressions are compiled to their value
+      QgsExpression staticExp( QStringLiteral( "1 + 2" ) );
+      staticExp.prepare( &context );
+      QVERIFY( staticExp.compile() );
+      QCOMPARE( staticExp.evaluate( &context ), QVariant( 3LL ) );
+
+      // copies share the program
+      QgsExpression copy( staticExp );
+      QVERIFY( copy.isCompiled() );
+      QCOMPARE( copy.evaluate( &context, QList< QgsFeature >() << QgsFeature() << QgsFeature() ), QVariantList() << 3LL << 3LL );
+      QVERIFY( copy.evaluate( &context, QList< QgsFeature >() ).isEmpty() );
+
+      // functions provided by the context are evaluated by the tree
+      QgsExpression overridden( QStringLiteral( "upper( 'a' || $id )" ) );
+      overridden.prepare( &context );
+      QVERIFY( overridden.compile() );
+      QgsExpressionContextScope *scope = new QgsExpressionContextScope();
+      scope->addFunction( QStringLiteral( "upper" ), new UpperOverrideFunction() );
+      context.appendScope( scope );
+      QgsFeature feature( 5 );
+      QCOMPARE( overridden.evaluate( &context, QList< QgsFeature >() << feature ), QVariantList() << QVariant( "a5!" ) );
+      context.setFeature( feature );
+      QCOMPARE( overridden.evaluate( &context ), QVariant( "a5!" ) );
+    }
+
+    void compile_subexpressions()
+    {
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int_f" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "str_f" ), QVariant::String ) );
+      QgsFeature f1( fields, 1 );
+      f1.setAttributes( QgsAttributes() << QVariant( 5 ) << QVariant( "abc" ) );
+      QgsFeature f2( fields, 2 );
+      f2.setAttributes( QgsAttributes() << QVariant( 7 ) << QVariant( "xyz" ) );
+
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f1, fields );
+      QgsExpressionContextScope *scope = new QgsExpressionContextScope();
+      scope->addFunction( QStringLiteral( "upper" ), new UpperOverrideFunction() );
+      context.appendScope( scope );
+      context.setFeature( f1 );
+
+      // identical subexpressions are evaluated once
+      UpperOverrideFunction::sCalls = 0;
+      QgsExpression exp( QStringLiteral( "upper( str_f ) || upper(str_f)" ) );
+      exp.prepare( &context );
+      QVERIFY( exp.compile() );
+      QCOMPARE( exp.evaluate( &context ), QVariant( "abc!abc!" ) );
+      QCOMPARE( UpperOverrideFunction::sCalls, 1 );
+
+      // unless the first one may be skipped
+      UpperOverrideFunction::sCalls = 0;
+      QgsExpression branches( QStringLiteral( "case when int_f > 10 then upper( str_f ) else 'x' end || upper( str_f )" ) );
+      branches.prepare( &context );
+      QVERIFY( branches.compile() );
+      QCOMPARE( branches.evaluate( &context ), QVariant( "xabc!" ) );
+      QCOMPARE( UpperOverrideFunction::sCalls, 1 );
+
+      // costly subexpressions can be shared between expressions
+      QgsExpressionValueCache sharedValues;
+      QgsExpression filter1( QStringLiteral( "upper( str_f ) = 'ABC!'" ) );
+      filter1.prepare( &context );
+      QVERIFY( filter1.compile( &sharedValues ) );
+      QgsExpression filter2( QStringLiteral( "upper( str_f ) || int_f" ) );
+      filter2.prepare( &context );
+      QVERIFY( filter2.compile( &sharedValues ) );
+      QCOMPARE( sharedValues.count(), 3 );
+
+      UpperOverrideFunction::sCalls = 0;
+      sharedValues.startFeature();
+      QCOMPARE( filter1.evaluate( &context ), QVariant( 0 ) );
+      QCOMPARE( filter2.evaluate( &context ), QVariant( "abc!5" ) );
+      QCOMPARE( filter1.evaluate( &context ), QVariant( 0 ) );
+      sharedValues.endFeature();
+      QCOMPARE( UpperOverrideFunction::sCalls, 1 );
+
+      // values are only shared between startFeature() and endFeature()
+      QCOMPARE( filter2.evaluate( &context ), QVariant( "abc!5" ) );
+      QCOMPARE( UpperOverrideFunction::sCalls, 2 );
+
+      context.setFeature( f2 );
+      sharedValues.startFeature();
+      QCOMPARE( filter2.evaluate( &context ), QVariant( "xyz!7" ) );
+      QCOMPARE( filter1.evaluate( &context ), QVariant( 0 ) );
+      sharedValues.endFeature();
+      QCOMPARE( UpperOverrideFunction::sCalls, 3 );
+
+      // volatile functions are never shared
+      QgsExpression random( QStringLiteral( "rand( 1, 1000000000 ) = rand( 1, 1000000000 )" ) );
+      random.prepare( &context );
+      QVERIFY( random.compile() );
+      QCOMPARE( random.evaluate( &context ), QVariant( 0 ) );
     }
 
     void eval_columns()
@@ -1685,6 +1953,162 @@ class TestQgsExpression: public QObject
       QCOMPARE( res, result );
     }
 
+    void aggregateCache()
+    {
+      QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?field=col1:integer" ), QStringLiteral( "cache_layer" ), QStringLiteral( "memory" ) );
+      QVERIFY( layer->isValid() );
+      QgsFeatureList features;
+      for ( int i = 1; i <= 3; ++i )
+      {
+        QgsFeature f( layer->fields() );
+        f.setAttribute( 0, i );
+        features << f;
+      }
+      layer->dataProvider()->addFeatures( features );
+      QgsProject::instance()->addMapLayer( layer );
+
+      QgsAggregateCache *cache = QgsApplication::aggregateCache();
+      const int count = cache->count();
+
+      QgsExpressionContext context;
+      QgsExpression exp( QStringLiteral( "aggregate('cache_layer','sum',\"col1\")" ) );
+      QCOMPARE( exp.evaluate( &context ), QVariant( 6 ) );
+      QCOMPARE( cache->count(), count + 1 );
+
+      // result is shared with other contexts
+      QgsExpressionContext otherContext;
+      QCOMPARE( exp.evaluate( &otherContext ), QVariant( 6 ) );
+      QCOMPARE( cache->count(), count + 1 );
+
+      // aggregates depending on the context are not shared
+      QgsExpressionContextScope *scope = new QgsExpressionContextScope();
+      scope->setVariable( QStringLiteral( "max_value" ), 2 );
+      otherContext << scope;
+      QgsExpression contextExp( QStringLiteral( "aggregate('cache_layer','sum',\"col1\",\"col1\" <= @max_value)" ) );
+      QCOMPARE( contextExp.evaluate( &otherContext ), QVariant( 3 ) );
+      QCOMPARE( cache->count(), count + 1 );
+
+      // edits invalidate the cached results
+      layer->startEditing();
+      QgsFeature added( layer->fields() );
+      added.setAttribute( 0, 10 );
+      layer->addFeature( added );
+      QCOMPARE( cache->count(), count );
+      QgsExpressionContext editContext;
+      QCOMPARE( exp.evaluate( &editContext ), QVariant( 16 ) );
+
+      QgsFeature f;
+      layer->getFeatures( QgsFeatureRequest().setFilterExpression( QStringLiteral( "col1 = 1" ) ) ).nextFeature( f );
+      layer->changeAttributeValue( f.id(), 0, 5 );
+      QgsExpressionContext changeContext;
+      QCOMPARE( exp.evaluate( &changeContext ), QVariant( 20 ) );
+
+      layer->rollBack();
+      QgsExpressionContext rollBackContext;
+      QCOMPARE( exp.evaluate( &rollBackContext ), QVariant( 6 ) );
+
+      // results calculated while the layer changed are discarded
+      const quint64 generation = cache->layerGeneration( layer );
+      layer->dataProvider()->addFeatures( QgsFeatureList() << added );
+      emit layer->dataChanged();
+      cache->setCachedValue( layer, QStringLiteral( "stale" ), 6, generation );
+      QVariant value;
+      QVERIFY( !cache->cachedValue( layer, QStringLiteral( "stale" ), value ) );
+      QgsExpressionContext providerContext;
+      QCOMPARE( exp.evaluate( &providerContext ), QVariant( 16 ) );
+
+      QgsProject::instance()->removeMapLayer( layer );
+      QCOMPARE( cache->count(), count );
+    }
+
+    void aggregateCacheIsCacheable_data()
+    {
+      QTest::addColumn<QString>( "string" );
+      QTest::addColumn<bool>( "cacheable" );
+
+      QTest::newRow( "empty filter" ) << QString() << true;
+      QTest::newRow( "field" ) << "\"col1\"" << true;
+      QTest::newRow( "expression" ) << "upper(\"col2\") || 'x' = 'ax' AND \"col1\" IN (1, 2)" << true;
+      QTest::newRow( "geometry" ) << "area($geometry) > 5" << true;
+      QTest::newRow( "variable" ) << "\"col1\" = @value" << false;
+      QTest::newRow( "parent" ) << "\"col1\" = attribute(@parent, 'col1')" << false;
+      QTest::newRow( "random" ) << "rand(1, 10)" << false;
+      QTest::newRow( "in condition" ) << "CASE WHEN \"col1\" > 1 THEN now() END" << false;
+      QTest::newRow( "selection" ) << "is_selected()" << false;
+      QTest::newRow( "other layer" ) << "get_feature('test', 'col1', \"col1\")" << false;
+      QTest::newRow( "nested aggregate" ) << "\"col1\" > sum(\"col1\")" << false;
+      QTest::newRow( "overridden" ) << "upper(\"col2\")" << false;
+    }
+
+    void aggregateCacheIsCacheable()
+    {
+      QFETCH( QString, string );
+      QFETCH( bool, cacheable );
+
+      QgsExpressionContext context;
+      QgsExpressionContextScope *scope = new QgsExpressionContextScope();
+      if ( QString( QTest::currentDataTag() ) == QLatin1String( "overridden" ) )
+        scope->addFunction( QStringLiteral( "upper" ), new UpperOverrideFunction() );
+      context << scope;
+
+      QCOMPARE( QgsAggregateCache::isCacheable( QgsExpression( string ), &context ), cacheable );
+    }
+
+    void relationAggregateGrouped()
+    {
+      QgsAggregateCache *cache = QgsApplication::aggregateCache();
+      cache->clear();
+
+      QgsExpression exp( QStringLiteral( "relation_aggregate('my_rel','sum',\"col3\" * 10)" ) );
+      QgsExpression filterExp( QStringLiteral( "aggregate('child_layer','sum',\"col3\" * 10, \"parent\" = attribute(@parent, 'col1'))" ) );
+
+      // the aggregates of all parent features are calculated at once
+      QgsFeatureIterator it = mAggregatesLayer->getFeatures();
+      QgsFeature parentFeature;
+      while ( it.nextFeature( parentFeature ) )
+      {
+        QgsExpressionContext context;
+        context.appendScope( QgsExpressionContextUtils::layerScope( mAggregatesLayer ) );
+        context.setFeature( parentFeature );
+        const QVariant result = exp.evaluate( &context );
+        QVERIFY( !exp.hasEvalError() );
+
+        // same results as with a filter for each parent feature
+        const QVariant expected = filterExp.evaluate( &context );
+        QCOMPARE( result.toInt(), expected.toInt() );
+        QCOMPARE( result.isNull(), expected.isNull() );
+        QCOMPARE( cache->count(), 1 );
+      }
+
+      // edits of the child layer invalidate the grouped results
+      QgsFeature f;
+      mChildLayer->getFeatures( QgsFeatureRequest().setFilterExpression( QStringLiteral( "col2 = 'test4'" ) ) ).nextFeature( f );
+      mChildLayer->startEditing();
+      mChildLayer->changeAttributeValue( f.id(), mChildLayer->fields().lookupField( QStringLiteral( "parent" ) ), 4 );
+      QCOMPARE( cache->count(), 0 );
+
+      QgsFeature parent( mAggregatesLayer->fields() );
+      parent.setAttribute( QStringLiteral( "col1" ), 4 );
+      QgsExpressionContext context;
+      context.appendScope( QgsExpressionContextUtils::layerScope( mAggregatesLayer ) );
+      context.setFeature( parent );
+      QCOMPARE( exp.evaluate( &context ), QVariant( 70 ) );
+      mChildLayer->rollBack();
+
+      QgsExpressionContext rollBackContext;
+      rollBackContext.appendScope( QgsExpressionContextUtils::layerScope( mAggregatesLayer ) );
+      rollBackContext.setFeature( parent );
+      QCOMPARE( exp.evaluate( &rollBackContext ), QVariant( 50 ) );
+
+      // values which would be rounded by the referencing field type do not match any group
+      parent.setAttribute( QStringLiteral( "col1" ), 4.4 );
+      QgsExpressionContext doubleContext;
+      doubleContext.appendScope( QgsExpressionContextUtils::layerScope( mAggregatesLayer ) );
+      doubleContext.setFeature( parent );
+      QCOMPARE( exp.evaluate( &doubleContext ), filterExp.evaluate( &doubleContext ) );
+      QCOMPARE( exp.evaluate( &doubleContext ).toInt(), 0 );
+    }
+
     void get_feature_geometry()
     {
       //test that get_feature fetches feature's geometry
@@ -2955,6 +2955,24 @@ void TestQgsGeometry::lineString()
   QCOMPARE( poly.at( 3 ).x(), 1.0 );
   QCOMPARE( poly.at( 3 ).y(), 22.0 );
 
+  // raw coordinate data
+  const double *xData = l13.xData();
+  const double *yData = l13.yData();
+  const double *zData = l13.zData();
+  const double *mData = l13.mData();
+  QCOMPARE( xData[0], 1.0 );
+  QCOMPARE( yData[1], 2.0 );
+  QCOMPARE( xData[3], 1.0 );
+  QCOMPARE( yData[3], 22.0 );
+  QCOMPARE( zData[2], 21.0 );
+  QCOMPARE( mData[3], 34.0 );
+  QgsLineString l13b;
+  l13b.setPoints( QgsPointSequence() << QgsPoint( 1, 2 ) << QgsPoint( 11, 12 ) );
+  QVERIFY( !l13b.zData() );
+  QVERIFY( !l13b.mData() );
+  QCOMPARE( l13b.asQPolygonF(), QPolygonF() << QPointF( 1, 2 ) << QPointF( 11, 12 ) );
+  QVERIFY( QgsLineString().asQPolygonF().isEmpty() );
+
   // clone tests. At the same time, check segmentize as the result should
   // be equal to a clone for LineStrings
   QgsLineString l14;
@@ -3222,6 +3240,23 @@ void TestQgsGeometry::lineString()
   QCOMPARE( l23.pointN( 1 ), QgsPoint( QgsWkbTypes::PointZM, 22, 36, 13, 14 ) );
   QCOMPARE( l23.boundingBox(), QgsRectangle( 2, 6, 22, 36 ) );
 
+  // affine and projective transforms
+  l23.setPoints( QgsPointSequence() << QgsPoint( 1, 2 ) << QgsPoint( 11, 12 ) );
+  QTransform qtr2 = QTransform().translate( 10, 20 ).rotate( 90 );
+  l23.transform( qtr2 );
+  QGSCOMPARENEAR( l23.xAt( 0 ), 8.0, 0.0000001 );
+  QGSCOMPARENEAR( l23.yAt( 0 ), 21.0, 0.0000001 );
+  QGSCOMPARENEAR( l23.xAt( 1 ), -2.0, 0.0000001 );
+  QGSCOMPARENEAR( l23.yAt( 1 ), 31.0, 0.0000001 );
+  l23.setPoints( QgsPointSequence() << QgsPoint( 1, 2 ) << QgsPoint( 11, 12 ) );
+  QTransform qtr3( 1, 0, 0.5, 0, 1, 0, 0, 0, 1 );
+  QVERIFY( !qtr3.isAffine() );
+  l23.transform( qtr3 );
+  QGSCOMPARENEAR( l23.xAt( 0 ), 1.0 / 1.5, 0.0000001 );
+  QGSCOMPARENEAR( l23.yAt( 0 ), 2.0 / 1.5, 0.0000001 );
+  QGSCOMPARENEAR( l23.xAt( 1 ), 11.0 / 6.5, 0.0000001 );
+  QGSCOMPARENEAR( l23.yAt( 1 ), 12.0 / 6.5, 0.0000001 );
+
   //insert vertex
 
   //insert vertex in empty line
@@ -14979,6 +15014,26 @@ void TestQgsGeometry::wkbInOut()
   badHeader.fromWkb( wkb, size );
   QVERIFY( badHeader.isNull() );
   QCOMPARE( badHeader.wkbType(), QgsWkbTypes::Unknown );
+
+  // decoding into an unshared geometry of the same type recycles it
+  QgsGeometry recycled = QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 0),(1 1, 2 1, 2 2, 1 1))" ) );
+  const QgsAbstractGeometry *previous = recycled.geometry();
+  recycled.fromWkb( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 5 0, 5 5, 0 5, 0 0))" ) ).exportToWkb() );
+  QCOMPARE( recycled.geometry(), previous );
+  QCOMPARE( recycled.exportToWkt(), QStringLiteral( "Polygon ((0 0, 5 0, 5 5, 0 5, 0 0))" ) );
+  recycled.fromWkb( QgsGeometry::fromWkt( QStringLiteral( "LineString (1 1, 2 2)" ) ).exportToWkb() );
+  QCOMPARE( recycled.exportToWkt(), QStringLiteral( "LineString (1 1, 2 2)" ) );
+
+  recycled = QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon (((0 0, 10 0, 10 10, 0 0)),((20 20, 30 20, 30 30, 20 20)))" ) );
+  recycled.fromWkb( QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon (((0 0, 5 0, 5 5, 0 0),(1 1, 2 1, 2 2, 1 1)))" ) ).exportToWkb() );
+  QCOMPARE( recycled.exportToWkt(), QStringLiteral( "MultiPolygon (((0 0, 5 0, 5 5, 0 0),(1 1, 2 1, 2 2, 1 1)))" ) );
+  QCOMPARE( recycled.boundingBox(), QgsRectangle( 0, 0, 5, 5 ) );
+
+  // shared geometries must not be modified
+  QgsGeometry shared = recycled;
+  recycled.fromWkb( QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon (((5 5, 6 5, 6 6, 5 5)))" ) ).exportToWkb() );
+  QCOMPARE( recycled.exportToWkt(), QStringLiteral( "MultiPolygon (((5 5, 6 5, 6 6, 5 5)))" ) );
+  QCOMPARE( shared.exportToWkt(), QStringLiteral( "MultiPolygon (((0 0, 5 0, 5 5, 0 0),(1 1, 2 1, 2 2, 1 1)))" ) );
 }
 
 void TestQgsGeometry::directionNeutralSegmentation()
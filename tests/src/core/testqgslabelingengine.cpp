@@ -17,6 +17,7 @@
 
 #include <qgsapplication.h>
 #include <qgslabelingengine.h>
+#include <qgslabelplacementcache.h>
 #include <qgsproject.h>
 #include <qgsmaprenderersequentialjob.h>
 #include <qgsreadwritecontext.h>
@@ -48,6 +49,7 @@ class TestQgsLabelingEngine : public QObject
     void testCapitalization();
     void testParticipatingLayers();
     void testRegisterFeatureUnprojectible();
+    void testPlacementCache();
 
   private:
     QgsVectorLayer *vl = nullptr;
@@ -623,5 +625,72 @@ void TestQgsLabelingEngine::testRegisterFeatureUnprojectible()
   QCOMPARE( provider->mLabels.size(), 0 );
 }
 
+void TestQgsLabelingEngine::testPlacementCache()
+{
+  QgsPalLayerSettings settings;
+  settings.fieldName = QStringLiteral( "Class" );
+  setDefaultLabelParams( settings );
+  vl->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 640, 480 ) );
+  mapSettings.setExtent( vl->extent() );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl );
+  mapSettings.setOutputDpi( 96 );
+
+  QgsLabelPlacementCache cache;
+  QgsMapRendererSequentialJob job( mapSettings );
+  job.setLabelPlacementCache( &cache );
+  job.start();
+  job.waitForFinished();
+  std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+  QList<QgsLabelPosition> labels = results->labelsWithinRect( mapSettings.extent() );
+  QVERIFY( !labels.isEmpty() );
+
+  // all placed labels are stored in the cache
+  QgsLabelPlacementCache::LayerPlacements placements = cache.layerPlacements( vl->id(), mapSettings.scale() );
+  int count = 0;
+  Q_FOREACH ( const QList< QgsLabelPlacementCache::Placement > &featurePlacements, placements )
+    count += featurePlacements.count();
+  QCOMPARE( count, labels.count() );
+  QVERIFY( cache.layerPlacements( vl->id(), mapSettings.scale() * 2 ).isEmpty() );
+
+  // pan the map - labels which are still visible must keep their position
+  QgsRectangle extent = mapSettings.extent();
+  const double shift = extent.width() / 10;
+  extent.setXMinimum( extent.xMinimum() + shift );
+  extent.setXMaximum( extent.xMaximum() + shift );
+  mapSettings.setExtent( extent );
+
+  QgsMapRendererSequentialJob job2( mapSettings );
+  job2.setLabelPlacementCache( &cache );
+  job2.start();
+  job2.waitForFinished();
+  std::unique_ptr< QgsLabelingResults > results2( job2.takeLabelingResults() );
+  QList<QgsLabelPosition> labels2 = results2->labelsWithinRect( mapSettings.extent() );
+  QVERIFY( !labels2.isEmpty() );
+
+  int kept = 0;
+  Q_FOREACH ( const QgsLabelPosition &label2, labels2 )
+  {
+    Q_FOREACH ( const QgsLabelPosition &label, labels )
+    {
+      if ( label.featureId != label2.featureId || !mapSettings.visibleExtent().contains( label.labelRect ) )
+        continue;
+
+      QGSCOMPARENEAR( label2.labelRect.xMinimum(), label.labelRect.xMinimum(), 1e-6 );
+      QGSCOMPARENEAR( label2.labelRect.yMinimum(), label.labelRect.yMinimum(), 1e-6 );
+      kept++;
+    }
+  }
+  QVERIFY( kept > 0 );
+
+  // changes to the layer invalidate its placements
+  vl->triggerRepaint();
+  QVERIFY( cache.layerPlacements( vl->id(), mapSettings.scale() ).isEmpty() );
+
+  vl->setLabeling( nullptr );
+}
+
 QGSTEST_MAIN( TestQgsLabelingEngine )
 #include "testqgslabelingengine.moc"
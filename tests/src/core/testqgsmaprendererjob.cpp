@@ -75,6 +75,7 @@ class TestQgsMapRendererJob : public QObject
      */
     void testFourAdjacentTiles_data();
     void testFourAdjacentTiles();
+    void profile();
 
   private:
     QString mEncoding;
@@ -329,6 +330,37 @@ void TestQgsMapRendererJob::testFourAdjacentTiles()
   QVERIFY( result );
 }
 
+void TestQgsMapRendererJob::profile()
+{
+  QgsMapSettings mapSettings;
+  mapSettings.setExtent( QgsRectangle( -10, -10, 10, 10 ) );
+  mapSettings.setOutputSize( QSize( 100, 100 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << mpPolysLayer );
+
+  QgsMapRendererSequentialJob renderJob( mapSettings );
+  QVERIFY( !renderJob.isProfilingEnabled() );
+  renderJob.start();
+  renderJob.waitForFinished();
+  QVERIFY( renderJob.profile().counts().isEmpty() );
+
+  QgsMapRendererSequentialJob profiledJob( mapSettings );
+  profiledJob.setProfilingEnabled( true );
+  profiledJob.start();
+  profiledJob.waitForFinished();
+
+  const QString layerId = mpPolysLayer->id();
+  const QgsRuntimeProfiler &profile = profiledJob.profile();
+  // 0.5 degree squares within the extent
+  QVERIFY( profile.count( layerId + QStringLiteral( "/features" ) ) >= 40 * 40 );
+  QCOMPARE( profile.count( layerId + QStringLiteral( "/vertices" ) ), profile.count( layerId + QStringLiteral( "/features" ) ) * 5 );
+  QVERIFY( profile.profileTime( layerId + QStringLiteral( "/fetch" ) ) > 0 );
+  QVERIFY( profile.profileTime( layerId + QStringLiteral( "/draw" ) ) > 0 );
+  QVERIFY( profile.profileTime( layerId + QStringLiteral( "/transform" ) ) > 0 );
+  QVERIFY( profile.profileTime( layerId + QStringLiteral( "/draw" ) ) >= profile.profileTime( layerId + QStringLiteral( "/transform" ) ) );
+  QCOMPARE( profile.count( layerId + QStringLiteral( "/cached" ) ), 0LL );
+  QVERIFY( profile.toJson().contains( QStringLiteral( "\"%1/fetch\"" ).arg( layerId ) ) );
+}
+
 
 QGSTEST_MAIN( TestQgsMapRendererJob )
 #include "testqgsmaprendererjob.moc"
@@ -29,6 +29,7 @@ class TestQgsMapToPixel: public QObject
     void getters();
     void fromScale();
     void toMapPoint();
+    void transformPolygon();
 };
 
 void TestQgsMapToPixel::rotation()
@@ -119,6 +120,30 @@ void TestQgsMapToPixel::toMapPoint()
   QCOMPARE( p, QgsPointXY( 20, 20 ) );
 }
 
+void TestQgsMapToPixel::transformPolygon()
+{
+  QgsMapToPixel m2p( 0.5, 5, 5, 10, 10, 30 );
+
+  // odd number of points, so that both the batched and the remaining points are transformed
+  QPolygonF poly;
+  poly << QPointF( 5, 5 ) << QPointF( 10, 10 ) << QPointF( -3.5, 7.25 ) << QPointF( 1e6, -1e6 ) << QPointF( 0, 0 );
+  QPolygonF expected = poly;
+  for ( int i = 0; i < expected.size(); ++i )
+    m2p.transformInPlace( expected[i].rx(), expected[i].ry() );
+
+  m2p.transformInPlace( poly );
+  QCOMPARE( poly.size(), expected.size() );
+  for ( int i = 0; i < poly.size(); ++i )
+  {
+    QGSCOMPARENEAR( poly.at( i ).x(), expected.at( i ).x(), 0.000001 );
+    QGSCOMPARENEAR( poly.at( i ).y(), expected.at( i ).y(), 0.000001 );
+  }
+
+  poly.clear();
+  m2p.transformInPlace( poly );
+  QVERIFY( poly.isEmpty() );
+}
+
 QGSTEST_MAIN( TestQgsMapToPixel )
 #include "testqgsmaptopixel.moc"
 
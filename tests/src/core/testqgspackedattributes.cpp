@@ -0,0 +1,211 @@
+/***************************************************************************
+     testqgspackedattributes.cpp
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QDateTime>
+
+#include "qgsapplication.h"
+#include "qgspackedattributes.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsgeometry.h"
+
+class TestQgsPackedAttributes : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void empty();
+    void roundTrip();
+    void nullValues();
+    void strings();
+    void subset();
+    void memoryProvider();
+
+  private:
+    /**
+     * Returns a description of the first difference between the values of \a a and \a b, including
+     * their types and null flags, or an empty string if they are identical
+     */
+    static QString difference( const QgsAttributes &a, const QgsAttributes &b );
+};
+
+//! Verifies that the attributes \a a and \a b are identical, reporting their first difference otherwise
+#define QVERIFY_IDENTICAL( a, b ) \
+  do { \
+    const QString attributesDifference = TestQgsPackedAttributes::difference( a, b ); \
+    QVERIFY2( attributesDifference.isEmpty(), qPrintable( attributesDifference ) ); \
+  } while ( false )
+
+void TestQgsPackedAttributes::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsPackedAttributes::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QString TestQgsPackedAttributes::difference( const QgsAttributes &a, const QgsAttributes &b )
+{
+  if ( a.size() != b.size() )
+    return QStringLiteral( "Attribute counts differ: %1 != %2" ).arg( a.size() ).arg( b.size() );
+
+  auto describe = []( const QVariant & v )
+  {
+    return QStringLiteral( "%1 (%2)" ).arg( v.isNull() ? QStringLiteral( "NULL" ) : v.toString(), QString::fromLatin1( v.typeName() ) );
+  };
+
+  for ( int i = 0; i < a.size(); ++i )
+  {
+    if ( a.at( i ).type() != b.at( i ).type() || a.at( i ).isNull() != b.at( i ).isNull() || a.at( i ) != b.at( i ) )
+      return QStringLiteral( "Attribute %1 differs: %2 != %3" ).arg( i ).arg( describe( a.at( i ) ), describe( b.at( i ) ) );
+  }
+  return QString();
+}
+
+void TestQgsPackedAttributes::empty()
+{
+  QgsPackedAttributes packed;
+  QVERIFY( packed.isEmpty() );
+  QCOMPARE( packed.size(), 0 );
+  QVERIFY( !packed.at( 0 ).isValid() );
+  QVERIFY( packed.toAttributes().isEmpty() );
+
+  QgsPackedAttributes packedEmpty( ( QgsAttributes() ) );
+  QVERIFY( packedEmpty.isEmpty() );
+  QCOMPARE( packedEmpty.byteSize(), 0 );
+  QVERIFY( packed == packedEmpty );
+}
+
+void TestQgsPackedAttributes::roundTrip()
+{
+  QgsAttributes attributes;
+  attributes << 5 << -7 << QVariant( 5000000000LL ) << 1.25 << true << false
+             << QDate( 2017, 10, 1 ) << QDateTime( QDate( 2017, 10, 1 ), QTime( 12, 30 ) )
+             << QVariant( QStringList() << QStringLiteral( "a" ) << QStringLiteral( "b" ) )
+             << QVariant() << QVariant( 3u );
+
+  QgsPackedAttributes packed( attributes );
+  QCOMPARE( packed.size(), attributes.size() );
+  QVERIFY_IDENTICAL( packed.toAttributes(), attributes );
+  for ( int i = 0; i < attributes.size(); ++i )
+  {
+    QCOMPARE( packed.at( i ), attributes.at( i ) );
+    QCOMPARE( packed.at( i ).type(), attributes.at( i ).type() );
+  }
+  QVERIFY( !packed.at( -1 ).isValid() );
+  QVERIFY( !packed.at( attributes.size() ).isValid() );
+
+  // implicitly shared copies
+  QgsPackedAttributes copy = packed;
+  QVERIFY( copy == packed );
+  QgsAttributes changed = attributes;
+  changed[0] = 6;
+  QVERIFY( QgsPackedAttributes( changed ) != packed );
+}
+
+void TestQgsPackedAttributes::nullValues()
+{
+  QgsAttributes attributes;
+  attributes << QVariant( QVariant::Int ) << QVariant( QVariant::LongLong ) << QVariant( QVariant::Double )
+             << QVariant( QVariant::Bool ) << QVariant( QVariant::String ) << QVariant( QVariant::Date )
+             << QVariant() << 0 << 0.0 << QString( "" );
+
+  QgsPackedAttributes packed( attributes );
+  QVERIFY_IDENTICAL( packed.toAttributes(), attributes );
+  for ( int i = 0; i < attributes.size(); ++i )
+    QCOMPARE( packed.isNull( i ), attributes.at( i ).isNull() );
+  QVERIFY( packed.isNull( 100 ) );
+
+  // empty strings are not null
+  QVERIFY( !packed.at( 9 ).toString().isNull() );
+  QVERIFY( packed.at( 9 ).toString().isEmpty() );
+}
+
+void TestQgsPackedAttributes::strings()
+{
+  QgsAttributes attributes;
+  attributes << QStringLiteral( "short" ) << QStringLiteral( "1234567" ) << QStringLiteral( "12345678" )
+             << QStringLiteral( "a much longer string which is stored after the slots" )
+             << QString::fromUtf8( "\xc3\xa9t\xc3\xa9" ) // fits in Latin-1
+             << QString::fromUtf8( "\xe2\x82\xac" ) // euro sign, not Latin-1
+             << QString::fromUtf8( "\xf0\x9f\x98\x80 emoji" ) << QString( QChar( 0 ) );
+
+  QgsPackedAttributes packed( attributes );
+  QVERIFY_IDENTICAL( packed.toAttributes(), attributes );
+
+  // the buffer holds the slots and the long strings, but no copy of short strings
+  const int slotsSize = attributes.size() * 8;
+  QVERIFY( packed.byteSize() >= slotsSize );
+  QVERIFY( packed.byteSize() < slotsSize + 200 );
+}
+
+void TestQgsPackedAttributes::subset()
+{
+  QgsAttributes attributes;
+  attributes << 1 << QStringLiteral( "a long string value" ) << 2.5 << QStringLiteral( "b" );
+
+  QgsPackedAttributes packed( attributes );
+  QgsAttributes result = packed.toAttributes( QgsAttributeList() << 1 << 3 << 10 );
+  QCOMPARE( result.size(), 4 );
+  QVERIFY( !result.at( 0 ).isValid() );
+  QCOMPARE( result.at( 1 ), attributes.at( 1 ) );
+  QVERIFY( !result.at( 2 ).isValid() );
+  QCOMPARE( result.at( 3 ), attributes.at( 3 ) );
+}
+
+void TestQgsPackedAttributes::memoryProvider()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=int:integer&field=str:string&field=dbl:double&field=date:date" ), QStringLiteral( "test" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  QgsFeature f( layer.fields() );
+  f.setAttributes( QgsAttributes() << 1 << QStringLiteral( "a string longer than a slot" ) << QVariant( QVariant::Double ) << QDate( 2017, 10, 1 ) );
+  f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( 1, 2 ) ) );
+  QVERIFY( layer.dataProvider()->addFeatures( QgsFeatureList() << f ) );
+
+  QgsFeature stored;
+  QVERIFY( layer.dataProvider()->getFeatures().nextFeature( stored ) );
+  QVERIFY_IDENTICAL( stored.attributes(), f.attributes() );
+  QCOMPARE( stored.geometry().asPoint(), QgsPointXY( 1, 2 ) );
+  QCOMPARE( stored.fields(), layer.fields() );
+
+  // changed values are packed again
+  QgsChangedAttributesMap changes;
+  changes[stored.id()][1] = QStringLiteral( "b" );
+  changes[stored.id()][2] = 3.5;
+  QVERIFY( layer.dataProvider()->changeAttributeValues( changes ) );
+  QVERIFY( layer.dataProvider()->getFeatures().nextFeature( stored ) );
+  QVERIFY_IDENTICAL( stored.attributes(), QgsAttributes() << 1 << QStringLiteral( "b" ) << 3.5 << QDate( 2017, 10, 1 ) );
+
+  // only the requested attributes are unpacked
+  QVERIFY( layer.dataProvider()->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() << 2 ) ).nextFeature( stored ) );
+  QCOMPARE( stored.attributes().size(), 4 );
+  QCOMPARE( stored.attribute( 2 ), QVariant( 3.5 ) );
+  QVERIFY( !stored.attribute( 1 ).isValid() );
+
+  QVERIFY( layer.dataProvider()->addAttributes( QList<QgsField>() << QgsField( QStringLiteral( "new" ), QVariant::Int ) ) );
+  QVERIFY( layer.dataProvider()->deleteAttributes( QgsAttributeIds() << 0 ) );
+  QVERIFY( layer.dataProvider()->getFeatures().nextFeature( stored ) );
+  QVERIFY_IDENTICAL( stored.attributes(), QgsAttributes() << QStringLiteral( "b" ) << 3.5 << QDate( 2017, 10, 1 ) << QVariant() );
+}
+
+QGSTEST_MAIN( TestQgsPackedAttributes )
+#include "testqgspackedattributes.moc"
@@ -15,6 +15,7 @@
 
 #include "qgstest.h"
 #include <QObject>
+#include <QSignalSpy>
 #include <QString>
 
 #include "qgsapplication.h"
@@ -302,6 +303,119 @@ class TestQgsPointLocator : public QObject
 
       delete vlEmptyGeom;
     }
+
+    void testCompactGeometries()
+    {
+      // a polygon with a hole and a multipolygon
+      QgsVectorLayer *vl = new QgsVectorLayer( QStringLiteral( "MultiPolygon" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      QgsFeature f1, f2;
+      f1.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon(((0 0, 10 0, 10 10, 0 10, 0 0),(4 4, 6 4, 6 6, 4 6, 4 4)))" ) ) );
+      f2.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon(((20 0, 30 0, 30 10, 20 0)),((12 12, 14 12, 14 14, 12 12)))" ) ) );
+      QgsFeatureList flist;
+      flist << f1 << f2;
+      vl->dataProvider()->addFeatures( flist );
+
+      QgsPointLocator loc( vl );
+      QgsPointLocator locCompact( vl );
+      QVERIFY( !locCompact.compactGeometries() );
+      locCompact.setCompactGeometries( true );
+      QVERIFY( locCompact.compactGeometries() );
+
+      for ( double x = -1; x <= 31; x += 0.5 )
+      {
+        for ( double y = -1; y <= 15; y += 0.5 )
+        {
+          QgsPointXY pt( x, y );
+          QCOMPARE( locCompact.nearestVertex( pt, 5 ), loc.nearestVertex( pt, 5 ) );
+          QCOMPARE( locCompact.nearestEdge( pt, 5 ), loc.nearestEdge( pt, 5 ) );
+          QCOMPARE( locCompact.pointInPolygon( pt ), loc.pointInPolygon( pt ) );
+          QCOMPARE( locCompact.edgesInRect( pt, 1 ), loc.edgesInRect( pt, 1 ) );
+        }
+      }
+      QCOMPARE( locCompact.cachedGeometryCount(), 2 );
+
+      // points in the hole are not within the polygon
+      QCOMPARE( locCompact.pointInPolygon( QgsPointXY( 5, 5 ) ).count(), 0 );
+      QCOMPARE( locCompact.pointInPolygon( QgsPointXY( 4, 5 ) ).count(), 1 );
+
+      // changing the option destroys the index
+      locCompact.setCompactGeometries( false );
+      QVERIFY( !locCompact.hasIndex() );
+
+      delete vl;
+    }
+
+    void testIndexingInBackground()
+    {
+      QgsVectorLayer *vl = new QgsVectorLayer( QStringLiteral( "Point" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      QgsFeatureList flist;
+      for ( int i = 0; i < 5000; ++i )
+      {
+        QgsFeature f;
+        f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( i % 100, i / 100 ) ) );
+        flist << f;
+      }
+      vl->dataProvider()->addFeatures( flist );
+
+      QgsPointLocator loc( vl );
+      QSignalSpy spy( &loc, &QgsPointLocator::initFinished );
+      QVERIFY( loc.init( -1, true ) );
+      QVERIFY( loc.hasIndex() );
+      QVERIFY( spy.wait() );
+      QCOMPARE( spy.count(), 1 );
+      QVERIFY( spy.at( 0 ).at( 0 ).toBool() );
+      QVERIFY( !loc.isIndexing() );
+      QCOMPARE( loc.cachedGeometryCount(), 5000 );
+
+      QgsPointLocator::Match m = loc.nearestVertex( QgsPointXY( 42.1, 17.2 ), 1 );
+      QVERIFY( m.isValid() );
+      QCOMPARE( m.point(), QgsPointXY( 42, 17 ) );
+
+      // the limit of features is exceeded
+      QgsPointLocator locLimited( vl );
+      QSignalSpy spyLimited( &locLimited, &QgsPointLocator::initFinished );
+      QVERIFY( locLimited.init( 100, true ) );
+      locLimited.waitForIndexingFinished();
+      QVERIFY( !locLimited.hasIndex() );
+      QCOMPARE( locLimited.cachedGeometryCount(), 0 );
+      QVERIFY( spyLimited.wait() );
+      QVERIFY( !spyLimited.at( 0 ).at( 0 ).toBool() );
+
+      // features edited while indexing are kept up to date
+      QgsPointLocator locEdited( vl );
+      vl->startEditing();
+      QVERIFY( locEdited.init( -1, true ) );
+      QVERIFY( vl->changeGeometry( flist.at( 0 ).id(), QgsGeometry::fromPoint( QgsPointXY( 500, 500 ) ) ) );
+      QVERIFY( vl->deleteFeature( flist.at( 1 ).id() ) );
+      locEdited.waitForIndexingFinished();
+      QCOMPARE( locEdited.cachedGeometryCount(), 4999 );
+      QCOMPARE( locEdited.nearestVertex( QgsPointXY( 500, 500 ), 1 ).featureId(), flist.at( 0 ).id() );
+      QVERIFY( !locEdited.nearestVertex( QgsPointXY( 1, 0 ), 0.5 ).isValid() );
+      vl->rollBack();
+
+      delete vl;
+    }
+
+    void testAddToEmptyLayer()
+    {
+      QgsVectorLayer *vl = new QgsVectorLayer( QStringLiteral( "Point" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      QgsPointLocator loc( vl );
+      QVERIFY( loc.init() );
+      QVERIFY( loc.hasIndex() );
+      QVERIFY( !loc.nearestVertex( QgsPointXY( 1, 1 ), 1 ).isValid() );
+
+      vl->startEditing();
+      QgsFeature f;
+      f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( 1, 1 ) ) );
+      QVERIFY( vl->addFeature( f ) );
+      QCOMPARE( loc.cachedGeometryCount(), 1 );
+      QgsPointLocator::Match m = loc.nearestVertex( QgsPointXY( 1.1, 1 ), 1 );
+      QVERIFY( m.isValid() );
+      QCOMPARE( m.featureId(), f.id() );
+      vl->rollBack();
+
+      delete vl;
+    }
 };
 
 QGSTEST_MAIN( TestQgsPointLocator )
@@ -22,10 +22,15 @@
 #include "qgsprocessingcontext.h"
 #include "qgsprocessingmodelalgorithm.h"
 #include <QObject>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
 #include <QtTest/QSignalSpy>
 #include "qgis.h"
 #include "qgstest.h"
 #include "qgsrasterlayer.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
 #include "qgsproject.h"
 #include "qgspoint.h"
 #include "qgsgeometry.h"
@@ -34,6 +39,61 @@
 #include "qgsxmlutils.h"
 #include "qgsreferencedgeometry.h"
 
+class DummyFeatureBasedAlgorithm : public QgsProcessingFeatureBasedAlgorithm
+{
+  public:
+
+    DummyFeatureBasedAlgorithm( bool parallel ) : mParallel( parallel ) {}
+
+    QString name() const override { return QStringLiteral( "featurebased" ); }
+    QString displayName() const override { return name(); }
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | ( mParallel ? Flags( FlagSupportsParallelFeatures ) : Flags() ); }
+    DummyFeatureBasedAlgorithm *createInstance() const override { return new DummyFeatureBasedAlgorithm( mParallel ); }
+
+    static QSet< QThread * > sThreads;
+    static QMutex sThreadsMutex;
+
+  protected:
+
+    QString outputName() const override { return QStringLiteral( "out" ); }
+
+    void initParameters( const QVariantMap & ) override
+    {
+      addParameter( new QgsProcessingParameterNumber( QStringLiteral( "FACTOR" ) ) );
+    }
+
+    bool prepareAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback * ) override
+    {
+      mFactor = parameterAsInt( parameters, QStringLiteral( "FACTOR" ), context );
+      return true;
+    }
+
+    QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback * ) override
+    {
+      {
+        QMutexLocker locker( &sThreadsMutex );
+        sThreads << QThread::currentThread();
+      }
+
+      // skip every tenth feature
+      const int value = feature.attribute( 0 ).toInt();
+      if ( value % 10 == 0 )
+        return QgsFeature();
+
+      QgsFeature f = feature;
+      f.setAttribute( 0, value * mFactor );
+      return f;
+    }
+
+  private:
+
+    bool mParallel = false;
+    int mFactor = 1;
+};
+
+QSet< QThread * > DummyFeatureBasedAlgorithm::sThreads;
+QMutex DummyFeatureBasedAlgorithm::sThreadsMutex;
+
 class DummyAlgorithm : public QgsProcessingAlgorithm
 {
   public:
@@ -354,6 +414,8 @@ class TestQgsProcessing: public QObject
     void create();
     void combineFields();
     void stringToPythonLiteral();
+    void featureBasedAlgorithm_data();
+    void featureBasedAlgorithm();
 
   private:
 
@@ -5609,5 +5671,70 @@ void TestQgsProcessing::stringToPythonLiteral()
   QCOMPARE( QgsProcessingUtils::stringToPythonLiteral( QStringLiteral( "a \"string\"" ) ), QStringLiteral( "'a \\\"string\\\"'" ) );
 }
 
+void TestQgsProcessing::featureBasedAlgorithm_data()
+{
+  QTest::addColumn<bool>( "parallel" );
+
+  QTest::newRow( "sequential" ) << false;
+  QTest::newRow( "parallel" ) << true;
+}
+
+void TestQgsProcessing::featureBasedAlgorithm()
+{
+  QFETCH( bool, parallel );
+
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?field=value:integer" ), QStringLiteral( "input" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < 5000; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( i, i ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+  QgsProject::instance()->addMapLayer( layer );
+
+  DummyFeatureBasedAlgorithm alg( parallel );
+  alg.initAlgorithm();
+  QVERIFY( parallel == static_cast< bool >( alg.flags() & QgsProcessingAlgorithm::FlagSupportsParallelFeatures ) );
+
+  DummyFeatureBasedAlgorithm::sThreads.clear();
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), layer->id() );
+  parameters.insert( QStringLiteral( "FACTOR" ), 3 );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+  QgsProcessingContext context;
+  QgsProcessingFeedback feedback;
+  bool ok = false;
+  QVariantMap results = alg.run( parameters, context, &feedback, &ok );
+  QVERIFY( ok );
+
+  if ( !parallel || QThreadPool::globalInstance()->maxThreadCount() < 2 )
+    QCOMPARE( DummyFeatureBasedAlgorithm::sThreads.count(), 1 );
+  else
+    QVERIFY( DummyFeatureBasedAlgorithm::sThreads.count() > 1 );
+
+  // features must be written in input order, whatever thread processed them
+  QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( QgsProcessingUtils::mapLayerFromString( results.value( QStringLiteral( "OUTPUT" ) ).toString(), context ) );
+  QVERIFY( output );
+  QCOMPARE( output->featureCount(), 4500L );
+  QgsFeatureIterator it = output->getFeatures();
+  QgsFeature f;
+  int expected = 1;
+  while ( it.nextFeature( f ) )
+  {
+    QCOMPARE( f.attribute( 0 ).toInt(), expected * 3 );
+    QCOMPARE( f.geometry().asPoint(), QgsPointXY( expected, expected ) );
+    expected++;
+    if ( expected % 10 == 0 )
+      expected++;
+  }
+  QCOMPARE( expected, 5001 );
+
+  QgsProject::instance()->removeMapLayer( layer );
+}
+
 QGSTEST_MAIN( TestQgsProcessing )
 #include "testqgsprocessing.moc"
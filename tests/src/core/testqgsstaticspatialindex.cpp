@@ -0,0 +1,349 @@
+/***************************************************************************
+  testqgsstaticspatialindex.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+
+#include <qgsapplication.h>
+#include "qgsfeatureiterator.h"
+#include <qgsgeometry.h>
+#include <qgsspatialindex.h>
+#include <qgsspatialindexfilecache.h>
+#include <qgsstaticspatialindex.h>
+#include <qgsvectordataprovider.h>
+#include <qgsvectorlayer.h>
+
+static QgsFeature _pointFeature( QgsFeatureId id, qreal x, qreal y )
+{
+  QgsFeature f( id );
+  QgsGeometry g = QgsGeometry::fromPoint( QgsPointXY( x, y ) );
+  f.setGeometry( g );
+  return f;
+}
+
+static QgsVectorLayer *_pointLayer()
+{
+  /*
+   *  2   |   1
+   *      |
+   * -----+-----
+   *      |
+   *  3   |   4
+   */
+
+  QgsVectorLayer *vl = new QgsVectorLayer( QStringLiteral( "Point" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+  QgsFeatureList feats;
+  feats << _pointFeature( 1,  1,  1 )
+        << _pointFeature( 2, -1,  1 )
+        << _pointFeature( 3, -1, -1 )
+        << _pointFeature( 4,  1, -1 )
+        << QgsFeature( 5 );
+  vl->dataProvider()->addFeatures( feats );
+  return vl;
+}
+
+//! Random rectangles, with the same seed for each test run
+static void _randomItems( int count, QList< QgsFeatureId > &ids, QVector< QgsRectangle > &bounds )
+{
+  qsrand( 42 );
+  for ( int i = 0; i < count; ++i )
+  {
+    const double x = qrand() % 10000 / 10.0;
+    const double y = qrand() % 10000 / 10.0;
+    ids << i + 100;
+    bounds << QgsRectangle( x, y, x + qrand() % 100 / 10.0, y + qrand() % 100 / 10.0 );
+  }
+}
+
+class TestQgsStaticSpatialIndex : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void initTestCase()
+    {
+      QgsApplication::init();
+      QgsApplication::initQgis();
+    }
+    void cleanupTestCase()
+    {
+      QgsApplication::exitQgis();
+    }
+
+    void testEmpty()
+    {
+      QgsStaticSpatialIndex index;
+      QVERIFY( index.isValid() );
+      QVERIFY( index.isEmpty() );
+      QCOMPARE( index.count(), 0 );
+      QVERIFY( index.intersects( QgsRectangle( -10, -10, 10, 10 ) ).isEmpty() );
+      QVERIFY( index.nearestNeighbor( QgsPointXY( 0, 0 ), 3 ).isEmpty() );
+
+      QgsStaticSpatialIndex index2( QList< QgsFeatureId >(), QVector< QgsRectangle >() );
+      QVERIFY( index2.isEmpty() );
+      QVERIFY( index2.intersects( QgsRectangle( -10, -10, 10, 10 ) ).isEmpty() );
+    }
+
+    void testQuery()
+    {
+      std::unique_ptr< QgsVectorLayer > vl( _pointLayer() );
+      QgsStaticSpatialIndex index( *vl->dataProvider() );
+
+      // feature without geometry is skipped
+      QVERIFY( index.isValid() );
+      QCOMPARE( index.count(), 4 );
+      QCOMPARE( index.extent(), QgsRectangle( -1, -1, 1, 1 ) );
+
+      QList<QgsFeatureId> fids = index.intersects( QgsRectangle( 0, 0, 10, 10 ) );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 1 );
+
+      QList<QgsFeatureId> fids2 = index.intersects( QgsRectangle( -10, -10, 0, 10 ) );
+      QCOMPARE( fids2.count(), 2 );
+      QVERIFY( fids2.contains( 2 ) );
+      QVERIFY( fids2.contains( 3 ) );
+
+      // touching items are included
+      QCOMPARE( index.intersects( QgsRectangle( 1, 1, 2, 2 ) ), QList<QgsFeatureId>() << 1 );
+      QVERIFY( index.intersects( QgsRectangle( 2, 2, 3, 3 ) ).isEmpty() );
+
+      // visitor can stop the query
+      int visited = 0;
+      index.intersects( QgsRectangle( -10, -10, 10, 10 ), [&visited]( QgsFeatureId )
+      {
+        ++visited;
+        return visited < 2;
+      } );
+      QCOMPARE( visited, 2 );
+    }
+
+    void testSingleItem()
+    {
+      QgsStaticSpatialIndex index( QList< QgsFeatureId >() << 7, QVector< QgsRectangle >() << QgsRectangle( 1, 2, 3, 4 ) );
+      QCOMPARE( index.count(), 1 );
+      QCOMPARE( index.intersects( QgsRectangle( 0, 0, 10, 10 ) ), QList<QgsFeatureId>() << 7 );
+      QVERIFY( index.intersects( QgsRectangle( 5, 5, 10, 10 ) ).isEmpty() );
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( 10, 10 ), 1 ), QList<QgsFeatureId>() << 7 );
+      QVERIFY( index.nearestNeighbor( QgsPointXY( 10, 10 ), 1, 2 ).isEmpty() );
+    }
+
+    void testNearestNeighbor()
+    {
+      std::unique_ptr< QgsVectorLayer > vl( _pointLayer() );
+      QgsStaticSpatialIndex index( *vl->dataProvider() );
+
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( 0.9, 0.8 ), 1 ), QList<QgsFeatureId>() << 1 );
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( -0.9, -0.8 ), 1 ), QList<QgsFeatureId>() << 3 );
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( 0.5, 0.9 ), 2 ), QList<QgsFeatureId>() << 1 << 2 );
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( 0, 0 ), 10 ).count(), 4 );
+    }
+
+    void testCompareWithSpatialIndex_data()
+    {
+      QTest::addColumn< int >( "count" );
+      QTest::addColumn< int >( "nodeSize" );
+
+      QTest::newRow( "small" ) << 17 << 16;
+      QTest::newRow( "node size 2" ) << 1000 << 2;
+      QTest::newRow( "default" ) << 5000 << 16;
+      QTest::newRow( "parallel build" ) << 150000 << 16;
+    }
+
+    void testCompareWithSpatialIndex()
+    {
+      QFETCH( int, count );
+      QFETCH( int, nodeSize );
+
+      QList< QgsFeatureId > ids;
+      QVector< QgsRectangle > bounds;
+      _randomItems( count, ids, bounds );
+
+      QgsStaticSpatialIndex staticIndex( ids, bounds, nodeSize );
+      QCOMPARE( staticIndex.count(), count );
+      QCOMPARE( staticIndex.nodeSize(), nodeSize );
+
+      QgsSpatialIndex index;
+      for ( int i = 0; i < count; ++i )
+        index.insertFeature( ids.at( i ), bounds.at( i ) );
+
+      for ( int i = 0; i < 100; ++i )
+      {
+        const double x = i * 10;
+        const QgsRectangle rect( x, 1000 - x, x + 50, 1000 - x + 30 );
+        QList<QgsFeatureId> expected = index.intersects( rect );
+        QList<QgsFeatureId> found = staticIndex.intersects( rect );
+        std::sort( expected.begin(), expected.end() );
+        std::sort( found.begin(), found.end() );
+        QCOMPARE( found, expected );
+      }
+    }
+
+    void testSaveLoad()
+    {
+      QList< QgsFeatureId > ids;
+      QVector< QgsRectangle > bounds;
+      _randomItems( 1000, ids, bounds );
+      QgsStaticSpatialIndex index( ids, bounds );
+      const QgsRectangle rect( 200, 200, 400, 300 );
+      QList<QgsFeatureId> expected = index.intersects( rect );
+      QVERIFY( !expected.isEmpty() );
+
+      QTemporaryDir dir;
+      const QString path = dir.filePath( QStringLiteral( "index.qix" ) );
+      QVERIFY( index.writeToFile( path ) );
+
+      QgsStaticSpatialIndex loaded;
+      QVERIFY( loaded.readFromFile( path ) );
+      QCOMPARE( loaded.count(), 1000 );
+      QCOMPARE( loaded.extent(), index.extent() );
+      QCOMPARE( loaded.intersects( rect ), expected );
+      QCOMPARE( loaded.nearestNeighbor( QgsPointXY( 500, 500 ), 5 ), index.nearestNeighbor( QgsPointXY( 500, 500 ), 5 ) );
+
+      // copies stay valid after the mapped index is replaced
+      QgsStaticSpatialIndex copy = loaded;
+      loaded = QgsStaticSpatialIndex();
+      QCOMPARE( copy.intersects( rect ), expected );
+
+      bool ok = false;
+      QgsStaticSpatialIndex fromData = QgsStaticSpatialIndex::fromData( copy.data(), &ok );
+      QVERIFY( ok );
+      QCOMPARE( fromData.intersects( rect ), expected );
+
+      // invalid data
+      QVERIFY( !loaded.readFromFile( dir.filePath( QStringLiteral( "missing.qix" ) ) ) );
+      QByteArray truncated = index.data();
+      truncated.chop( 8 );
+      QgsStaticSpatialIndex::fromData( truncated, &ok );
+      QVERIFY( !ok );
+      QByteArray corrupted = index.data();
+      corrupted[0] = 'X';
+      QVERIFY( QgsStaticSpatialIndex::fromData( corrupted, &ok ).isEmpty() );
+      QVERIFY( !ok );
+    }
+
+    void testFileCache()
+    {
+      QTemporaryDir dir;
+      const QString dataPath = dir.filePath( QStringLiteral( "points" ) );
+      const QString cachePath = dir.filePath( QStringLiteral( "cache" ) );
+      for ( const QString &suffix : QStringList() << QStringLiteral( ".shp" ) << QStringLiteral( ".shx" ) << QStringLiteral( ".dbf" ) << QStringLiteral( ".prj" ) )
+        QVERIFY( QFile::copy( QStringLiteral( TEST_DATA_DIR ) + "/points" + suffix, dataPath + suffix ) );
+
+      QgsSpatialIndexFileCache::setEnabled( true );
+      QgsSpatialIndexFileCache::setCacheDirectory( cachePath );
+      QCOMPARE( QgsSpatialIndexFileCache::cacheDirectory(), cachePath );
+
+      std::unique_ptr< QgsVectorLayer > vl( new QgsVectorLayer( dataPath + ".shp", QStringLiteral( "points" ), QStringLiteral( "ogr" ) ) );
+      QVERIFY( vl->isValid() );
+      const QString indexPath = QgsSpatialIndexFileCache::indexFilePath( vl.get() );
+      QVERIFY( indexPath.startsWith( cachePath ) );
+      QVERIFY( !QFile::exists( indexPath ) );
+
+      const QgsRectangle rect( -110, 30, -90, 40 );
+      QgsStaticSpatialIndex built = QgsSpatialIndexFileCache::staticIndex( vl.get() );
+      QCOMPARE( built.count(), static_cast< int >( vl->featureCount() ) );
+      QVERIFY( QFile::exists( indexPath ) );
+      QList<QgsFeatureId> expected = QgsSpatialIndex( *vl ).intersects( rect );
+      std::sort( expected.begin(), expected.end() );
+      QVERIFY( !expected.isEmpty() );
+
+      // loaded from the index file
+      QgsStaticSpatialIndex loaded = QgsSpatialIndexFileCache::staticIndex( vl.get() );
+      QCOMPARE( loaded.data(), built.data() );
+      QList<QgsFeatureId> found = loaded.intersects( rect );
+      std::sort( found.begin(), found.end() );
+      QCOMPARE( found, expected );
+
+      // dynamic index bulk loaded from the static index
+      QgsSpatialIndex spatialIndex = QgsSpatialIndexFileCache::spatialIndex( vl.get() );
+      found = spatialIndex.intersects( rect );
+      std::sort( found.begin(), found.end() );
+      QCOMPARE( found, expected );
+
+      // subset strings are indexed separately
+      QVERIFY( vl->setSubsetString( QStringLiteral( "\"Class\" = 'Jet'" ) ) );
+      const QString subsetIndexPath = QgsSpatialIndexFileCache::indexFilePath( vl.get() );
+      QVERIFY( subsetIndexPath != indexPath );
+      QCOMPARE( QgsSpatialIndexFileCache::staticIndex( vl.get() ).count(), static_cast< int >( vl->featureCount() ) );
+      QVERIFY( QFile::exists( subsetIndexPath ) );
+      QVERIFY( QFile::exists( indexPath ) );
+
+      // layers with edits and layers not read from files are not persisted
+      vl->startEditing();
+      QgsFeature f( vl->fields() );
+      f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( 0, 0 ) ) );
+      vl->addFeature( f );
+      QVERIFY( QgsSpatialIndexFileCache::indexFilePath( vl.get() ).isEmpty() );
+      QCOMPARE( QgsSpatialIndexFileCache::staticIndex( vl.get() ).count(), static_cast< int >( vl->featureCount() ) );
+      vl->rollBack();
+
+      std::unique_ptr< QgsVectorLayer > memoryLayer( _pointLayer() );
+      QVERIFY( QgsSpatialIndexFileCache::indexFilePath( memoryLayer.get() ).isEmpty() );
+      QCOMPARE( QgsSpatialIndexFileCache::staticIndex( memoryLayer.get() ).count(), 4 );
+
+      // changes of the files read with the main file are detected
+      QFile cpg( dataPath + ".cpg" );
+      QVERIFY( cpg.open( QIODevice::WriteOnly ) );
+      cpg.write( "UTF-8" );
+      cpg.close();
+      QVERIFY( QgsSpatialIndexFileCache::indexFilePath( vl.get() ) != subsetIndexPath );
+
+      // changes which may not be written to the main file yet
+      QFile wal( dataPath + ".shp-wal" );
+      QVERIFY( wal.open( QIODevice::WriteOnly ) );
+      wal.write( "changes" );
+      wal.close();
+      QVERIFY( QgsSpatialIndexFileCache::indexFilePath( vl.get() ).isEmpty() );
+      QVERIFY( wal.remove() );
+
+      QgsSpatialIndexFileCache::clear();
+      QVERIFY( !QFile::exists( indexPath ) );
+      QVERIFY( !QFile::exists( subsetIndexPath ) );
+      QgsSpatialIndexFileCache::setCacheDirectory( QString() );
+      QgsSpatialIndexFileCache::setEnabled( false );
+    }
+
+    void benchmarkBulkLoad()
+    {
+      QList< QgsFeatureId > ids;
+      QVector< QgsRectangle > bounds;
+      _randomItems( 100000, ids, bounds );
+
+      QBENCHMARK
+      {
+        QgsStaticSpatialIndex index( ids, bounds );
+        QCOMPARE( index.count(), 100000 );
+      }
+    }
+
+    void benchmarkIntersect()
+    {
+      QList< QgsFeatureId > ids;
+      QVector< QgsRectangle > bounds;
+      _randomItems( 100000, ids, bounds );
+      QgsStaticSpatialIndex index( ids, bounds );
+
+      QBENCHMARK
+      {
+        for ( int i = 0; i < 100; ++i )
+          index.intersects( QgsRectangle( i, i, i + 10, i + 10 ) );
+      }
+    }
+};
+
+QGSTEST_MAIN( TestQgsStaticSpatialIndex )
+
+#include "testqgsstaticspatialindex.moc"
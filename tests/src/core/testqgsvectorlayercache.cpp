@@ -53,6 +53,8 @@ class TestVectorLayerCache : public QObject
     void testFullCacheThroughRequest();
     void testCanUseCacheForRequest();
     void testCacheGeom();
+    void testColumnarStorage();
+    void testColumnarStorageOverflow();
 
     void onCommittedFeaturesAdded( const QString &, const QgsFeatureList & );
 
@@ -390,6 +392,117 @@ void TestVectorLayerCache::testCacheGeom()
   QVERIFY( !cache.hasFullCache() );
 }
 
+void TestVectorLayerCache::testColumnarStorage()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=int:integer&field=dbl:double&field=str:string&field=date:date" ), QStringLiteral( "test" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  QgsFeature f1( layer.fields() );
+  f1.setAttributes( QgsAttributes() << 5 << 1.5 << QStringLiteral( "b" ) << QDate( 2017, 10, 1 ) );
+  QgsFeature f2( layer.fields() );
+  f2.setAttributes( QgsAttributes() << 3 << QVariant( QVariant::Double ) << QStringLiteral( "a" ) << QVariant( QVariant::Date ) );
+  QgsFeature f3( layer.fields() );
+  f3.setAttributes( QgsAttributes() << QVariant( QVariant::Int ) << -2.5 << QStringLiteral( "b" ) << QDate( 2017, 9, 1 ) );
+  QVERIFY( layer.dataProvider()->addFeatures( QgsFeatureList() << f1 << f2 << f3 ) );
+
+  QgsVectorLayerCache cache( &layer, 10 );
+  QVERIFY( !cache.columnarStorage() );
+  cache.setColumnarStorage( true );
+  QVERIFY( cache.columnarStorage() );
+  cache.setFullCache( true );
+  QCOMPARE( cache.cachedFeatureIds().count(), 3 );
+
+  // features read from the cache must be identical to the features of the layer
+  QgsFeature layerFeature;
+  QgsFeatureIterator it = layer.getFeatures();
+  while ( it.nextFeature( layerFeature ) )
+  {
+    QgsFeature cachedFeature;
+    QVERIFY( cache.featureAtId( layerFeature.id(), cachedFeature ) );
+    QCOMPARE( cachedFeature.attributes().count(), layerFeature.attributes().count() );
+    for ( int i = 0; i < layerFeature.attributes().count(); ++i )
+    {
+      QCOMPARE( cachedFeature.attribute( i ), layerFeature.attribute( i ) );
+      QCOMPARE( cachedFeature.attribute( i ).type(), layerFeature.attribute( i ).type() );
+      QCOMPARE( cachedFeature.attribute( i ).isNull(), layerFeature.attribute( i ).isNull() );
+    }
+    QVERIFY( cachedFeature.hasGeometry() == layerFeature.hasGeometry() );
+  }
+
+  QgsFeature f;
+  int count = 0;
+  it = cache.getFeatures( QgsFeatureRequest().setFilterExpression( QStringLiteral( "\"str\" = 'b'" ) ) );
+  while ( it.nextFeature( f ) )
+    count++;
+  QCOMPARE( count, 2 );
+
+  // column scans
+  const QHash<QgsFeatureId, QVariant> values = cache.cachedAttributeValues( 0 );
+  QCOMPARE( values.count(), 3 );
+  it = layer.getFeatures();
+  while ( it.nextFeature( layerFeature ) )
+    QCOMPARE( values.value( layerFeature.id() ), layerFeature.attribute( 0 ) );
+
+  QCOMPARE( cache.uniqueValues( 0 ), layer.uniqueValues( 0 ) );
+  QCOMPARE( cache.uniqueValues( 1 ), layer.uniqueValues( 1 ) );
+  QCOMPARE( cache.uniqueValues( 2 ), QSet<QVariant>() << QStringLiteral( "a" ) << QStringLiteral( "b" ) );
+  QCOMPARE( cache.uniqueValues( 2, 1 ).count(), 1 );
+  QCOMPARE( cache.minimumValue( 0 ), QVariant( 3 ) );
+  QCOMPARE( cache.maximumValue( 0 ), QVariant( 5 ) );
+  QCOMPARE( cache.minimumValue( 1 ), QVariant( -2.5 ) );
+  QCOMPARE( cache.maximumValue( 1 ), QVariant( 1.5 ) );
+  QCOMPARE( cache.minimumValue( 2 ), QVariant( QStringLiteral( "a" ) ) );
+  QCOMPARE( cache.maximumValue( 2 ), QVariant( QStringLiteral( "b" ) ) );
+  QCOMPARE( cache.minimumValue( 3 ), QVariant( QDate( 2017, 9, 1 ) ) );
+  QCOMPARE( cache.maximumValue( 3 ), QVariant( QDate( 2017, 10, 1 ) ) );
+
+  // edits must be reflected in the columns
+  const QgsFeatureId fid1 = cache.cachedAttributeValues( 2 ).key( QStringLiteral( "a" ) );
+  layer.startEditing();
+  QVERIFY( layer.changeAttributeValue( fid1, 2, QStringLiteral( "c" ) ) );
+  QVERIFY( layer.changeAttributeValue( fid1, 0, 7 ) );
+  QVERIFY( cache.featureAtId( fid1, f ) );
+  QCOMPARE( f.attribute( 2 ), QVariant( QStringLiteral( "c" ) ) );
+  QCOMPARE( cache.uniqueValues( 2 ), QSet<QVariant>() << QStringLiteral( "b" ) << QStringLiteral( "c" ) );
+  QCOMPARE( cache.maximumValue( 0 ), QVariant( 7 ) );
+
+  // a value of another type than the field must be returned unchanged
+  QVERIFY( layer.changeAttributeValue( fid1, 0, QStringLiteral( "x" ) ) );
+  QVERIFY( cache.featureAtId( fid1, f ) );
+  QCOMPARE( f.attribute( 0 ), QVariant( QStringLiteral( "x" ) ) );
+  QVERIFY( cache.cachedAttributeValues( 0 ).values().contains( QVariant( 5 ) ) );
+  QVERIFY( cache.uniqueValues( 0 ).contains( QVariant( QVariant::Int ) ) );
+  layer.rollBack();
+}
+
+void TestVectorLayerCache::testColumnarStorageOverflow()
+{
+  // features evicted from the cache must free their rows for other features
+  QgsVectorLayerCache cache( mPointsLayer, 2 );
+  cache.setColumnarStorage( true );
+
+  QgsFeature layerFeature;
+  QgsFeatureIterator it = mPointsLayer->getFeatures();
+  while ( it.nextFeature( layerFeature ) )
+  {
+    QgsFeature cachedFeature;
+    QVERIFY( cache.featureAtId( layerFeature.id(), cachedFeature ) );
+    QCOMPARE( cachedFeature.attributes(), layerFeature.attributes() );
+    QVERIFY( cache.featureAtId( layerFeature.id(), cachedFeature ) );
+    QCOMPARE( cachedFeature.attributes(), layerFeature.attributes() );
+  }
+  QCOMPARE( cache.cachedAttributeValues( 0 ).count(), cache.cachedFeatureIds().count() );
+
+  // without a full cache the layer is asked
+  QCOMPARE( cache.uniqueValues( 0 ), mPointsLayer->uniqueValues( 0 ) );
+  QCOMPARE( cache.minimumValue( 0 ), mPointsLayer->minimumValue( 0 ) );
+
+  cache.setFullCache( true );
+  QCOMPARE( cache.uniqueValues( 0 ), mPointsLayer->uniqueValues( 0 ) );
+  QCOMPARE( cache.minimumValue( 0 ), mPointsLayer->minimumValue( 0 ) );
+  QCOMPARE( cache.maximumValue( 0 ), mPointsLayer->maximumValue( 0 ) );
+}
+
 void TestVectorLayerCache::onCommittedFeaturesAdded( const QString &layerId, const QgsFeatureList &features )
 {
   Q_UNUSED( layerId )
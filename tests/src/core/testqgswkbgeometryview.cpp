@@ -0,0 +1,142 @@
+/***************************************************************************
+     testqgswkbgeometryview.cpp
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsclipper.h"
+#include "qgsgeometry.h"
+#include "qgsmaptopixelgeometrysimplifier.h"
+#include "qgswkbgeometryview.h"
+
+class TestQgsWkbGeometryView: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void invalid();
+    void lineString();
+    void polygon();
+    void multiPolygon();
+    void clipping();
+    void simplify();
+};
+
+static QgsWkbGeometryView viewFromWkt( const QString &wkt )
+{
+  return QgsWkbGeometryView( QgsGeometry::fromWkt( wkt ).exportToWkb() );
+}
+
+void TestQgsWkbGeometryView::invalid()
+{
+  QgsWkbGeometryView empty;
+  QVERIFY( !empty.isValid() );
+  QVERIFY( empty.geometry().isNull() );
+
+  // truncated WKB
+  QByteArray wkb = QgsGeometry::fromWkt( QStringLiteral( "LineString (0 0, 1 1, 2 2)" ) ).exportToWkb();
+  wkb.chop( 4 );
+  QgsWkbGeometryView truncated( wkb );
+  QVERIFY( !truncated.isValid() );
+  QCOMPARE( truncated.sequenceCount(), 0 );
+
+  // curves can't be viewed, but still decoded
+  QgsWkbGeometryView curve = viewFromWkt( QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) );
+  QVERIFY( !curve.isValid() );
+  QCOMPARE( curve.wkbType(), QgsWkbTypes::CircularString );
+  QCOMPARE( curve.geometry().exportToWkt(), QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) );
+}
+
+void TestQgsWkbGeometryView::lineString()
+{
+  QgsWkbGeometryView view = viewFromWkt( QStringLiteral( "LineStringZ (1 2 10, 3 -4 20, 5 6 30)" ) );
+  QVERIFY( view.isValid() );
+  QCOMPARE( view.wkbType(), QgsWkbTypes::LineStringZ );
+  QCOMPARE( view.partCount(), 1 );
+  QCOMPARE( view.sequenceCount(), 1 );
+  QCOMPARE( view.vertexCount(), 3 );
+  QCOMPARE( view.sequence( 0 ).dimensions, 3 );
+  QCOMPARE( view.vertexAt( 0, 1 ), QPointF( 3, -4 ) );
+  QCOMPARE( view.points( 0 ), QPolygonF() << QPointF( 1, 2 ) << QPointF( 3, -4 ) << QPointF( 5, 6 ) );
+  QCOMPARE( view.boundingBox(), QgsRectangle( 1, -4, 5, 6 ) );
+  QVERIFY( !view.contains( 3, -4 ) );
+  QCOMPARE( view.geometry().exportToWkt(), QStringLiteral( "LineStringZ (1 2 10, 3 -4 20, 5 6 30)" ) );
+}
+
+void TestQgsWkbGeometryView::polygon()
+{
+  QgsWkbGeometryView view = viewFromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0),(2 2, 4 2, 4 4, 2 4, 2 2))" ) );
+  QVERIFY( view.isValid() );
+  QCOMPARE( view.partCount(), 1 );
+  QCOMPARE( view.sequenceCount(), 2 );
+  QCOMPARE( view.sequence( 1 ).ring, 1 );
+  QCOMPARE( view.vertexCount(), 10 );
+  QCOMPARE( view.boundingBox(), QgsRectangle( 0, 0, 10, 10 ) );
+  QVERIFY( view.contains( 5, 5 ) );
+  QVERIFY( !view.contains( 3, 3 ) ); // in hole
+  QVERIFY( !view.contains( 11, 5 ) );
+
+  // big endian WKB
+  QByteArray wkb;
+  QDataStream stream( &wkb, QIODevice::WriteOnly );
+  stream.setByteOrder( QDataStream::BigEndian );
+  stream << static_cast< quint8 >( 0 ) << static_cast< quint32 >( QgsWkbTypes::Polygon ) << static_cast< quint32 >( 1 ) << static_cast< quint32 >( 4 );
+  stream << 0.0 << 0.0 << 4.0 << 0.0 << 0.0 << 4.0 << 0.0 << 0.0;
+  QgsWkbGeometryView bigEndian( wkb );
+  QVERIFY( bigEndian.isValid() );
+  QCOMPARE( bigEndian.boundingBox(), QgsRectangle( 0, 0, 4, 4 ) );
+  QVERIFY( bigEndian.contains( 1, 1 ) );
+  QVERIFY( !bigEndian.contains( 3, 3 ) );
+}
+
+void TestQgsWkbGeometryView::multiPolygon()
+{
+  QgsWkbGeometryView view = viewFromWkt( QStringLiteral( "MultiPolygon (((0 0, 1 0, 1 1, 0 0)),((10 10, 12 10, 12 12, 10 12, 10 10)))" ) );
+  QVERIFY( view.isValid() );
+  QCOMPARE( view.partCount(), 2 );
+  QCOMPARE( view.sequenceCount(), 2 );
+  QCOMPARE( view.sequence( 1 ).part, 1 );
+  QCOMPARE( view.boundingBox(), QgsRectangle( 0, 0, 12, 12 ) );
+  QVERIFY( view.contains( 11, 11 ) );
+  QVERIFY( view.contains( 0.8, 0.2 ) );
+  QVERIFY( !view.contains( 5, 5 ) );
+
+  QgsWkbGeometryView collection = viewFromWkt( QStringLiteral( "GeometryCollection (Point (1 2),LineString (0 0, 5 5))" ) );
+  QVERIFY( collection.isValid() );
+  QCOMPARE( collection.partCount(), 2 );
+  QCOMPARE( collection.vertexCount(), 3 );
+  QCOMPARE( collection.boundingBox(), QgsRectangle( 0, 0, 5, 5 ) );
+}
+
+void TestQgsWkbGeometryView::clipping()
+{
+  QgsWkbGeometryView view = viewFromWkt( QStringLiteral( "LineString (-5 5, 5 5, 15 5)" ) );
+  const QgsRectangle clipRect( 0, 0, 10, 10 );
+  QPolygonF clipped = QgsClipper::clippedLine( view.points( 0 ), clipRect );
+  QCOMPARE( clipped, QPolygonF() << QPointF( 0, 5 ) << QPointF( 5, 5 ) << QPointF( 10, 5 ) );
+}
+
+void TestQgsWkbGeometryView::simplify()
+{
+  QgsWkbGeometryView view = viewFromWkt( QStringLiteral( "Polygon ((0 0, 1 0, 1 0.5, 1 1, 0.5 1, 0 1, 0 0.5, 0 0))" ) );
+  QgsMapToPixelSimplifier simplifier( QgsMapToPixelSimplifier::SimplifyEnvelope, 10 );
+  QCOMPARE( simplifier.simplify( view ).exportToWkt(), QStringLiteral( "Polygon ((0 0, 1 0, 1 1, 0 1, 0 0))" ) );
+
+  // not small enough to be replaced by the bounding box
+  simplifier.setTolerance( 0.1 );
+  QCOMPARE( simplifier.simplify( view ).exportToWkt(), view.geometry().exportToWkt() );
+}
+
+QGSTEST_MAIN( TestQgsWkbGeometryView )
+#include "testqgswkbgeometryview.moc"
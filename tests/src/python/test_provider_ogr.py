@@ -17,7 +17,7 @@ import shutil
 import sys
 import tempfile
 
-from qgis.core import QgsVectorLayer, QgsVectorDataProvider, QgsWkbTypes, QgsFeature, QgsFeatureRequest
+from qgis.core import QgsVectorLayer, QgsVectorDataProvider, QgsWkbTypes, QgsFeature, QgsFeatureRequest, QgsRectangle
 from qgis.testing import (
     start_app,
     unittest
@@ -255,6 +255,44 @@ class PyQgsOGRProvider(unittest.TestCase):
         while it.nextFeature(f):
             self.assertTrue(f.attribute("text") == "shape 2")
 
+    def testExactIntersectWithoutGeometry(self):
+        """ Test intersecting features with a rectangle without fetching their geometries """
+
+        datasource = os.path.join(self.basetestpath, 'testExactIntersectWithoutGeometry.csv')
+        with open(datasource, 'wt') as f:
+            f.write('id,WKT\n')
+            f.write('1,"POLYGON((0 0,10 0,10 10,0 10,0 0),(2 2,8 2,8 8,2 8,2 2))"\n')
+            f.write('2,"LINESTRING(20 0,30 10)"\n')
+            f.write('3,"POINT(5 5)"\n')
+            f.write('4,"MULTIPOLYGON(((40 0,50 0,50 10,40 10,40 0)))"\n')
+
+        vl = QgsVectorLayer('{}|layerid=0'.format(datasource), 'test', 'ogr')
+        self.assertTrue(vl.isValid())
+
+        def intersecting(rect):
+            request = QgsFeatureRequest().setFilterRect(rect).setFlags(QgsFeatureRequest.ExactIntersect | QgsFeatureRequest.NoGeometry)
+            ids = set()
+            for f in vl.getFeatures(request):
+                self.assertFalse(f.hasGeometry())
+                ids.add(f.id())
+            # must match the result of the test on the fetched geometries
+            request.setFlags(QgsFeatureRequest.ExactIntersect)
+            self.assertEqual(ids, set(f.id() for f in vl.getFeatures(request)))
+            return ids
+
+        # within the hole of the polygon
+        self.assertEqual(intersecting(QgsRectangle(4, 4, 6, 6)), set([3]))
+        # within the polygon ring
+        self.assertEqual(intersecting(QgsRectangle(0.5, 0.5, 1.5, 1.5)), set([1]))
+        # crossing the ring and the hole
+        self.assertEqual(intersecting(QgsRectangle(1, 1, 3, 3)), set([1]))
+        # within the bounding box of the line, but not touching it
+        self.assertEqual(intersecting(QgsRectangle(21, 5, 22, 8)), set())
+        self.assertEqual(intersecting(QgsRectangle(24, 4, 26, 6)), set([2]))
+        # containing whole features
+        self.assertEqual(intersecting(QgsRectangle(-1, -1, 60, 11)), set([1, 2, 3, 4]))
+        self.assertEqual(intersecting(QgsRectangle(45, 5, 46, 6)), set([4]))
+
     def testTriangleTINPolyhedralSurface(self):
         """ Test support for Triangles (mapped to Polygons) """
         testsets = (
@@ -19,8 +19,8 @@ import tempfile
 import shutil
 from osgeo import gdal, ogr
 
-from qgis.core import QgsVectorLayer, QgsVectorLayerExporter, QgsFeature, QgsGeometry, QgsRectangle, QgsSettings
-from qgis.PyQt.QtCore import QCoreApplication
+from qgis.core import QgsVectorLayer, QgsVectorLayerExporter, QgsFeature, QgsFeatureRequest, QgsGeometry, QgsRectangle, QgsSettings, NULL
+from qgis.PyQt.QtCore import QCoreApplication, QDate
 from qgis.testing import start_app, unittest
 
 
@@ -514,5 +514,71 @@ class TestPyQgsOGRProviderGpkg(unittest.TestCase):
         self.assertEqual(got_geom.exportToWkb(), reference.exportToWkb(), 'Expected {}, got {}'.format(reference.exportToWkt(), got_geom.exportToWkt()))
 
 
+    def testBatchedReading(self):
+        """Test that features read in batches get all their requested attributes"""
+
+        tmpfile = os.path.join(self.basetestpath, 'testBatchedReading.gpkg')
+        ds = ogr.GetDriverByName('GPKG').CreateDataSource(tmpfile)
+        lyr = ds.CreateLayer('test', geom_type=ogr.wkbPoint)
+        lyr.CreateField(ogr.FieldDefn('int', ogr.OFTInteger))
+        lyr.CreateField(ogr.FieldDefn('int64', ogr.OFTInteger64))
+        lyr.CreateField(ogr.FieldDefn('real', ogr.OFTReal))
+        lyr.CreateField(ogr.FieldDefn('str', ogr.OFTString))
+        lyr.CreateField(ogr.FieldDefn('date', ogr.OFTDate))
+        lyr.StartTransaction()
+        for i in range(3000):
+            f = ogr.Feature(lyr.GetLayerDefn())
+            if i % 10 != 0:
+                f['int'] = i
+                f['int64'] = i * 10000000000
+                f['real'] = i / 2.0
+                f['str'] = 'f{}'.format(i)
+                f['date'] = '2017/10/{:02d}'.format(i % 28 + 1)
+            f.SetGeometry(ogr.CreateGeometryFromWkt('POINT({} {})'.format(i, i)))
+            lyr.CreateFeature(f)
+            f = None
+        lyr.CommitTransaction()
+        ds = None
+
+        vl = QgsVectorLayer('{}|layerid=0'.format(tmpfile), 'test', 'ogr')
+        self.assertTrue(vl.isValid())
+
+        def check(feature, attributes):
+            i = feature.id() - 1
+            expected = [feature.id(), i, i * 10000000000, i / 2.0, 'f{}'.format(i), QDate(2017, 10, i % 28 + 1)]
+            if i % 10 == 0:
+                expected = [feature.id(), NULL, NULL, NULL, NULL, NULL]
+            for idx in attributes:
+                self.assertEqual(feature.attributes()[idx], expected[idx], (i, idx))
+            self.assertEqual(feature.geometry().asPoint().x(), i)
+
+        features = [f for f in vl.getFeatures()]
+        self.assertEqual(len(features), 3000)
+        for f in features:
+            check(f, range(6))
+
+        # only the requested attributes are read
+        features = [f for f in vl.getFeatures(QgsFeatureRequest().setSubsetOfAttributes([0, 4]))]
+        self.assertEqual(len(features), 3000)
+        for f in features:
+            check(f, [0, 4])
+            self.assertFalse(f.attributes()[1])
+
+        # rewinding starts a new batch
+        it = vl.getFeatures()
+        f = QgsFeature()
+        for i in range(5):
+            self.assertTrue(it.nextFeature(f))
+        self.assertTrue(it.rewind())
+        self.assertTrue(it.nextFeature(f))
+        self.assertEqual(f.id(), 1)
+
+        # iterations by feature ids
+        features = [f for f in vl.getFeatures(QgsFeatureRequest().setFilterFids([20, 2000, 2999]))]
+        self.assertEqual(sorted([f.id() for f in features]), [20, 2000, 2999])
+        for f in features:
+            check(f, range(6))
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -16,6 +16,7 @@ __revision__ = '$Format:%H$'
 import qgis  # NOQA
 import psycopg2
 
+import math
 import os
 import time
 
@@ -32,7 +33,9 @@ from qgis.core import (
     QgsTransactionGroup,
     QgsReadWriteContext,
     QgsRectangle,
-    QgsDefaultValue
+    QgsDefaultValue,
+    QgsFeatureSink,
+    QgsGeometry
 )
 from qgis.gui import QgsGui
 from qgis.PyQt.QtCore import QDate, QTime, QDateTime, QVariant, QDir, QObject
@@ -301,6 +304,126 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         self.assertNotEqual(f[0]['obj_id'], NULL, f[0].attributes())
         vl.deleteFeatures([f[0].id()])
 
+    def testFastInsertCopy(self):
+        """Test that features added without returning generated values are copied with their values"""
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.fast_insert CASCADE')
+        self.execSQLCommand('CREATE TABLE qgis_test.fast_insert ( pk SERIAL NOT NULL PRIMARY KEY, txt text, dbl float8, dt date, flag boolean, geom public.geometry(MultiPolygon, 4326))')
+        vl = QgsVectorLayer('{} table="qgis_test"."fast_insert" key="pk" (geom) sql='.format(self.dbconn), "fast_insert", "postgres")
+        self.assertTrue(vl.isValid())
+
+        f1 = QgsFeature(vl.fields())
+        f1.setAttributes([NULL, 'tab\there\nnew line \\ backslash', 1.5, QDate(2017, 10, 1), True])
+        # single polygons are converted to the layer type
+        f1.setGeometry(QgsGeometry.fromWkt('Polygon ((0 0, 1 0, 1 1, 0 0))'))
+        f2 = QgsFeature(vl.fields())
+        f2.setAttributes([NULL, '', NULL, NULL, False])
+        self.assertTrue(vl.dataProvider().addFeatures([f1, f2], QgsFeatureSink.FastInsert)[0])
+        self.assertEqual(vl.dataProvider().featureCount(), 2)
+
+        features = [f for f in vl.getFeatures(QgsFeatureRequest().addOrderBy('pk'))]
+        self.assertEqual(len(features), 2)
+        self.assertNotEqual(features[0]['pk'], NULL)
+        self.assertEqual(features[0]['txt'], 'tab\there\nnew line \\ backslash')
+        self.assertEqual(features[0]['dbl'], 1.5)
+        self.assertEqual(features[0]['dt'], QDate(2017, 10, 1))
+        self.assertEqual(features[0]['flag'], True)
+        self.assertEqual(features[0].geometry().asWkt(), 'MultiPolygon (((0 0, 1 0, 1 1, 0 0)))')
+        self.assertEqual(features[1]['txt'], '')
+        self.assertEqual(features[1]['dbl'], NULL)
+        self.assertEqual(features[1]['dt'], NULL)
+        self.assertEqual(features[1]['flag'], False)
+        self.assertFalse(features[1].hasGeometry())
+
+    def testBinaryValues(self):
+        """Test that values of types decoded from binary cursors are read correctly"""
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.binary_values CASCADE')
+        self.execSQLCommand('CREATE TABLE qgis_test.binary_values ( pk integer NOT NULL PRIMARY KEY, i2 int2, i4 int4, i8 int8, f4 float4, f8 float8, b boolean)')
+        self.execSQLCommand("INSERT INTO qgis_test.binary_values (pk, i2, i4, i8, f4, f8, b) VALUES "
+                            "(1, 1, 1, 1, 1.5, 1.5, true),"
+                            "(2, -1, -1, -1, -1.5, -1.5, false),"
+                            "(3, -32768, -2147483648, -9223372036854775808, -3.25e38, -1.7976931348623157e308, true),"
+                            "(4, 32767, 2147483647, 9223372036854775807, 'NaN', 'NaN', false),"
+                            "(5, NULL, NULL, NULL, NULL, NULL, NULL)")
+        vl = QgsVectorLayer('{} table="qgis_test"."binary_values" key="pk" sql='.format(self.dbconn), "binary_values", "postgres")
+        self.assertTrue(vl.isValid())
+
+        features = {f['pk']: f for f in vl.getFeatures()}
+        self.assertEqual(len(features), 5)
+        self.assertEqual(features[1].attributes(), [1, 1, 1, 1, 1.5, 1.5, True])
+        self.assertEqual(features[2].attributes(), [2, -1, -1, -1, -1.5, -1.5, False])
+        self.assertEqual(features[3].attributes()[:4], [3, -32768, -2147483648, -9223372036854775808])
+        self.assertAlmostEqual(features[3]['f4'], -3.25e38, delta=1e32)
+        self.assertEqual(features[3]['f8'], -1.7976931348623157e308)
+        self.assertTrue(features[3]['b'])
+        self.assertEqual(features[4].attributes()[:4], [4, 32767, 2147483647, 9223372036854775807])
+        self.assertTrue(math.isnan(features[4]['f4']))
+        self.assertTrue(math.isnan(features[4]['f8']))
+        self.assertFalse(features[4]['b'])
+        self.assertEqual(features[5].attributes(), [5, NULL, NULL, NULL, NULL, NULL, NULL])
+
+    def testRewindAndCloseWithPendingFetch(self):
+        """Test rewinding and closing iterators while the next batch of features is still fetched"""
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.pending_fetch CASCADE')
+        self.execSQLCommand('CREATE TABLE qgis_test.pending_fetch ( pk integer NOT NULL PRIMARY KEY, val integer)')
+        self.execSQLCommand('INSERT INTO qgis_test.pending_fetch (pk, val) SELECT i, -i FROM generate_series(1, 100) AS i')
+        vl = QgsVectorLayer('{} table="qgis_test"."pending_fetch" key="pk" sql='.format(self.dbconn), "pending_fetch", "postgres")
+        self.assertTrue(vl.isValid())
+        expected = set(range(1, 101))
+
+        # the first batches are small, so the following batch is requested after the first feature
+        it = vl.getFeatures(QgsFeatureRequest().addOrderBy('pk'))
+        f = QgsFeature()
+        self.assertTrue(it.nextFeature(f))
+        self.assertEqual(f['pk'], 1)
+        self.assertTrue(it.nextFeature(f))
+        self.assertTrue(it.rewind())
+        values = []
+        while it.nextFeature(f):
+            self.assertEqual(f['val'], -f['pk'])
+            values.append(f['pk'])
+        self.assertEqual(values, list(range(1, 101)))
+
+        it = vl.getFeatures()
+        self.assertTrue(it.nextFeature(f))
+        self.assertTrue(it.nextFeature(f))
+        self.assertTrue(it.close())
+        self.assertFalse(it.nextFeature(f))
+
+        # the connection is still usable after closing the cursor with a pending fetch
+        self.assertEqual(set([f['pk'] for f in vl.getFeatures()]), expected)
+        self.assertEqual(vl.dataProvider().featureCount(), 100)
+
+    def testSharedConnectionErrors(self):
+        """Test that a failing cursor does not abort the other cursors of a shared connection"""
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.shared_cursors CASCADE')
+        self.execSQLCommand('CREATE TABLE qgis_test.shared_cursors ( pk integer NOT NULL PRIMARY KEY, val integer)')
+        self.execSQLCommand('INSERT INTO qgis_test.shared_cursors (pk, val) SELECT i, i FROM generate_series(1, 100) AS i')
+        vl = QgsVectorLayer('{} table="qgis_test"."shared_cursors" key="pk" sql='.format(self.dbconn), "shared_cursors", "postgres")
+        self.assertTrue(vl.isValid())
+        # fails with a division by zero when the cursor reaches the 50th row
+        failing_vl = QgsVectorLayer('{} table="qgis_test"."shared_cursors" key="pk" sql=1 / (val - 50) < 1000'.format(self.dbconn), "failing", "postgres")
+        self.assertTrue(failing_vl.isValid())
+
+        QgsSettings().setValue('PostgreSQL/shareIteratorConnections', True)
+        try:
+            f = QgsFeature()
+            # the pool connections are used by the first iterators, the failing ones share them
+            iterators = [vl.getFeatures() for i in range(4)]
+            failing_iterators = [failing_vl.getFeatures() for i in range(4)]
+            counts = [0] * 8
+            running = True
+            while running:
+                running = False
+                for i, it in enumerate(iterators + failing_iterators):
+                    if it.nextFeature(f):
+                        counts[i] += 1
+                        running = True
+            self.assertEqual(counts[:4], [100] * 4)
+            for count in counts[4:]:
+                self.assertLess(count, 50)
+        finally:
+            QgsSettings().setValue('PostgreSQL/shareIteratorConnections', False)
+
     def testNestedInsert(self):
         tg = QgsTransactionGroup()
         tg.addLayer(self.vl)
@@ -313,6 +313,57 @@ class TestQgsAggregateCalculator(unittest.TestCase):
         self.assertTrue(ok)
         self.assertEqual(val, 24)
 
+    def testGroups(self):
+        """ test calculating aggregates for groups of features """
+
+        layer = QgsVectorLayer("Point?field=fldgroup:string&field=fldint:integer", "layer", "memory")
+        pr = layer.dataProvider()
+
+        values = [['a', 4], ['b', 2], ['a', 3], [None, 2], ['b', 5], ['a', None], ['c', 8]]
+
+        features = []
+        for v in values:
+            f = QgsFeature()
+            f.setFields(layer.fields())
+            f.setAttributes(v)
+            features.append(f)
+        assert pr.addFeatures(features)
+
+        agg = QgsAggregateCalculator(layer)
+        vals, ok, empty = agg.calculateGroups(QgsAggregateCalculator.Sum, 'fldint', [0])
+        self.assertTrue(ok)
+        self.assertEqual(len(vals), 4)
+        self.assertEqual(vals[QgsAggregateCalculator.groupKey(['a'])], 7)
+        self.assertEqual(vals[QgsAggregateCalculator.groupKey(['b'])], 7)
+        self.assertEqual(vals[QgsAggregateCalculator.groupKey(['c'])], 8)
+        self.assertEqual(vals[QgsAggregateCalculator.groupKey([NULL])], 2)
+        self.assertEqual(empty, 0)
+
+        # results must match the aggregate calculated with a filter for each group
+        agg.setFilter("fldint > 2")
+        vals, ok, empty = agg.calculateGroups(QgsAggregateCalculator.Max, 'fldint * 2', [0])
+        self.assertTrue(ok)
+        for group in ['a', 'b', 'c']:
+            agg.setFilter("fldint > 2 AND fldgroup = '{}'".format(group))
+            val, ok = agg.calculate(QgsAggregateCalculator.Max, 'fldint * 2')
+            self.assertEqual(vals[QgsAggregateCalculator.groupKey([group])], val)
+        self.assertFalse(QgsAggregateCalculator.groupKey([NULL]) in vals)
+        self.assertEqual(empty, NULL)
+
+        # bad group by field
+        agg.setFilter(None)
+        vals, ok, empty = agg.calculateGroups(QgsAggregateCalculator.Sum, 'fldint', [5])
+        self.assertFalse(ok)
+
+    def testGroupKey(self):
+        """ test keys of groups of values """
+        self.assertEqual(QgsAggregateCalculator.groupKey([5]), QgsAggregateCalculator.groupKey([5.0]))
+        self.assertNotEqual(QgsAggregateCalculator.groupKey([5]), QgsAggregateCalculator.groupKey([5.5]))
+        self.assertNotEqual(QgsAggregateCalculator.groupKey([5]), QgsAggregateCalculator.groupKey(['5']))
+        self.assertNotEqual(QgsAggregateCalculator.groupKey([NULL]), QgsAggregateCalculator.groupKey(['']))
+        self.assertNotEqual(QgsAggregateCalculator.groupKey(['a', 'b']), QgsAggregateCalculator.groupKey(['ab', '']))
+        self.assertEqual(QgsAggregateCalculator.groupKey(['a', 1]), QgsAggregateCalculator.groupKey(['a', 1]))
+
     def testExpression(self):
         """ test aggregate calculation using an expression """
 
@@ -24,9 +24,14 @@ from qgis.core import (QgsMapRendererCache,
                        QgsVectorLayer,
                        QgsVectorLayerSimpleLabeling,
                        QgsFeature,
+                       QgsLabelingEngineSettings,
                        QgsGeometry,
                        QgsMapSettings,
-                       QgsPointXY)
+                       QgsMarkerSymbol,
+                       QgsPointXY,
+                       QgsProperty,
+                       QgsSingleSymbolRenderer,
+                       QgsSymbolLayer)
 from qgis.testing import start_app, unittest
 from qgis.PyQt.QtCore import QSize, QThreadPool
 from qgis.PyQt.QtGui import QPainter, QImage
@@ -458,6 +463,184 @@ class TestQgsMapRenderer(unittest.TestCase):
         self.runRendererChecks(create_job)
         p.end()
 
+    def testParallelRendererLayerTiles(self):
+        """ test rendering a layer split into tiles with QgsMapRendererParallelJob"""
+        layer = QgsVectorLayer("Polygon?field=fldtxt:string",
+                               "layer1", "memory")
+
+        # add a ton of random squares, many of them crossing the tile boundaries
+        features = []
+        for i in range(2000):
+            x = uniform(5, 25)
+            y = uniform(25, 45)
+            f = QgsFeature()
+            f.setGeometry(QgsGeometry.fromRect(QgsRectangle(x, y, x + uniform(0.1, 3), y + uniform(0.1, 3))))
+            f.initAttributes(1)
+            features.append(f)
+        layer.dataProvider().addFeatures(features)
+
+        settings = QgsMapSettings()
+        settings.setExtent(QgsRectangle(5, 25, 25, 45))
+        settings.setOutputSize(QSize(600, 400))
+        settings.setLayers([layer])
+        settings.setFlag(QgsMapSettings.Antialiasing, False)
+
+        max_threads = QThreadPool.globalInstance().maxThreadCount()
+        QThreadPool.globalInstance().setMaxThreadCount(4)
+        try:
+            job = QgsMapRendererParallelJob(settings)
+            job.start()
+            job.waitForFinished()
+            image = job.renderedImage()
+
+            settings.setFlag(QgsMapSettings.RenderLayerTiles, True)
+            job = QgsMapRendererParallelJob(settings)
+            job.start()
+            job.waitForFinished()
+            tiled_image = job.renderedImage()
+            self.assertFalse(job.errors())
+
+            # tiles must be seamless
+            self.assertEqual(image, tiled_image)
+
+            # tiled layers must be cancelable too
+            job = QgsMapRendererParallelJob(settings)
+            finished_spy = QSignalSpy(job.finished)
+            job.start()
+            job.cancel()
+            self.assertFalse(job.isActive())
+            self.assertEqual(len(finished_spy), 1)
+        finally:
+            QThreadPool.globalInstance().setMaxThreadCount(max_threads)
+
+    def testParallelRendererLayerTilesLargeSymbols(self):
+        """ test that symbols reaching over tile boundaries are rendered in all the tiles they overlap"""
+        layer = QgsVectorLayer("Point?field=fldtxt:string",
+                               "layer1", "memory")
+        # a marker of about 230 pixels, centered 80 pixels right of the vertical tile boundary
+        f = QgsFeature()
+        f.setGeometry(QgsGeometry.fromPoint(QgsPointXY(19, 35)))
+        f.initAttributes(1)
+        layer.dataProvider().addFeatures([f])
+        symbol = QgsMarkerSymbol.createSimple({'name': 'square', 'size': '60', 'color': '255,0,0'})
+        layer.setRenderer(QgsSingleSymbolRenderer(symbol.clone()))
+
+        settings = QgsMapSettings()
+        settings.setExtent(QgsRectangle(5, 25, 25, 45))
+        settings.setOutputSize(QSize(600, 400))
+        settings.setLayers([layer])
+        settings.setFlag(QgsMapSettings.Antialiasing, False)
+
+        def render(tiles):
+            settings.setFlag(QgsMapSettings.RenderLayerTiles, tiles)
+            job = QgsMapRendererParallelJob(settings)
+            job.start()
+            job.waitForFinished()
+            self.assertFalse(job.errors())
+            return job.renderedImage()
+
+        max_threads = QThreadPool.globalInstance().maxThreadCount()
+        QThreadPool.globalInstance().setMaxThreadCount(4)
+        try:
+            # the tile margin is derived from the size of the symbol
+            self.assertEqual(render(False), render(True))
+
+            # data defined sizes are only known when rendering, so the layer is not split
+            symbol.symbolLayer(0).setDataDefinedProperty(QgsSymbolLayer.PropertySize, QgsProperty.fromExpression('60'))
+            layer.setRenderer(QgsSingleSymbolRenderer(symbol.clone()))
+            self.assertEqual(render(False), render(True))
+        finally:
+            QThreadPool.globalInstance().setMaxThreadCount(max_threads)
+
+    def testParallelRendererPreparedLabels(self):
+        """ labels prepared while layers are rendered in parallel must match the sequential solution"""
+        layers = []
+        for i in range(3):
+            layer = QgsVectorLayer("Point?field=fldtxt:string",
+                                   "layer{}".format(i), "memory")
+            features = []
+            for j in range(200):
+                f = QgsFeature()
+                f.setGeometry(QgsGeometry.fromPoint(QgsPointXY(uniform(5, 25), uniform(25, 45))))
+                f.setAttributes(['label {}'.format(j)])
+                features.append(f)
+            layer.dataProvider().addFeatures(features)
+
+            labelSettings = QgsPalLayerSettings()
+            labelSettings.fieldName = "fldtxt"
+            layer.setLabeling(QgsVectorLayerSimpleLabeling(labelSettings))
+            layers.append(layer)
+
+        settings = QgsMapSettings()
+        settings.setExtent(QgsRectangle(5, 25, 25, 45))
+        settings.setOutputSize(QSize(600, 400))
+        settings.setLayers(layers)
+
+        job = QgsMapRendererSequentialJob(settings)
+        job.start()
+        job.waitForFinished()
+        sequential_image = job.renderedImage()
+
+        job = QgsMapRendererParallelJob(settings)
+        job.start()
+        job.waitForFinished()
+        parallel_image = job.renderedImage()
+        self.assertTrue(job.takeLabelingResults())
+
+        self.assertEqual(sequential_image, parallel_image)
+
+    def testParallelLabelSolver(self):
+        """ solving independent groups of labels in parallel must not depend on the number of threads"""
+        layer = QgsVectorLayer("Point?field=fldtxt:string",
+                               "layer1", "memory")
+        # several separate clusters of conflicting labels
+        features = []
+        for i in range(5):
+            for j in range(5):
+                for k in range(20):
+                    f = QgsFeature()
+                    f.setGeometry(QgsGeometry.fromPoint(QgsPointXY(5 + i * 4 + uniform(0, 1), 25 + j * 4 + uniform(0, 1))))
+                    f.setAttributes(['label {}'.format(k)])
+                    features.append(f)
+        layer.dataProvider().addFeatures(features)
+
+        labelSettings = QgsPalLayerSettings()
+        labelSettings.fieldName = "fldtxt"
+        layer.setLabeling(QgsVectorLayerSimpleLabeling(labelSettings))
+
+        settings = QgsMapSettings()
+        settings.setExtent(QgsRectangle(5, 25, 25, 45))
+        settings.setOutputSize(QSize(600, 400))
+        settings.setLayers([layer])
+
+        def render(search_method, parallel, threads):
+            engine_settings = settings.labelingEngineSettings()
+            engine_settings.setSearchMethod(search_method)
+            engine_settings.setFlag(QgsLabelingEngineSettings.ParallelSolver, parallel)
+            settings.setLabelingEngineSettings(engine_settings)
+
+            max_threads = QThreadPool.globalInstance().maxThreadCount()
+            QThreadPool.globalInstance().setMaxThreadCount(threads)
+            try:
+                job = QgsMapRendererSequentialJob(settings)
+                job.start()
+                job.waitForFinished()
+                results = job.takeLabelingResults()
+                placements = sorted((p.featureId, p.labelRect.toString()) for p in results.labelsWithinRect(settings.extent()))
+                return job.renderedImage(), placements
+            finally:
+                QThreadPool.globalInstance().setMaxThreadCount(max_threads)
+
+        # the parallel solver orders candidates of the same rank by id, so its placements may differ
+        # from the ones of the default solver, but they must not depend on the number of threads
+        for search_method in (QgsLabelingEngineSettings.Falp, QgsLabelingEngineSettings.Chain):
+            image, placements = render(search_method, True, 1)
+            self.assertTrue(placements)
+            for threads in (2, 4):
+                parallel_image, parallel_placements = render(search_method, True, threads)
+                self.assertEqual(placements, parallel_placements)
+                self.assertEqual(image, parallel_image)
+
 
 if __name__ == '__main__':
     unittest.main()
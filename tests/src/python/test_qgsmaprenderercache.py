@@ -15,13 +15,17 @@ __revision__ = '$Format:%H$'
 import qgis  # NOQA
 
 from qgis.core import (QgsMapRendererCache,
+                       QgsMapSettings,
                        QgsRectangle,
                        QgsVectorLayer,
                        QgsProject)
 from qgis.testing import start_app, unittest
-from qgis.PyQt.QtCore import QCoreApplication
-from qgis.PyQt.QtGui import QImage
+from qgis.PyQt.QtCore import QCoreApplication, QSize
+from qgis.PyQt.QtGui import QImage, QColor
 from time import sleep
+import os
+import shutil
+import tempfile
 start_app()
 
 
@@ -266,6 +270,124 @@ class TestQgsMapRendererCache(unittest.TestCase):
         # cache should be cleared
         self.assertFalse(cache.hasCacheImage('l1'))
 
+    def testStorageKey(self):
+        layer = QgsVectorLayer("Point?field=fldtxt:string",
+                               "layer1", "memory")
+        settings = QgsMapSettings()
+        settings.setExtent(QgsRectangle(0, 0, 10, 10))
+        settings.setOutputSize(QSize(100, 100))
+        key = QgsMapRendererCache.storageKey(layer, settings)
+        self.assertEqual(QgsMapRendererCache.storageKey(layer, settings), key)
+
+        # map settings
+        settings.setOutputSize(QSize(200, 100))
+        self.assertNotEqual(QgsMapRendererCache.storageKey(layer, settings), key)
+        settings.setOutputSize(QSize(100, 100))
+        self.assertEqual(QgsMapRendererCache.storageKey(layer, settings), key)
+        settings.setExtent(QgsRectangle(0, 0, 20, 20))
+        self.assertNotEqual(QgsMapRendererCache.storageKey(layer, settings), key)
+        settings.setExtent(QgsRectangle(0, 0, 10, 10))
+
+        # layer style and filter
+        layer.setOpacity(0.5)
+        self.assertNotEqual(QgsMapRendererCache.storageKey(layer, settings), key)
+        layer.setOpacity(1)
+        self.assertEqual(QgsMapRendererCache.storageKey(layer, settings), key)
+        layer.setSubsetString('"fldtxt" = \'a\'')
+        self.assertNotEqual(QgsMapRendererCache.storageKey(layer, settings), key)
+
+    def testCacheImageStorageKey(self):
+        cache = QgsMapRendererCache()
+        im = QImage(20, 20, QImage.Format_RGB32)
+        self.assertEqual(cache.cacheImageStorageKey('l1'), '')
+        cache.setCacheImage('l1', im, [], 'k1')
+        self.assertEqual(cache.cacheImageStorageKey('l1'), 'k1')
+        # images rendered with different settings replace the key
+        cache.setCacheImage('l1', im, [], 'k2')
+        self.assertEqual(cache.cacheImageStorageKey('l1'), 'k2')
+        cache.setCacheImage('l2', im)
+        self.assertEqual(cache.cacheImageStorageKey('l2'), '')
+        cache.clear()
+        self.assertEqual(cache.cacheImageStorageKey('l1'), '')
+
+    def testStoreImagesInMemory(self):
+        cache = QgsMapRendererCache()
+        self.assertFalse(cache.hasImageStorage())
+        layer1 = QgsVectorLayer("Point?field=fldtxt:string",
+                                "layer1", "memory")
+        layer2 = QgsVectorLayer("Point?field=fldtxt:string",
+                                "layer2", "memory")
+        im = QImage(20, 20, QImage.Format_RGB32)
+        im.fill(QColor(255, 0, 0))
+
+        # storage disabled
+        cache.storeImage(layer1, 'k1', im)
+        self.assertTrue(cache.storedImage(layer1, 'k1').isNull())
+
+        cache.setMaximumStoredImages(2)
+        self.assertEqual(cache.maximumStoredImages(), 2)
+        self.assertTrue(cache.hasImageStorage())
+        cache.storeImage(layer1, 'k1', im)
+        cache.storeImage(layer1, 'k2', im)
+        self.assertEqual(cache.storedImage(layer1, 'k1'), im)
+        # wrong layer
+        self.assertTrue(cache.storedImage(layer2, 'k1').isNull())
+
+        # least recently used image is dropped
+        cache.storeImage(layer2, 'k3', im)
+        self.assertFalse(cache.storedImage(layer1, 'k1').isNull())
+        self.assertTrue(cache.storedImage(layer1, 'k2').isNull())
+        self.assertFalse(cache.storedImage(layer2, 'k3').isNull())
+
+        # stored images survive a change of extent
+        cache.init(QgsRectangle(1, 2, 3, 4), 1000)
+        self.assertFalse(cache.storedImage(layer1, 'k1').isNull())
+
+        # but not a repaint of their layer
+        layer1.triggerRepaint()
+        self.assertTrue(cache.storedImage(layer1, 'k1').isNull())
+        self.assertFalse(cache.storedImage(layer2, 'k3').isNull())
+
+        cache.clear()
+        self.assertTrue(cache.storedImage(layer2, 'k3').isNull())
+
+    def testStoreImagesOnDisk(self):
+        temp_dir = tempfile.mkdtemp()
+        layer1 = QgsVectorLayer("Point?field=fldtxt:string",
+                                "layer1", "memory")
+        layer2 = QgsVectorLayer("Point?field=fldtxt:string",
+                                "layer2", "memory")
+        im = QImage(20, 20, QImage.Format_ARGB32)
+        im.fill(QColor(255, 0, 0, 100))
+
+        cache = QgsMapRendererCache()
+        cache.setStorageDirectory(temp_dir)
+        self.assertEqual(cache.storageDirectory(), temp_dir)
+        self.assertTrue(cache.hasImageStorage())
+        cache.storeImage(layer1, 'k1', im)
+        cache.storeImage(layer2, 'k2', im)
+        self.assertEqual(len(os.listdir(temp_dir)), 2)
+
+        # another cache using the same directory, e.g. in another process
+        cache2 = QgsMapRendererCache()
+        cache2.setStorageDirectory(temp_dir)
+        self.assertEqual(cache2.storedImage(layer1, 'k1'), im)
+        self.assertTrue(cache2.storedImage(layer1, 'k2').isNull())
+
+        # repaint removes the stored files of the layer
+        layer1.triggerRepaint()
+        self.assertTrue(cache.storedImage(layer1, 'k1').isNull())
+        self.assertEqual(len(os.listdir(temp_dir)), 1)
+        self.assertEqual(cache.storedImage(layer2, 'k2'), im)
+
+        # other files are kept when clearing
+        open(os.path.join(temp_dir, 'other.png'), 'w').close()
+        cache.clearStorage()
+        self.assertTrue(cache.storedImage(layer2, 'k2').isNull())
+        self.assertEqual(os.listdir(temp_dir), ['other.png'])
+
+        shutil.rmtree(temp_dir, True)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -20,6 +20,7 @@ import qgis  # NOQA
 from qgis.core import (QgsVectorLayer,
                        QgsFeature,
                        QgsField,
+                       QgsFields,
                        QgsGeometry,
                        QgsPointXY,
                        QgsCoordinateReferenceSystem,
@@ -520,6 +521,59 @@ class TestQgsVectorFileWriter(unittest.TestCase):
         int8_idx = created_layer.fields().lookupField('int8')
         self.assertEqual(f.attributes()[int8_idx], 2123456789)
 
+    def testBatchedWrite(self):
+        """Tests writing many features in transaction batches with addFeatures()"""
+        dest_file_name = os.path.join(str(QDir.tempPath()), 'batched_write.gpkg')
+        if os.path.exists(dest_file_name):
+            os.remove(dest_file_name)
+
+        fields = QgsFields()
+        fields.append(QgsField('int_f', QVariant.Int))
+        fields.append(QgsField('str_f', QVariant.String))
+        fields.append(QgsField('dt_f', QVariant.DateTime))
+        writer = QgsVectorFileWriter(dest_file_name, 'utf-8', fields, QgsWkbTypes.MultiPoint, QgsCoordinateReferenceSystem(), 'GPKG')
+        self.assertEqual(writer.hasError(), QgsVectorFileWriter.NoError)
+        self.assertEqual(writer.transactionBatchSize(), 0)
+        writer.setTransactionBatchSize(700)
+        self.assertEqual(writer.transactionBatchSize(), 700)
+
+        features = []
+        for i in range(2000):
+            f = QgsFeature(fields)
+            # mix features with single, multi and no geometries, and with values of other types than the fields
+            if i % 3 == 0:
+                f.setGeometry(QgsGeometry.fromWkt('Point ({} 1)'.format(i)))
+            elif i % 3 == 1:
+                f.setGeometry(QgsGeometry.fromWkt('MultiPoint (({} 2))'.format(i)))
+            f.setAttributes([i if i % 5 else str(i), 'value {}'.format(i), QDateTime(QDate(2017, 10, 1), QTime(i % 24, 0, 0)) if i % 7 else None])
+            features.append(f)
+        self.assertTrue(writer.addFeatures(features))
+        self.assertTrue(writer.flushBuffer())
+        f = QgsFeature(fields)
+        f.setAttributes([2000, 'last', None])
+        self.assertTrue(writer.addFeature(f))
+        del writer
+
+        created_layer = QgsVectorLayer(dest_file_name, 'test', 'ogr')
+        self.assertTrue(created_layer.isValid())
+        self.assertEqual(created_layer.featureCount(), 2001)
+        for f in created_layer.getFeatures():
+            i = f['int_f']
+            if i == 2000:
+                self.assertEqual(f['str_f'], 'last')
+                continue
+            self.assertEqual(f['str_f'], 'value {}'.format(i))
+            if i % 7:
+                self.assertEqual(f['dt_f'], QDateTime(QDate(2017, 10, 1), QTime(i % 24, 0, 0)))
+            else:
+                self.assertFalse(f['dt_f'])
+            if i % 3 == 0:
+                self.assertEqual(f.geometry().exportToWkt(), 'MultiPoint (({} 1))'.format(i))
+            elif i % 3 == 1:
+                self.assertEqual(f.geometry().exportToWkt(), 'MultiPoint (({} 2))'.format(i))
+            else:
+                self.assertTrue(f.geometry().isEmpty())
+
     def testDefaultDatasetOptions(self):
         """ Test retrieving default dataset options for a format """
 